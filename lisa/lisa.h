@@ -10,7 +10,25 @@
 #include "lisa_defines.h"
 #include "lisa_types.h"
 
+#include "lisa_alloc.h"
 #include "lisa_objio.h"
+#include "lisa_symbols.h"
+#include "lisa_relocate.h"
+#include "lisa_resolve.h"
+#include "lisa_writer.h"
+#include "lisa_rebuild.h"
+#include "lisa_link.h"
+#include "lisa_diff.h"
+#include "lisa_similar.h"
+#include "lisa_verify.h"
+#include "lisa_checksum.h"
+#include "lisa_archive.h"
+#include "lisa_store.h"
+#include "lisa_extract.h"
+#include "lisa_image.h"
+#include "lisa_batch.h"
+#include "lisa_summary.h"
+#include "lisa_stats.h"
 
 
 #endif /* __LISA__H__ */
@@ -0,0 +1,440 @@
+//  lisa.hpp
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#ifndef __LISA__HPP__
+#define __LISA__HPP__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "lisa.h"
+
+LISA_HEADER_BEGIN
+
+
+/*!
+    A header-only C++20 layer over the C API, for use from C++.
+
+    Everything here is a view of an open object file: spans and string
+    views point into the file's buffer, and are only valid until it's
+    closed. Nothing throws; as in C, failures give back an empty handle
+    or `std::nullopt` with errno set.
+ */
+namespace lisa {
+
+
+// MARK: - Block Types
+
+/*!
+    What's known at compile time about a block type: the struct its
+    content is, and for tables and reference lists, the type of their
+    entries and where they start, counting the 4-byte block header.
+    Only block types with content have traits.
+ */
+template <lisa_obj_block_type Type>
+struct block_traits;
+
+#define LISA_BLOCK_TRAITS(T) \
+    template <> \
+    struct block_traits<T> { \
+        using content_type = lisa_##T; \
+        static content_type *content(lisa_objfile_content c) noexcept { return c.T; } \
+    };
+
+#define LISA_BLOCK_TABLE_TRAITS(T, Count) \
+    template <> \
+    struct block_traits<T> { \
+        using content_type = lisa_##T; \
+        using variant_type = std::remove_extent_t<decltype(lisa_##T::variants)>; \
+        static constexpr std::size_t variants_offset = 4 + offsetof(lisa_##T, variants); \
+        static content_type *content(lisa_objfile_content c) noexcept { return c.T; } \
+        static lisa_integer count(const content_type &content) noexcept { return content.Count; } \
+    };
+
+#define LISA_BLOCK_REFS_TRAITS(T, Refs) \
+    template <> \
+    struct block_traits<T> { \
+        using content_type = lisa_##T; \
+        using ref_type = std::remove_extent_t<decltype(lisa_##T::Refs)>; \
+        static constexpr std::size_t refs_offset = 4 + offsetof(lisa_##T, Refs); \
+        static content_type *content(lisa_objfile_content c) noexcept { return c.T; } \
+    };
+
+LISA_BLOCK_TRAITS(ModuleName)
+LISA_BLOCK_TRAITS(EndBlock)
+LISA_BLOCK_TRAITS(EntryPoint)
+LISA_BLOCK_REFS_TRAITS(External, Ref)
+LISA_BLOCK_TRAITS(StartAddress)
+LISA_BLOCK_TRAITS(CodeBlock)
+LISA_BLOCK_REFS_TRAITS(Relocation, Ref)
+LISA_BLOCK_REFS_TRAITS(CommonRelocation, Ref)
+LISA_BLOCK_REFS_TRAITS(ShortExternal, ShortRef)
+LISA_BLOCK_TRAITS(UnitBlock)
+LISA_BLOCK_TRAITS(Executable)
+LISA_BLOCK_TRAITS(VersionCtrl)
+LISA_BLOCK_TABLE_TRAITS(SegmentTable, nSegments)
+LISA_BLOCK_TABLE_TRAITS(UnitTable, nUnits)
+LISA_BLOCK_TABLE_TRAITS(SegLocation, nSegments)
+LISA_BLOCK_TABLE_TRAITS(UnitLocation, nUnits)
+LISA_BLOCK_TABLE_TRAITS(StringBlock, nStrings)
+LISA_BLOCK_TRAITS(PackedCode)
+LISA_BLOCK_TRAITS(PackTable)
+LISA_BLOCK_TRAITS(OSData)
+
+#undef LISA_BLOCK_TRAITS
+#undef LISA_BLOCK_TABLE_TRAITS
+#undef LISA_BLOCK_REFS_TRAITS
+
+
+/*! A list of block types, to visit. */
+template <lisa_obj_block_type... Types>
+struct block_type_list {};
+
+/*! Every block type with content. */
+using content_block_types = block_type_list<
+    ModuleName, EndBlock, EntryPoint, External, StartAddress, CodeBlock,
+    Relocation, CommonRelocation, ShortExternal, UnitBlock, Executable,
+    VersionCtrl, SegmentTable, UnitTable, SegLocation, UnitLocation,
+    StringBlock, PackedCode, PackTable, OSData>;
+
+
+// MARK: - Strings
+
+/*! Get \a name as a string, without its blank padding. */
+inline std::string_view
+name(const lisa_ObjName &name) noexcept
+{
+    std::size_t length = sizeof(lisa_ObjName);
+    while ((length > 0) && ((name[length - 1] == ' ') || (name[length - 1] == '\0'))) length--;
+    return std::string_view(name, length);
+}
+
+/*! Get \a view as a string. */
+inline std::string_view
+string(const lisa_pstring_view &view) noexcept
+{
+    return view.chars ? std::string_view(view.chars, view.length) : std::string_view();
+}
+
+
+// MARK: - Blocks
+
+/*!
+    A block known to be of type \a Type, giving its content as the
+    struct it is, and its tables and reference lists as spans.
+ */
+template <lisa_obj_block_type Type>
+class block_ref {
+public:
+    using traits = block_traits<Type>;
+    using content_type = typename traits::content_type;
+
+    static constexpr lisa_obj_block_type type = Type;
+
+    /*! Wrap \a block, which must be of type \a Type. */
+    explicit block_ref(lisa_objfile_block *block) noexcept
+        : _block(block), _content(traits::content(lisa_objfile_block_content(block))) {}
+
+    lisa_objfile_block *get() const noexcept { return _block; }
+    content_type &content() const noexcept { return *_content; }
+    content_type &operator*() const noexcept { return *_content; }
+    content_type *operator->() const noexcept { return _content; }
+
+    lisa_longint size() const noexcept { return lisa_objfile_block_size(_block); }
+    lisa_FileAddr offset() const noexcept { return lisa_objfile_block_offset(_block); }
+
+    /*!
+        Get the entries of a table block. Counts that run past the end
+        of the block are cut short to what it holds.
+     */
+    auto
+    variants() const noexcept requires requires { typename traits::variant_type; }
+    {
+        using variant_type = typename traits::variant_type;
+        const std::size_t fits = entries_fitting(traits::variants_offset, sizeof(variant_type));
+        const lisa_integer count = traits::count(*_content);
+        const std::size_t n = (count < 0) ? 0 : std::min(static_cast<std::size_t>(count), fits);
+        return std::span<variant_type>(reinterpret_cast<variant_type *>(entries()), n);
+    }
+
+    /*!
+        Get the references of a reference list block, as many as its
+        size holds. These are words within the file and may not be
+        aligned, which is fine on the machines this runs on.
+     */
+    auto
+    refs() const noexcept requires requires { typename traits::ref_type; }
+    {
+        using ref_type = typename traits::ref_type;
+        return std::span<ref_type>(reinterpret_cast<ref_type *>(entries()),
+                                   lisa_relocate_reference_count(_block));
+    }
+
+private:
+    /*! Get the first entry of the block's table or reference list. */
+    std::uint8_t *
+    entries() const noexcept
+    {
+        // Both start right after the fixed part of the content.
+        if constexpr (requires { traits::variants_offset; }) {
+            return reinterpret_cast<std::uint8_t *>(_content) + traits::variants_offset - 4;
+        } else {
+            return reinterpret_cast<std::uint8_t *>(_content) + traits::refs_offset - 4;
+        }
+    }
+
+    /*! Get how many entries of \a entry_size fit in the block after \a offset. */
+    std::size_t
+    entries_fitting(std::size_t offset, std::size_t entry_size) const noexcept
+    {
+        const lisa_longint block_size = size();
+        return (block_size > 0 && static_cast<std::size_t>(block_size) > offset)
+            ? (static_cast<std::size_t>(block_size) - offset) / entry_size : 0;
+    }
+
+    lisa_objfile_block	*_block;
+    content_type		*_content;
+};
+
+
+/*! A block of any type. */
+class block {
+public:
+    explicit block(lisa_objfile_block *block) noexcept : _block(block) {}
+
+    lisa_objfile_block *get() const noexcept { return _block; }
+    lisa_obj_block_type type() const noexcept { return lisa_objfile_block_type(_block); }
+    lisa_longint size() const noexcept { return lisa_objfile_block_size(_block); }
+    lisa_FileAddr offset() const noexcept { return lisa_objfile_block_offset(_block); }
+    lisa_objfile_content content() const noexcept { return lisa_objfile_block_content(_block); }
+
+    /*! Get the block as a \a Type block, if that's what it is. */
+    template <lisa_obj_block_type Type>
+    std::optional<block_ref<Type>>
+    as() const noexcept
+    {
+        if (type() != Type) return std::nullopt;
+        return block_ref<Type>(_block);
+    }
+
+private:
+    lisa_objfile_block	*_block;
+};
+
+
+/*! The blocks of an object file, in file order, for range-based `for`. */
+class block_range {
+public:
+    class iterator {
+    public:
+        using value_type = lisa::block;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() noexcept = default;
+        iterator(lisa_objfile *of, lisa_integer index) noexcept : _of(of), _index(index) {}
+
+        lisa::block operator*() const noexcept { return lisa::block(lisa_objfile_block_at_index(_of, _index)); }
+        iterator &operator++() noexcept { _index++; return *this; }
+        iterator operator++(int) noexcept { iterator old = *this; _index++; return old; }
+        bool operator==(const iterator &other) const noexcept { return _index == other._index; }
+
+    private:
+        lisa_objfile	* LISA_NULLABLE _of = nullptr;
+        lisa_integer	_index = 0;
+    };
+
+    explicit block_range(lisa_objfile *of) noexcept : _of(of), _count(lisa_objfile_block_count(of)) {}
+
+    iterator begin() const noexcept { return iterator(_of, 0); }
+    iterator end() const noexcept { return iterator(_of, _count); }
+    lisa_integer size() const noexcept { return _count; }
+    lisa::block operator[](lisa_integer idx) const noexcept { return lisa::block(lisa_objfile_block_at_index(_of, idx)); }
+
+private:
+    lisa_objfile	*_of;
+    lisa_integer	_count;
+};
+
+
+// MARK: - Visitors
+
+/*!
+    Call \a visitor with a `block_ref` for each block of \a of whose
+    type is one of \a Types, in file order.
+
+    Which types to look for is settled at compile time, so each block
+    costs just its type and one comparison per type; there are no
+    virtual calls, and no switch over every type.
+ */
+template <lisa_obj_block_type... Types, class Visitor>
+requires (sizeof...(Types) > 0)
+void
+visit(lisa_objfile *of, Visitor &&visitor)
+{
+    const lisa_integer count = lisa_objfile_block_count(of);
+    for (lisa_integer i = 0; i < count; i++) {
+        lisa_objfile_block *block = lisa_objfile_block_at_index(of, i);
+        const lisa_obj_block_type type = lisa_objfile_block_type(block);
+        static_cast<void>(((type == Types && (static_cast<void>(visitor(block_ref<Types>(block))), true)) || ...));
+    }
+}
+
+/*! Call \a visitor for each block of \a of whose type is in \a Types. */
+template <lisa_obj_block_type... Types, class Visitor>
+void
+visit(lisa_objfile *of, block_type_list<Types...>, Visitor &&visitor)
+{
+    visit<Types...>(of, std::forward<Visitor>(visitor));
+}
+
+namespace detail {
+
+template <class Visitor, lisa_obj_block_type... Types>
+void
+visit_accepted(lisa_objfile *of, Visitor &visitor, block_type_list<Types...>)
+{
+    const lisa_integer count = lisa_objfile_block_count(of);
+    for (lisa_integer i = 0; i < count; i++) {
+        lisa_objfile_block *block = lisa_objfile_block_at_index(of, i);
+        const lisa_obj_block_type type = lisa_objfile_block_type(block);
+        ([&] {
+            if constexpr (std::is_invocable_v<Visitor &, block_ref<Types>>) {
+                if (type == Types) visitor(block_ref<Types>(block));
+            }
+        }(), ...);
+    }
+}
+
+} // namespace detail
+
+/*!
+    Call \a visitor for each block of \a of whose type it accepts, as
+    worked out from its overloads at compile time: a visitor taking a
+    `block_ref<SegLocation>` sees only SegLocation blocks. A generic
+    visitor accepts every block with content.
+ */
+template <class Visitor>
+void
+visit(lisa_objfile *of, Visitor &&visitor)
+{
+    detail::visit_accepted(of, visitor, content_block_types());
+}
+
+
+// MARK: - Object Files
+
+/*! An open object file, closed when it goes away. */
+class objfile {
+public:
+    objfile() noexcept = default;
+
+    /*! Take ownership of \a of, which may be NULL. */
+    explicit objfile(lisa_objfile * LISA_NULLABLE of) noexcept : _of(of) {}
+
+    objfile(objfile &&other) noexcept : _of(std::exchange(other._of, nullptr)) {}
+    objfile &operator=(objfile &&other) noexcept
+    {
+        if (this != &other) {
+            lisa_objfile_close(_of);
+            _of = std::exchange(other._of, nullptr);
+        }
+        return *this;
+    }
+    objfile(const objfile &) = delete;
+    objfile &operator=(const objfile &) = delete;
+    ~objfile() { lisa_objfile_close(_of); }
+
+    /*! Open the file at \a path, which is empty if that fails. */
+    static objfile
+    open(const char *path, const lisa_allocator * LISA_NULLABLE allocator = nullptr) noexcept
+    {
+        return objfile(lisa_objfile_open_with_allocator(path, allocator));
+    }
+
+    /*! Open the file at \a path by mapping it, which is empty if that fails. */
+    static objfile
+    open_mapped(const char *path, const lisa_allocator * LISA_NULLABLE allocator = nullptr) noexcept
+    {
+        return objfile(lisa_objfile_open_mapped_with_allocator(path, allocator));
+    }
+
+    explicit operator bool() const noexcept { return _of != nullptr; }
+    lisa_objfile * LISA_NULLABLE get() const noexcept { return _of; }
+    lisa_objfile * LISA_NULLABLE release() noexcept { return std::exchange(_of, nullptr); }
+
+    std::size_t size() const noexcept { return lisa_objfile_size(_of); }
+    block_range blocks() const noexcept { return block_range(_of); }
+    lisa_Executable * LISA_NULLABLE executable() const noexcept { return lisa_objfile_executable(_of); }
+
+    std::optional<lisa_segment>
+    segment_numbered(lisa_integer number) const noexcept
+    {
+        lisa_segment segment;
+        if (lisa_objfile_segment_numbered(_of, number, &segment) == -1) return std::nullopt;
+        return segment;
+    }
+
+    std::optional<lisa_segment>
+    segment_named(const char *name) const noexcept
+    {
+        lisa_segment segment;
+        if (lisa_objfile_segment_named(_of, name, &segment) == -1) return std::nullopt;
+        return segment;
+    }
+
+    const lisa_jump_table_entry * LISA_NULLABLE
+    jump_table_entry_at_address(lisa_MemAddr address) const noexcept
+    {
+        return lisa_objfile_jump_table_entry_at_address(_of, address);
+    }
+
+    /*! Get the name the StringBlock gives \a file_number. */
+    std::optional<std::string_view>
+    file_name(lisa_integer file_number) const noexcept
+    {
+        lisa_pstring_view name;
+        if (lisa_objfile_file_name(_of, file_number, &name) == -1) return std::nullopt;
+        return string(name);
+    }
+
+    /*! Get the Pascal string at \a offset. */
+    std::optional<std::string_view>
+    pstring_at_offset(lisa_FileAddr offset) const noexcept
+    {
+        lisa_pstring_view view;
+        if (lisa_objfile_pstring_at_offset(_of, offset, &view) == -1) return std::nullopt;
+        return string(view);
+    }
+
+    /*! Call \a visitor for each block of the given types; see `lisa::visit`. */
+    template <lisa_obj_block_type... Types, class Visitor>
+    void
+    visit(Visitor &&visitor) const
+    {
+        if constexpr (sizeof...(Types) > 0) {
+            lisa::visit<Types...>(_of, std::forward<Visitor>(visitor));
+        } else {
+            lisa::visit(_of, std::forward<Visitor>(visitor));
+        }
+    }
+
+private:
+    lisa_objfile	* LISA_NULLABLE _of = nullptr;
+};
+
+
+} // namespace lisa
+
+
+LISA_HEADER_END
+
+#endif /* __LISA__HPP__ */
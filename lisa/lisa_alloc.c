@@ -0,0 +1,71 @@
+//  lisa_alloc.c
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#include "lisa_alloc.h"
+
+#include <stdlib.h>
+
+#include "alloc_utils.h"
+
+#include "lisa_stats.h"
+
+
+LISA_SOURCE_BEGIN
+
+
+// MARK: - Internals
+
+void * LISA_NULLABLE
+lisa_default_allocate(size_t size, void * LISA_NULLABLE context)
+{
+    (void)context;
+
+    uint64_t start = lisa_stats_begin();
+    void *ptr = malloc(size);
+    lisa_stats_end(lisa_stats_allocate, start, 0, size);
+    return ptr;
+}
+
+
+void * LISA_NULLABLE
+lisa_default_reallocate(void * LISA_NULLABLE ptr, size_t old_size, size_t new_size, void * LISA_NULLABLE context)
+{
+    (void)old_size;
+    (void)context;
+
+    uint64_t start = lisa_stats_begin();
+    void *moved = realloc(ptr, new_size);
+    lisa_stats_end(lisa_stats_allocate, start, 0, new_size);
+    return moved;
+}
+
+
+void
+lisa_default_deallocate(void * LISA_NULLABLE ptr, void * LISA_NULLABLE context)
+{
+    (void)context;
+    free(ptr);
+}
+
+
+static const lisa_allocator lisa_default_allocator_hooks = {
+    .allocate = lisa_default_allocate,
+    .reallocate = lisa_default_reallocate,
+    .deallocate = lisa_default_deallocate,
+    .context = NULL,
+};
+
+
+// MARK: - Allocators
+
+const lisa_allocator *
+lisa_default_allocator(void)
+{
+    return &lisa_default_allocator_hooks;
+}
+
+
+LISA_SOURCE_END
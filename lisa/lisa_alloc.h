@@ -0,0 +1,39 @@
+//  lisa_alloc.h
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#ifndef __LISA__ALLOC__H__
+#define __LISA__ALLOC__H__
+
+#include "lisa_defines.h"
+#include "lisa_types.h"
+
+LISA_HEADER_BEGIN
+
+
+/*!
+    Hooks for how the library allocates memory, as declared by
+    `alloc_utils.h`, which also provides a bump arena that hooks can be
+    gotten from.
+
+    Entry points that take an allocator use the default one if it's NULL.
+ */
+struct allocator;
+typedef struct allocator lisa_allocator;
+
+
+/*!
+    Get the allocator the library uses by default, which uses `malloc`,
+    `realloc` and `free`, and counts and times each allocation as
+    `lisa_stats_allocate` while stats are being recorded.
+ */
+LISA_EXTERN
+const lisa_allocator *
+lisa_default_allocator(void);
+
+
+LISA_HEADER_END
+
+#endif /* __LISA__ALLOC__H__ */
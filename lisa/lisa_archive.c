@@ -0,0 +1,324 @@
+//  lisa_archive.c
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#include "lisa_archive.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "endian_utils.h"
+
+#include "lisa_stats.h"
+
+
+LISA_SOURCE_BEGIN
+
+
+// MARK: - Internals
+
+/*! The smallest amount an archive's preallocated space grows by. */
+#define LISA_ARCHIVE_MIN_PREALLOCATION ((uint64_t)1 << 20)
+
+
+struct lisa_archive_entry {
+    char				*name;
+    uint64_t			offset;
+    uint64_t			size;
+};
+typedef struct lisa_archive_entry lisa_archive_entry;
+
+struct lisa_archive_writer {
+    int					fd;
+
+    pthread_mutex_t		lock;
+    lisa_archive_entry	* LISA_NULLABLE entries;
+    size_t				entry_count;
+    size_t				entry_capacity;
+    uint64_t			data_end;			//!< end of the space handed out so far
+    uint64_t			allocated;			//!< end of the space preallocated so far
+    int					error;				//!< first errno from any write, or 0
+};
+
+
+/*! Round \a value up to the archive alignment. */
+uint64_t
+lisa_archive_align(uint64_t value)
+{
+    return (value + (LISA_ARCHIVE_ALIGNMENT - 1)) & ~(uint64_t)(LISA_ARCHIVE_ALIGNMENT - 1);
+}
+
+
+/*!
+    Make sure the archive has space through \a end, reserving it on disk
+    where the platform allows so the data isn't fragmented as it's
+    written out of order.
+ */
+int
+lisa_archive_preallocate(int fd, uint64_t start, uint64_t end)
+{
+#if defined(__linux__)
+    int fallocate_err = posix_fallocate(fd, (off_t)start, (off_t)(end - start));
+    if (fallocate_err == ENOSPC) {
+        errno = ENOSPC;
+        return -1;
+    }
+#elif defined(__APPLE__)
+    fstore_t store = { F_ALLOCATEALL, F_PEOFPOSMODE, 0, (off_t)(end - start), 0 };
+    fcntl(fd, F_PREALLOCATE, &store);
+#else
+    (void)start;
+#endif
+
+    // Whether or not the space could be reserved, the file needs to be
+    // long enough to be written anywhere within it.
+    return ftruncate(fd, (off_t)end);
+}
+
+
+/*! Write all of \a buf at \a offset. */
+int
+lisa_archive_pwrite(int fd, const void *buf, size_t size, uint64_t offset)
+{
+    const uint8_t *bytes = buf;
+    size_t written = 0;
+
+    uint64_t write_start = lisa_stats_begin();
+
+    while (written < size) {
+        ssize_t n = pwrite(fd, &bytes[written], size - written, (off_t)(offset + written));
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        written += (size_t)n;
+    }
+
+    lisa_stats_end(lisa_stats_write, write_start, size, 0);
+
+    return 0;
+}
+
+
+int
+lisa_archive_entry_compare(const void *a, const void *b)
+{
+    const lisa_archive_entry *entry_a = a;
+    const lisa_archive_entry *entry_b = b;
+    return strcmp(entry_a->name, entry_b->name);
+}
+
+
+/*! Write the directory and trailer, and trim any unused preallocation. */
+int
+lisa_archive_write_directory(lisa_archive_writer *writer)
+{
+    if (writer->entry_count > 0) {
+        qsort(writer->entries, writer->entry_count, sizeof(lisa_archive_entry), lisa_archive_entry_compare);
+    }
+
+    size_t names_size = 0;
+    for (size_t e = 0; e < writer->entry_count; e++) {
+        names_size += strlen(writer->entries[e].name) + 1;
+    }
+
+    const size_t records_size = writer->entry_count * LISA_ARCHIVE_RECORD_SIZE;
+    const size_t directory_size = records_size + names_size;
+    const uint64_t directory_offset = lisa_archive_align(writer->data_end);
+
+    uint8_t *directory = calloc(directory_size + LISA_ARCHIVE_TRAILER_SIZE, 1);
+    if (directory == NULL) return -1;
+
+    uint32_t name_offset = 0;
+    for (size_t e = 0; e < writer->entry_count; e++) {
+        lisa_archive_entry *entry = &writer->entries[e];
+        uint8_t *record = &directory[e * LISA_ARCHIVE_RECORD_SIZE];
+        uint32_t name_length = (uint32_t)strlen(entry->name);
+
+        uint64_t offset_be = swapu64be(entry->offset);
+        uint64_t size_be = swapu64be(entry->size);
+        uint32_t name_offset_be = swapu32be(name_offset);
+        uint32_t name_length_be = swapu32be(name_length);
+        memcpy(&record[0], &offset_be, 8);
+        memcpy(&record[8], &size_be, 8);
+        memcpy(&record[16], &name_offset_be, 4);
+        memcpy(&record[20], &name_length_be, 4);
+
+        memcpy(&directory[records_size + name_offset], entry->name, name_length + 1);
+        name_offset += name_length + 1;
+    }
+
+    uint8_t *trailer = &directory[directory_size];
+    uint64_t directory_offset_be = swapu64be(directory_offset);
+    uint64_t entry_count_be = swapu64be((uint64_t)writer->entry_count);
+    uint64_t directory_size_be = swapu64be((uint64_t)directory_size);
+    memcpy(&trailer[0], LISA_ARCHIVE_DIRECTORY_MAGIC, 8);
+    memcpy(&trailer[8], &directory_offset_be, 8);
+    memcpy(&trailer[16], &entry_count_be, 8);
+    memcpy(&trailer[24], &directory_size_be, 8);
+
+    int write_err = lisa_archive_pwrite(writer->fd, directory, directory_size + LISA_ARCHIVE_TRAILER_SIZE,
+                                        directory_offset);
+    free(directory);
+    if (write_err == -1) return -1;
+
+    return ftruncate(writer->fd, (off_t)(directory_offset + directory_size + LISA_ARCHIVE_TRAILER_SIZE));
+}
+
+
+// MARK: - Archives
+
+lisa_archive_writer * LISA_NULLABLE
+lisa_archive_writer_create(const char *path)
+{
+    lisa_archive_writer *writer = calloc(sizeof(lisa_archive_writer), 1);
+    if (writer == NULL) return NULL;
+
+    writer->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (writer->fd == -1) {
+        free(writer);
+        return NULL;
+    }
+
+    pthread_mutex_init(&writer->lock, NULL);
+    writer->data_end = LISA_ARCHIVE_HEADER_SIZE;
+    writer->allocated = LISA_ARCHIVE_HEADER_SIZE;
+
+    uint8_t header[LISA_ARCHIVE_HEADER_SIZE] = { 0 };
+    uint32_t version_be = swapu32be(LISA_ARCHIVE_VERSION);
+    memcpy(&header[0], LISA_ARCHIVE_MAGIC, 8);
+    memcpy(&header[8], &version_be, 4);
+
+    int write_err = lisa_archive_pwrite(writer->fd, header, sizeof(header), 0);
+    if (write_err == -1) {
+        int write_errno = errno;
+        close(writer->fd);
+        pthread_mutex_destroy(&writer->lock);
+        free(writer);
+        errno = write_errno;
+        return NULL;
+    }
+
+    return writer;
+}
+
+
+int
+lisa_archive_writer_add_entries(lisa_archive_writer *writer, size_t count,
+                                const char * const *names, const uint64_t *sizes,
+                                uint64_t *offsets)
+{
+    int result = -1;
+
+    pthread_mutex_lock(&writer->lock);
+
+    if (writer->entry_count + count > writer->entry_capacity) {
+        size_t new_capacity = writer->entry_capacity ? writer->entry_capacity * 2 : 64;
+        while (new_capacity < writer->entry_count + count) new_capacity *= 2;
+        lisa_archive_entry *entries = realloc(writer->entries, sizeof(lisa_archive_entry) * new_capacity);
+        if (entries == NULL) goto done;
+        writer->entries = entries;
+        writer->entry_capacity = new_capacity;
+    }
+
+    // Lay out the entries one after another, so each batch of entries
+    // is written as one contiguous run.
+
+    uint64_t end = writer->data_end;
+    for (size_t e = 0; e < count; e++) {
+        offsets[e] = lisa_archive_align(end);
+        end = offsets[e] + sizes[e];
+    }
+
+    // Grow the preallocated space geometrically, so a stream of small
+    // additions doesn't turn into a stream of small allocations.
+
+    if (end > writer->allocated) {
+        uint64_t new_allocated = writer->allocated + writer->allocated / 2;
+        if (new_allocated < writer->allocated + LISA_ARCHIVE_MIN_PREALLOCATION) {
+            new_allocated = writer->allocated + LISA_ARCHIVE_MIN_PREALLOCATION;
+        }
+        if (new_allocated < end) new_allocated = end;
+
+        int preallocate_err = lisa_archive_preallocate(writer->fd, writer->allocated, new_allocated);
+        if (preallocate_err == -1) goto done;
+        writer->allocated = new_allocated;
+    }
+
+    writer->data_end = end;
+
+    for (size_t e = 0; e < count; e++) {
+        char *name = strdup(names[e]);
+        if (name == NULL) {
+            // Entries already added keep their space, but the caller
+            // has no offsets for them, so they stay empty.
+            goto done;
+        }
+        writer->entries[writer->entry_count].name = name;
+        writer->entries[writer->entry_count].offset = offsets[e];
+        writer->entries[writer->entry_count].size = sizes[e];
+        writer->entry_count += 1;
+    }
+
+    result = 0;
+
+done:
+    pthread_mutex_unlock(&writer->lock);
+    return result;
+}
+
+
+int
+lisa_archive_writer_write(lisa_archive_writer *writer, uint64_t offset,
+                          const void *buf, size_t size)
+{
+    int write_err = lisa_archive_pwrite(writer->fd, buf, size, offset);
+    if (write_err == -1) {
+        int write_errno = errno;
+        pthread_mutex_lock(&writer->lock);
+        if (writer->error == 0) writer->error = write_errno;
+        pthread_mutex_unlock(&writer->lock);
+        errno = write_errno;
+        return -1;
+    }
+
+    return 0;
+}
+
+
+int
+lisa_archive_writer_close(lisa_archive_writer *writer)
+{
+    int error = writer->error;
+
+    if (error == 0) {
+        int directory_err = lisa_archive_write_directory(writer);
+        if (directory_err == -1) error = errno;
+    }
+
+    int close_err = close(writer->fd);
+    if ((close_err == -1) && (error == 0)) error = errno;
+
+    for (size_t e = 0; e < writer->entry_count; e++) {
+        free(writer->entries[e].name);
+    }
+    free(writer->entries);
+    pthread_mutex_destroy(&writer->lock);
+    free(writer);
+
+    if (error != 0) {
+        errno = error;
+        return -1;
+    }
+
+    return 0;
+}
+
+
+LISA_SOURCE_END
@@ -0,0 +1,92 @@
+//  lisa_archive.h
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#ifndef __LISA__ARCHIVE__H__
+#define __LISA__ARCHIVE__H__
+
+#include <stddef.h>
+
+#include "lisa_defines.h"
+#include "lisa_types.h"
+
+LISA_HEADER_BEGIN
+
+
+/*!
+    An archive of extracted code, for writing many entries to a single
+    file rather than to a file apiece.
+
+    The format is uncompressed and meant to be mapped and read in place.
+    All integers are big-endian.
+
+    - A 16-byte header: the magic `LISAARC\0`, a 32-bit version (1), and
+      32 bits of zero.
+    - The entries' data, each starting on a 16-byte boundary.
+    - The directory: a 24-byte record per entry, sorted by name, holding
+      its 64-bit data offset, 64-bit size, 32-bit name offset and 32-bit
+      name length. The name offset is relative to the name table, which
+      immediately follows the records and holds each name followed by a
+      NUL.
+    - A 32-byte trailer: the magic `LISADIR\0`, then the 64-bit offset
+      of the directory, the 64-bit number of entries, and the 64-bit
+      size of the directory including its name table.
+ */
+struct lisa_archive_writer;
+typedef struct lisa_archive_writer lisa_archive_writer;
+
+
+#define LISA_ARCHIVE_MAGIC				"LISAARC"
+#define LISA_ARCHIVE_DIRECTORY_MAGIC	"LISADIR"
+#define LISA_ARCHIVE_VERSION			1
+#define LISA_ARCHIVE_HEADER_SIZE		16
+#define LISA_ARCHIVE_TRAILER_SIZE		32
+#define LISA_ARCHIVE_RECORD_SIZE		24
+#define LISA_ARCHIVE_ALIGNMENT			16
+
+
+/*! Create a new archive at \a path, replacing any file already there. */
+LISA_EXTERN
+lisa_archive_writer * LISA_NULLABLE
+lisa_archive_writer_create(const char *path);
+
+/*!
+    Add \a count entries with the given names and sizes to an archive,
+    getting back the offset where each entry's data must be written.
+    The entries' space is laid out contiguously and preallocated, so
+    their data can be written in any order and from any thread.
+
+    This may be called from multiple threads at once.
+ */
+LISA_EXTERN
+int
+lisa_archive_writer_add_entries(lisa_archive_writer *writer, size_t count,
+                                const char * const *names, const uint64_t *sizes,
+                                uint64_t *offsets);
+
+/*!
+    Write \a size bytes of an entry's data at \a offset, as returned by
+    `lisa_archive_writer_add_entries`.
+
+    This may be called from multiple threads at once.
+ */
+LISA_EXTERN
+int
+lisa_archive_writer_write(lisa_archive_writer *writer, uint64_t offset,
+                          const void *buf, size_t size);
+
+/*!
+    Write the directory and trailer of an archive, then close and free
+    it. Returns -1 if the archive couldn't be completed, or if any write
+    to it failed.
+ */
+LISA_EXTERN
+int
+lisa_archive_writer_close(lisa_archive_writer *writer);
+
+
+LISA_HEADER_END
+
+#endif /* __LISA__ARCHIVE__H__ */
@@ -0,0 +1,541 @@
+//  lisa_batch.c
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#include "lisa_batch.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "alloc_utils.h"
+#include "async_reader.h"
+#include "thread_pool.h"
+
+#include "lisa_stats.h"
+
+
+LISA_SOURCE_BEGIN
+
+
+// MARK: - Internals
+
+struct lisa_batch;
+typedef struct lisa_batch lisa_batch;
+
+/*! A single file of a batch, and its output until it's emitted. */
+struct lisa_batch_item {
+    lisa_batch			*batch;
+    const char			*path;
+    size_t				size;				//!< file size, as charged against the budget
+    bool				read_ahead;			//!< whether content was read before processing
+    bool				submitted;			//!< whether it's been handed to the pool
+    void				* LISA_NULLABLE content;
+    size_t				content_size;
+    int					read_error;
+    char				* LISA_NULLABLE output;
+    size_t				output_size;
+    int					result;
+    bool				done;
+};
+typedef struct lisa_batch_item lisa_batch_item;
+
+/*! State shared by every file of a batch. */
+struct lisa_batch {
+    lisa_batch_item		* LISA_NULLABLE items;
+    size_t				item_count;
+    lisa_batch_fn		fn;
+    void				* LISA_NULLABLE context;
+    FILE				*out;
+    const char			* LISA_NULLABLE separator;
+    size_t				max_bytes_in_flight;
+
+    pthread_mutex_t		lock;
+    pthread_cond_t		budget_available;	//!< signaled when bytes in flight drop
+    size_t				bytes_in_flight;
+    size_t				next_output;		//!< index of the next item to emit
+    bool				wrote_output;		//!< whether a separator is needed
+
+    size_t				reads_in_flight;
+    size_t				max_reads_in_flight;
+    uint64_t			read_depth_total;	//!< sum of reads in flight as each started
+    size_t				files_read;
+    uint64_t			bytes_read;
+
+    arena				* LISA_NULLABLE * LISA_NULLABLE arenas;	//!< one per worker, and one more for the calling thread
+    size_t				arena_count;
+};
+
+
+/*! Get the current time in seconds, for reporting. */
+double
+lisa_batch_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+
+/*! Note that a read has started; the batch must be locked. */
+void
+lisa_batch_read_started(lisa_batch *batch)
+{
+    batch->reads_in_flight += 1;
+    if (batch->reads_in_flight > batch->max_reads_in_flight) {
+        batch->max_reads_in_flight = batch->reads_in_flight;
+    }
+    batch->read_depth_total += batch->reads_in_flight;
+}
+
+
+/*! Note that a read has finished; the batch must be locked. */
+void
+lisa_batch_read_finished(lisa_batch *batch, size_t bytes)
+{
+    batch->reads_in_flight -= 1;
+    batch->files_read += 1;
+    batch->bytes_read += bytes;
+}
+
+
+/*! Open an item's file, reading it unless its content is already here. */
+lisa_objfile * LISA_NULLABLE
+lisa_batch_open_item(lisa_batch *batch, lisa_batch_item *item, const lisa_allocator * LISA_NULLABLE allocator)
+{
+    if (item->read_ahead) {
+        // The reader allocated the content, so it can't come from an
+        // arena, and neither can the rest or it'd be freed differently.
+
+        if (item->read_error != 0) {
+            errno = item->read_error;
+            return NULL;
+        }
+
+        void *content = item->content;
+        item->content = NULL;
+        return lisa_objfile_open_buffer(content, item->content_size);
+    }
+
+    pthread_mutex_lock(&batch->lock);
+    lisa_batch_read_started(batch);
+    pthread_mutex_unlock(&batch->lock);
+
+    lisa_objfile *of = lisa_objfile_open_with_allocator(item->path, allocator);
+    int open_errno = errno;
+
+    pthread_mutex_lock(&batch->lock);
+    lisa_batch_read_finished(batch, of ? lisa_objfile_size(of) : 0);
+    pthread_mutex_unlock(&batch->lock);
+
+    errno = open_errno;
+    return of;
+}
+
+
+/*! Open, process, and close a single file, on the given worker's arena if there are any. */
+int
+lisa_batch_run_item(lisa_batch *batch, lisa_batch_item *item, FILE *out, size_t worker_index)
+{
+    arena *a = (worker_index < batch->arena_count) ? batch->arenas[worker_index] : NULL;
+
+    lisa_objfile *of = lisa_batch_open_item(batch, item, a ? arena_allocator(a) : NULL);
+    int result = batch->fn(of, item->path, out, batch->context);
+    lisa_objfile_close(of);
+
+    if (a) arena_reset(a);
+    return result;
+}
+
+
+/*!
+    Emit the output of every finished item that's next in order; the
+    batch must be locked.
+ */
+void
+lisa_batch_emit_ready(lisa_batch *batch)
+{
+    while ((batch->next_output < batch->item_count) && batch->items[batch->next_output].done) {
+        lisa_batch_item *item = &batch->items[batch->next_output];
+
+        if (item->output_size > 0) {
+            if (batch->wrote_output && batch->separator) {
+                fputs(batch->separator, batch->out);
+            }
+            fwrite(item->output, item->output_size, 1, batch->out);
+            batch->wrote_output = true;
+        }
+
+        batch->bytes_in_flight -= item->output_size;
+        free(item->output);
+        item->output = NULL;
+        item->output_size = 0;
+
+        batch->next_output += 1;
+    }
+}
+
+
+/*! Process a single file; runs on a worker thread. */
+void
+lisa_batch_item_task(void * LISA_NULLABLE context, size_t worker_index)
+{
+    lisa_batch_item *item = context;
+    lisa_batch *batch = item->batch;
+
+    // Output is captured in memory until every earlier file's output has
+    // been emitted, so results come out in order however work is stolen.
+
+    FILE *out = open_memstream(&item->output, &item->output_size);
+    if (out == NULL) {
+        item->result = -1;
+    } else {
+        item->result = lisa_batch_run_item(batch, item, out, worker_index);
+        fclose(out);
+    }
+
+    // The content is normally owned by the object file by now, unless
+    // it was never opened.
+    free(item->content);
+    item->content = NULL;
+
+    pthread_mutex_lock(&batch->lock);
+    batch->bytes_in_flight -= item->size;
+    batch->bytes_in_flight += item->output_size;
+    item->done = true;
+    lisa_batch_emit_ready(batch);
+    pthread_cond_broadcast(&batch->budget_available);
+    pthread_mutex_unlock(&batch->lock);
+}
+
+
+/*!
+    Charge \a item's file size against the budget, waiting for room if
+    \a wait is true. Returns false if it doesn't fit and \a wait is false.
+ */
+bool
+lisa_batch_charge(lisa_batch *batch, lisa_batch_item *item, bool wait)
+{
+    bool charged = false;
+
+    pthread_mutex_lock(&batch->lock);
+    for (;;) {
+        if ((batch->bytes_in_flight == 0)
+            || (batch->bytes_in_flight + item->size <= batch->max_bytes_in_flight))
+        {
+            batch->bytes_in_flight += item->size;
+            charged = true;
+            break;
+        }
+        if (!wait) break;
+        pthread_cond_wait(&batch->budget_available, &batch->lock);
+    }
+    pthread_mutex_unlock(&batch->lock);
+
+    return charged;
+}
+
+
+/*! Set up \a item to process the file at \a path. */
+void
+lisa_batch_item_init(lisa_batch *batch, lisa_batch_item *item, const char *path)
+{
+    item->batch = batch;
+    item->path = path;
+
+    struct stat st;
+    item->size = (stat(path, &st) == 0) ? (size_t)st.st_size : 0;
+}
+
+
+/*! Hand an item to the pool, or process it here if it can't be queued. */
+void
+lisa_batch_submit_item(thread_pool *pool, lisa_batch_item *item)
+{
+    item->submitted = true;
+    int submit_err = thread_pool_submit(pool, lisa_batch_item_task, item);
+    if (submit_err == -1) {
+        // Skipping it would stall the output sequence. This thread isn't
+        // a worker, so it gets the arena after theirs.
+        lisa_batch_item_task(item, thread_pool_thread_count(pool));
+    }
+}
+
+
+/*!
+    Hand out every item in order, each waiting until it fits in the
+    budget. Everything before it has already been handed out, so the
+    output holding up the budget will always drain.
+ */
+void
+lisa_batch_submit_all(lisa_batch *batch, thread_pool *pool, const char * const *paths)
+{
+    for (size_t p = 0; p < batch->item_count; p++) {
+        lisa_batch_item *item = &batch->items[p];
+        lisa_batch_item_init(batch, item, paths[p]);
+        lisa_batch_charge(batch, item, true);
+        lisa_batch_submit_item(pool, item);
+    }
+}
+
+
+/*!
+    Read items ahead of the workers, keeping up to the reader's queue
+    depth of reads in flight and handing each item to the pool as soon
+    as its read finishes. Items are still started in order, so the
+    budget drains just as it does without reading ahead.
+ */
+void
+lisa_batch_read_all(lisa_batch *batch, thread_pool *pool, async_reader *reader, const char * const *paths)
+{
+    const size_t queue_depth = async_reader_queue_depth(reader);
+    size_t next = 0;
+    size_t pending = 0;
+    size_t initialized = 0;
+
+    for (;;) {
+        // Fill the queue as far as the budget allows. With nothing being
+        // read, only the workers can free up budget, so wait for them.
+
+        while ((next < batch->item_count) && (pending < queue_depth)) {
+            lisa_batch_item *item = &batch->items[next];
+            if (next == initialized) {
+                lisa_batch_item_init(batch, item, paths[next]);
+                item->read_ahead = true;
+                initialized += 1;
+            }
+
+            if (!lisa_batch_charge(batch, item, (pending == 0))) break;
+
+            int submit_err = async_reader_submit(reader, item->path, item);
+            if (submit_err == -1) {
+                item->read_ahead = false;
+                lisa_batch_submit_item(pool, item);
+            } else {
+                pending += 1;
+                pthread_mutex_lock(&batch->lock);
+                lisa_batch_read_started(batch);
+                pthread_mutex_unlock(&batch->lock);
+            }
+
+            next += 1;
+        }
+
+        if (pending > 0) {
+            // Reads overlap with everything else, so only the time
+            // spent waiting for them counts as reading.
+
+            async_read_result result;
+            uint64_t wait_start = lisa_stats_begin();
+            int wait_err = async_reader_wait(reader, &result);
+            if (wait_err == -1) break;
+            lisa_stats_end(lisa_stats_read, wait_start, 0, (result.error == 0) ? result.size : 0);
+            pending -= 1;
+
+            lisa_batch_item *item = result.context;
+            item->content = result.buffer;
+            item->content_size = result.size;
+            item->read_error = result.error;
+
+            pthread_mutex_lock(&batch->lock);
+            lisa_batch_read_finished(batch, result.size);
+            pthread_mutex_unlock(&batch->lock);
+
+            lisa_batch_submit_item(pool, item);
+            continue;
+        }
+
+        if (next == batch->item_count) break;
+    }
+
+    // If waiting failed, the reads still pending will never be handed
+    // over, so their items are read again by the workers instead; they
+    // hold budget and come first in the output, so they have to go first.
+
+    if (pending > 0) {
+        pthread_mutex_lock(&batch->lock);
+        batch->reads_in_flight -= pending;
+        pthread_mutex_unlock(&batch->lock);
+
+        for (size_t p = 0; p < next; p++) {
+            lisa_batch_item *item = &batch->items[p];
+            if (item->submitted) continue;
+            item->read_ahead = false;
+            lisa_batch_submit_item(pool, item);
+        }
+    }
+
+    // Then process whatever's left without reading ahead.
+    for (; next < batch->item_count; next++) {
+        lisa_batch_item *item = &batch->items[next];
+        if (next == initialized) {
+            lisa_batch_item_init(batch, item, paths[next]);
+            initialized += 1;
+        }
+        item->read_ahead = false;
+        lisa_batch_charge(batch, item, true);
+        lisa_batch_submit_item(pool, item);
+    }
+}
+
+
+// MARK: - Batches
+
+int
+lisa_batch_process(const char * const *paths, size_t path_count,
+                   lisa_batch_fn fn, void * LISA_NULLABLE context,
+                   FILE *out, const lisa_batch_options * LISA_NULLABLE options)
+{
+    lisa_batch_options default_options = { 0 };
+    if (options == NULL) options = &default_options;
+
+    const double start_time = lisa_batch_now();
+
+    size_t thread_count = options->thread_count ? options->thread_count : thread_pool_default_thread_count();
+    if (thread_count > path_count) thread_count = path_count;
+
+    lisa_batch batch = {
+        .items = NULL,
+        .item_count = path_count,
+        .fn = fn,
+        .context = context,
+        .out = out,
+        .separator = options->separator,
+        .max_bytes_in_flight = options->max_bytes_in_flight ? options->max_bytes_in_flight : LISA_BATCH_DEFAULT_MAX_BYTES_IN_FLIGHT,
+        .bytes_in_flight = 0,
+        .next_output = 0,
+        .wrote_output = false,
+    };
+    pthread_mutex_init(&batch.lock, NULL);
+    pthread_cond_init(&batch.budget_available, NULL);
+
+    const char *io_backend = "stdio";
+    int error = 0;
+    int status = 0;
+    thread_pool *pool = NULL;
+    async_reader *reader = NULL;
+
+    if (options->arena_size > 0) {
+        batch.arena_count = thread_count + 1;
+        batch.arenas = calloc(sizeof(arena *), batch.arena_count);
+        if (batch.arenas == NULL) {
+            error = ENOMEM;
+            goto done;
+        }
+        for (size_t a = 0; a < batch.arena_count; a++) {
+            batch.arenas[a] = arena_create(options->arena_size, lisa_default_allocator());
+            if (batch.arenas[a] == NULL) {
+                error = ENOMEM;
+                goto done;
+            }
+        }
+    }
+
+    if ((thread_count <= 1) && (options->io == lisa_batch_io_stdio)) {
+        // With only one thread there's nothing to reorder, so just run
+        // each file in turn. Output only needs capturing to know whether
+        // it's empty, for placing separators.
+
+        for (size_t p = 0; p < path_count; p++) {
+            lisa_batch_item item = { .batch = &batch, .path = paths[p] };
+            int result;
+
+            if (options->separator == NULL) {
+                result = lisa_batch_run_item(&batch, &item, out, 0);
+            } else {
+                FILE *item_out = open_memstream(&item.output, &item.output_size);
+                if (item_out == NULL) {
+                    error = errno;
+                    break;
+                }
+                result = lisa_batch_run_item(&batch, &item, item_out, 0);
+                fclose(item_out);
+
+                if (item.output_size > 0) {
+                    if (batch.wrote_output) fputs(options->separator, out);
+                    fwrite(item.output, item.output_size, 1, out);
+                    batch.wrote_output = true;
+                }
+                free(item.output);
+            }
+
+            if ((status == 0) && (result != 0)) status = result;
+        }
+
+        goto done;
+    }
+
+    batch.items = calloc(sizeof(lisa_batch_item), path_count + 1);
+    if (batch.items == NULL) {
+        error = ENOMEM;
+        goto done;
+    }
+
+    pool = thread_pool_create(thread_count);
+    if (pool == NULL) {
+        error = ENOMEM;
+        goto done;
+    }
+
+    if (options->io == lisa_batch_io_stdio) {
+        lisa_batch_submit_all(&batch, pool, paths);
+    } else {
+        async_reader_backend backend = (options->io == lisa_batch_io_threads)
+            ? async_reader_backend_threads : async_reader_backend_any;
+        reader = async_reader_create(options->queue_depth, backend);
+        if (reader == NULL) {
+            error = ENOMEM;
+            goto done;
+        }
+        io_backend = async_reader_backend_name(async_reader_get_backend(reader));
+
+        lisa_batch_read_all(&batch, pool, reader, paths);
+    }
+
+    thread_pool_wait(pool);
+
+    for (size_t p = 0; p < path_count; p++) {
+        if (batch.items[p].result != 0) {
+            status = batch.items[p].result;
+            break;
+        }
+    }
+
+done:
+    async_reader_free(reader);
+    thread_pool_free(pool);
+    free(batch.items);
+
+    if (batch.arenas) {
+        for (size_t a = 0; a < batch.arena_count; a++) arena_free(batch.arenas[a]);
+        free(batch.arenas);
+    }
+
+    if (options->stats) {
+        lisa_batch_stats *stats = options->stats;
+        stats->io_backend = io_backend;
+        stats->files_read = batch.files_read;
+        stats->bytes_read = batch.bytes_read;
+        stats->seconds = lisa_batch_now() - start_time;
+        stats->max_queue_depth = batch.max_reads_in_flight;
+        stats->mean_queue_depth = batch.files_read ? ((double)batch.read_depth_total / (double)batch.files_read) : 0.0;
+    }
+
+    pthread_cond_destroy(&batch.budget_available);
+    pthread_mutex_destroy(&batch.lock);
+
+    if (error != 0) {
+        errno = error;
+        return -1;
+    }
+
+    return status;
+}
+
+
+LISA_SOURCE_END
@@ -0,0 +1,105 @@
+//  lisa_batch.h
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#ifndef __LISA__BATCH__H__
+#define __LISA__BATCH__H__
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "lisa_defines.h"
+#include "lisa_types.h"
+
+#include "lisa_objio.h"
+
+LISA_HEADER_BEGIN
+
+
+/*! How a batch reads its files. */
+enum lisa_batch_io: uint32_t {
+    lisa_batch_io_stdio		= 0,	//!< each worker reads the file it's about to process
+    lisa_batch_io_async		= 1,	//!< reads are kept in flight ahead of the workers, via io_uring if available
+    lisa_batch_io_threads	= 2,	//!< like async, but always with blocking reads on their own threads
+};
+typedef enum lisa_batch_io lisa_batch_io;
+
+
+/*! What happened while processing a batch, for reporting. */
+struct lisa_batch_stats {
+    const char			*io_backend;		//!< "stdio", "io_uring" or "threads"
+    size_t				files_read;
+    uint64_t			bytes_read;
+    double				seconds;			//!< wall-clock time for the whole batch
+    size_t				max_queue_depth;	//!< most reads in flight at once
+    double				mean_queue_depth;	//!< reads in flight, averaged as each read starts
+};
+typedef struct lisa_batch_stats lisa_batch_stats;
+
+
+/*! Options for processing a batch of object files. */
+struct lisa_batch_options {
+    size_t				thread_count;		//!< worker threads to use, 0 for one per CPU
+    size_t				max_bytes_in_flight;	//!< bound on file and output bytes held at once, 0 for the default
+    const char			* LISA_NULLABLE separator;	//!< written between consecutive non-empty outputs
+    lisa_batch_io		io;
+    size_t				queue_depth;		//!< reads to keep in flight for async I/O, 0 for the default
+    lisa_batch_stats	* LISA_NULLABLE stats;	//!< filled in once the batch is done, if given
+    size_t				arena_size;			//!< give each worker an arena with chunks this big for opening files, 0 for none
+};
+typedef struct lisa_batch_options lisa_batch_options;
+
+/*! The default bound on bytes held in memory by a batch, 256MB. */
+#define LISA_BATCH_DEFAULT_MAX_BYTES_IN_FLIGHT ((size_t)256 * 1024 * 1024)
+
+
+/*!
+    Processes one object file of a batch. Anything written to \a out is
+    emitted in the order the paths were given, regardless of the order
+    the files are processed in.
+
+    \a of is NULL if the file at \a path couldn't be opened, with errno
+    set, so the function can report that however it likes. The file is
+    closed once this returns.
+
+    Returns 0 for success, or a nonzero status of the caller's choosing.
+ */
+typedef int (*lisa_batch_fn)(lisa_objfile * LISA_NULLABLE of, const char *path,
+                             FILE *out, void * LISA_NULLABLE context);
+
+
+/*!
+    Opens, processes with \a fn, and closes each of the \a path_count
+    object files in \a paths, writing their output to \a out in order.
+
+    Files are processed concurrently on a work-stealing thread pool.
+    With async I/O, the calling thread keeps the options' `queue_depth`
+    reads in flight and hands each file to the pool as soon as it's been
+    read, so parsing overlaps with the reads still pending.
+
+    With an `arena_size`, each worker opens its files with its own
+    arena, which is reset once each file is done with, so files stop
+    costing allocations once the arenas have grown to fit them. Files
+    read ahead still need their content allocated by the reader.
+
+    Files aren't started while the sizes of the files being processed
+    plus the output waiting on earlier files would exceed the options'
+    `max_bytes_in_flight`, unless nothing else is in flight, so memory
+    stays bounded however many files there are.
+
+    Returns the first nonzero status from \a fn, in path order, or 0 if
+    every file succeeded. Returns -1 with errno set if the batch itself
+    couldn't be run.
+ */
+LISA_EXTERN
+int
+lisa_batch_process(const char * const *paths, size_t path_count,
+                   lisa_batch_fn fn, void * LISA_NULLABLE context,
+                   FILE *out, const lisa_batch_options * LISA_NULLABLE options);
+
+
+LISA_HEADER_END
+
+#endif /* __LISA__BATCH__H__ */
@@ -0,0 +1,580 @@
+//  lisa_checksum.c
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#include "lisa_checksum.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "file_utils.h"
+#include "hash_utils.h"
+
+
+LISA_SOURCE_BEGIN
+
+
+// MARK: - Internals
+
+/*! The checksums of a single file in a manifest. */
+struct lisa_checksum_file {
+    char				*path;
+    lisa_checksum		* LISA_NULLABLE checksums;
+    size_t				count;
+    size_t				sequence;		//!< when it was set, so the last one set wins
+};
+typedef struct lisa_checksum_file lisa_checksum_file;
+
+struct lisa_checksum_manifest {
+    lisa_checksum_file	* LISA_NULLABLE files;
+    size_t				count;
+    size_t				capacity;
+    size_t				next_sequence;
+    bool				sorted;			//!< by path, with only one set of checksums for each
+    pthread_mutex_t		lock;
+};
+
+
+/*! Make sure \a buffer can hold \a size bytes. */
+int
+lisa_checksum_reserve(uint8_t * LISA_NULLABLE * LISA_NONNULL buffer, size_t *capacity, size_t size)
+{
+    if (*capacity >= size) return 0;
+
+    uint8_t *grown = realloc(*buffer, size);
+    if (grown == NULL) return -1;
+    *buffer = grown;
+    *capacity = size;
+    return 0;
+}
+
+
+/*! Fill in the sums of \a size bytes at \a buf. */
+void
+lisa_checksum_compute(lisa_checksum *checksum, const uint8_t *buf, size_t size)
+{
+    checksum->size = size;
+    checksum->crc32c = hash_crc32c(0, buf, size);
+    checksum->xxh64 = hash_xxh64(buf, size, 0);
+}
+
+
+/*! Order files by path, then by when they were set. */
+int
+lisa_checksum_file_compare(const void *a, const void *b)
+{
+    const lisa_checksum_file *file_a = a;
+    const lisa_checksum_file *file_b = b;
+
+    int path_order = strcmp(file_a->path, file_b->path);
+    if (path_order != 0) return path_order;
+    return (file_a->sequence > file_b->sequence) - (file_a->sequence < file_b->sequence);
+}
+
+
+/*! Order checksums by kind, then by index. */
+int
+lisa_checksum_order(const lisa_checksum *a, const lisa_checksum *b)
+{
+    if (a->kind != b->kind) return (a->kind > b->kind) ? 1 : -1;
+    return (a->index > b->index) - (a->index < b->index);
+}
+
+
+/*! Order checksums by kind, then by index, for qsort. */
+int
+lisa_checksum_compare(const void *a, const void *b)
+{
+    return lisa_checksum_order(a, b);
+}
+
+
+/*! Free a file's path and checksums. */
+void
+lisa_checksum_file_free(lisa_checksum_file *file)
+{
+    free(file->path);
+    free(file->checksums);
+}
+
+
+/*!
+    Sort a manifest's files by path, keeping only the last checksums set
+    for each. The manifest must be locked, or not shared yet.
+ */
+void
+lisa_checksum_manifest_sort(lisa_checksum_manifest *manifest)
+{
+    if (manifest->sorted) return;
+
+    qsort(manifest->files, manifest->count, sizeof(lisa_checksum_file), lisa_checksum_file_compare);
+
+    size_t kept = 0;
+    for (size_t f = 0; f < manifest->count; f++) {
+        bool superseded = (f + 1 < manifest->count)
+                          && (strcmp(manifest->files[f].path, manifest->files[f + 1].path) == 0);
+        if (superseded) {
+            lisa_checksum_file_free(&manifest->files[f]);
+        } else {
+            manifest->files[kept++] = manifest->files[f];
+        }
+    }
+    manifest->count = kept;
+    manifest->sorted = true;
+}
+
+
+/*!
+    Add a file to a manifest, taking ownership of \a path and
+    \a checksums whether or not it succeeds. The manifest must be
+    locked, or not shared yet.
+ */
+int
+lisa_checksum_manifest_add(lisa_checksum_manifest *manifest, char *path,
+                           lisa_checksum * LISA_NULLABLE checksums, size_t count)
+{
+    if (manifest->count == manifest->capacity) {
+        size_t new_capacity = manifest->capacity ? manifest->capacity * 2 : 64;
+        lisa_checksum_file *files = realloc(manifest->files, sizeof(lisa_checksum_file) * new_capacity);
+        if (files == NULL) {
+            free(path);
+            free(checksums);
+            return -1;
+        }
+        manifest->files = files;
+        manifest->capacity = new_capacity;
+    }
+
+    manifest->files[manifest->count++] = (lisa_checksum_file){
+        .path = path,
+        .checksums = checksums,
+        .count = count,
+        .sequence = manifest->next_sequence++,
+    };
+    manifest->sorted = false;
+    return 0;
+}
+
+
+/*!
+    Parse a manifest line into \a checksum, leaving \a path pointing at
+    the path at its end. Returns false for a line that isn't a checksum.
+ */
+bool
+lisa_checksum_parse_line(char *line, lisa_checksum *checksum, char **path)
+{
+    char *end;
+    *checksum = (lisa_checksum){ 0 };
+
+    char *crc_start = line;
+    unsigned long long crc = strtoull(crc_start, &end, 16);
+    if ((end == crc_start) || (*end != ' ') || (crc > UINT32_MAX)) return false;
+    checksum->crc32c = (uint32_t)crc;
+
+    char *xxh_start = end + 1;
+    checksum->xxh64 = strtoull(xxh_start, &end, 16);
+    if ((end == xxh_start) || (*end != ' ')) return false;
+
+    char *size_start = end + 1;
+    checksum->size = strtoull(size_start, &end, 10);
+    if ((end == size_start) || (*end != ' ')) return false;
+
+    char *kind_start = end + 1;
+    char *kind_end = strchr(kind_start, ' ');
+    if (kind_end == NULL) return false;
+    *kind_end = '\0';
+    if (strcmp(kind_start, lisa_checksum_kind_string(lisa_checksum_block)) == 0) {
+        checksum->kind = lisa_checksum_block;
+    } else if (strcmp(kind_start, lisa_checksum_kind_string(lisa_checksum_segment)) == 0) {
+        checksum->kind = lisa_checksum_segment;
+    } else {
+        return false;
+    }
+
+    char *index_start = kind_end + 1;
+    unsigned long long index = strtoull(index_start, &end, 10);
+    if ((end == index_start) || (*end != ' ') || (index > UINT32_MAX)) return false;
+    checksum->index = (uint32_t)index;
+
+    char *name_start = end + 1;
+    char *name_end = strchr(name_start, ' ');
+    if ((name_end == NULL) || (name_end == name_start)) return false;
+    if ((size_t)(name_end - name_start) >= sizeof(checksum->name)) return false;
+    memcpy(checksum->name, name_start, (size_t)(name_end - name_start));
+
+    *path = name_end + 1;
+    return (**path != '\0');
+}
+
+
+/*! Find the checksums of the file at \a path in a sorted manifest. */
+lisa_checksum_file * LISA_NULLABLE
+lisa_checksum_manifest_find(lisa_checksum_manifest *manifest, const char *path)
+{
+    if (manifest->count == 0) return NULL;
+
+    size_t lo = 0, hi = manifest->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int order = strcmp(manifest->files[mid].path, path);
+        if (order == 0) return &manifest->files[mid];
+        if (order < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return NULL;
+}
+
+
+// MARK: - Checksums
+
+const char *
+lisa_checksum_kind_string(lisa_checksum_kind kind)
+{
+    switch (kind) {
+        case lisa_checksum_block:	return "block";
+        case lisa_checksum_segment:	return "segment";
+    }
+    return "unknown";
+}
+
+
+int
+lisa_objfile_checksums(lisa_objfile *of, lisa_checksum * LISA_NULLABLE * LISA_NONNULL checksums, size_t *count)
+{
+    int result = -1;
+    uint8_t *buffer = NULL;
+    size_t buffer_capacity = 0;
+
+    const lisa_integer block_count = lisa_objfile_block_count(of);
+    const lisa_integer segment_count = lisa_objfile_segment_count(of);
+
+    *checksums = NULL;
+    *count = 0;
+
+    lisa_checksum *sums = calloc(sizeof(lisa_checksum), (size_t)block_count + (size_t)segment_count + 1);
+    if (sums == NULL) goto done;
+    size_t sum_count = 0;
+
+    // Blocks are encoded back to big-endian, as they're stored, since
+    // they've been swapped in memory.
+
+    for (lisa_integer b = 0; b < block_count; b++) {
+        lisa_objfile_block *block = lisa_objfile_block_at_index(of, b);
+        lisa_obj_block_type type = lisa_objfile_block_type(block);
+        lisa_longint size = lisa_objfile_block_size(block);
+        if ((type == EOFMark) || (size < 4)) continue;
+
+        if (lisa_checksum_reserve(&buffer, &buffer_capacity, (size_t)size) == -1) goto done;
+        int encode_err = lisa_obj_block_encode(type, lisa_objfile_block_content(block).data, size - 4, buffer);
+        if (encode_err == -1) goto done;
+
+        lisa_checksum *checksum = &sums[sum_count++];
+        checksum->kind = lisa_checksum_block;
+        checksum->index = (uint32_t)b;
+        strlcpy(checksum->name, lisa_obj_block_type_string(type), sizeof(checksum->name));
+        lisa_checksum_compute(checksum, buffer, (size_t)size);
+    }
+
+    // Then each segment's code is unpacked, with at most twice as many
+    // bytes as it has packed, whatever it claims.
+
+    for (lisa_integer s = 0; s < segment_count; s++) {
+        lisa_segment segment;
+        if (lisa_objfile_segment_at_index(of, s, &segment) == -1) goto done;
+
+        if ((segment.unpacked_size < 0)
+            || (segment.packed && (segment.unpacked_size > segment.code_size * 2)))
+        {
+            errno = EINVAL;
+            goto done;
+        }
+
+        lisa_longint unpacked_size = (segment.unpacked_size > segment.code_size)
+                                     ? segment.unpacked_size : segment.code_size;
+        if (lisa_checksum_reserve(&buffer, &buffer_capacity, (size_t)unpacked_size + 2) == -1) goto done;
+        if (lisa_segment_unpack(&segment, buffer, &unpacked_size) == -1) goto done;
+
+        lisa_checksum *checksum = &sums[sum_count++];
+        checksum->kind = lisa_checksum_segment;
+        checksum->index = (uint32_t)s;
+        strlcpy(checksum->name, segment.name[0] ? segment.name : "-", sizeof(checksum->name));
+        lisa_checksum_compute(checksum, buffer, (size_t)unpacked_size);
+    }
+
+    *checksums = sums;
+    *count = sum_count;
+    sums = NULL;
+    result = 0;
+
+done:
+    {
+        int checksum_errno = errno;
+        free(sums);
+        free(buffer);
+        errno = checksum_errno;
+    }
+    return result;
+}
+
+
+// MARK: - Manifests
+
+lisa_checksum_manifest * LISA_NULLABLE
+lisa_checksum_manifest_create(void)
+{
+    lisa_checksum_manifest *manifest = calloc(sizeof(lisa_checksum_manifest), 1);
+    if (manifest == NULL) return NULL;
+
+    manifest->sorted = true;
+    pthread_mutex_init(&manifest->lock, NULL);
+    return manifest;
+}
+
+
+void
+lisa_checksum_manifest_free(lisa_checksum_manifest * LISA_NULLABLE manifest)
+{
+    if (manifest) {
+        for (size_t f = 0; f < manifest->count; f++) {
+            lisa_checksum_file_free(&manifest->files[f]);
+        }
+        free(manifest->files);
+        pthread_mutex_destroy(&manifest->lock);
+        free(manifest);
+    }
+}
+
+
+lisa_checksum_manifest * LISA_NULLABLE
+lisa_checksum_manifest_read(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL) return NULL;
+
+    lisa_checksum_manifest *manifest = lisa_checksum_manifest_create();
+    if (manifest == NULL) {
+        fclose(f);
+        return NULL;
+    }
+
+    int result = -1;
+    char *line = NULL;
+    size_t line_capacity = 0;
+    ssize_t length;
+
+    char *file_path = NULL;
+    lisa_checksum *checksums = NULL;
+    size_t count = 0;
+    size_t capacity = 0;
+
+    length = getline(&line, &line_capacity, f);
+    if (length <= 0) {
+        if (!ferror(f)) errno = EINVAL;
+        goto done;
+    }
+    if (line[length - 1] == '\n') line[length - 1] = '\0';
+    if (strcmp(line, LISA_CHECKSUM_MANIFEST_HEADER) != 0) {
+        errno = EINVAL;
+        goto done;
+    }
+
+    // Each file's checksums are on consecutive lines, so they're
+    // gathered until the path changes. Lines that don't look like
+    // checksums are ignored.
+
+    while ((length = getline(&line, &line_capacity, f)) > 0) {
+        if (line[length - 1] == '\n') line[length - 1] = '\0';
+
+        lisa_checksum checksum;
+        char *line_path;
+        if (!lisa_checksum_parse_line(line, &checksum, &line_path)) continue;
+
+        if ((file_path == NULL) || (strcmp(file_path, line_path) != 0)) {
+            if (file_path) {
+                qsort(checksums, count, sizeof(lisa_checksum), lisa_checksum_compare);
+                int add_err = lisa_checksum_manifest_add(manifest, file_path, checksums, count);
+                file_path = NULL;
+                checksums = NULL;
+                if (add_err == -1) goto done;
+            }
+
+            file_path = strdup(line_path);
+            if (file_path == NULL) goto done;
+            count = 0;
+            capacity = 0;
+        }
+
+        if (count == capacity) {
+            size_t new_capacity = capacity ? capacity * 2 : 64;
+            lisa_checksum *grown = realloc(checksums, sizeof(lisa_checksum) * new_capacity);
+            if (grown == NULL) goto done;
+            checksums = grown;
+            capacity = new_capacity;
+        }
+        checksums[count++] = checksum;
+    }
+    if (ferror(f)) goto done;
+
+    if (file_path) {
+        qsort(checksums, count, sizeof(lisa_checksum), lisa_checksum_compare);
+        int add_err = lisa_checksum_manifest_add(manifest, file_path, checksums, count);
+        file_path = NULL;
+        checksums = NULL;
+        if (add_err == -1) goto done;
+    }
+
+    lisa_checksum_manifest_sort(manifest);
+    result = 0;
+
+done:
+    {
+        int read_errno = errno;
+        free(file_path);
+        free(checksums);
+        free(line);
+        fclose(f);
+        if (result == -1) {
+            lisa_checksum_manifest_free(manifest);
+            manifest = NULL;
+        }
+        errno = read_errno;
+    }
+    return manifest;
+}
+
+
+int
+lisa_checksum_manifest_fwrite(lisa_checksum_manifest *manifest, FILE *f)
+{
+    pthread_mutex_lock(&manifest->lock);
+    lisa_checksum_manifest_sort(manifest);
+
+    fprintf(f, "%s" "\n", LISA_CHECKSUM_MANIFEST_HEADER);
+    for (size_t i = 0; i < manifest->count; i++) {
+        lisa_checksum_file *file = &manifest->files[i];
+        for (size_t c = 0; c < file->count; c++) {
+            lisa_checksum *checksum = &file->checksums[c];
+            fprintf(f, "%08" PRIx32 " " "%016" PRIx64 " " "%" PRIu64 " " "%s" " " "%" PRIu32 " " "%s" " " "%s" "\n",
+                    checksum->crc32c, checksum->xxh64, checksum->size,
+                    lisa_checksum_kind_string(checksum->kind), checksum->index, checksum->name,
+                    file->path);
+        }
+    }
+
+    pthread_mutex_unlock(&manifest->lock);
+    return ferror(f) ? -1 : 0;
+}
+
+
+/*! Write the manifest given as \a context to \a f, for `write_file_atomically`. */
+int
+lisa_checksum_manifest_file_writer(FILE *f, void * LISA_NULLABLE context)
+{
+    return lisa_checksum_manifest_fwrite(context, f);
+}
+
+
+int
+lisa_checksum_manifest_write(lisa_checksum_manifest *manifest, const char *path)
+{
+    return write_file_atomically(path, lisa_checksum_manifest_file_writer, manifest);
+}
+
+
+int
+lisa_checksum_manifest_set(lisa_checksum_manifest *manifest, const char *path,
+                           const lisa_checksum *checksums, size_t count)
+{
+    char *path_copy = strdup(path);
+    if (path_copy == NULL) return -1;
+
+    lisa_checksum *checksums_copy = calloc(sizeof(lisa_checksum), count + 1);
+    if (checksums_copy == NULL) {
+        free(path_copy);
+        return -1;
+    }
+    memcpy(checksums_copy, checksums, sizeof(lisa_checksum) * count);
+    qsort(checksums_copy, count, sizeof(lisa_checksum), lisa_checksum_compare);
+
+    pthread_mutex_lock(&manifest->lock);
+    int add_err = lisa_checksum_manifest_add(manifest, path_copy, checksums_copy, count);
+    int add_errno = errno;
+    pthread_mutex_unlock(&manifest->lock);
+
+    errno = add_errno;
+    return add_err;
+}
+
+
+size_t
+lisa_checksum_manifest_file_count(lisa_checksum_manifest *manifest)
+{
+    pthread_mutex_lock(&manifest->lock);
+    lisa_checksum_manifest_sort(manifest);
+    size_t count = manifest->count;
+    pthread_mutex_unlock(&manifest->lock);
+    return count;
+}
+
+
+int
+lisa_checksum_manifest_compare(lisa_checksum_manifest *manifest, const char *path,
+                               const lisa_checksum *checksums, size_t count,
+                               lisa_checksum_difference_fn fn, void * LISA_NULLABLE context,
+                               size_t * LISA_NULLABLE differences)
+{
+    pthread_mutex_lock(&manifest->lock);
+    lisa_checksum_manifest_sort(manifest);
+    lisa_checksum_file *file = lisa_checksum_manifest_find(manifest, path);
+    pthread_mutex_unlock(&manifest->lock);
+
+    if (file == NULL) {
+        errno = ENOENT;
+        return -1;
+    }
+
+    // Both sides are in order, so they're merged, matching checksums up
+    // by kind and index.
+
+    size_t difference_count = 0;
+    size_t e = 0, a = 0;
+    while ((e < file->count) || (a < count)) {
+        const lisa_checksum *expected = (e < file->count) ? &file->checksums[e] : NULL;
+        const lisa_checksum *actual = (a < count) ? &checksums[a] : NULL;
+
+        int order = (expected && actual) ? lisa_checksum_order(expected, actual) : (expected ? -1 : 1);
+        if (order < 0) {
+            fn(lisa_checksum_missing, path, expected, NULL, context);
+            difference_count += 1;
+            e += 1;
+        } else if (order > 0) {
+            fn(lisa_checksum_added, path, NULL, actual, context);
+            difference_count += 1;
+            a += 1;
+        } else {
+            if ((expected->size != actual->size) || (expected->crc32c != actual->crc32c)
+                || (expected->xxh64 != actual->xxh64) || (strcmp(expected->name, actual->name) != 0))
+            {
+                fn(lisa_checksum_changed, path, expected, actual, context);
+                difference_count += 1;
+            }
+            e += 1;
+            a += 1;
+        }
+    }
+
+    if (differences) *differences = difference_count;
+    return 0;
+}
+
+
+LISA_SOURCE_END
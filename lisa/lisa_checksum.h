@@ -0,0 +1,164 @@
+//  lisa_checksum.h
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#ifndef __LISA__CHECKSUM__H__
+#define __LISA__CHECKSUM__H__
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "lisa_defines.h"
+#include "lisa_types.h"
+
+#include "lisa_objio.h"
+
+LISA_HEADER_BEGIN
+
+
+/*! What a checksum is of. */
+enum lisa_checksum_kind: uint32_t {
+    lisa_checksum_block		= 0,	//!< a block as stored, header and all
+    lisa_checksum_segment	= 1,	//!< a segment's code once unpacked
+};
+typedef enum lisa_checksum_kind lisa_checksum_kind;
+
+
+/*!
+    The checksums of a single block or segment: its CRC32C, for checking
+    with other tools, and its XXH64, which is far less likely to miss a
+    change. Blocks are checksummed as they're stored in the file, in
+    big-endian order, so checksums are the same on any host.
+ */
+struct lisa_checksum {
+    lisa_checksum_kind	kind;
+    uint32_t			index;			//!< of the block, or of the segment
+    char				name[24];		//!< the block's type, or the segment's name
+    uint64_t			size;			//!< of what was checksummed
+    uint32_t			crc32c;
+    uint64_t			xxh64;
+};
+typedef struct lisa_checksum lisa_checksum;
+
+
+/*!
+    Checksum every block of \a of and every segment's unpacked code, in
+    a single pass over the file, giving blocks and then segments in
+    order. The caller must free \a checksums.
+
+    Fails with EINVAL if a segment's code can't be unpacked.
+ */
+LISA_EXTERN
+int
+lisa_objfile_checksums(lisa_objfile *of, lisa_checksum * LISA_NULLABLE * LISA_NONNULL checksums, size_t *count);
+
+
+/*!
+    The checksums of any number of object files, by path. (Opaque!)
+
+    A manifest can be written to a file and read back, and is text: a
+    `lisa-checksum-manifest 1` header, then a line per checksum giving
+    its CRC32C and XXH64 in hex, its size, its kind (`block` or
+    `segment`), its index, its name, and the path of its file, separated
+    by spaces. Lines are sorted by path, then by kind and index, so
+    manifests can be compared with diff(1), and any file can be checked
+    against a manifest without the others.
+ */
+struct lisa_checksum_manifest;
+typedef struct lisa_checksum_manifest lisa_checksum_manifest;
+
+#define LISA_CHECKSUM_MANIFEST_HEADER	"lisa-checksum-manifest 1"
+
+
+/*! How a file's checksums differ from those in a manifest. */
+enum lisa_checksum_difference: uint32_t {
+    lisa_checksum_changed	= 0,	//!< in both, but different
+    lisa_checksum_missing	= 1,	//!< only in the manifest
+    lisa_checksum_added		= 2,	//!< only in the file
+};
+typedef enum lisa_checksum_difference lisa_checksum_difference;
+
+
+/*!
+    Called by `lisa_checksum_manifest_compare` for each difference, in
+    order, given what the manifest has and what the file has, either of
+    which may be missing.
+ */
+typedef void (*lisa_checksum_difference_fn)(lisa_checksum_difference difference, const char *path,
+                                            const lisa_checksum * LISA_NULLABLE expected,
+                                            const lisa_checksum * LISA_NULLABLE actual,
+                                            void * LISA_NULLABLE context);
+
+
+/*! Create an empty manifest. */
+LISA_EXTERN
+lisa_checksum_manifest * LISA_NULLABLE
+lisa_checksum_manifest_create(void);
+
+/*! Read a manifest from the file at \a path; fails with EINVAL if it isn't one. */
+LISA_EXTERN
+lisa_checksum_manifest * LISA_NULLABLE
+lisa_checksum_manifest_read(const char *path);
+
+/*!
+    Write a manifest to the file at \a path, by way of a temporary file
+    so an interrupted write doesn't leave a truncated manifest behind.
+ */
+LISA_EXTERN
+int
+lisa_checksum_manifest_write(lisa_checksum_manifest *manifest, const char *path);
+
+/*! Write a manifest to \a f. */
+LISA_EXTERN
+int
+lisa_checksum_manifest_fwrite(lisa_checksum_manifest *manifest, FILE *f);
+
+/*! Free a manifest. */
+LISA_EXTERN
+void
+lisa_checksum_manifest_free(lisa_checksum_manifest * LISA_NULLABLE manifest);
+
+/*!
+    Set the checksums of the file at \a path, replacing any the manifest
+    already had for it. The checksums are copied.
+
+    This may be called from multiple threads at once.
+ */
+LISA_EXTERN
+int
+lisa_checksum_manifest_set(lisa_checksum_manifest *manifest, const char *path,
+                           const lisa_checksum *checksums, size_t count);
+
+/*! Get the number of files in a manifest. */
+LISA_EXTERN
+size_t
+lisa_checksum_manifest_file_count(lisa_checksum_manifest *manifest);
+
+/*!
+    Compare the checksums of the file at \a path with the manifest's,
+    calling \a fn for each difference. The checksums must be in the
+    order `lisa_objfile_checksums` gives them. If \a differences is
+    given, it's set to how many there were.
+
+    Fails with ENOENT if the manifest has nothing for \a path. This may be
+    called from multiple threads at once, but not while checksums are
+    still being set.
+ */
+LISA_EXTERN
+int
+lisa_checksum_manifest_compare(lisa_checksum_manifest *manifest, const char *path,
+                               const lisa_checksum *checksums, size_t count,
+                               lisa_checksum_difference_fn fn, void * LISA_NULLABLE context,
+                               size_t * LISA_NULLABLE differences);
+
+/*! Get the name of a kind of checksum, as written in manifests. */
+LISA_EXTERN
+const char *
+lisa_checksum_kind_string(lisa_checksum_kind kind);
+
+
+LISA_HEADER_END
+
+#endif /* __LISA__CHECKSUM__H__ */
@@ -0,0 +1,671 @@
+//  lisa_diff.c
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#include "lisa_diff.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hash_utils.h"
+#include "lisa_symbols.h"
+
+
+LISA_SOURCE_BEGIN
+
+
+// MARK: - Internals
+
+/*! The multiplier for Fibonacci hashing of window hashes into slots. */
+#define LISA_DIFF_FIBONACCI		0x9E3779B97F4A7C15ULL
+
+/*! How far along a chain of windows with the same slot to look for a match. */
+#define LISA_DIFF_CHAIN_LIMIT	32
+
+
+/*! A block to compare, with what it's matched on. */
+struct lisa_diff_block {
+    uint64_t			key;			//!< module name, big-endian so keys sort by name; 0 outside any
+    uint32_t			occurrence;		//!< of the module's name, from 0
+    uint32_t			type;
+    uint32_t			ordinal;		//!< among the module's blocks of the type
+    lisa_integer		index;
+    uint64_t			hash;			//!< of the block's content
+};
+typedef struct lisa_diff_block lisa_diff_block;
+
+
+/*! One of the two files being compared. */
+struct lisa_diff_side {
+    lisa_objfile		*of;
+    lisa_diff_block		* LISA_NULLABLE blocks;
+    size_t				block_count;
+    uint8_t				* LISA_NULLABLE code;	//!< unpacked code of the segment being compared
+    size_t				code_capacity;
+};
+typedef struct lisa_diff_side lisa_diff_side;
+
+
+/*! The state of a comparison in progress. */
+struct lisa_differ {
+    lisa_diff_side		old_side;
+    lisa_diff_side		new_side;
+    const lisa_diff_options	*options;
+    lisa_diff_fn		fn;
+    void				* LISA_NULLABLE context;
+    lisa_diff_stats		stats;
+
+    lisa_diff_range		* LISA_NULLABLE ranges;
+    size_t				range_count;
+    size_t				range_capacity;
+
+    int32_t				* LISA_NULLABLE window_slots;	//!< first window offset / 2 per slot, or -1
+    int32_t				* LISA_NULLABLE window_next;	//!< next window offset / 2 in the same slot, or -1
+    size_t				window_slot_capacity;
+    size_t				window_next_capacity;
+    int					window_shift;
+};
+typedef struct lisa_differ lisa_differ;
+
+
+/*! Get a module name as a key that sorts the way the name does. */
+uint64_t
+lisa_diff_name_key(const lisa_ObjName name)
+{
+    uint64_t key = 0;
+    for (int i = 0; i < 8; i++) {
+        key = (key << 8) | (uint8_t)name[i];
+    }
+    return key;
+}
+
+
+/*! Get the module name a key was made from, trimmed as a C string. */
+void
+lisa_diff_key_name(uint64_t key, char name[9])
+{
+    if (key == 0) {
+        name[0] = '\0';
+        return;
+    }
+
+    lisa_ObjName objname;
+    for (int i = 0; i < 8; i++) {
+        objname[i] = (char)(key >> (56 - 8 * i));
+    }
+    lisa_ObjName_get_cstring(name, objname);
+}
+
+
+int
+lisa_diff_block_compare(const void *a, const void *b)
+{
+    const lisa_diff_block *block_a = a;
+    const lisa_diff_block *block_b = b;
+
+    if (block_a->key != block_b->key) return (block_a->key < block_b->key) ? -1 : 1;
+    if (block_a->occurrence != block_b->occurrence) return (block_a->occurrence < block_b->occurrence) ? -1 : 1;
+    if (block_a->type != block_b->type) return (block_a->type < block_b->type) ? -1 : 1;
+    if (block_a->ordinal != block_b->ordinal) return (block_a->ordinal < block_b->ordinal) ? -1 : 1;
+    return 0;
+}
+
+
+/*!
+    Gather and hash the blocks of a side's file, other than the code
+    blocks of its segments, sorted by what they're matched on.
+ */
+int
+lisa_diff_side_gather(lisa_diff_side *side)
+{
+    int result = -1;
+    lisa_objfile *of = side->of;
+    const lisa_integer block_count = lisa_objfile_block_count(of);
+    const lisa_integer module_count = lisa_objfile_module_count(of);
+    const lisa_integer segment_count = lisa_objfile_segment_count(of);
+
+    bool *skip = calloc(sizeof(bool), (size_t)block_count + 1);
+    lisa_symbol_table *occurrences = lisa_symbol_table_create();
+    side->blocks = calloc(sizeof(lisa_diff_block), (size_t)block_count + 1);
+    if ((skip == NULL) || (occurrences == NULL) || (side->blocks == NULL)) goto done;
+
+    for (lisa_integer s = 0; s < segment_count; s++) {
+        lisa_segment segment;
+        if (lisa_objfile_segment_at_index(of, s, &segment) == -1) continue;
+        skip[lisa_objfile_module_at_index(of, segment.module)->code_block] = true;
+    }
+
+    uint32_t counts[256];
+    for (lisa_integer m = 0; m < module_count; m++) {
+        const lisa_objfile_module *module = lisa_objfile_module_at_index(of, m);
+        lisa_objfile_block *name_block = lisa_objfile_block_at_index(of, module->first_block);
+        const char *name = lisa_objfile_block_content(name_block).ModuleName->ModuleName;
+
+        lisa_MemAddr occurrence = 0;
+        lisa_symbol_table_lookup_ObjName(occurrences, name, &occurrence);
+        if (lisa_symbol_table_add_ObjName(occurrences, name, occurrence + 1) == -1) goto done;
+
+        memset(counts, 0, sizeof(counts));
+        for (lisa_integer b = module->first_block; b <= module->last_block; b++) {
+            lisa_obj_block_type type = lisa_objfile_block_type(lisa_objfile_block_at_index(of, b));
+            if (!skip[b]) {
+                side->blocks[side->block_count++] = (lisa_diff_block){
+                    .key = lisa_diff_name_key(name),
+                    .occurrence = (uint32_t)occurrence,
+                    .type = type,
+                    .ordinal = counts[type]++,
+                    .index = b,
+                };
+            }
+            skip[b] = true;
+        }
+    }
+
+    memset(counts, 0, sizeof(counts));
+    for (lisa_integer b = 0; b < block_count; b++) {
+        if (skip[b]) continue;
+        lisa_obj_block_type type = lisa_objfile_block_type(lisa_objfile_block_at_index(of, b));
+        side->blocks[side->block_count++] = (lisa_diff_block){
+            .type = type,
+            .ordinal = counts[type]++,
+            .index = b,
+        };
+    }
+
+    // Hash each block's content, never past the end of the file. An
+    // EOFMark has none, whatever its size claims.
+
+    const size_t file_size = lisa_objfile_size(of);
+    for (size_t i = 0; i < side->block_count; i++) {
+        lisa_objfile_block *block = lisa_objfile_block_at_index(of, side->blocks[i].index);
+        const size_t content_offset = (size_t)lisa_objfile_block_offset(block) + 4;
+        const size_t available = (file_size > content_offset) ? (file_size - content_offset) : 0;
+        lisa_longint content_size = lisa_objfile_block_size(block) - 4;
+        size_t hashed_size = (content_size > 0) ? (size_t)content_size : 0;
+        if (hashed_size > available) hashed_size = available;
+        if (side->blocks[i].type == EOFMark) hashed_size = 0;
+
+        side->blocks[i].hash = hash_xxh64(lisa_objfile_block_content(block).data, hashed_size, 0);
+    }
+
+    qsort(side->blocks, side->block_count, sizeof(lisa_diff_block), lisa_diff_block_compare);
+    result = 0;
+
+done:
+    free(skip);
+    lisa_symbol_table_free(occurrences);
+    return result;
+}
+
+
+/*! Fill in a block result for \a block of \a side, as old or new. */
+void
+lisa_diff_block_fill(lisa_diff_result *result, lisa_diff_side *side, const lisa_diff_block *block, bool old)
+{
+    lisa_objfile_block *of_block = lisa_objfile_block_at_index(side->of, block->index);
+
+    lisa_diff_key_name(block->key, result->name);
+    result->type = (lisa_obj_block_type)block->type;
+    if (old) {
+        result->old_index = block->index;
+        result->old_offset = lisa_objfile_block_offset(of_block);
+        result->old_size = lisa_objfile_block_size(of_block);
+    } else {
+        result->new_index = block->index;
+        result->new_offset = lisa_objfile_block_offset(of_block);
+        result->new_size = lisa_objfile_block_size(of_block);
+    }
+}
+
+
+/*! Compare the sorted blocks of both sides, reporting those that differ. */
+void
+lisa_diff_blocks(lisa_differ *differ)
+{
+    lisa_diff_side *old_side = &differ->old_side;
+    lisa_diff_side *new_side = &differ->new_side;
+    size_t o = 0, n = 0;
+
+    while ((o < old_side->block_count) || (n < new_side->block_count)) {
+        const lisa_diff_block *old_block = (o < old_side->block_count) ? &old_side->blocks[o] : NULL;
+        const lisa_diff_block *new_block = (n < new_side->block_count) ? &new_side->blocks[n] : NULL;
+
+        int order = (old_block == NULL) ? 1 : (new_block == NULL) ? -1
+                  : lisa_diff_block_compare(old_block, new_block);
+
+        lisa_diff_result result = {
+            .item = lisa_diff_item_block,
+            .old_index = -1, .new_index = -1,
+            .old_offset = -1, .new_offset = -1,
+        };
+
+        if (order < 0) {
+            result.kind = lisa_diff_removed;
+            lisa_diff_block_fill(&result, old_side, old_block, true);
+            differ->stats.blocks_removed += 1;
+            o++;
+        } else if (order > 0) {
+            result.kind = lisa_diff_added;
+            lisa_diff_block_fill(&result, new_side, new_block, false);
+            differ->stats.blocks_added += 1;
+            n++;
+        } else {
+            lisa_diff_block_fill(&result, old_side, old_block, true);
+            lisa_diff_block_fill(&result, new_side, new_block, false);
+            o++;
+            n++;
+
+            if ((old_block->hash == new_block->hash) && (result.old_size == result.new_size)) {
+                differ->stats.blocks_same += 1;
+                continue;
+            }
+
+            result.kind = lisa_diff_changed;
+            differ->stats.blocks_changed += 1;
+        }
+
+        differ->fn(&result, differ->context);
+    }
+}
+
+
+/*! Get a segment's unpacked code, unpacking it into the side's buffer if it's packed. */
+int
+lisa_diff_side_code(lisa_diff_side *side, const lisa_segment *segment, const uint8_t **code, size_t *size)
+{
+    if (!segment->packed) {
+        *code = segment->code;
+        *size = (size_t)segment->code_size;
+        return 0;
+    }
+
+    if (side->code_capacity < (size_t)segment->unpacked_size + 1) {
+        uint8_t *grown = realloc(side->code, (size_t)segment->unpacked_size + 1);
+        if (grown == NULL) return -1;
+        side->code = grown;
+        side->code_capacity = (size_t)segment->unpacked_size + 1;
+    }
+
+    lisa_longint unpacked_size = (lisa_longint)side->code_capacity;
+    if (lisa_segment_unpack(segment, side->code, &unpacked_size) == -1) return -1;
+
+    *code = side->code;
+    *size = (size_t)unpacked_size;
+    return 0;
+}
+
+
+/*! Count the bytes \a a and \a b have in common from their start, a word at a time. */
+size_t
+lisa_diff_common_prefix(const uint8_t *a, size_t a_size, const uint8_t *b, size_t b_size)
+{
+    size_t limit = (a_size < b_size) ? a_size : b_size;
+    size_t i = 0;
+
+    while (i + sizeof(uint64_t) <= limit) {
+        uint64_t a_word, b_word;
+        memcpy(&a_word, &a[i], sizeof(a_word));
+        memcpy(&b_word, &b[i], sizeof(b_word));
+        if (a_word != b_word) break;
+        i += sizeof(uint64_t);
+    }
+    while ((i < limit) && (a[i] == b[i])) i++;
+
+    return i;
+}
+
+
+/*! Count the bytes \a a and \a b have in common at their end, up to \a limit. */
+size_t
+lisa_diff_common_suffix(const uint8_t *a, size_t a_size, const uint8_t *b, size_t b_size, size_t limit)
+{
+    size_t i = 0;
+
+    while (i + sizeof(uint64_t) <= limit) {
+        uint64_t a_word, b_word;
+        memcpy(&a_word, &a[a_size - i - sizeof(uint64_t)], sizeof(a_word));
+        memcpy(&b_word, &b[b_size - i - sizeof(uint64_t)], sizeof(b_word));
+        if (a_word != b_word) break;
+        i += sizeof(uint64_t);
+    }
+    while ((i < limit) && (a[a_size - i - 1] == b[b_size - i - 1])) i++;
+
+    return i;
+}
+
+
+/*! Hash the `LISA_DIFF_WINDOW` bytes at \a p. */
+uint64_t
+lisa_diff_window_hash(const uint8_t *p)
+{
+    uint64_t first, second;
+    memcpy(&first, &p[0], sizeof(first));
+    memcpy(&second, &p[8], sizeof(second));
+
+    uint64_t hash = (first * LISA_DIFF_FIBONACCI) ^ (second + (second << 29) + (second >> 17));
+    return hash * LISA_DIFF_FIBONACCI;
+}
+
+
+/*!
+    Index the windows of \a code that start at even offsets from \a start
+    up to \a end, by hash. Each slot's chain runs in ascending order.
+ */
+int
+lisa_diff_index_windows(lisa_differ *differ, const uint8_t *code, size_t start, size_t end)
+{
+    size_t window_count = (end >= start + LISA_DIFF_WINDOW) ? (end - start - LISA_DIFF_WINDOW) / 2 + 1 : 0;
+
+    // Keep the slots at most half full.
+
+    size_t slot_count = 16;
+    int shift = 60;
+    while (slot_count < window_count * 2) {
+        slot_count *= 2;
+        shift -= 1;
+    }
+
+    if (differ->window_slot_capacity < slot_count) {
+        int32_t *slots = realloc(differ->window_slots, sizeof(int32_t) * slot_count);
+        if (slots == NULL) return -1;
+        differ->window_slots = slots;
+        differ->window_slot_capacity = slot_count;
+    }
+    if (differ->window_next_capacity < (end / 2) + 1) {
+        int32_t *next = realloc(differ->window_next, sizeof(int32_t) * ((end / 2) + 1));
+        if (next == NULL) return -1;
+        differ->window_next = next;
+        differ->window_next_capacity = (end / 2) + 1;
+    }
+
+    differ->window_shift = shift;
+    memset(differ->window_slots, 0xFF, sizeof(int32_t) * slot_count);
+
+    start &= ~(size_t)1;
+    for (size_t w = window_count; w > 0; w--) {
+        size_t offset = start + (w - 1) * 2;
+        size_t slot = (size_t)(lisa_diff_window_hash(&code[offset]) >> shift);
+        differ->window_next[offset / 2] = differ->window_slots[slot];
+        differ->window_slots[slot] = (int32_t)(offset / 2);
+    }
+
+    return 0;
+}
+
+
+/*! Find the first indexed window of \a code at or after \a min matching \a window, or -1. */
+int64_t
+lisa_diff_find_window(lisa_differ *differ, const uint8_t *code, size_t min, const uint8_t *window)
+{
+    size_t slot = (size_t)(lisa_diff_window_hash(window) >> differ->window_shift);
+    int32_t entry = differ->window_slots[slot];
+
+    for (int steps = 0; (entry != -1) && (steps < LISA_DIFF_CHAIN_LIMIT); steps++) {
+        size_t offset = (size_t)entry * 2;
+        if ((offset >= min) && (memcmp(&code[offset], window, LISA_DIFF_WINDOW) == 0)) return (int64_t)offset;
+        entry = differ->window_next[entry];
+    }
+
+    return -1;
+}
+
+
+/*! Add a range to the differ's ranges. */
+int
+lisa_diff_add_range(lisa_differ *differ, size_t old_offset, size_t old_size, size_t new_offset, size_t new_size)
+{
+    if ((old_size == 0) && (new_size == 0)) return 0;
+
+    if (differ->range_count == differ->range_capacity) {
+        size_t new_capacity = differ->range_capacity ? differ->range_capacity * 2 : 16;
+        lisa_diff_range *ranges = realloc(differ->ranges, sizeof(lisa_diff_range) * new_capacity);
+        if (ranges == NULL) return -1;
+        differ->ranges = ranges;
+        differ->range_capacity = new_capacity;
+    }
+
+    differ->ranges[differ->range_count++] = (lisa_diff_range){
+        .old_offset = (lisa_longint)old_offset,
+        .old_size = (lisa_longint)old_size,
+        .new_offset = (lisa_longint)new_offset,
+        .new_size = (lisa_longint)new_size,
+    };
+    differ->stats.bytes_changed += (old_size > new_size) ? old_size : new_size;
+    return 0;
+}
+
+
+/*!
+    Find the ranges of bytes that differ between \a old_code and
+    \a new_code.
+
+    Matching bytes are skipped a word at a time. At each difference,
+    the new code is scanned for the next window that matches either the
+    old code at the same distance along (for bytes changed in place) or
+    any indexed window of the old code further along (for bytes inserted
+    or deleted), and the bytes skipped over on each side are a range.
+ */
+int
+lisa_diff_find_ranges(lisa_differ *differ,
+                      const uint8_t *old_code, size_t old_size,
+                      const uint8_t *new_code, size_t new_size)
+{
+    differ->range_count = 0;
+
+    size_t prefix = lisa_diff_common_prefix(old_code, old_size, new_code, new_size);
+    size_t limit = ((old_size < new_size) ? old_size : new_size) - prefix;
+    size_t suffix = lisa_diff_common_suffix(old_code, old_size, new_code, new_size, limit);
+    size_t old_end = old_size - suffix;
+    size_t new_end = new_size - suffix;
+
+    if (lisa_diff_index_windows(differ, old_code, prefix, old_end) == -1) return -1;
+
+    size_t o = prefix, n = prefix;
+    while ((o < old_end) && (n < new_end)) {
+        size_t same = lisa_diff_common_prefix(&old_code[o], old_end - o, &new_code[n], new_end - n);
+        o += same;
+        n += same;
+        if ((o >= old_end) || (n >= new_end)) break;
+
+        // Code is made of words, so start differences on a word.
+
+        if ((o & 1) && (n & 1)) {
+            o -= 1;
+            n -= 1;
+        }
+
+        bool found = false;
+        size_t next_o = old_end, next_n = new_end;
+        for (size_t d = n; d + LISA_DIFF_WINDOW <= new_end; d += 2) {
+            size_t in_place = o + (d - n);
+            if ((in_place + LISA_DIFF_WINDOW <= old_end)
+                && (memcmp(&old_code[in_place], &new_code[d], LISA_DIFF_WINDOW) == 0)) {
+                next_o = in_place;
+                next_n = d;
+                found = true;
+                break;
+            }
+
+            int64_t moved = lisa_diff_find_window(differ, old_code, o, &new_code[d]);
+            if (moved != -1) {
+                next_o = (size_t)moved;
+                next_n = d;
+                found = true;
+                break;
+            }
+        }
+
+        if (lisa_diff_add_range(differ, o, next_o - o, n, next_n - n) == -1) return -1;
+        o = next_o;
+        n = next_n;
+        if (!found) break;
+    }
+
+    if (lisa_diff_add_range(differ, o, old_end - o, n, new_end - n) == -1) return -1;
+    return 0;
+}
+
+
+/*! Compare a segment present in both files, reporting it if it changed. */
+int
+lisa_diff_segment_pair(lisa_differ *differ, const lisa_segment *old_segment, const lisa_segment *new_segment)
+{
+    // Identical code as stored is identical code, without unpacking.
+
+    if ((old_segment->packed == new_segment->packed)
+        && (old_segment->code_size == new_segment->code_size)
+        && (hash_xxh64(old_segment->code, (size_t)old_segment->code_size, 0)
+            == hash_xxh64(new_segment->code, (size_t)new_segment->code_size, 0))) {
+        differ->stats.segments_same += 1;
+        differ->stats.segments_same_packed += 1;
+        return 0;
+    }
+
+    const uint8_t *old_code, *new_code;
+    size_t old_size, new_size;
+    if (lisa_diff_side_code(&differ->old_side, old_segment, &old_code, &old_size) == -1) return -1;
+    if (lisa_diff_side_code(&differ->new_side, new_segment, &new_code, &new_size) == -1) return -1;
+
+    if ((old_size == new_size) && (hash_xxh64(old_code, old_size, 0) == hash_xxh64(new_code, new_size, 0))) {
+        differ->stats.segments_same += 1;
+        return 0;
+    }
+
+    lisa_diff_result result = {
+        .item = lisa_diff_item_segment,
+        .kind = lisa_diff_changed,
+        .old_index = old_segment->module,
+        .new_index = new_segment->module,
+        .old_offset = -1,
+        .new_offset = -1,
+        .old_size = (lisa_longint)old_size,
+        .new_size = (lisa_longint)new_size,
+    };
+    strcpy(result.name, old_segment->name);
+
+    if (differ->options->ranges) {
+        if (lisa_diff_find_ranges(differ, old_code, old_size, new_code, new_size) == -1) return -1;
+        result.ranges = differ->ranges;
+        result.range_count = differ->range_count;
+    }
+
+    differ->stats.segments_changed += 1;
+    differ->fn(&result, differ->context);
+    return 0;
+}
+
+
+/*! Report a segment only one file has. */
+void
+lisa_diff_segment_single(lisa_differ *differ, const lisa_segment *segment, lisa_diff_kind kind)
+{
+    lisa_diff_result result = {
+        .item = lisa_diff_item_segment,
+        .kind = kind,
+        .old_index = (kind == lisa_diff_removed) ? segment->module : -1,
+        .new_index = (kind == lisa_diff_added) ? segment->module : -1,
+        .old_offset = -1,
+        .new_offset = -1,
+        .old_size = (kind == lisa_diff_removed) ? segment->unpacked_size : 0,
+        .new_size = (kind == lisa_diff_added) ? segment->unpacked_size : 0,
+    };
+    strcpy(result.name, segment->name);
+
+    if (kind == lisa_diff_added) {
+        differ->stats.segments_added += 1;
+    } else {
+        differ->stats.segments_removed += 1;
+    }
+    differ->fn(&result, differ->context);
+}
+
+
+/*! Compare the segments of both files by name. */
+int
+lisa_diff_segments(lisa_differ *differ)
+{
+    lisa_objfile *old_of = differ->old_side.of;
+    lisa_objfile *new_of = differ->new_side.of;
+
+    bool *matched = calloc(sizeof(bool), (size_t)lisa_objfile_module_count(new_of) + 1);
+    if (matched == NULL) return -1;
+
+    int result = -1;
+    const lisa_integer old_count = lisa_objfile_segment_count(old_of);
+    for (lisa_integer s = 0; s < old_count; s++) {
+        lisa_segment old_segment, new_segment;
+        if (lisa_objfile_segment_at_index(old_of, s, &old_segment) == -1) continue;
+
+        if (lisa_objfile_segment_named(new_of, old_segment.name, &new_segment) == -1) {
+            lisa_diff_segment_single(differ, &old_segment, lisa_diff_removed);
+            continue;
+        }
+
+        matched[new_segment.module] = true;
+        if (lisa_diff_segment_pair(differ, &old_segment, &new_segment) == -1) goto done;
+    }
+
+    const lisa_integer new_count = lisa_objfile_segment_count(new_of);
+    for (lisa_integer s = 0; s < new_count; s++) {
+        lisa_segment new_segment;
+        if (lisa_objfile_segment_at_index(new_of, s, &new_segment) == -1) continue;
+        if (matched[new_segment.module]) continue;
+
+        lisa_diff_segment_single(differ, &new_segment, lisa_diff_added);
+    }
+
+    result = 0;
+
+done:
+    free(matched);
+    return result;
+}
+
+
+// MARK: - Comparing
+
+int
+lisa_objfile_diff(lisa_objfile *old_of, lisa_objfile *new_of,
+                  const lisa_diff_options *options,
+                  lisa_diff_fn fn, void * LISA_NULLABLE context,
+                  lisa_diff_stats * LISA_NULLABLE stats)
+{
+    int result = -1;
+    int diff_errno = 0;
+    lisa_differ differ = {
+        .old_side = { .of = old_of },
+        .new_side = { .of = new_of },
+        .options = options,
+        .fn = fn,
+        .context = context,
+    };
+
+    if (lisa_diff_segments(&differ) == -1) goto done;
+
+    if (!options->segments_only) {
+        if (lisa_diff_side_gather(&differ.old_side) == -1) goto done;
+        if (lisa_diff_side_gather(&differ.new_side) == -1) goto done;
+        lisa_diff_blocks(&differ);
+    }
+
+    if (stats) *stats = differ.stats;
+    result = 0;
+
+done:
+    diff_errno = errno;
+    free(differ.old_side.blocks);
+    free(differ.old_side.code);
+    free(differ.new_side.blocks);
+    free(differ.new_side.code);
+    free(differ.ranges);
+    free(differ.window_slots);
+    free(differ.window_next);
+    errno = diff_errno;
+    return result;
+}
+
+
+LISA_SOURCE_END
@@ -0,0 +1,133 @@
+//  lisa_diff.h
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#ifndef __LISA__DIFF__H__
+#define __LISA__DIFF__H__
+
+#include <stddef.h>
+
+#include "lisa_defines.h"
+#include "lisa_types.h"
+
+#include "lisa_objio.h"
+
+LISA_HEADER_BEGIN
+
+
+/*!
+    The size of the windows hashed to find where two segments' code
+    lines up again after a difference. Differences closer together than
+    this are reported as one range.
+ */
+#define LISA_DIFF_WINDOW	16
+
+
+/*! What's being compared. */
+enum lisa_diff_item: uint32_t {
+    lisa_diff_item_segment	= 0,	//!< a segment's unpacked code, matched by name
+    lisa_diff_item_block	= 1,	//!< a block other than code, matched by module and type
+};
+typedef enum lisa_diff_item lisa_diff_item;
+
+
+/*! How an item differs between the old and new files. */
+enum lisa_diff_kind: uint32_t {
+    lisa_diff_added		= 0,	//!< only in the new file
+    lisa_diff_removed	= 1,	//!< only in the old file
+    lisa_diff_changed	= 2,	//!< in both, with different content
+};
+typedef enum lisa_diff_kind lisa_diff_kind;
+
+
+/*! A range of bytes of a segment's unpacked code that differs. */
+struct lisa_diff_range {
+    lisa_longint		old_offset;
+    lisa_longint		old_size;		//!< 0 if bytes were only inserted
+    lisa_longint		new_offset;
+    lisa_longint		new_size;		//!< 0 if bytes were only deleted
+};
+typedef struct lisa_diff_range lisa_diff_range;
+
+
+/*! A single added, removed or changed segment or block. */
+struct lisa_diff_result {
+    lisa_diff_item		item;
+    lisa_diff_kind		kind;
+    char				name[9];		//!< segment name, or name of the block's module (empty if outside any)
+    lisa_obj_block_type	type;			//!< of the blocks
+    lisa_integer		old_index;		//!< of the block, or the segment's module; -1 if added
+    lisa_integer		new_index;		//!< of the block, or the segment's module; -1 if removed
+    lisa_FileAddr		old_offset;		//!< of the block, or -1
+    lisa_FileAddr		new_offset;		//!< of the block, or -1
+    lisa_longint		old_size;		//!< of the block, or of the segment's unpacked code
+    lisa_longint		new_size;		//!< of the block, or of the segment's unpacked code
+    const lisa_diff_range	* LISA_NULLABLE ranges;	//!< for changed segments, if asked for
+    size_t				range_count;
+};
+typedef struct lisa_diff_result lisa_diff_result;
+
+
+/*! How to compare two object files. */
+struct lisa_diff_options {
+    bool				segments_only;	//!< don't compare blocks other than code
+    bool				ranges;			//!< find the byte ranges that differ in changed segments
+};
+typedef struct lisa_diff_options lisa_diff_options;
+
+
+/*! What comparing two object files found, for reporting. */
+struct lisa_diff_stats {
+    size_t				segments_same;
+    size_t				segments_same_packed;	//!< of those, found the same from their code as stored
+    size_t				segments_changed;
+    size_t				segments_added;
+    size_t				segments_removed;
+    size_t				blocks_same;
+    size_t				blocks_changed;
+    size_t				blocks_added;
+    size_t				blocks_removed;
+    size_t				bytes_changed;	//!< in changed segments' ranges, in the new file
+};
+typedef struct lisa_diff_stats lisa_diff_stats;
+
+
+/*! Called by `lisa_objfile_diff` for each difference, in order. */
+typedef void (*lisa_diff_fn)(const lisa_diff_result *result, void * LISA_NULLABLE context);
+
+
+/*!
+    Compare the object files \a old_of and \a new_of, calling \a fn for
+    each segment and block that differs.
+
+    Segments are matched by name and compared by hashing their code:
+    first as stored, which is enough to find most unchanged segments
+    without unpacking them, and then unpacked. For changed segments,
+    the ranges of bytes that differ are found by comparing a word at a
+    time, and, where code has been inserted or deleted, by hashing
+    windows of `LISA_DIFF_WINDOW` bytes to find where the two line up
+    again. Segments are reported in the old file's order, followed by
+    any added ones in the new file's order.
+
+    Every other block is matched by the name of its module (the n-th
+    module of a name matching the n-th), then by type and by its place
+    among the module's blocks of that type, and compared by hashing its
+    content. Blocks outside any module are matched in the same way.
+    The code blocks of segments are left to the segment comparison.
+    Blocks are reported by module name, then type, then place.
+
+    If \a stats is given, it's set to what was found.
+ */
+LISA_EXTERN
+int
+lisa_objfile_diff(lisa_objfile *old_of, lisa_objfile *new_of,
+                  const lisa_diff_options *options,
+                  lisa_diff_fn fn, void * LISA_NULLABLE context,
+                  lisa_diff_stats * LISA_NULLABLE stats);
+
+
+LISA_HEADER_END
+
+#endif /* __LISA__DIFF__H__ */
@@ -0,0 +1,1016 @@
+//  lisa_extract.c
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#include "lisa_extract.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "file_utils.h"
+#include "hash_utils.h"
+#include "thread_pool.h"
+
+#include "lisa_stats.h"
+
+
+LISA_SOURCE_BEGIN
+
+
+// MARK: - Internals
+
+/*! Per-worker state, so unpacking buffers are reused across modules. */
+struct lisa_extract_worker {
+    uint8_t				* LISA_NULLABLE buffer;
+    size_t				capacity;
+    lisa_relocator		* LISA_NULLABLE relocator;	//!< created when first needed
+};
+typedef struct lisa_extract_worker lisa_extract_worker;
+
+/*! A file written by an incremental extraction, or code written to a store. */
+struct lisa_extract_manifest_entry {
+    char				*name;
+    uint64_t			hash;			//!< of the module's code as stored
+    uint64_t			size;			//!< of the file as written
+    uint8_t				digest[LISA_STORE_DIGEST_SIZE];	//!< of the code as written, for a store
+    bool				current;		//!< whether this extraction still produces it
+};
+typedef struct lisa_extract_manifest_entry lisa_extract_manifest_entry;
+
+/*! The files written by an incremental extraction, or to a store, sorted by name. */
+struct lisa_extract_manifest {
+    bool				valid;			//!< whether there was a manifest to read
+    bool				store;			//!< whether it's of code written to a store
+    bool				packed;			//!< whether the code was written as stored
+    lisa_extract_manifest_entry	* LISA_NULLABLE entries;
+    size_t				count;
+    size_t				capacity;
+};
+typedef struct lisa_extract_manifest lisa_extract_manifest;
+
+/*! The first line of a manifest, followed by "packed" or "unpacked". */
+#define LISA_EXTRACT_MANIFEST_HEADER "lisa-extract-manifest 1"
+
+/*! The first line of a store's manifest, followed by "packed" or "unpacked". */
+#define LISA_EXTRACT_STORE_MANIFEST_HEADER "lisa-store-manifest 1"
+
+
+/*! State shared by every module extraction of a single file. */
+struct lisa_extract_job {
+    lisa_objfile		*objfile;
+    const char			*path_prefix;
+    bool				packed;
+    bool				incremental;
+    const lisa_relocate_options	* LISA_NULLABLE relocate;
+    lisa_archive_writer	* LISA_NULLABLE archive;
+    lisa_store			* LISA_NULLABLE store;
+    lisa_extract_worker	* LISA_NULLABLE workers;
+    lisa_extract_manifest	manifest;	//!< from the last extraction, when incremental or to a store
+
+    pthread_mutex_t		lock;
+    int					error;			//!< first errno encountered, or 0
+};
+typedef struct lisa_extract_job lisa_extract_job;
+
+/*! A single module to extract, as submitted to the thread pool. */
+struct lisa_extract_task {
+    lisa_extract_job	*job;
+    lisa_integer		module;
+    uint64_t			archive_offset;	//!< where the code goes, when writing an archive
+    uint64_t			archive_size;
+    uint64_t			hash;			//!< of the code as stored, when incremental or to a store
+    uint8_t				digest[LISA_STORE_DIGEST_SIZE];	//!< of the code as written, when to a store
+    bool				written;
+    bool				unchanged;		//!< skipped because its code hadn't changed
+    bool				deduplicated;	//!< not written because the store already held it
+    size_t				relocated;		//!< fields patched by relocation
+    size_t				unresolved;		//!< references left unrelocated
+};
+typedef struct lisa_extract_task lisa_extract_task;
+
+
+/*!
+    Whether a module's code is extracted: it has to have code, and an
+    EndBlock, since a module is only complete once it's reached one.
+ */
+bool
+lisa_extract_module_complete(lisa_objfile *of, lisa_integer module_index)
+{
+    const lisa_objfile_module *module = lisa_objfile_module_at_index(of, module_index);
+    if (module->code_block == -1) return false;
+
+    lisa_objfile_block *last_block = lisa_objfile_block_at_index(of, module->last_block);
+    return lisa_objfile_block_type(last_block) == EndBlock;
+}
+
+
+/*! Record the first error seen by any worker. */
+void
+lisa_extract_job_fail(lisa_extract_job *job, int error)
+{
+    pthread_mutex_lock(&job->lock);
+    if (job->error == 0) job->error = error;
+    pthread_mutex_unlock(&job->lock);
+}
+
+
+/*! Make sure a worker's buffer can hold \a size bytes. */
+int
+lisa_extract_worker_reserve(lisa_extract_worker *worker, size_t size)
+{
+    if (worker->capacity >= size) return 0;
+
+    uint8_t *buffer = realloc(worker->buffer, size);
+    if (buffer == NULL) return -1;
+    worker->buffer = buffer;
+    worker->capacity = size;
+    return 0;
+}
+
+
+/*! Free everything a worker has accumulated, but not the worker itself. */
+void
+lisa_extract_worker_dispose(lisa_extract_worker *worker)
+{
+    free(worker->buffer);
+    lisa_relocator_free(worker->relocator);
+}
+
+
+/*! Write all of \a buf to a new file at \a path. */
+int
+lisa_extract_write_file(const char *path, const uint8_t *buf, size_t size)
+{
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd == -1) return -1;
+
+    uint64_t write_start = lisa_stats_begin();
+
+    size_t written = 0;
+    while (written < size) {
+        ssize_t n = write(fd, &buf[written], size - written);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            int write_errno = errno;
+            close(fd);
+            errno = write_errno;
+            return -1;
+        }
+        written += (size_t)n;
+    }
+
+    lisa_stats_end(lisa_stats_write, write_start, size, 0);
+
+    return close(fd);
+}
+
+
+/*!
+    Whether the unpacked size of some code could be right. For packed
+    code it's csize straight from the file, and since packing can at
+    most halve code, anything else is damage not to make room for.
+ */
+bool
+lisa_extract_unpacked_size_valid(lisa_longint code_size, lisa_longint unpacked_size)
+{
+    return (unpacked_size >= 0) && ((int64_t)unpacked_size <= 2 * (int64_t)code_size);
+}
+
+
+/*!
+    Get the size of the code that will be extracted for a module, or -1
+    if its unpacked size can't be right.
+ */
+int64_t
+lisa_extract_output_size(lisa_extract_job *job, lisa_integer module_index)
+{
+    const lisa_objfile_module *module = lisa_objfile_module_at_index(job->objfile, module_index);
+    lisa_objfile_block *block = lisa_objfile_block_at_index(job->objfile, module->code_block);
+
+    uint8_t *code;
+    lisa_longint code_size, unpacked_size;
+    lisa_MemAddr addr;
+    lisa_objfile_block_get_code(block, &code, &code_size, &unpacked_size, &addr);
+
+    if (job->packed) return code_size;
+    return lisa_extract_unpacked_size_valid(code_size, unpacked_size) ? unpacked_size : -1;
+}
+
+
+/*!
+    Reserve archive space for every task's module, all together so that
+    a file's code stays contiguous in the archive.
+ */
+int
+lisa_extract_reserve(lisa_extract_job *job, lisa_extract_task *tasks, size_t task_count)
+{
+    int result = -1;
+    char **names = calloc(sizeof(char *), task_count + 1);
+    uint64_t *sizes = calloc(sizeof(uint64_t), task_count + 1);
+    uint64_t *offsets = calloc(sizeof(uint64_t), task_count + 1);
+    if ((names == NULL) || (sizes == NULL) || (offsets == NULL)) goto done;
+
+    for (size_t t = 0; t < task_count; t++) {
+        char path[PATH_MAX];
+        int path_err = lisa_objfile_module_extract_path(job->objfile, tasks[t].module, job->path_prefix,
+                                                        path, sizeof(path));
+        if (path_err == -1) {
+            errno = ENAMETOOLONG;
+            goto done;
+        }
+
+        names[t] = strdup(path);
+        if (names[t] == NULL) goto done;
+
+        int64_t size = lisa_extract_output_size(job, tasks[t].module);
+        if (size == -1) {
+            errno = EINVAL;
+            goto done;
+        }
+        sizes[t] = (uint64_t)size;
+    }
+
+    int add_err = lisa_archive_writer_add_entries(job->archive, task_count,
+                                                  (const char * const *)names, sizes, offsets);
+    if (add_err == -1) goto done;
+
+    for (size_t t = 0; t < task_count; t++) {
+        tasks[t].archive_offset = offsets[t];
+        tasks[t].archive_size = sizes[t];
+    }
+
+    result = 0;
+
+done:
+    if (names) {
+        for (size_t t = 0; t < task_count; t++) {
+            free(names[t]);
+        }
+    }
+    free(names);
+    free(sizes);
+    free(offsets);
+    return result;
+}
+
+
+int
+lisa_extract_manifest_entry_compare(const void *a, const void *b)
+{
+    const lisa_extract_manifest_entry *entry_a = a;
+    const lisa_extract_manifest_entry *entry_b = b;
+    return strcmp(entry_a->name, entry_b->name);
+}
+
+
+/*! Add an entry to \a manifest, which needs sorting again afterwards. */
+int
+lisa_extract_manifest_add(lisa_extract_manifest *manifest, const char *name, uint64_t hash, uint64_t size,
+                          const uint8_t * LISA_NULLABLE digest)
+{
+    if (manifest->count == manifest->capacity) {
+        size_t new_capacity = manifest->capacity ? manifest->capacity * 2 : 64;
+        lisa_extract_manifest_entry *entries = realloc(manifest->entries,
+                                                       sizeof(lisa_extract_manifest_entry) * new_capacity);
+        if (entries == NULL) return -1;
+        manifest->entries = entries;
+        manifest->capacity = new_capacity;
+    }
+
+    char *entry_name = strdup(name);
+    if (entry_name == NULL) return -1;
+
+    manifest->entries[manifest->count] = (lisa_extract_manifest_entry){
+        .name = entry_name,
+        .hash = hash,
+        .size = size,
+        .current = false,
+    };
+    if (digest) memcpy(manifest->entries[manifest->count].digest, digest, LISA_STORE_DIGEST_SIZE);
+    manifest->count += 1;
+    return 0;
+}
+
+
+/*! Find the entry for the file at \a name in a sorted manifest. */
+lisa_extract_manifest_entry * LISA_NULLABLE
+lisa_extract_manifest_find(lisa_extract_manifest *manifest, const char *name)
+{
+    if (manifest->count == 0) return NULL;
+
+    lisa_extract_manifest_entry key = { .name = (char *)name };
+    return bsearch(&key, manifest->entries, manifest->count, sizeof(lisa_extract_manifest_entry),
+                   lisa_extract_manifest_entry_compare);
+}
+
+
+void
+lisa_extract_manifest_free(lisa_extract_manifest *manifest)
+{
+    for (size_t e = 0; e < manifest->count; e++) {
+        free(manifest->entries[e].name);
+    }
+    free(manifest->entries);
+    manifest->entries = NULL;
+    manifest->count = 0;
+    manifest->capacity = 0;
+}
+
+
+/*! Get the path of the manifest for extractions to \a path_prefix, or to a store from it. */
+int
+lisa_extract_manifest_path(const char *path_prefix, bool store, char *path, size_t path_size)
+{
+    strlcpy(path, path_prefix, path_size);
+    size_t length = strlcat(path, store ? LISA_EXTRACT_STORE_MANIFEST_SUFFIX : LISA_EXTRACT_MANIFEST_SUFFIX, path_size);
+    if (length >= path_size) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    return 0;
+}
+
+
+/*!
+    Read the manifest at \a path, of the kind \a manifest says. A missing
+    or unrecognized manifest isn't an error; it just leaves \a manifest
+    invalid, so everything gets written.
+ */
+int
+lisa_extract_manifest_read(lisa_extract_manifest *manifest, const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return (errno == ENOENT) ? 0 : -1;
+    }
+
+    int result = -1;
+    char *line = NULL;
+    size_t line_capacity = 0;
+    ssize_t length;
+
+    // The header says how the code was written.
+
+    length = getline(&line, &line_capacity, f);
+    if (length <= 0) {
+        result = ferror(f) ? -1 : 0;
+        goto done;
+    }
+    if (line[length - 1] == '\n') line[length - 1] = '\0';
+
+    const char *header = manifest->store ? LISA_EXTRACT_STORE_MANIFEST_HEADER : LISA_EXTRACT_MANIFEST_HEADER;
+    size_t header_length = strlen(header);
+    if ((strncmp(line, header, header_length) != 0) || (line[header_length] != ' ')) {
+        result = 0;
+        goto done;
+    }
+
+    if (strcmp(&line[header_length + 1], "packed") == 0) {
+        manifest->packed = true;
+    } else if (strcmp(&line[header_length + 1], "unpacked") == 0) {
+        manifest->packed = false;
+    } else {
+        result = 0;
+        goto done;
+    }
+
+    // Then each line is the hash, the size, and the name of a file, with
+    // a store's also starting with the digest of the code. Lines that
+    // don't look like that are ignored.
+
+    while ((length = getline(&line, &line_capacity, f)) > 0) {
+        if (line[length - 1] == '\n') line[length - 1] = '\0';
+
+        char *hash_start = line;
+        uint8_t digest[LISA_STORE_DIGEST_SIZE];
+        if (manifest->store) {
+            if ((size_t)length < LISA_STORE_DIGEST_SIZE * 2 + 1) continue;
+            if (line[LISA_STORE_DIGEST_SIZE * 2] != ' ') continue;
+            line[LISA_STORE_DIGEST_SIZE * 2] = '\0';
+            if (!lisa_store_digest_parse(line, digest)) continue;
+            hash_start = &line[LISA_STORE_DIGEST_SIZE * 2 + 1];
+        }
+
+        char *end;
+        uint64_t hash = strtoull(hash_start, &end, 16);
+        if ((end == hash_start) || (*end != ' ')) continue;
+
+        char *size_start = end + 1;
+        uint64_t size = strtoull(size_start, &end, 10);
+        if ((end == size_start) || (*end != ' ') || (end[1] == '\0')) continue;
+
+        int add_err = lisa_extract_manifest_add(manifest, end + 1, hash, size, manifest->store ? digest : NULL);
+        if (add_err == -1) goto done;
+    }
+    if (ferror(f)) goto done;
+
+    qsort(manifest->entries, manifest->count, sizeof(lisa_extract_manifest_entry),
+          lisa_extract_manifest_entry_compare);
+    manifest->valid = true;
+    result = 0;
+
+done:
+    if (result == -1) {
+        int read_errno = errno;
+        lisa_extract_manifest_free(manifest);
+        errno = read_errno;
+    }
+    free(line);
+    fclose(f);
+    return result;
+}
+
+
+/*! Write the manifest given as \a context to \a f, for `write_file_atomically`. */
+int
+lisa_extract_manifest_fwrite(FILE *f, void * LISA_NULLABLE context)
+{
+    lisa_extract_manifest *manifest = context;
+
+    fprintf(f, "%s" " " "%s" "\n",
+            manifest->store ? LISA_EXTRACT_STORE_MANIFEST_HEADER : LISA_EXTRACT_MANIFEST_HEADER,
+            manifest->packed ? "packed" : "unpacked");
+    for (size_t e = 0; e < manifest->count; e++) {
+        lisa_extract_manifest_entry *entry = &manifest->entries[e];
+        if (manifest->store) {
+            char digest[LISA_STORE_DIGEST_STRING_SIZE];
+            lisa_store_digest_string(entry->digest, digest);
+            fprintf(f, "%s" " ", digest);
+        }
+        fprintf(f, "%016" PRIx64 " " "%" PRIu64 " " "%s" "\n", entry->hash, entry->size, entry->name);
+    }
+
+    return ferror(f) ? -1 : 0;
+}
+
+
+/*!
+    Write \a manifest to \a path, by way of a temporary file so an
+    interrupted write doesn't leave a truncated manifest behind.
+ */
+int
+lisa_extract_manifest_write(lisa_extract_manifest *manifest, const char *path)
+{
+    qsort(manifest->entries, manifest->count, sizeof(lisa_extract_manifest_entry),
+          lisa_extract_manifest_entry_compare);
+
+    return write_file_atomically(path, lisa_extract_manifest_fwrite, manifest);
+}
+
+
+/*!
+    Whether the file at \a path already holds the code that hashes to
+    \a hash, per the last extraction's manifest, and is still there.
+    When extracting to a store, whether the store still holds the code
+    the manifest says it was extracted to, getting back its \a digest.
+ */
+bool
+lisa_extract_is_unchanged(lisa_extract_job *job, const char *path, uint64_t hash, uint64_t size,
+                          uint8_t digest[LISA_STORE_DIGEST_SIZE])
+{
+    if (!job->manifest.valid || (job->manifest.packed != job->packed)) return false;
+
+    lisa_extract_manifest_entry *entry = lisa_extract_manifest_find(&job->manifest, path);
+    if ((entry == NULL) || (entry->hash != hash) || (entry->size != size)) return false;
+
+    if (job->store) {
+        if (!lisa_store_contains(job->store, entry->digest, size)) return false;
+        memcpy(digest, entry->digest, LISA_STORE_DIGEST_SIZE);
+        return true;
+    }
+
+    struct stat st;
+    if (stat(path, &st) == -1) return false;
+    return S_ISREG(st.st_mode) && ((uint64_t)st.st_size == size);
+}
+
+
+/*!
+    Once every task has run, delete the files of modules that are gone
+    (if \a whole_file) and write the new manifest, if anything changed.
+    Code in a store is shared, so it's never deleted; modules that are
+    gone just drop out of the manifest.
+ */
+int
+lisa_extract_finish_manifest(lisa_extract_job *job, lisa_extract_task *tasks, size_t task_count,
+                             bool whole_file, lisa_extract_stats *stats)
+{
+    int result = -1;
+    lisa_extract_manifest current = { .valid = true, .store = (job->store != NULL), .packed = job->packed };
+    bool changed = !job->manifest.valid || (job->manifest.packed != job->packed);
+
+    char manifest_path[PATH_MAX];
+    int path_err = lisa_extract_manifest_path(job->path_prefix, current.store, manifest_path, sizeof(manifest_path));
+    if (path_err == -1) goto done;
+
+    for (size_t t = 0; t < task_count; t++) {
+        lisa_extract_task *task = &tasks[t];
+
+        char path[PATH_MAX];
+        path_err = lisa_objfile_module_extract_path(job->objfile, task->module, job->path_prefix,
+                                                    path, sizeof(path));
+        if (path_err == -1) continue;
+
+        // A module that failed keeps its file, but drops out of the
+        // manifest so it's written again next time.
+
+        lisa_extract_manifest_entry *previous = lisa_extract_manifest_find(&job->manifest, path);
+        if (previous) previous->current = true;
+
+        if (task->written || task->unchanged || task->deduplicated) {
+            uint64_t size = (uint64_t)lisa_extract_output_size(job, task->module);
+            int add_err = lisa_extract_manifest_add(&current, path, task->hash, size,
+                                                    current.store ? task->digest : NULL);
+            if (add_err == -1) goto done;
+        }
+
+        if (task->written || task->deduplicated || (previous && !task->unchanged)) changed = true;
+    }
+
+    for (size_t e = 0; e < job->manifest.count; e++) {
+        lisa_extract_manifest_entry *previous = &job->manifest.entries[e];
+        if (previous->current) continue;
+
+        if (!whole_file) {
+            // Everything else is left alone, as long as it was written
+            // the same way.
+            if (job->manifest.packed == job->packed) {
+                int add_err = lisa_extract_manifest_add(&current, previous->name, previous->hash, previous->size,
+                                                        current.store ? previous->digest : NULL);
+                if (add_err == -1) goto done;
+            }
+            continue;
+        }
+
+        if (job->store) {
+            changed = true;
+            continue;
+        }
+
+        // Only delete what looks like one of our own files, in case the
+        // manifest has been tampered with.
+
+        size_t prefix_length = strlen(job->path_prefix);
+        size_t name_length = strlen(previous->name);
+        if ((strncmp(previous->name, job->path_prefix, prefix_length) != 0)
+            || (previous->name[prefix_length] != '-')
+            || (name_length < 4) || (strcmp(&previous->name[name_length - 4], ".bin") != 0))
+        {
+            continue;
+        }
+
+        int unlink_err = unlink(previous->name);
+        if ((unlink_err == -1) && (errno != ENOENT)) goto done;
+        stats->removed += 1;
+        changed = true;
+    }
+
+    if (changed) {
+        int write_err = lisa_extract_manifest_write(&current, manifest_path);
+        if (write_err == -1) goto done;
+    }
+
+    result = 0;
+
+done:
+    lisa_extract_manifest_free(&current);
+    return result;
+}
+
+
+/*!
+    Check the job's options, and load the manifest of the last extraction
+    if incremental or to a store.
+ */
+int
+lisa_extract_job_begin(lisa_extract_job *job)
+{
+    if (job->relocate && (job->packed || job->incremental)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (job->store && (job->archive || job->incremental)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (!job->incremental && !job->store) return 0;
+
+    if (job->archive) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    job->manifest.store = (job->store != NULL);
+
+    char manifest_path[PATH_MAX];
+    int path_err = lisa_extract_manifest_path(job->path_prefix, job->manifest.store,
+                                              manifest_path, sizeof(manifest_path));
+    if (path_err == -1) return -1;
+
+    return lisa_extract_manifest_read(&job->manifest, manifest_path);
+}
+
+
+/*!
+    Tally what every task did, and finish an incremental extraction or
+    one to a store. Records any failure in the job.
+ */
+void
+lisa_extract_job_end(lisa_extract_job *job, lisa_extract_task *tasks, size_t task_count,
+                     bool whole_file, lisa_extract_stats * LISA_NULLABLE stats)
+{
+    lisa_extract_stats job_stats = { 0 };
+
+    for (size_t t = 0; t < task_count; t++) {
+        if (tasks[t].written) job_stats.written += 1;
+        if (tasks[t].unchanged) job_stats.unchanged += 1;
+        if (tasks[t].deduplicated) job_stats.deduplicated += 1;
+        job_stats.relocated += tasks[t].relocated;
+        job_stats.unresolved += tasks[t].unresolved;
+    }
+
+    if (job->incremental || job->store) {
+        int finish_err = lisa_extract_finish_manifest(job, tasks, task_count, whole_file, &job_stats);
+        if (finish_err == -1) lisa_extract_job_fail(job, errno);
+    }
+
+    lisa_extract_manifest_free(&job->manifest);
+
+    if (stats) *stats = job_stats;
+}
+
+
+/*! Extract a single module using the given worker's buffer. */
+void
+lisa_extract_module(lisa_extract_job *job, lisa_extract_task *task, lisa_extract_worker *worker)
+{
+    const lisa_integer module_index = task->module;
+    const lisa_objfile_module *module = lisa_objfile_module_at_index(job->objfile, module_index);
+    lisa_objfile_block *block = lisa_objfile_block_at_index(job->objfile, module->code_block);
+
+    uint8_t *code;
+    lisa_longint code_size, unpacked_size;
+    lisa_MemAddr addr;
+    lisa_objfile_block_get_code(block, &code, &code_size, &unpacked_size, &addr);
+
+    char path[PATH_MAX];
+    if (job->archive == NULL) {
+        int path_err = lisa_objfile_module_extract_path(job->objfile, module_index, job->path_prefix,
+                                                        path, sizeof(path));
+        if (path_err == -1) {
+            lisa_extract_job_fail(job, ENAMETOOLONG);
+            return;
+        }
+    }
+
+    // When incremental, the code is hashed as stored, so unchanged
+    // modules can be skipped before they're unpacked. The block type
+    // seeds the hash, since it says how the code is stored. The same
+    // goes for a store, unless the code is relocated on the way.
+
+    if (job->incremental || (job->store && !job->relocate)) {
+        task->hash = hash_xxh64(code, (size_t)code_size, (uint64_t)lisa_objfile_block_type(block));
+
+        uint64_t size = (uint64_t)(job->packed ? code_size : unpacked_size);
+        if (lisa_extract_is_unchanged(job, path, task->hash, size, task->digest)) {
+            task->unchanged = true;
+            return;
+        }
+    }
+
+    // Code that's already in the right form is written straight from
+    // the file's buffer; only packed code needs the worker's buffer.
+
+    const uint8_t *output = code;
+    size_t output_size = (size_t)code_size;
+
+    if (!job->packed && (lisa_objfile_block_type(block) == PackedCode)) {
+        if (!lisa_extract_unpacked_size_valid(code_size, unpacked_size)) {
+            lisa_extract_job_fail(job, EINVAL);
+            return;
+        }
+
+        if (lisa_extract_worker_reserve(worker, (size_t)unpacked_size) == -1) {
+            lisa_extract_job_fail(job, ENOMEM);
+            return;
+        }
+
+        int unpack_err = lisa_unpackcode(code, code_size, worker->buffer, &unpacked_size, NULL);
+        if (unpack_err != 0) {
+            lisa_extract_job_fail(job, EINVAL);
+            return;
+        }
+
+        output = worker->buffer;
+        output_size = (size_t)unpacked_size;
+    }
+
+    // Relocation patches the code in place, so code that would have been
+    // written straight from the file's buffer is copied first.
+
+    if (job->relocate && lisa_objfile_module_has_references(job->objfile, module_index)) {
+        if (output != worker->buffer) {
+            if (lisa_extract_worker_reserve(worker, output_size) == -1) {
+                lisa_extract_job_fail(job, ENOMEM);
+                return;
+            }
+            memcpy(worker->buffer, output, output_size);
+            output = worker->buffer;
+        }
+
+        if (worker->relocator == NULL) {
+            worker->relocator = lisa_relocator_create(job->relocate);
+            if (worker->relocator == NULL) {
+                lisa_extract_job_fail(job, ENOMEM);
+                return;
+            }
+        }
+
+        lisa_relocate_stats relocate_stats;
+        int relocate_err = lisa_relocator_apply(worker->relocator, job->objfile, module_index,
+                                                worker->buffer, output_size, &relocate_stats);
+        if (relocate_err == -1) {
+            lisa_extract_job_fail(job, errno);
+            return;
+        }
+
+        task->relocated = relocate_stats.applied;
+        task->unresolved = relocate_stats.unresolved;
+    }
+
+    if (job->store) {
+        bool added;
+        int put_err = lisa_store_put(job->store, output, output_size, task->digest, &added);
+        if (put_err == -1) {
+            lisa_extract_job_fail(job, errno);
+            return;
+        }
+        task->written = added;
+        task->deduplicated = !added;
+        return;
+    }
+
+    if (job->archive) {
+        // The space was reserved from the code's header, so the code
+        // itself had better agree.
+        if (output_size != task->archive_size) {
+            lisa_extract_job_fail(job, EINVAL);
+            return;
+        }
+
+        int write_err = lisa_archive_writer_write(job->archive, task->archive_offset, output, output_size);
+        if (write_err == -1) {
+            lisa_extract_job_fail(job, errno);
+            return;
+        }
+        task->written = true;
+        return;
+    }
+
+    int write_err = lisa_extract_write_file(path, output, output_size);
+    if (write_err == -1) {
+        lisa_extract_job_fail(job, errno);
+        return;
+    }
+    task->written = true;
+}
+
+
+/*! Extract a single module; runs on a worker thread. */
+void
+lisa_extract_module_task(void * LISA_NULLABLE context, size_t worker_index)
+{
+    lisa_extract_task *task = context;
+    lisa_extract_job *job = task->job;
+
+    lisa_extract_module(job, task, &job->workers[worker_index]);
+}
+
+
+// MARK: - Extraction
+
+int
+lisa_objfile_module_extract_path(lisa_objfile *of, lisa_integer module_index,
+                                 const char *path_prefix,
+                                 char *path, size_t path_size)
+{
+    const lisa_objfile_module *module = lisa_objfile_module_at_index(of, module_index);
+    if (module->code_block == -1) return -1;
+
+    lisa_objfile_block *name_block = lisa_objfile_block_at_index(of, module->first_block);
+    lisa_objfile_block *code_block = lisa_objfile_block_at_index(of, module->code_block);
+    lisa_objfile_content name_content = lisa_objfile_block_content(name_block);
+
+    char module_name[9];
+    char segment_name[9];
+    lisa_ObjName_get_cstring(module_name, name_content.ModuleName->ModuleName);
+    lisa_ObjName_get_cstring(segment_name, name_content.ModuleName->SegmentName);
+
+    uint8_t *code;
+    lisa_longint code_size, unpacked_size;
+    lisa_MemAddr addr;
+    lisa_objfile_block_get_code(code_block, &code, &code_size, &unpacked_size, &addr);
+
+    // For the output file name, we use the input file name and add
+    // -modulename[-segmentname][-address].bin so it carries all of its
+    // important metadata with it. (If there's no segment or the address
+    // is 0, we skip those.)
+
+    strlcpy(path, path_prefix, path_size);
+    strlcat(path, "-", path_size);
+    strlcat(path, module_name, path_size);
+
+    if (segment_name[0] != '\0') {
+        strlcat(path, "-", path_size);
+        strlcat(path, segment_name, path_size);
+    }
+
+    if (addr != 0) {
+        char addrbuf[10];
+        strlcat(path, "-", path_size);
+        snprintf(addrbuf, 10, "$%08x", addr);
+        strlcat(path, addrbuf, path_size);
+    }
+
+    size_t length = strlcat(path, ".bin", path_size);
+    return (length < path_size) ? 0 : -1;
+}
+
+
+int
+lisa_objfile_extract(lisa_objfile *of, const char *path_prefix,
+                     const lisa_extract_options * LISA_NULLABLE options)
+{
+    lisa_extract_options default_options = { 0 };
+    if (options == NULL) options = &default_options;
+
+    // Module boundaries are already indexed, so all of the work can be
+    // handed out up front.
+
+    const lisa_integer module_count = lisa_objfile_module_count(of);
+    lisa_extract_task *tasks = calloc(sizeof(lisa_extract_task), (size_t)(module_count + 1));
+    if (tasks == NULL) return -1;
+
+    lisa_extract_job job = {
+        .objfile = of,
+        .path_prefix = path_prefix,
+        .packed = options->packed,
+        .incremental = options->incremental,
+        .relocate = options->relocate,
+        .archive = options->archive,
+        .store = options->store,
+        .workers = NULL,
+        .error = 0,
+    };
+    pthread_mutex_init(&job.lock, NULL);
+
+    if (lisa_extract_job_begin(&job) == -1) {
+        free(tasks);
+        pthread_mutex_destroy(&job.lock);
+        return -1;
+    }
+
+    size_t task_count = 0;
+    for (lisa_integer m = 0; m < module_count; m++) {
+        if (!lisa_extract_module_complete(of, m)) continue;
+        tasks[task_count].job = &job;
+        tasks[task_count].module = m;
+        task_count += 1;
+    }
+
+    if (job.archive && (task_count > 0)) {
+        int reserve_err = lisa_extract_reserve(&job, tasks, task_count);
+        if (reserve_err == -1) {
+            lisa_extract_manifest_free(&job.manifest);
+            free(tasks);
+            pthread_mutex_destroy(&job.lock);
+            return -1;
+        }
+    }
+
+    size_t thread_count = options->thread_count ? options->thread_count : thread_pool_default_thread_count();
+    if (thread_count > task_count) thread_count = task_count;
+
+    thread_pool *pool = NULL;
+
+    if ((task_count > 0) && (thread_count == 1)) {
+        // Not worth a thread; this is the usual case when many files are
+        // being extracted at once.
+
+        lisa_extract_worker worker = { 0 };
+        for (size_t t = 0; t < task_count; t++) {
+            lisa_extract_module(&job, &tasks[t], &worker);
+        }
+        lisa_extract_worker_dispose(&worker);
+    } else if (task_count > 0) {
+        job.workers = calloc(sizeof(lisa_extract_worker), thread_count);
+        if (job.workers == NULL) {
+            job.error = ENOMEM;
+            goto done;
+        }
+
+        pool = thread_pool_create(thread_count);
+        if (pool == NULL) {
+            job.error = ENOMEM;
+            goto done;
+        }
+
+        for (size_t t = 0; t < task_count; t++) {
+            int submit_err = thread_pool_submit(pool, lisa_extract_module_task, &tasks[t]);
+            if (submit_err == -1) {
+                lisa_extract_job_fail(&job, ENOMEM);
+                break;
+            }
+        }
+
+        thread_pool_wait(pool);
+    }
+
+done:
+    thread_pool_free(pool);
+
+    if (job.workers) {
+        for (size_t w = 0; w < thread_count; w++) {
+            lisa_extract_worker_dispose(&job.workers[w]);
+        }
+        free(job.workers);
+    }
+
+    lisa_extract_job_end(&job, tasks, task_count, true, options->stats);
+
+    free(tasks);
+    pthread_mutex_destroy(&job.lock);
+
+    if (job.error != 0) {
+        errno = job.error;
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+int
+lisa_objfile_extract_module(lisa_objfile *of, lisa_integer module,
+                            const char *path_prefix,
+                            const lisa_extract_options * LISA_NULLABLE options)
+{
+    if (!lisa_extract_module_complete(of, module)) {
+        errno = ENOENT;
+        return -1;
+    }
+
+    lisa_extract_worker worker = { 0 };
+    lisa_extract_job job = {
+        .objfile = of,
+        .path_prefix = path_prefix,
+        .packed = options ? options->packed : false,
+        .incremental = options ? options->incremental : false,
+        .relocate = options ? options->relocate : NULL,
+        .archive = options ? options->archive : NULL,
+        .store = options ? options->store : NULL,
+        .workers = &worker,
+        .error = 0,
+    };
+    pthread_mutex_init(&job.lock, NULL);
+
+    lisa_extract_task task = { .job = &job, .module = module };
+
+    if ((lisa_extract_job_begin(&job) == -1)
+        || (job.archive && (lisa_extract_reserve(&job, &task, 1) == -1)))
+    {
+        lisa_extract_manifest_free(&job.manifest);
+        pthread_mutex_destroy(&job.lock);
+        return -1;
+    }
+
+    lisa_extract_module(&job, &task, &worker);
+
+    lisa_extract_job_end(&job, &task, 1, false, options ? options->stats : NULL);
+
+    lisa_extract_worker_dispose(&worker);
+    pthread_mutex_destroy(&job.lock);
+
+    if (job.error != 0) {
+        errno = job.error;
+        return -1;
+    }
+
+    return 0;
+}
+
+
+LISA_SOURCE_END
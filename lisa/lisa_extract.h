@@ -0,0 +1,129 @@
+//  lisa_extract.h
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#ifndef __LISA__EXTRACT__H__
+#define __LISA__EXTRACT__H__
+
+#include <stddef.h>
+
+#include "lisa_defines.h"
+#include "lisa_types.h"
+
+#include "lisa_archive.h"
+#include "lisa_objio.h"
+#include "lisa_relocate.h"
+#include "lisa_store.h"
+
+LISA_HEADER_BEGIN
+
+
+/*! What an extraction did, for reporting. */
+struct lisa_extract_stats {
+    size_t				written;		//!< outputs written
+    size_t				deduplicated;	//!< outputs not written because the store already held them
+    size_t				unchanged;		//!< outputs skipped because their code hadn't changed
+    size_t				removed;		//!< outputs deleted because their module is gone
+    size_t				relocated;		//!< fields patched by relocation
+    size_t				unresolved;		//!< references to unknown symbols, left as they were
+};
+typedef struct lisa_extract_stats lisa_extract_stats;
+
+
+/*! Options for extracting code from an object file. */
+struct lisa_extract_options {
+    bool				packed;			//!< write code as stored, rather than unpacked
+    bool				incremental;	//!< only write code that changed since the last extraction
+    size_t				thread_count;	//!< worker threads to use, 0 for one per CPU
+    lisa_archive_writer	* LISA_NULLABLE archive;	//!< write entries to this archive instead of to files
+    lisa_store			* LISA_NULLABLE store;		//!< write code to this store instead of to files
+    lisa_extract_stats	* LISA_NULLABLE stats;		//!< filled in once extraction is done, if given
+    const lisa_relocate_options	* LISA_NULLABLE relocate;	//!< relocate unpacked code as given, if given
+};
+typedef struct lisa_extract_options lisa_extract_options;
+
+
+/*! Appended to the path prefix to name an incremental extraction's manifest. */
+#define LISA_EXTRACT_MANIFEST_SUFFIX ".manifest"
+
+/*! Appended to the path prefix to name the manifest of an extraction to a store. */
+#define LISA_EXTRACT_STORE_MANIFEST_SUFFIX ".store"
+
+
+/*!
+    Gets the path that the code for \a module of \a of is extracted to,
+    given the \a path_prefix for the whole file. This is the prefix
+    followed by `-modulename[-segmentname][-$address].bin`, omitting the
+    segment name if there isn't one and the address if it's 0.
+
+    Returns -1 if the module has no code or the path doesn't fit.
+ */
+LISA_EXTERN
+int
+lisa_objfile_module_extract_path(lisa_objfile *of, lisa_integer module,
+                                 const char *path_prefix,
+                                 char *path, size_t path_size);
+
+/*!
+    Extracts the code of every module in \a of to its own file, named
+    per `lisa_objfile_module_extract_path`. Only modules that end with
+    an EndBlock are extracted; one cut off before its EndBlock isn't.
+
+    Modules are unpacked and written in parallel, each worker reusing a
+    single unpacking buffer for all of the modules it handles.
+
+    If the options give an archive, the code is written there instead,
+    each module as an entry named just as its file would be. Space for
+    all of the file's entries is reserved together, so they're laid out
+    contiguously and can be written in parallel.
+
+    If the options ask for an incremental extraction, a manifest of the
+    files written is kept at the path prefix followed by
+    `LISA_EXTRACT_MANIFEST_SUFFIX`, recording a hash of each module's
+    code as stored in the object file. Modules whose stored code hashes
+    the same as last time, and whose file is still there, are skipped
+    without being unpacked; files whose modules are gone are deleted.
+    Incremental extraction can't be combined with an archive.
+
+    If the options give a store, the code is written there instead, each
+    module only if the store doesn't already hold the same code, and a
+    manifest is kept at the path prefix followed by
+    `LISA_EXTRACT_STORE_MANIFEST_SUFFIX`, giving the digest and size of
+    each module's code under the name its file would have. The manifest
+    also records a hash of each module's code as stored in the object
+    file, so extracting an unchanged file again finds its code in the
+    store without unpacking or hashing it. A store can't be combined
+    with an archive or with incremental extraction, which it subsumes.
+
+    If the options say how to relocate code, each module's code is
+    relocated as it's written, per `lisa_relocator_apply`. Relocation
+    can't be combined with writing code as stored, or with incremental
+    extraction.
+ */
+LISA_EXTERN
+int
+lisa_objfile_extract(lisa_objfile *of, const char *path_prefix,
+                     const lisa_extract_options * LISA_NULLABLE options);
+
+
+/*!
+    Extracts the code of just \a module of \a of to its own file, named
+    per `lisa_objfile_module_extract_path`, on the calling thread. Fails
+    with ENOENT if the module has no code or doesn't end with an EndBlock.
+
+    An incremental extraction of a single module, or one to a store,
+    updates just its own entry in the manifest, and never deletes
+    anything.
+ */
+LISA_EXTERN
+int
+lisa_objfile_extract_module(lisa_objfile *of, lisa_integer module,
+                            const char *path_prefix,
+                            const lisa_extract_options * LISA_NULLABLE options);
+
+
+LISA_HEADER_END
+
+#endif /* __LISA__EXTRACT__H__ */
@@ -0,0 +1,426 @@
+//  lisa_image.c
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#include "lisa_image.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "endian_utils.h"
+#include "thread_pool.h"
+
+
+LISA_SOURCE_BEGIN
+
+
+// MARK: - Internals
+
+/*! A region of a memory image being built. */
+struct lisa_image_region {
+    uint32_t			address;
+    uint32_t			size;
+    lisa_image_region_kind	kind;
+    lisa_integer		number;			//!< SegNumber, or -1
+    char				name[8];		//!< blank-padded
+    lisa_segment		segment;		//!< the code to unpack, for segments
+    struct lisa_image_build	*build;
+};
+typedef struct lisa_image_region lisa_image_region;
+
+/*! The state shared by the workers building a memory image. */
+struct lisa_image_build {
+    uint8_t				*image;			//!< the mapped image, after the header
+    uint32_t			base;			//!< memory address of the start of the image
+
+    pthread_mutex_t		lock;
+    int					error;			//!< first errno from any worker, or 0
+};
+typedef struct lisa_image_build lisa_image_build;
+
+
+/*! Record the first failure of a build, for reporting once it's done. */
+void
+lisa_image_build_fail(lisa_image_build *build, int error)
+{
+    pthread_mutex_lock(&build->lock);
+    if (build->error == 0) build->error = error;
+    pthread_mutex_unlock(&build->lock);
+}
+
+
+/*! Round \a value up to the image alignment. */
+uint64_t
+lisa_image_align(uint64_t value)
+{
+    return (value + (LISA_IMAGE_ALIGNMENT - 1)) & ~(uint64_t)(LISA_IMAGE_ALIGNMENT - 1);
+}
+
+
+int
+lisa_image_region_compare(const void *a, const void *b)
+{
+    const lisa_image_region *region_a = a;
+    const lisa_image_region *region_b = b;
+    if (region_a->address != region_b->address) {
+        return (region_a->address < region_b->address) ? -1 : 1;
+    }
+    return (int)region_a->kind - (int)region_b->kind;
+}
+
+
+/*!
+    Gather the regions of the executable: a segment per JTSegVariant,
+    then the jump table and global data if there are any. Returns the
+    number of regions, or -1.
+ */
+ssize_t
+lisa_image_gather_regions(lisa_objfile *of, lisa_Executable *executable, lisa_image_region *regions)
+{
+    size_t count = 0;
+
+    lisa_JTSegVariantTable *jtsegs = lisa_Executable_JTSegVariantTable(executable);
+    for (lisa_integer i = 0; i < jtsegs->numSegs; i++) {
+        const lisa_JTSegVariant *variant = &jtsegs->variants[i];
+        lisa_image_region *region = &regions[count++];
+
+        int segment_err = lisa_objfile_segment_at_offset(of, variant->SegmentAddr, &region->segment);
+        if (segment_err == -1) return -1;
+
+        // The variant's sizes are only 16 bits, so the code block's own
+        // size is the one to trust.
+
+        region->address = (uint32_t)variant->MemLoc;
+        region->size = (uint32_t)region->segment.unpacked_size;
+        region->kind = lisa_image_region_segment;
+        region->number = region->segment.number;
+        memset(region->name, ' ', 8);
+        memcpy(region->name, region->segment.name, strlen(region->segment.name));
+    }
+
+    if (executable->JTSize > 0) {
+        regions[count++] = (lisa_image_region){
+            .address = (uint32_t)executable->JTLaddr,
+            .size = (uint32_t)executable->JTSize,
+            .kind = lisa_image_region_jump_table,
+            .number = -1,
+            .name = "        ",
+        };
+    }
+
+    // Globals are addressed at negative offsets from the jump table, so
+    // they sit just below it.
+
+    if (executable->DataSize > 0) {
+        if ((uint32_t)executable->DataSize > (uint32_t)executable->JTLaddr) {
+            errno = EINVAL;
+            return -1;
+        }
+
+        regions[count++] = (lisa_image_region){
+            .address = (uint32_t)executable->JTLaddr - (uint32_t)executable->DataSize,
+            .size = (uint32_t)executable->DataSize,
+            .kind = lisa_image_region_data,
+            .number = -1,
+            .name = "        ",
+        };
+    }
+
+    return (ssize_t)count;
+}
+
+
+/*!
+    Sort the regions by address and find the extent of the image. Fails
+    if any of the regions with content overlap, or if the image doesn't
+    fit in the address space.
+ */
+int
+lisa_image_lay_out(lisa_image_region *regions, size_t count, uint32_t *base, uint64_t *size)
+{
+    qsort(regions, count, sizeof(lisa_image_region), lisa_image_region_compare);
+
+    uint64_t start = UINT64_MAX;
+    uint64_t end = 0;
+    uint64_t content_end = 0;
+
+    for (size_t r = 0; r < count; r++) {
+        const lisa_image_region *region = &regions[r];
+        uint64_t region_end = (uint64_t)region->address + region->size;
+
+        if (region->address < start) start = region->address;
+        if (region_end > end) end = region_end;
+
+        // Global data is just zeroes, so nothing is lost if code
+        // overlaps it; code that overlaps other code is an error.
+
+        if (region->kind == lisa_image_region_data) continue;
+        if (region->address < content_end) {
+            errno = EINVAL;
+            return -1;
+        }
+        content_end = region_end;
+    }
+
+    if (count == 0) start = 0;
+    if (end > UINT32_MAX) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    *base = (uint32_t)start;
+    *size = end - start;
+    return 0;
+}
+
+
+/*!
+    Reserve space on disk for the regions with content, where the
+    platform allows, so writing them through the mapping can't fail.
+    Everything else is left as holes.
+ */
+int
+lisa_image_preallocate(int fd, const lisa_image_region *regions, size_t count,
+                       uint64_t header_size, uint32_t base)
+{
+#if defined(__linux__)
+    for (size_t r = 0; r < count; r++) {
+        const lisa_image_region *region = &regions[r];
+        if ((region->kind == lisa_image_region_data) || (region->size == 0)) continue;
+
+        off_t offset = (off_t)(header_size + (region->address - base));
+        int fallocate_err = posix_fallocate(fd, offset, (off_t)region->size);
+        if (fallocate_err == ENOSPC) {
+            errno = ENOSPC;
+            return -1;
+        }
+    }
+#else
+    (void)fd; (void)regions; (void)count; (void)header_size; (void)base;
+#endif
+
+    return 0;
+}
+
+
+/*! Write the image's header and region records. */
+void
+lisa_image_write_header(uint8_t *header, lisa_Executable *executable,
+                        const lisa_image_region *regions, size_t count,
+                        uint64_t header_size, uint32_t base, uint64_t size)
+{
+    const uint32_t fields[] = {
+        LISA_IMAGE_VERSION,
+        (uint32_t)header_size,
+        base,
+        (uint32_t)size,
+        (uint32_t)executable->JTLaddr,
+        (uint32_t)executable->JTSize,
+        (uint32_t)executable->DataSize,
+        (uint32_t)executable->MainSize,
+        (uint32_t)executable->JTSegDelta,
+        (uint32_t)executable->StkSegDelta,
+        (uint32_t)executable->DynStack,
+        (uint32_t)executable->MaxStack,
+        (uint32_t)executable->MinHeap,
+        (uint32_t)executable->MaxHeap,
+        (uint32_t)count,
+        0,
+    };
+
+    memcpy(&header[0], LISA_IMAGE_MAGIC, 8);
+    for (size_t f = 0; f < sizeof(fields) / sizeof(fields[0]); f++) {
+        uint32_t field_be = swapu32be(fields[f]);
+        memcpy(&header[8 + f * 4], &field_be, 4);
+    }
+
+    for (size_t r = 0; r < count; r++) {
+        const lisa_image_region *region = &regions[r];
+        uint8_t *record = &header[LISA_IMAGE_HEADER_SIZE + r * LISA_IMAGE_RECORD_SIZE];
+
+        uint32_t address_be = swapu32be(region->address);
+        uint32_t size_be = swapu32be(region->size);
+        uint16_t kind_be = swapu16be((uint16_t)region->kind);
+        uint16_t number_be = swapu16be((uint16_t)region->number);
+        memcpy(&record[0], &address_be, 4);
+        memcpy(&record[4], &size_be, 4);
+        memcpy(&record[8], &kind_be, 2);
+        memcpy(&record[10], &number_be, 2);
+        memcpy(&record[12], region->name, 8);
+    }
+}
+
+
+/*! Write the jump table's descriptors, as far as they fit in JTSize. */
+void
+lisa_image_write_jump_table(uint8_t *jump_table, lisa_Executable *executable)
+{
+    lisa_JTVariantTable *jtvariants = lisa_Executable_JTVariantTable(executable);
+    size_t count = (jtvariants->numDescriptors > 0) ? (size_t)jtvariants->numDescriptors : 0;
+    if (count > (size_t)executable->JTSize / sizeof(lisa_JTVariant)) {
+        count = (size_t)executable->JTSize / sizeof(lisa_JTVariant);
+    }
+
+    for (size_t d = 0; d < count; d++) {
+        uint16_t jump_be = swapu16be((uint16_t)jtvariants->variants[d].JumpL);
+        uint32_t addr_be = swapu32be((uint32_t)jtvariants->variants[d].AbsAddr);
+        memcpy(&jump_table[d * sizeof(lisa_JTVariant)], &jump_be, 2);
+        memcpy(&jump_table[d * sizeof(lisa_JTVariant) + 2], &addr_be, 4);
+    }
+}
+
+
+/*! Unpack a segment straight into its place in the image. */
+void
+lisa_image_segment_task(void * LISA_NULLABLE context, size_t worker)
+{
+    (void)worker;
+    lisa_image_region *region = context;
+    lisa_image_build *build = region->build;
+
+    lisa_longint unpacked_size = region->segment.unpacked_size;
+    int unpack_err = lisa_segment_unpack(&region->segment, &build->image[region->address - build->base],
+                                         &unpacked_size);
+    if (unpack_err == -1) lisa_image_build_fail(build, errno);
+}
+
+
+// MARK: - Images
+
+int
+lisa_objfile_build_image(lisa_objfile *of, const char *path,
+                         const lisa_image_options *options)
+{
+    int result = -1;
+    int build_errno = 0;
+    int fd = -1;
+    bool created = false;
+    uint8_t *mapping = MAP_FAILED;
+    size_t mapping_size = 0;
+    lisa_image_region *regions = NULL;
+    thread_pool *pool = NULL;
+
+    lisa_image_build build = { 0 };
+    pthread_mutex_init(&build.lock, NULL);
+
+    lisa_Executable *executable = lisa_objfile_executable(of);
+    if (executable == NULL) {
+        errno = EINVAL;
+        goto done;
+    }
+
+    // Lay out every region before creating anything, so an executable
+    // that can't be imaged doesn't leave a file behind.
+
+    lisa_JTSegVariantTable *jtsegs = lisa_Executable_JTSegVariantTable(executable);
+    size_t max_regions = ((jtsegs->numSegs > 0) ? (size_t)jtsegs->numSegs : 0) + 2;
+    regions = calloc(sizeof(lisa_image_region), max_regions);
+    if (regions == NULL) goto done;
+
+    ssize_t count = lisa_image_gather_regions(of, executable, regions);
+    if (count == -1) goto done;
+
+    uint64_t size;
+    int layout_err = lisa_image_lay_out(regions, (size_t)count, &build.base, &size);
+    if (layout_err == -1) goto done;
+
+    const uint64_t header_size = lisa_image_align(LISA_IMAGE_HEADER_SIZE
+                                                  + (uint64_t)count * LISA_IMAGE_RECORD_SIZE);
+    mapping_size = (size_t)(header_size + size);
+
+    // Size the file to hold the whole image up front, so it's sparse,
+    // then write everything through a mapping of it.
+
+    fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (fd == -1) goto done;
+    created = true;
+
+    int truncate_err = ftruncate(fd, (off_t)mapping_size);
+    if (truncate_err == -1) goto done;
+
+    int preallocate_err = lisa_image_preallocate(fd, regions, (size_t)count, header_size, build.base);
+    if (preallocate_err == -1) goto done;
+
+    mapping = mmap(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) goto done;
+
+    build.image = &mapping[header_size];
+
+    lisa_image_write_header(mapping, executable, regions, (size_t)count, header_size, build.base, size);
+    if (executable->JTSize > 0) {
+        lisa_image_write_jump_table(&build.image[(uint32_t)executable->JTLaddr - build.base], executable);
+    }
+
+    // Segments' ranges are disjoint, so each can be unpacked in place
+    // without any coordination.
+
+    size_t segment_count = 0;
+    for (ssize_t r = 0; r < count; r++) {
+        regions[r].build = &build;
+        if (regions[r].kind == lisa_image_region_segment) segment_count += 1;
+    }
+
+    size_t thread_count = options->thread_count ? options->thread_count : thread_pool_default_thread_count();
+    if (thread_count > segment_count) thread_count = segment_count;
+
+    if (thread_count <= 1) {
+        for (ssize_t r = 0; r < count; r++) {
+            if (regions[r].kind == lisa_image_region_segment) lisa_image_segment_task(&regions[r], 0);
+        }
+    } else {
+        pool = thread_pool_create(thread_count);
+        if (pool == NULL) goto done;
+
+        for (ssize_t r = 0; r < count; r++) {
+            if (regions[r].kind != lisa_image_region_segment) continue;
+
+            int submit_err = thread_pool_submit(pool, lisa_image_segment_task, &regions[r]);
+            if (submit_err == -1) {
+                lisa_image_build_fail(&build, ENOMEM);
+                break;
+            }
+        }
+
+        thread_pool_wait(pool);
+    }
+
+    if (build.error != 0) {
+        errno = build.error;
+        goto done;
+    }
+
+    int unmap_err = munmap(mapping, mapping_size);
+    mapping = MAP_FAILED;
+    if (unmap_err == -1) goto done;
+
+    int close_err = close(fd);
+    fd = -1;
+    if (close_err == -1) goto done;
+
+    result = 0;
+
+done:
+    build_errno = errno;
+
+    thread_pool_free(pool);
+    if (mapping != MAP_FAILED) munmap(mapping, mapping_size);
+    if (fd != -1) close(fd);
+    free(regions);
+    pthread_mutex_destroy(&build.lock);
+
+    // Don't leave a partial image behind.
+    if ((result == -1) && created) unlink(path);
+
+    errno = build_errno;
+    return result;
+}
+
+
+LISA_SOURCE_END
@@ -0,0 +1,87 @@
+//  lisa_image.h
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#ifndef __LISA__IMAGE__H__
+#define __LISA__IMAGE__H__
+
+#include <stddef.h>
+
+#include "lisa_defines.h"
+#include "lisa_types.h"
+
+#include "lisa_objio.h"
+
+LISA_HEADER_BEGIN
+
+
+/*!
+    A memory image of an executable: its segments, jump table and global
+    data laid out as they would sit in Lisa memory, in a single file
+    meant to be mapped and used in place.
+
+    The format is uncompressed, and all integers are big-endian.
+
+    - A header: the magic `LISAIMG\0`, a 32-bit version (1), the 32-bit
+      size of the header, the 32-bit memory address of the start of the
+      image, and the 32-bit size of the image.
+    - The executable's JTLaddr, JTSize, DataSize, MainSize, JTSegDelta,
+      StkSegDelta, DynStack, MaxStack, MinHeap and MaxHeap, 32 bits each.
+    - The 32-bit number of regions, and 32 bits of zero.
+    - A 24-byte record per region, sorted by address, holding its 32-bit
+      address, 32-bit size, 16-bit kind, 16-bit segment number (or -1),
+      8-byte blank-padded name, and 32 bits of zero.
+    - Padding to `LISA_IMAGE_ALIGNMENT`, which is the size of the header.
+    - The image itself, so memory address `a` is at file offset
+      `header size + (a - image address)`.
+
+    Memory between regions is left as holes in the file, so it reads as
+    zero without taking up any space.
+ */
+#define LISA_IMAGE_MAGIC				"LISAIMG"
+#define LISA_IMAGE_VERSION				1
+#define LISA_IMAGE_HEADER_SIZE			72
+#define LISA_IMAGE_RECORD_SIZE			24
+#define LISA_IMAGE_ALIGNMENT			4096
+
+
+/*! What a region of a memory image holds. */
+enum lisa_image_region_kind: uint16_t {
+    lisa_image_region_segment		= 1,	//!< a segment's unpacked code, at its MemLoc
+    lisa_image_region_jump_table	= 2,	//!< the jump table, at JTLaddr
+    lisa_image_region_data			= 3,	//!< global data, the DataSize bytes below JTLaddr
+};
+typedef enum lisa_image_region_kind lisa_image_region_kind;
+
+
+/*! Options for building a memory image. */
+struct lisa_image_options {
+    size_t				thread_count;	//!< worker threads to use, 0 for one per CPU
+};
+typedef struct lisa_image_options lisa_image_options;
+
+
+/*!
+    Builds a memory image of the executable \a of at \a path, replacing
+    any file already there.
+
+    Each segment in the executable's JTSegVariantTable is unpacked
+    straight into the mapped image at its MemLoc, in parallel, since
+    their ranges are disjoint. The jump table is written from its
+    JTVariantTable, and the global data is left zeroed.
+
+    Returns -1 with errno set to EINVAL if \a of isn't an executable or
+    its segments and jump table overlap, or to ENOENT if a segment's
+    code can't be found.
+ */
+LISA_EXTERN
+int
+lisa_objfile_build_image(lisa_objfile *of, const char *path,
+                         const lisa_image_options *options);
+
+
+LISA_HEADER_END
+
+#endif /* __LISA__IMAGE__H__ */
@@ -0,0 +1,877 @@
+//  lisa_link.c
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#include "lisa_link.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "lisa_relocate.h"
+#include "lisa_symbols.h"
+#include "lisa_writer.h"
+#include "thread_pool.h"
+
+
+LISA_SOURCE_BEGIN
+
+
+// MARK: - Internals
+
+/*! The instruction of every jump table descriptor: `JMP abs.L`. */
+#define LISA_LINK_JUMP_OPCODE	0x4EF9
+
+/*! The size of a PackedCode block's content before its code. */
+#define LISA_LINK_PACKED_HEADER_SIZE	8
+
+/*! The size of a CodeBlock's content before its code. */
+#define LISA_LINK_CODE_HEADER_SIZE		4
+
+
+/*! A module being linked. */
+struct lisa_link_module {
+    lisa_objfile		*objfile;
+    const char			*path;
+    lisa_integer		index;			//!< within its object file
+    char				name[9];
+    size_t				segment;
+    lisa_MemAddr		code_addr;		//!< Addr of its code block
+    uint32_t			offset;			//!< of its code within its segment
+    uint32_t			size;			//!< of its code, unpacked
+};
+typedef struct lisa_link_module lisa_link_module;
+
+/*! A segment being linked. */
+struct lisa_link_segment {
+    lisa_ObjName		name;
+    uint32_t			address;
+    uint32_t			size;
+    size_t				first_module;	//!< into the link's module order
+    size_t				module_count;
+    size_t				first_definition;	//!< into the link's definitions by address
+    size_t				definition_count;
+    lisa_symbol_table	* LISA_NULLABLE locals;	//!< addresses of the segment's own entry points
+
+    uint8_t				* LISA_NULLABLE content;	//!< PackedCode or CodeBlock content, once assembled
+    lisa_longint		content_size;
+    bool				packed;			//!< whether the content is PackedCode
+    lisa_longint		stored_size;	//!< of its code as stored in the content
+    lisa_relocate_stats	stats;
+    int					error;			//!< errno if assembling failed, or 0
+    struct lisa_link	*link;
+};
+typedef struct lisa_link_segment lisa_link_segment;
+
+/*! An entry point, as first defined. */
+struct lisa_link_definition {
+    lisa_ObjName		name;
+    lisa_ObjName		user_name;		//!< as the defining EntryPoint gives it
+    size_t				module;
+    uint32_t			address;
+    bool				jump;			//!< whether it needs a jump table descriptor
+};
+typedef struct lisa_link_definition lisa_link_definition;
+
+/*! Where a definition is, for sorting definitions by address. */
+struct lisa_link_placement {
+    uint32_t			address;
+    size_t				definition;
+};
+typedef struct lisa_link_placement lisa_link_placement;
+
+/*! The state of a link in progress. */
+struct lisa_link {
+    const lisa_link_options	*options;
+
+    lisa_link_module	* LISA_NULLABLE modules;	//!< in input order
+    size_t				module_count;
+    size_t				module_capacity;
+    size_t				* LISA_NULLABLE order;	//!< module indexes, grouped by segment
+
+    lisa_link_segment	* LISA_NULLABLE segments;
+    size_t				segment_count;
+    size_t				segment_capacity;
+    lisa_symbol_table	* LISA_NULLABLE segment_names;	//!< segment indexes, by name
+
+    lisa_link_definition	* LISA_NULLABLE definitions;
+    size_t				definition_count;
+    size_t				definition_capacity;
+    lisa_symbol_table	* LISA_NULLABLE definition_names;	//!< definition indexes, by name
+    lisa_link_placement	* LISA_NULLABLE by_address;	//!< definitions, by address
+    size_t				duplicates;
+
+    bool				has_start;
+    size_t				start_module;
+    lisa_SegAddr		start;			//!< Start of the StartAddress block
+    lisa_longint		data_size;		//!< GSize of the StartAddress block
+
+    uint32_t			jump_table_address;
+    uint32_t			* LISA_NULLABLE jump_targets;	//!< address each descriptor jumps to
+    size_t				jump_count;
+    lisa_symbol_table	* LISA_NULLABLE jump_symbols;	//!< descriptor addresses, by name
+
+    lisa_relocator		* LISA_NULLABLE * LISA_NULLABLE relocators;	//!< one per worker
+    lisa_relocate_options	* LISA_NULLABLE relocate_options;	//!< one per worker
+    size_t				worker_count;
+};
+typedef struct lisa_link lisa_link_state;
+
+
+/*! Make sure the array at \a items has room for one more item. */
+int
+lisa_link_reserve(void * LISA_NULLABLE * LISA_NONNULL items, size_t *capacity, size_t count, size_t item_size)
+{
+    if (count < *capacity) return 0;
+
+    size_t new_capacity = *capacity ? *capacity * 2 : 64;
+    void *grown = realloc(*items, item_size * new_capacity);
+    if (grown == NULL) return -1;
+    *items = grown;
+    *capacity = new_capacity;
+    return 0;
+}
+
+
+/*! Round \a value up to a multiple of \a alignment, a power of 2. */
+uint64_t
+lisa_link_align(uint64_t value, uint64_t alignment)
+{
+    return (value + (alignment - 1)) & ~(alignment - 1);
+}
+
+
+/*! Get the index of the segment named \a name, adding it if it's new. */
+ssize_t
+lisa_link_segment_named(lisa_link_state *link, const lisa_ObjName name)
+{
+    lisa_MemAddr index;
+    if (lisa_symbol_table_lookup_ObjName(link->segment_names, name, &index)) return (ssize_t)index;
+
+    if (lisa_link_reserve((void **)&link->segments, &link->segment_capacity,
+                          link->segment_count, sizeof(lisa_link_segment)) == -1) return -1;
+
+    lisa_link_segment *segment = &link->segments[link->segment_count];
+    *segment = (lisa_link_segment){ .link = link };
+    memcpy(segment->name, name, sizeof(lisa_ObjName));
+
+    segment->locals = lisa_symbol_table_create();
+    if (segment->locals == NULL) return -1;
+
+    if (lisa_symbol_table_add_ObjName(link->segment_names, name, (lisa_MemAddr)link->segment_count) == -1) {
+        lisa_symbol_table_free(segment->locals);
+        return -1;
+    }
+
+    return (ssize_t)link->segment_count++;
+}
+
+
+/*! Gather every module of every input, and the start address if any. */
+int
+lisa_link_gather(lisa_link_state *link, const lisa_link_input *inputs, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        lisa_objfile *of = inputs[i].objfile;
+
+        if (lisa_objfile_executable(of) != NULL) {
+            errno = EINVAL;
+            return -1;
+        }
+
+        const lisa_integer module_count = lisa_objfile_module_count(of);
+        for (lisa_integer m = 0; m < module_count; m++) {
+            const lisa_objfile_module *module = lisa_objfile_module_at_index(of, m);
+
+            if (lisa_link_reserve((void **)&link->modules, &link->module_capacity,
+                                  link->module_count, sizeof(lisa_link_module)) == -1) return -1;
+
+            lisa_link_module *link_module = &link->modules[link->module_count];
+            *link_module = (lisa_link_module){ .objfile = of, .path = inputs[i].path, .index = m };
+
+            lisa_objfile_block *name_block = lisa_objfile_block_at_index(of, module->first_block);
+            lisa_ObjName_get_cstring(link_module->name, lisa_objfile_block_content(name_block).ModuleName->ModuleName);
+
+            if (module->code_block != -1) {
+                uint8_t *code;
+                lisa_longint code_size, unpacked_size;
+                lisa_objfile_block_get_code(lisa_objfile_block_at_index(of, module->code_block),
+                                            &code, &code_size, &unpacked_size, &link_module->code_addr);
+                link_module->size = (uint32_t)unpacked_size;
+            }
+
+            for (lisa_integer b = module->first_block; (b <= module->last_block) && !link->has_start; b++) {
+                lisa_objfile_block *block = lisa_objfile_block_at_index(of, b);
+                if (lisa_objfile_block_type(block) != StartAddress) continue;
+
+                link->has_start = true;
+                link->start_module = link->module_count;
+                link->start = lisa_objfile_block_content(block).StartAddress->Start;
+                link->data_size = lisa_objfile_block_content(block).StartAddress->GSize;
+            }
+
+            link->module_count += 1;
+        }
+    }
+
+    return 0;
+}
+
+
+/*! Put the module at index \a m in the segment it names. */
+int
+lisa_link_assign_segment(lisa_link_state *link, size_t m)
+{
+    lisa_link_module *module = &link->modules[m];
+    const lisa_objfile_module *of_module = lisa_objfile_module_at_index(module->objfile, module->index);
+    lisa_objfile_block *name_block = lisa_objfile_block_at_index(module->objfile, of_module->first_block);
+
+    ssize_t segment = lisa_link_segment_named(link, lisa_objfile_block_content(name_block).ModuleName->SegmentName);
+    if (segment == -1) return -1;
+    module->segment = (size_t)segment;
+    return 0;
+}
+
+
+/*!
+    Group the modules into segments by SegmentName, with the segment
+    holding the start address first, and lay them out in memory.
+ */
+int
+lisa_link_lay_out(lisa_link_state *link)
+{
+    if (link->has_start && (lisa_link_assign_segment(link, link->start_module) == -1)) return -1;
+    for (size_t m = 0; m < link->module_count; m++) {
+        if (lisa_link_assign_segment(link, m) == -1) return -1;
+    }
+
+    // Order the modules by segment, keeping their input order within
+    // each, and give each its place in its segment.
+
+    link->order = calloc(sizeof(size_t), link->module_count ? link->module_count : 1);
+    if (link->order == NULL) return -1;
+
+    for (size_t m = 0; m < link->module_count; m++) {
+        link->segments[link->modules[m].segment].module_count += 1;
+    }
+
+    size_t first = 0;
+    for (size_t s = 0; s < link->segment_count; s++) {
+        link->segments[s].first_module = first;
+        first += link->segments[s].module_count;
+        link->segments[s].module_count = 0;
+    }
+
+    for (size_t m = 0; m < link->module_count; m++) {
+        lisa_link_module *module = &link->modules[m];
+        lisa_link_segment *segment = &link->segments[module->segment];
+
+        module->offset = segment->size;
+        segment->size = (uint32_t)lisa_link_align((uint64_t)segment->size + module->size, 2);
+        link->order[segment->first_module + segment->module_count++] = m;
+    }
+
+    // Then lay the segments out one after another, followed by the
+    // global data and the jump table.
+
+    uint64_t address = link->options->base ? (uint32_t)link->options->base : LISA_LINK_DEFAULT_BASE;
+    for (size_t s = 0; s < link->segment_count; s++) {
+        address = lisa_link_align(address, LISA_LINK_SEGMENT_ALIGNMENT);
+        link->segments[s].address = (uint32_t)address;
+        address += link->segments[s].size;
+    }
+
+    // Segment sizes are only 16 bits wide in the segment tables.
+
+    for (size_t s = 0; s < link->segment_count; s++) {
+        if (link->segments[s].size > UINT16_MAX) {
+            errno = EFBIG;
+            return -1;
+        }
+    }
+
+    address = lisa_link_align(address, LISA_LINK_SEGMENT_ALIGNMENT);
+    address += lisa_link_align((link->data_size > 0) ? (uint64_t)link->data_size : 0, 2);
+    if (address > UINT32_MAX) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    link->jump_table_address = (uint32_t)address;
+    return 0;
+}
+
+
+/*! Where a module address in \a module ends up in memory. */
+uint32_t
+lisa_link_module_address(const lisa_link_state *link, const lisa_link_module *module, lisa_SegAddr addr)
+{
+    return link->segments[module->segment].address + module->offset + (uint32_t)(addr - module->code_addr);
+}
+
+
+int
+lisa_link_placement_compare(const void *a, const void *b)
+{
+    const lisa_link_placement *placement_a = a;
+    const lisa_link_placement *placement_b = b;
+    if (placement_a->address != placement_b->address) return (placement_a->address < placement_b->address) ? -1 : 1;
+    return (placement_a->definition < placement_b->definition) ? -1 : 1;
+}
+
+
+/*! Gather every module's entry points into the symbol table, first definition first. */
+int
+lisa_link_define(lisa_link_state *link)
+{
+    for (size_t m = 0; m < link->module_count; m++) {
+        const lisa_link_module *module = &link->modules[m];
+        const lisa_objfile_module *of_module = lisa_objfile_module_at_index(module->objfile, module->index);
+
+        for (lisa_integer b = of_module->first_block; b <= of_module->last_block; b++) {
+            lisa_objfile_block *block = lisa_objfile_block_at_index(module->objfile, b);
+            if (lisa_objfile_block_type(block) != EntryPoint) continue;
+
+            const lisa_EntryPoint *entry = lisa_objfile_block_content(block).EntryPoint;
+            lisa_MemAddr existing;
+            if (lisa_symbol_table_lookup_ObjName(link->definition_names, entry->LinkName, &existing)) {
+                link->duplicates += 1;
+                continue;
+            }
+
+            if (lisa_link_reserve((void **)&link->definitions, &link->definition_capacity,
+                                  link->definition_count, sizeof(lisa_link_definition)) == -1) return -1;
+
+            lisa_link_definition *definition = &link->definitions[link->definition_count];
+            *definition = (lisa_link_definition){
+                .module = m,
+                .address = lisa_link_module_address(link, module, entry->Loc),
+            };
+            memcpy(definition->name, entry->LinkName, sizeof(lisa_ObjName));
+            memcpy(definition->user_name, entry->UserName, sizeof(lisa_ObjName));
+
+            int add_err = lisa_symbol_table_add_ObjName(link->definition_names, entry->LinkName,
+                                                        (lisa_MemAddr)link->definition_count);
+            if (add_err == -1) return -1;
+
+            int local_err = lisa_symbol_table_add_ObjName(link->segments[module->segment].locals, entry->LinkName,
+                                                          (lisa_MemAddr)definition->address);
+            if (local_err == -1) return -1;
+
+            link->definition_count += 1;
+        }
+    }
+
+    // Segments are laid out in order, so sorting by address also groups
+    // each segment's definitions together.
+
+    link->by_address = calloc(sizeof(lisa_link_placement), link->definition_count ? link->definition_count : 1);
+    if (link->by_address == NULL) return -1;
+
+    for (size_t d = 0; d < link->definition_count; d++) {
+        link->by_address[d] = (lisa_link_placement){ .address = link->definitions[d].address, .definition = d };
+    }
+    qsort(link->by_address, link->definition_count, sizeof(lisa_link_placement), lisa_link_placement_compare);
+
+    for (size_t i = 0; i < link->definition_count; i++) {
+        const lisa_link_definition *definition = &link->definitions[link->by_address[i].definition];
+        lisa_link_segment *segment = &link->segments[link->modules[definition->module].segment];
+        if (segment->definition_count == 0) segment->first_definition = i;
+        segment->definition_count += 1;
+    }
+
+    return 0;
+}
+
+
+/*!
+    Give a jump table descriptor to the start address, and to every
+    entry point referenced from outside its own segment, in address
+    order.
+ */
+int
+lisa_link_build_jump_table(lisa_link_state *link)
+{
+    for (size_t m = 0; m < link->module_count; m++) {
+        const lisa_link_module *module = &link->modules[m];
+        const lisa_objfile_module *of_module = lisa_objfile_module_at_index(module->objfile, module->index);
+
+        for (lisa_integer b = of_module->first_block; b <= of_module->last_block; b++) {
+            lisa_objfile_block *block = lisa_objfile_block_at_index(module->objfile, b);
+            const char *name;
+
+            switch (lisa_objfile_block_type(block)) {
+                case External:		name = lisa_objfile_block_content(block).External->LinkName;		break;
+                case ShortExternal:	name = lisa_objfile_block_content(block).ShortExternal->LinkName;	break;
+                default:			continue;
+            }
+
+            lisa_MemAddr d;
+            if (!lisa_symbol_table_lookup_ObjName(link->definition_names, name, &d)) continue;
+
+            lisa_link_definition *definition = &link->definitions[d];
+            if (link->modules[definition->module].segment != module->segment) definition->jump = true;
+        }
+    }
+
+    link->jump_targets = calloc(sizeof(uint32_t), link->definition_count + 1);
+    if (link->jump_targets == NULL) return -1;
+
+    if (link->has_start) {
+        const lisa_link_module *module = &link->modules[link->start_module];
+        link->jump_targets[link->jump_count++] = lisa_link_module_address(link, module, link->start);
+    }
+
+    for (size_t i = 0; i < link->definition_count; i++) {
+        const lisa_link_definition *definition = &link->definitions[link->by_address[i].definition];
+        if (!definition->jump) continue;
+
+        if (link->jump_count == INT16_MAX) {
+            errno = EFBIG;
+            return -1;
+        }
+
+        uint32_t descriptor = link->jump_table_address + (uint32_t)(link->jump_count * sizeof(lisa_JTVariant));
+        int add_err = lisa_symbol_table_add_ObjName(link->jump_symbols, definition->name, (lisa_MemAddr)descriptor);
+        if (add_err == -1) return -1;
+
+        link->jump_targets[link->jump_count++] = definition->address;
+    }
+
+    return 0;
+}
+
+
+/*! Assemble, relocate and pack a segment. */
+void
+lisa_link_segment_task(void * LISA_NULLABLE context, size_t worker)
+{
+    lisa_link_segment *segment = context;
+    lisa_link_state *link = segment->link;
+    lisa_relocator *relocator = link->relocators[worker];
+    lisa_relocate_options *relocate_options = &link->relocate_options[worker];
+
+    uint8_t *code = calloc(segment->size ? segment->size : 1, 1);
+    if (code == NULL) goto error;
+
+    for (size_t i = 0; i < segment->module_count; i++) {
+        const lisa_link_module *module = &link->modules[link->order[segment->first_module + i]];
+        const lisa_objfile_module *of_module = lisa_objfile_module_at_index(module->objfile, module->index);
+        if (of_module->code_block == -1) continue;
+
+        uint8_t *stored;
+        lisa_longint stored_size, unpacked_size;
+        lisa_MemAddr addr;
+        lisa_objfile_block_get_code(lisa_objfile_block_at_index(module->objfile, of_module->code_block),
+                                    &stored, &stored_size, &unpacked_size, &addr);
+
+        uint8_t *module_code = &code[module->offset];
+        if (stored_size == unpacked_size) {
+            memcpy(module_code, stored, (size_t)stored_size);
+        } else {
+            lisa_longint size = unpacked_size;
+            if (lisa_unpackcode(stored, stored_size, module_code, &size, NULL) != 0) {
+                errno = EINVAL;
+                goto error;
+            }
+        }
+
+        // Each module is relocated in a single pass through its code, as
+        // if it were loaded where it is in the segment.
+
+        relocate_options->base = (lisa_MemAddr)(segment->address + module->offset);
+        relocate_options->local_symbols = segment->locals;
+
+        lisa_relocate_stats module_stats;
+        int relocate_err = lisa_relocator_apply(relocator, module->objfile, module->index,
+                                                module_code, module->size, &module_stats);
+        if (relocate_err == -1) goto error;
+
+        segment->stats.applied += module_stats.applied;
+        segment->stats.unresolved += module_stats.unresolved;
+        segment->stats.truncated += module_stats.truncated;
+    }
+
+    lisa_longint packed_size = (lisa_longint)lisa_packcode_max_size(segment->size);
+    segment->content = malloc(LISA_LINK_PACKED_HEADER_SIZE + (size_t)packed_size);
+    if (segment->content == NULL) goto error;
+
+    lisa_PackedCode *packedcode = (lisa_PackedCode *)segment->content;
+    packedcode->addr = (lisa_MemAddr)segment->address;
+    packedcode->csize = (lisa_longint)segment->size;
+
+    int pack_err = lisa_packcode(&segment->content[LISA_LINK_PACKED_HEADER_SIZE], &packed_size,
+                                 code, (lisa_longint)segment->size, NULL);
+    if (pack_err != 0) {
+        errno = EINVAL;
+        goto error;
+    }
+
+    if (packed_size < (lisa_longint)segment->size) {
+        segment->packed = true;
+        segment->stored_size = packed_size;
+        segment->content_size = LISA_LINK_PACKED_HEADER_SIZE + packed_size;
+    } else {
+        // Packing didn't make the code any smaller, so store it as is
+        // instead; the content has room, being sized for the worst case.
+
+        lisa_CodeBlock *codeblock = (lisa_CodeBlock *)segment->content;
+        codeblock->Addr = (lisa_SegAddr)segment->address;
+        memcpy(&segment->content[LISA_LINK_CODE_HEADER_SIZE], code, segment->size);
+
+        segment->packed = false;
+        segment->stored_size = (lisa_longint)segment->size;
+        segment->content_size = LISA_LINK_CODE_HEADER_SIZE + (lisa_longint)segment->size;
+    }
+
+    free(code);
+    return;
+
+error:
+    segment->error = errno;
+    free(code);
+}
+
+
+/*! Assemble every segment, spread across the threads. */
+int
+lisa_link_assemble(lisa_link_state *link)
+{
+    size_t thread_count = link->options->thread_count ? link->options->thread_count : thread_pool_default_thread_count();
+    if (thread_count > link->segment_count) thread_count = link->segment_count;
+    if (thread_count < 1) thread_count = 1;
+
+    // Each worker relocates with its own relocator, so its working
+    // storage is reused from one module to the next.
+
+    link->worker_count = thread_count;
+    link->relocators = calloc(sizeof(lisa_relocator *), thread_count);
+    link->relocate_options = calloc(sizeof(lisa_relocate_options), thread_count);
+    if ((link->relocators == NULL) || (link->relocate_options == NULL)) return -1;
+
+    for (size_t w = 0; w < thread_count; w++) {
+        link->relocate_options[w].symbols = link->jump_symbols;
+        link->relocators[w] = lisa_relocator_create(&link->relocate_options[w]);
+        if (link->relocators[w] == NULL) return -1;
+    }
+
+    if (thread_count == 1) {
+        for (size_t s = 0; s < link->segment_count; s++) {
+            lisa_link_segment_task(&link->segments[s], 0);
+        }
+    } else {
+        thread_pool *pool = thread_pool_create(thread_count);
+        if (pool == NULL) return -1;
+
+        for (size_t s = 0; s < link->segment_count; s++) {
+            int submit_err = thread_pool_submit(pool, lisa_link_segment_task, &link->segments[s]);
+            if (submit_err == -1) link->segments[s].error = ENOMEM;
+        }
+
+        thread_pool_wait(pool);
+        thread_pool_free(pool);
+    }
+
+    for (size_t s = 0; s < link->segment_count; s++) {
+        if (link->segments[s].error != 0) {
+            errno = link->segments[s].error;
+            return -1;
+        }
+        if (link->segments[s].stored_size > UINT16_MAX) {
+            errno = EFBIG;
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+
+/*! Append a block to the executable, getting back its index. */
+lisa_integer
+lisa_link_append(lisa_objfile_writer *writer, lisa_obj_block_type type, const void *content, size_t content_size)
+{
+    return lisa_objfile_writer_append_block(writer, type, content, (lisa_longint)content_size);
+}
+
+
+/*!
+    Build the Executable block's content: its header, a JTSegVariant
+    per segment and a descriptor per jump table entry. \a locations
+    holds the file location of each segment's module.
+ */
+void
+lisa_link_fill_executable(const lisa_link_state *link, lisa_Executable *executable, const lisa_FileAddr *locations)
+{
+    executable->JTLaddr = (lisa_MemAddr)link->jump_table_address;
+    executable->JTSize = (lisa_longint)(link->jump_count * sizeof(lisa_JTVariant));
+    executable->DataSize = (link->data_size > 0) ? link->data_size : 0;
+    executable->MainSize = (link->segment_count > 0) ? (lisa_longint)link->segments[0].size : 0;
+
+    lisa_JTSegVariantTable *jtsegs = lisa_Executable_JTSegVariantTable(executable);
+    jtsegs->numSegs = (lisa_integer)link->segment_count;
+    for (size_t s = 0; s < link->segment_count; s++) {
+        const lisa_link_segment *segment = &link->segments[s];
+        jtsegs->variants[s] = (lisa_JTSegVariant){
+            .SegmentAddr = locations[s],
+            .SizePacked = (lisa_integer)segment->stored_size,
+            .SizeUnpacked = (lisa_integer)segment->size,
+            .MemLoc = (lisa_MemAddr)segment->address,
+        };
+    }
+
+    lisa_JTVariantTable *jtvariants = lisa_Executable_JTVariantTable(executable);
+    jtvariants->numDescriptors = (lisa_integer)link->jump_count;
+    for (size_t j = 0; j < link->jump_count; j++) {
+        jtvariants->variants[j] = (lisa_JTVariant){
+            .JumpL = (lisa_integer)LISA_LINK_JUMP_OPCODE,
+            .AbsAddr = (lisa_MemAddr)link->jump_targets[j],
+        };
+    }
+}
+
+
+/*! Build the SegLocation block's content, as with `lisa_link_fill_executable`. */
+void
+lisa_link_fill_seglocation(const lisa_link_state *link, lisa_SegLocation *seglocation, const lisa_FileAddr *locations)
+{
+    seglocation->nSegments = (lisa_integer)link->segment_count;
+    for (size_t s = 0; s < link->segment_count; s++) {
+        const lisa_link_segment *segment = &link->segments[s];
+        lisa_SegLocVariant *variant = &seglocation->variants[s];
+
+        *variant = (lisa_SegLocVariant){
+            .SegNumber = (lisa_integer)(s + 1),
+            .FileLocation = locations[s],
+            .SizePacked = (lisa_integer)segment->stored_size,
+            .SizeUnpacked = (lisa_integer)segment->size,
+        };
+        memcpy(variant->SegName, segment->name, sizeof(lisa_ObjName));
+    }
+}
+
+
+/*!
+    Write the executable: the Executable and SegLocation blocks, then a
+    module per segment. The tables are written last, once the modules'
+    locations are known; their sizes don't depend on them.
+ */
+int
+lisa_link_write(lisa_link_state *link, const char *path, lisa_objfile_writer_stats *stats)
+{
+    int result = -1;
+    lisa_objfile_writer *writer = NULL;
+    uint8_t *executable = NULL;
+    uint8_t *seglocation = NULL;
+    lisa_FileAddr *locations = NULL;
+    lisa_integer *module_blocks = NULL;
+
+    const size_t segment_count = link->segment_count;
+    const size_t executable_size = sizeof(lisa_Executable)
+                                 + sizeof(lisa_integer) + segment_count * sizeof(lisa_JTSegVariant)
+                                 + sizeof(lisa_integer) + link->jump_count * sizeof(lisa_JTVariant);
+    const size_t seglocation_size = sizeof(lisa_integer) + segment_count * sizeof(lisa_SegLocVariant);
+
+    executable = calloc(executable_size, 1);
+    seglocation = calloc(seglocation_size, 1);
+    locations = calloc(sizeof(lisa_FileAddr), segment_count ? segment_count : 1);
+    module_blocks = calloc(sizeof(lisa_integer), segment_count ? segment_count : 1);
+    if ((executable == NULL) || (seglocation == NULL) || (locations == NULL) || (module_blocks == NULL)) goto done;
+
+    writer = lisa_objfile_writer_create(NULL);
+    if (writer == NULL) goto done;
+
+    lisa_integer executable_block = lisa_link_append(writer, Executable, executable, executable_size);
+    lisa_integer seglocation_block = lisa_link_append(writer, SegLocation, seglocation, seglocation_size);
+    if ((executable_block == -1) || (seglocation_block == -1)) goto done;
+
+    for (size_t s = 0; s < segment_count; s++) {
+        const lisa_link_segment *segment = &link->segments[s];
+
+        lisa_ModuleName modulename = { .CSize = (lisa_longint)segment->size };
+        memcpy(modulename.ModuleName, segment->name, sizeof(lisa_ObjName));
+        memcpy(modulename.SegmentName, segment->name, sizeof(lisa_ObjName));
+        module_blocks[s] = lisa_link_append(writer, ModuleName, &modulename, sizeof(modulename));
+        if (module_blocks[s] == -1) goto done;
+
+        for (size_t i = 0; i < segment->definition_count; i++) {
+            const lisa_link_definition *definition = &link->definitions[link->by_address[segment->first_definition + i].definition];
+
+            lisa_EntryPoint entrypoint = { .Loc = (lisa_SegAddr)definition->address };
+            memcpy(entrypoint.LinkName, definition->name, sizeof(lisa_ObjName));
+            memcpy(entrypoint.UserName, definition->user_name, sizeof(lisa_ObjName));
+            if (lisa_link_append(writer, EntryPoint, &entrypoint, sizeof(entrypoint)) == -1) goto done;
+        }
+
+        lisa_obj_block_type code_type = segment->packed ? PackedCode : CodeBlock;
+        if (lisa_link_append(writer, code_type, segment->content, (size_t)segment->content_size) == -1) goto done;
+
+        lisa_EndBlock endblock = { .CSize = (lisa_longint)segment->size };
+        if (lisa_link_append(writer, EndBlock, &endblock, sizeof(endblock)) == -1) goto done;
+    }
+
+    for (size_t s = 0; s < segment_count; s++) {
+        locations[s] = lisa_objfile_writer_block_offset(writer, module_blocks[s]);
+    }
+
+    lisa_link_fill_executable(link, (lisa_Executable *)executable, locations);
+    lisa_link_fill_seglocation(link, (lisa_SegLocation *)seglocation, locations);
+
+    int executable_err = lisa_objfile_writer_replace_block(writer, executable_block, Executable,
+                                                           executable, (lisa_longint)executable_size);
+    if (executable_err == -1) goto done;
+
+    int seglocation_err = lisa_objfile_writer_replace_block(writer, seglocation_block, SegLocation,
+                                                            seglocation, (lisa_longint)seglocation_size);
+    if (seglocation_err == -1) goto done;
+
+    int write_err = lisa_objfile_writer_write(writer, path, NULL, stats);
+    if (write_err == -1) goto done;
+
+    result = 0;
+
+done:
+    lisa_objfile_writer_free(writer);
+    free(executable);
+    free(seglocation);
+    free(locations);
+    free(module_blocks);
+    return result;
+}
+
+
+/*! Write a link map: segments and their modules, the jump table, and entry points by address. */
+void
+lisa_link_write_map(const lisa_link_state *link, FILE *f)
+{
+    fprintf(f, "Segments:" "\n");
+    for (size_t s = 0; s < link->segment_count; s++) {
+        const lisa_link_segment *segment = &link->segments[s];
+        char name[9];
+        lisa_ObjName_get_cstring(name, segment->name);
+
+        fprintf(f, "\t" "%-8s  #%zu  $%08x  %u bytes, %lld %s" "\n",
+                name, s + 1, segment->address, segment->size,
+                (long long)segment->stored_size, segment->packed ? "packed" : "unpacked");
+
+        for (size_t i = 0; i < segment->module_count; i++) {
+            const lisa_link_module *module = &link->modules[link->order[segment->first_module + i]];
+            fprintf(f, "\t\t" "$%08x  %-8s  %u bytes  %s" "\n",
+                    segment->address + module->offset, module->name, module->size, module->path);
+        }
+    }
+
+    fprintf(f, "Jump table at $%08x, %zu entries:" "\n", link->jump_table_address, link->jump_count);
+    for (size_t j = 0; j < link->jump_count; j++) {
+        fprintf(f, "\t" "$%08x  JMP $%08x" "\n",
+                link->jump_table_address + (uint32_t)(j * sizeof(lisa_JTVariant)), link->jump_targets[j]);
+    }
+
+    fprintf(f, "Entry points:" "\n");
+    for (size_t i = 0; i < link->definition_count; i++) {
+        const lisa_link_definition *definition = &link->definitions[link->by_address[i].definition];
+        const lisa_link_module *module = &link->modules[definition->module];
+        char name[9], segment_name[9];
+        lisa_ObjName_get_cstring(name, definition->name);
+        lisa_ObjName_get_cstring(segment_name, link->segments[module->segment].name);
+
+        fprintf(f, "\t" "$%08x  %-8s  %-8s  %s%s" "\n",
+                definition->address, name, segment_name, module->name, definition->jump ? "  (jump table)" : "");
+    }
+}
+
+
+/*! Free everything a link allocated. */
+void
+lisa_link_state_free(lisa_link_state *link)
+{
+    for (size_t s = 0; s < link->segment_count; s++) {
+        lisa_symbol_table_free(link->segments[s].locals);
+        free(link->segments[s].content);
+    }
+    for (size_t w = 0; w < link->worker_count; w++) {
+        if (link->relocators) lisa_relocator_free(link->relocators[w]);
+    }
+
+    free(link->modules);
+    free(link->order);
+    free(link->segments);
+    lisa_symbol_table_free(link->segment_names);
+    free(link->definitions);
+    lisa_symbol_table_free(link->definition_names);
+    free(link->by_address);
+    free(link->jump_targets);
+    lisa_symbol_table_free(link->jump_symbols);
+    free(link->relocators);
+    free(link->relocate_options);
+}
+
+
+// MARK: - Linking
+
+int
+lisa_link(const lisa_link_input *inputs, size_t count, const char *path,
+          const lisa_link_options *options,
+          lisa_link_stats * LISA_NULLABLE stats)
+{
+    int result = -1;
+    int link_errno = 0;
+    lisa_link_state link = { .options = options };
+    lisa_link_stats link_stats = { 0 };
+
+    if (count == 0) {
+        errno = EINVAL;
+        goto done;
+    }
+
+    link.segment_names = lisa_symbol_table_create();
+    link.definition_names = lisa_symbol_table_create();
+    link.jump_symbols = lisa_symbol_table_create();
+    if ((link.segment_names == NULL) || (link.definition_names == NULL) || (link.jump_symbols == NULL)) goto done;
+
+    if (lisa_link_gather(&link, inputs, count) == -1) goto done;
+    if (lisa_link_lay_out(&link) == -1) goto done;
+    if (lisa_link_define(&link) == -1) goto done;
+    if (lisa_link_build_jump_table(&link) == -1) goto done;
+    if (lisa_link_assemble(&link) == -1) goto done;
+
+    link_stats.modules = link.module_count;
+    link_stats.segments = link.segment_count;
+    link_stats.symbols = link.definition_count;
+    link_stats.duplicates = link.duplicates;
+    link_stats.jump_table_entries = link.jump_count;
+    for (size_t s = 0; s < link.segment_count; s++) {
+        const lisa_link_segment *segment = &link.segments[s];
+        link_stats.relocations += segment->stats.applied;
+        link_stats.unresolved += segment->stats.unresolved;
+        link_stats.truncated += segment->stats.truncated;
+        link_stats.code_size += segment->size;
+        link_stats.packed_size += (size_t)segment->stored_size;
+    }
+
+    if (options->map) lisa_link_write_map(&link, options->map);
+
+    if ((link_stats.unresolved > 0) && !options->allow_unresolved) {
+        if (stats) *stats = link_stats;
+        errno = ENOENT;
+        goto done;
+    }
+
+    lisa_objfile_writer_stats write_stats;
+    if (lisa_link_write(&link, path, &write_stats) == -1) goto done;
+
+    if (stats) *stats = link_stats;
+    result = 0;
+
+done:
+    link_errno = errno;
+    lisa_link_state_free(&link);
+    errno = link_errno;
+    return result;
+}
+
+
+LISA_SOURCE_END
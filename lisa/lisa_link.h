@@ -0,0 +1,103 @@
+//  lisa_link.h
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#ifndef __LISA__LINK__H__
+#define __LISA__LINK__H__
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "lisa_defines.h"
+#include "lisa_types.h"
+
+#include "lisa_objio.h"
+
+LISA_HEADER_BEGIN
+
+
+/*! The address the first segment is loaded at, unless told otherwise. */
+#define LISA_LINK_DEFAULT_BASE			0x00010000
+
+/*! The boundary each segment, and the global data, starts on. */
+#define LISA_LINK_SEGMENT_ALIGNMENT		512
+
+
+/*! An unlinked object file to link. */
+struct lisa_link_input {
+    lisa_objfile		*objfile;
+    const char			*path;			//!< for the link map
+};
+typedef struct lisa_link_input lisa_link_input;
+
+
+/*! How to link. */
+struct lisa_link_options {
+    lisa_MemAddr		base;			//!< address of the first segment; 0 for the default
+    size_t				thread_count;	//!< for relocating and packing; 0 for one per CPU
+    bool				allow_unresolved;	//!< write the executable even with unresolved references
+    FILE				* LISA_NULLABLE map;	//!< where to write a link map, if anywhere
+};
+typedef struct lisa_link_options lisa_link_options;
+
+
+/*! What linking did, for reporting. */
+struct lisa_link_stats {
+    size_t				modules;
+    size_t				segments;
+    size_t				symbols;		//!< entry points defined
+    size_t				duplicates;		//!< entry points ignored as already defined
+    size_t				jump_table_entries;
+    size_t				relocations;	//!< fields patched
+    size_t				unresolved;		//!< references to symbols defined nowhere
+    size_t				truncated;		//!< 16-bit fields whose new value didn't fit
+    size_t				code_size;		//!< of all segments, unpacked
+    size_t				packed_size;	//!< of all segments' code as stored, packed or not
+};
+typedef struct lisa_link_stats lisa_link_stats;
+
+
+/*!
+    Link unlinked object files into an executable at \a path.
+
+    Modules are grouped into segments by their SegmentName, in the order
+    the segments first appear, except that the segment holding the
+    module with a StartAddress block comes first. Each segment's modules
+    are laid out one after another in input order, and the segments one
+    after another from the base address, each starting on a
+    `LISA_LINK_SEGMENT_ALIGNMENT` boundary.
+
+    Entry points are gathered into a hashed symbol table; when a name is
+    defined more than once, the first definition in input order wins.
+    Every entry point referenced from outside its own segment gets a
+    jump table descriptor (a `JMP` to it), after the start address's if
+    there is one, and such references are resolved to the descriptor;
+    references within a segment are resolved to the entry point itself.
+    The program's global data sits just below the jump table, which
+    follows the last segment.
+
+    Each segment is then assembled, relocated a module at a time with
+    one `lisa_relocator` per thread, and packed, with segments spread
+    across threads. The executable gets an Executable block, a
+    SegLocation block, and a module per segment holding its entry
+    points and packed code.
+
+    Fails with EINVAL if an input is already an executable, with EFBIG
+    if a segment or the jump table is too big for the executable's
+    tables, and with ENOENT if any references are unresolved, unless
+    that's allowed.
+
+    If \a stats is given, it's set to what was done.
+ */
+LISA_EXTERN
+int
+lisa_link(const lisa_link_input *inputs, size_t count, const char *path,
+          const lisa_link_options *options,
+          lisa_link_stats * LISA_NULLABLE stats);
+
+
+LISA_HEADER_END
+
+#endif /* __LISA__LINK__H__ */
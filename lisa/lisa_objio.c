@@ -8,14 +8,23 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
+#include "alloc_utils.h"
 #include "array_utils.h"
 #include "bit_utils.h"
 #include "endian_utils.h"
 
+#include "lisa_stats.h"
+
 
 LISA_SOURCE_BEGIN
 
@@ -25,9 +34,39 @@ LISA_SOURCE_BEGIN
 struct lisa_objfile {
     void			* LISA_NULLABLE content;
     size_t			content_size;
+    bool			mapped;					//!< content is mapped rather than allocated
+    const lisa_allocator	*allocator;		//!< for content, unless mapped, and everything else
     ptr_array		* LISA_NULLABLE blocks;
     size_t			read_offset;			//!< used while iterating blocks
+    lisa_objfile_module	* LISA_NULLABLE modules;	//!< module index, in file order
+    lisa_integer	module_count;
+    struct lisa_objfile_segment_entry	* LISA_NULLABLE segments;	//!< segment index
+    lisa_integer	segment_count;
+    lisa_integer	* LISA_NULLABLE segment_name_table;		//!< open-addressed hash of segment names
+    size_t			segment_name_capacity;
+    lisa_integer	* LISA_NULLABLE segment_number_table;	//!< segment index by SegNumber
+    lisa_integer	segment_number_limit;
+    lisa_jump_table_entry	* LISA_NULLABLE jump_table;	//!< resolved jump table, by slot
+    lisa_integer	jump_table_count;
+    struct lisa_objfile_jump_table_key	* LISA_NULLABLE jump_table_by_address;	//!< sorted by address
+    lisa_pstring_view	* LISA_NULLABLE file_names;	//!< StringBlock names, by FileNumber
+    lisa_integer	file_number_limit;
+};
+
+/*! A segment of an object file, resolved through its segment tables. */
+struct lisa_objfile_segment_entry {
+    uint64_t		key;			//!< blank-padded segment name
+    lisa_integer	number;			//!< SegNumber, or -1
+    lisa_integer	module;			//!< index of the module holding the code
+};
+typedef struct lisa_objfile_segment_entry lisa_objfile_segment_entry;
+
+/*! A jump table descriptor's address, for finding it by address. */
+struct lisa_objfile_jump_table_key {
+    lisa_MemAddr	address;
+    lisa_integer	slot;
 };
+typedef struct lisa_objfile_jump_table_key lisa_objfile_jump_table_key;
 
 struct lisa_objfile_block {
     lisa_objfile        	* LISA_NULLABLE objfile;    //!< backpointer into containing objfile
@@ -41,120 +80,1152 @@ struct lisa_objfile_block {
 /*!
  Copy the next block from the given object file.
 
- - WARNING: Caller must free with `lisa_obj_block_free`.
- */
-lisa_objfile_block * LISA_NULLABLE
-lisa_obj_block_copy_next(lisa_objfile *of);
+ - WARNING: Caller must free with `lisa_obj_block_free`.
+ */
+lisa_objfile_block * LISA_NULLABLE
+lisa_obj_block_copy_next(lisa_objfile *of);
+
+
+/*!
+ Check that \a content_size bytes could hold an object file, however
+ they were read, failing with EINVAL if not.
+ */
+int
+lisa_objfile_check_size(size_t content_size);
+
+
+/*!
+ Open an object file given its content, which it takes ownership of.
+ The content is unmapped when closed if \a mapped, and freed with
+ \a allocator if not.
+ */
+lisa_objfile * LISA_NULLABLE
+lisa_objfile_open_content(void *content, size_t content_size, bool mapped,
+                          const lisa_allocator *allocator);
+
+
+/*! Free the given object file block. */
+void
+lisa_obj_block_free(lisa_objfile_block * LISA_NULLABLE b);
+
+
+/*!
+ Swap the block's data from big-endian to native-endian if \a to_native,
+ or back again if not.
+ */
+void
+lisa_obj_block_swap(lisa_objfile_block *block, bool to_native);
+
+
+/*!
+ Build the index of ModuleName...EndBlock ranges, so per-module access
+ doesn't need to walk every block.
+ */
+int
+lisa_objfile_index_modules(lisa_objfile *of);
+
+
+/*!
+ Build the index of segments by name and number from the SegLocation
+ and JTSegVariantTable blocks, or from the modules themselves if there
+ aren't any, so segments can be found without walking every block.
+ */
+int
+lisa_objfile_index_segments(lisa_objfile *of);
+
+
+/*!
+ Resolve the executable's jump table descriptors to segments, offsets
+ and entry points, and index them by address, so they can be looked up
+ without searching.
+ */
+int
+lisa_objfile_index_jump_table(lisa_objfile *of);
+
+
+/*!
+ Index the names in the StringBlock by FileNumber, as views into the
+ file, so a file number can be named without searching or copying.
+ */
+int
+lisa_objfile_index_strings(lisa_objfile *of);
+
+
+// MARK: - Files
+
+lisa_objfile * LISA_NULLABLE
+lisa_objfile_open(const char *path)
+{
+    return lisa_objfile_open_with_allocator(path, NULL);
+}
+
+
+lisa_objfile * LISA_NULLABLE
+lisa_objfile_open_with_allocator(const char *path, const lisa_allocator * LISA_NULLABLE allocator)
+{
+    void *content = NULL;
+    FILE *f = NULL;
+
+    if (allocator == NULL) allocator = lisa_default_allocator();
+
+    // Read the entire file into a contiguous buffer, to support
+    // chasing of FileAddr offsets within its data structures.
+
+    f = fopen(path, "rb");
+    if (f == NULL) goto error;
+
+    int seek1_err = fseeko(f, 0, SEEK_END);
+    if (seek1_err == -1) goto error;
+
+    off_t fs = ftello(f);
+    if (fs == -1) goto error;
+
+    size_t content_size = (size_t)fs;
+    if (lisa_objfile_check_size(content_size) == -1) goto error;
+
+    int seek2_err = fseeko(f, 0, SEEK_SET);
+    if (seek2_err == -1) goto error;
+
+    // Every byte is about to be read over, so don't bother zeroing.
+
+    content = allocator_allocate(allocator, content_size);
+    if (content == NULL) goto error;
+
+    uint64_t read_start = lisa_stats_begin();
+    size_t read_items = fread(content, content_size, 1, f);
+    if (read_items != 1) goto error;
+    lisa_stats_end(lisa_stats_read, read_start, 0, content_size);
+
+    fclose(f);
+    f = NULL;
+
+    return lisa_objfile_open_content(content, content_size, false, allocator);
+
+error:
+    {
+        int open_errno = errno;
+        if (f) fclose(f);
+        allocator_deallocate(allocator, content);
+        errno = open_errno;
+    }
+    return NULL;
+}
+
+
+lisa_objfile * LISA_NULLABLE
+lisa_objfile_open_mapped(const char *path)
+{
+    return lisa_objfile_open_mapped_with_allocator(path, NULL);
+}
+
+
+lisa_objfile * LISA_NULLABLE
+lisa_objfile_open_mapped_with_allocator(const char *path, const lisa_allocator * LISA_NULLABLE allocator)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) return NULL;
+
+    struct stat st;
+    int stat_err = fstat(fd, &st);
+    if (stat_err == -1) goto error;
+
+    if (lisa_objfile_check_size((size_t)st.st_size) == -1) goto error;
+
+    // Block headers and tables are swapped to native byte order in
+    // place, so the mapping is private: only the pages holding those
+    // get copied, while code stays shared with the page cache.
+
+    size_t content_size = (size_t)st.st_size;
+    uint64_t map_start = lisa_stats_begin();
+    void *content = mmap(NULL, content_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (content == MAP_FAILED) goto error;
+    lisa_stats_end(lisa_stats_read, map_start, 0, content_size);
+
+    close(fd);
+
+    return lisa_objfile_open_content(content, content_size, true,
+                                     allocator ? allocator : lisa_default_allocator());
+
+error:
+    {
+        int open_errno = errno;
+        close(fd);
+        errno = open_errno;
+    }
+    return NULL;
+}
+
+
+lisa_objfile * LISA_NULLABLE
+lisa_objfile_open_buffer(void *content, size_t content_size)
+{
+    return lisa_objfile_open_buffer_with_allocator(content, content_size, NULL);
+}
+
+
+lisa_objfile * LISA_NULLABLE
+lisa_objfile_open_buffer_with_allocator(void *content, size_t content_size,
+                                        const lisa_allocator * LISA_NULLABLE allocator)
+{
+    return lisa_objfile_open_content(content, content_size, false,
+                                     allocator ? allocator : lisa_default_allocator());
+}
+
+
+int
+lisa_objfile_check_size(size_t content_size)
+{
+    // Not even an EOFMark fits in an empty file.
+
+    if (content_size == 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return 0;
+}
+
+
+lisa_objfile * LISA_NULLABLE
+lisa_objfile_open_content(void *content, size_t content_size, bool mapped,
+                          const lisa_allocator *allocator)
+{
+    lisa_objfile *of = NULL;
+
+    if (lisa_objfile_check_size(content_size) == 0) {
+        of = allocator_allocate_zeroed(allocator, sizeof(lisa_objfile));
+    }
+    if (of == NULL) {
+        int open_errno = errno;
+        if (mapped) {
+            munmap(content, content_size);
+        } else {
+            allocator_deallocate(allocator, content);
+        }
+        errno = open_errno;
+        return NULL;
+    }
+
+    of->content = content;
+    of->content_size = content_size;
+    of->mapped = mapped;
+    of->allocator = allocator;
+
+    // Now create representations of all of the data structures in it.
+    // Blocks are at least 4 bytes, but most are much bigger, so guess
+    // at how many there are to avoid growing the array repeatedly.
+
+    of->blocks = ptr_array_create_with_allocator((content_size / 256) + 8, allocator);
+    if (of->blocks == NULL) goto error;
+
+    of->read_offset = 0;
+
+    uint64_t walk_start = lisa_stats_begin();
+
+    lisa_objfile_block *block;
+    do {
+        block = lisa_obj_block_copy_next(of);
+        if (block) {
+            ptr_array_append(of->blocks, block);
+        }
+
+        // The file will be padded to page size, so stop once a logical
+        // EOF mark is encountered rather than read all the way to
+        // physical EOF.
+    } while ((block != NULL) && (block->type != EOFMark));
+
+    lisa_stats_end(lisa_stats_header_walk, walk_start, of->read_offset, 0);
+
+    uint64_t index_start = lisa_stats_begin();
+
+    int index_err = lisa_objfile_index_modules(of);
+    if (index_err == -1) goto error;
+
+    int segment_index_err = lisa_objfile_index_segments(of);
+    if (segment_index_err == -1) goto error;
+
+    int jump_table_index_err = lisa_objfile_index_jump_table(of);
+    if (jump_table_index_err == -1) goto error;
+
+    int strings_index_err = lisa_objfile_index_strings(of);
+    if (strings_index_err == -1) goto error;
+
+    lisa_stats_end(lisa_stats_index, index_start, 0, 0);
+
+    return of;
+
+error:
+    lisa_objfile_close(of);
+    return NULL;
+}
+
+
+void
+lisa_objfile_close(lisa_objfile * LISA_NULLABLE ef)
+{
+    if (ef) {
+        const lisa_allocator *allocator = ef->allocator;
+
+        if (ef->mapped) {
+            munmap(ef->content, ef->content_size);
+        } else {
+            allocator_deallocate(allocator, ef->content);
+        }
+        allocator_deallocate(allocator, ef->modules);
+        allocator_deallocate(allocator, ef->segments);
+        allocator_deallocate(allocator, ef->segment_name_table);
+        allocator_deallocate(allocator, ef->segment_number_table);
+        allocator_deallocate(allocator, ef->jump_table);
+        allocator_deallocate(allocator, ef->jump_table_by_address);
+        allocator_deallocate(allocator, ef->file_names);
+
+        if (ef->blocks) {
+            for (size_t b = 0; b < ptr_array_count(ef->blocks); b++) {
+                lisa_objfile_block *block = ptr_array_item_at_index(ef->blocks, b);
+                lisa_obj_block_free(block);
+            }
+            ptr_array_free(ef->blocks);
+        }
+
+        allocator_deallocate(allocator, ef);
+    }
+}
+
+
+size_t
+lisa_objfile_size(lisa_objfile *of)
+{
+    return of->content_size;
+}
+
+
+lisa_integer
+lisa_objfile_block_count(lisa_objfile *of)
+{
+    size_t count = ptr_array_count(of->blocks);
+    assert(count <= INT16_MAX);
+
+    return (lisa_integer)count;
+}
+
+
+lisa_objfile_block *
+lisa_objfile_block_at_index(lisa_objfile *of, lisa_integer idx)
+{
+    return ptr_array_item_at_index(of->blocks, (size_t)idx);
+}
+
+
+lisa_integer
+lisa_objfile_block_index_at_offset(lisa_objfile *of, lisa_FileAddr offset)
+{
+    // Blocks are stored in file order, so binary search on their
+    // starting offsets.
+
+    lisa_integer lo = 0;
+    lisa_integer hi = lisa_objfile_block_count(of) - 1;
+    lisa_integer found = -1;
+
+    while (lo <= hi) {
+        lisa_integer mid = (lisa_integer)(lo + (hi - lo) / 2);
+        lisa_objfile_block *block = lisa_objfile_block_at_index(of, mid);
+        if (block->offset <= offset) {
+            found = mid;
+            lo = (lisa_integer)(mid + 1);
+        } else {
+            hi = (lisa_integer)(mid - 1);
+        }
+    }
+
+    if (found != -1) {
+        lisa_objfile_block *block = lisa_objfile_block_at_index(of, found);
+        if (offset >= block->offset + block->size) found = -1;
+    }
+
+    return found;
+}
+
+
+int
+lisa_objfile_index_modules(lisa_objfile *of)
+{
+    lisa_integer capacity = 0;
+    lisa_objfile_module *current = NULL;
+
+    const lisa_integer block_count = lisa_objfile_block_count(of);
+    for (lisa_integer b = 0; b < block_count; b++) {
+        lisa_objfile_block *block = lisa_objfile_block_at_index(of, b);
+
+        switch (block->type) {
+            case ModuleName: {
+                if (of->module_count == capacity) {
+                    const lisa_integer old_capacity = capacity;
+                    capacity = (lisa_integer)(capacity + 16);
+                    lisa_objfile_module *modules = allocator_reallocate(of->allocator, of->modules,
+                                                                        sizeof(lisa_objfile_module) * (size_t)old_capacity,
+                                                                        sizeof(lisa_objfile_module) * (size_t)capacity);
+                    if (modules == NULL) return -1;
+                    of->modules = modules;
+                }
+
+                current = &of->modules[of->module_count];
+                of->module_count += 1;
+
+                current->first_block = b;
+                current->last_block = b;
+                current->code_block = -1;
+            } break;
+
+            case CodeBlock:
+            case PackedCode: {
+                if (current && (current->code_block == -1)) current->code_block = b;
+            } break;
+
+            case EndBlock: {
+                if (current) {
+                    current->last_block = b;
+                    current = NULL;
+                }
+            } break;
+
+            default: {
+                // Anything else just belongs to the current module.
+            } break;
+        }
+
+        // Extend the current module; an unterminated module thus ends
+        // just before the next one starts.
+        if (current) current->last_block = b;
+    }
+
+    return 0;
+}
+
+
+lisa_Executable * LISA_NULLABLE
+lisa_objfile_executable(lisa_objfile *of)
+{
+    const lisa_integer block_count = lisa_objfile_block_count(of);
+    for (lisa_integer b = 0; b < block_count; b++) {
+        lisa_objfile_block *block = lisa_objfile_block_at_index(of, b);
+        if (block->type == Executable) return block->content.Executable;
+    }
+
+    return NULL;
+}
+
+
+lisa_integer
+lisa_objfile_module_count(lisa_objfile *of)
+{
+    return of->module_count;
+}
+
+
+const lisa_objfile_module *
+lisa_objfile_module_at_index(lisa_objfile *of, lisa_integer idx)
+{
+    assert((idx >= 0) && (idx < of->module_count));
+
+    return &of->modules[idx];
+}
+
+
+lisa_integer
+lisa_objfile_module_index_named(lisa_objfile *of, const char *name)
+{
+    for (lisa_integer m = 0; m < of->module_count; m++) {
+        lisa_objfile_block *block = lisa_objfile_block_at_index(of, of->modules[m].first_block);
+        char module_name[9];
+        lisa_ObjName_get_cstring(module_name, block->content.ModuleName->ModuleName);
+        if (strcmp(module_name, name) == 0) return m;
+    }
+
+    return -1;
+}
+
+
+// MARK: - Segments
+
+/*!
+ Get the hash key for a segment name: the name blank-padded to 8
+ characters, whatever padding it had originally.
+ */
+uint64_t
+lisa_objfile_segment_key(const char *name, size_t max_length)
+{
+    char padded[8];
+    memset(padded, ' ', 8);
+    for (size_t i = 0; (i < max_length) && (i < 8); i++) {
+        if ((name[i] == '\0') || (name[i] == ' ')) break;
+        padded[i] = name[i];
+    }
+
+    uint64_t key;
+    memcpy(&key, padded, 8);
+    return key;
+}
+
+
+/*! Hash a segment key into a table of the given (power of 2) capacity. */
+size_t
+lisa_objfile_segment_slot(uint64_t key, size_t capacity)
+{
+    // Fibonacci hashing spreads similar names across the table.
+    return (size_t)((key * UINT64_C(0x9E3779B97F4A7C15)) >> 32) & (capacity - 1);
+}
+
+
+/*! Get the index of the module containing the block at the given index, or -1. */
+lisa_integer
+lisa_objfile_module_index_containing_block(lisa_objfile *of, lisa_integer b)
+{
+    lisa_integer lo = 0;
+    lisa_integer hi = (lisa_integer)(of->module_count - 1);
+
+    while (lo <= hi) {
+        lisa_integer mid = (lisa_integer)(lo + (hi - lo) / 2);
+        if (b < of->modules[mid].first_block) {
+            hi = (lisa_integer)(mid - 1);
+        } else if (b > of->modules[mid].last_block) {
+            lo = (lisa_integer)(mid + 1);
+        } else {
+            return mid;
+        }
+    }
+
+    return -1;
+}
+
+
+/*! Get the index of the first module whose segment name has the given key, or -1. */
+lisa_integer
+lisa_objfile_module_index_for_segment_key(lisa_objfile *of, uint64_t key)
+{
+    for (lisa_integer m = 0; m < of->module_count; m++) {
+        lisa_objfile_block *block = lisa_objfile_block_at_index(of, of->modules[m].first_block);
+        if (lisa_objfile_segment_key(block->content.ModuleName->SegmentName, 8) == key) return m;
+    }
+
+    return -1;
+}
+
+
+/*! Add a segment to the index, unless one with its name is already there. */
+void
+lisa_objfile_add_segment(lisa_objfile *of, uint64_t key, lisa_integer number, lisa_integer module)
+{
+    size_t slot = lisa_objfile_segment_slot(key, of->segment_name_capacity);
+    while (of->segment_name_table[slot] != -1) {
+        if (of->segments[of->segment_name_table[slot]].key == key) return;
+        slot = (slot + 1) & (of->segment_name_capacity - 1);
+    }
+
+    lisa_integer idx = of->segment_count;
+    of->segments[idx].key = key;
+    of->segments[idx].number = number;
+    of->segments[idx].module = module;
+    of->segment_name_table[slot] = idx;
+    of->segment_count += 1;
+}
+
+
+int
+lisa_objfile_index_segments(lisa_objfile *of)
+{
+    lisa_SegLocation *seglocation = NULL;
+    lisa_JTSegVariantTable *jtsegs = NULL;
+
+    const lisa_integer block_count = lisa_objfile_block_count(of);
+    for (lisa_integer b = 0; b < block_count; b++) {
+        lisa_objfile_block *block = lisa_objfile_block_at_index(of, b);
+        if ((block->type == SegLocation) && (seglocation == NULL)) {
+            seglocation = block->content.SegLocation;
+        } else if ((block->type == Executable) && (jtsegs == NULL)) {
+            jtsegs = lisa_Executable_JTSegVariantTable(block->content.Executable);
+        }
+    }
+
+    // Size the tables for every segment we could possibly find, with the
+    // name table at most half full.
+
+    size_t max_segments = (size_t)of->module_count;
+    if (seglocation && (seglocation->nSegments > 0)) max_segments += (size_t)seglocation->nSegments;
+    if (jtsegs && (jtsegs->numSegs > 0)) max_segments += (size_t)jtsegs->numSegs;
+    if (max_segments == 0) return 0;
+
+    of->segment_name_capacity = 8;
+    while (of->segment_name_capacity < max_segments * 2) of->segment_name_capacity *= 2;
+
+    of->segments = allocator_allocate(of->allocator, sizeof(lisa_objfile_segment_entry) * max_segments);
+    if (of->segments == NULL) return -1;
+    of->segment_name_table = allocator_allocate(of->allocator, sizeof(lisa_integer) * of->segment_name_capacity);
+    if (of->segment_name_table == NULL) return -1;
+    for (size_t i = 0; i < of->segment_name_capacity; i++) of->segment_name_table[i] = -1;
+
+    // The segment location table is authoritative: its FileLocation
+    // leads to the block (and thus module) holding the segment's code.
+    // That's only an offset into this file if FileNumber 0, the file
+    // itself, holds the segment; one held in another file only matches
+    // a module here by its segment name, as does one whose FileLocation
+    // doesn't lead anywhere.
+
+    if (seglocation) {
+        for (lisa_integer i = 0; i < seglocation->nSegments; i++) {
+            lisa_SegLocVariant *variant = &seglocation->variants[i];
+            uint64_t key = lisa_objfile_segment_key(variant->SegName, 8);
+
+            lisa_integer module = -1;
+            if (variant->FileNumber == 0) {
+                lisa_integer b = lisa_objfile_block_index_at_offset(of, variant->FileLocation);
+                if (b != -1) module = lisa_objfile_module_index_containing_block(of, b);
+            }
+            if (module == -1) module = lisa_objfile_module_index_for_segment_key(of, key);
+            if (module == -1) continue;
+
+            lisa_objfile_add_segment(of, key, variant->SegNumber, module);
+        }
+    }
+
+    // Executables without a segment location table still locate their
+    // segments through the jump table's segment table, in segment order,
+    // numbered from 1 as the linker numbers SegLocation's segments.
+
+    if (jtsegs && (seglocation == NULL)) {
+        for (lisa_integer i = 0; i < jtsegs->numSegs; i++) {
+            lisa_integer b = lisa_objfile_block_index_at_offset(of, jtsegs->variants[i].SegmentAddr);
+            lisa_integer module = (b != -1) ? lisa_objfile_module_index_containing_block(of, b) : -1;
+            if (module == -1) continue;
+
+            lisa_objfile_block *block = lisa_objfile_block_at_index(of, of->modules[module].first_block);
+            uint64_t key = lisa_objfile_segment_key(block->content.ModuleName->SegmentName, 8);
+            lisa_objfile_add_segment(of, key, (lisa_integer)(i + 1), module);
+        }
+    }
+
+    // Anything else with code is findable by its module's segment name.
+
+    for (lisa_integer m = 0; m < of->module_count; m++) {
+        if (of->modules[m].code_block == -1) continue;
+
+        lisa_objfile_block *block = lisa_objfile_block_at_index(of, of->modules[m].first_block);
+        uint64_t key = lisa_objfile_segment_key(block->content.ModuleName->SegmentName, 8);
+        lisa_objfile_add_segment(of, key, -1, m);
+    }
+
+    // Segment numbers are small, so index them directly.
+
+    lisa_integer max_number = -1;
+    for (lisa_integer i = 0; i < of->segment_count; i++) {
+        if (of->segments[i].number > max_number) max_number = of->segments[i].number;
+    }
+
+    if (max_number >= 0) {
+        of->segment_number_limit = (lisa_integer)(max_number + 1);
+        of->segment_number_table = allocator_allocate(of->allocator, sizeof(lisa_integer) * (size_t)of->segment_number_limit);
+        if (of->segment_number_table == NULL) return -1;
+        for (lisa_integer n = 0; n < of->segment_number_limit; n++) of->segment_number_table[n] = -1;
+
+        for (lisa_integer i = 0; i < of->segment_count; i++) {
+            lisa_integer number = of->segments[i].number;
+            if ((number >= 0) && (of->segment_number_table[number] == -1)) {
+                of->segment_number_table[number] = i;
+            }
+        }
+    }
+
+    return 0;
+}
+
+
+/*! Fill in \a segment from the given segment index entry. */
+int
+lisa_objfile_get_segment(lisa_objfile *of, lisa_integer idx, lisa_segment *segment)
+{
+    lisa_objfile_segment_entry *entry = &of->segments[idx];
+    const lisa_objfile_module *module = &of->modules[entry->module];
+    if (module->code_block == -1) {
+        errno = ENOENT;
+        return -1;
+    }
+
+    memcpy(segment->name, &entry->key, 8);
+    segment->name[8] = '\0';
+    char *first_blank = strchr(segment->name, ' ');
+    if (first_blank) *first_blank = '\0';
+
+    segment->number = entry->number;
+    segment->module = entry->module;
+
+    lisa_objfile_block *code_block = lisa_objfile_block_at_index(of, module->code_block);
+    segment->packed = (code_block->type == PackedCode);
+    lisa_objfile_block_get_code(code_block, &segment->code, &segment->code_size,
+                                &segment->unpacked_size, &segment->addr);
+
+    return 0;
+}
+
+
+lisa_integer
+lisa_objfile_segment_count(lisa_objfile *of)
+{
+    return of->segment_count;
+}
+
+
+int
+lisa_objfile_segment_at_index(lisa_objfile *of, lisa_integer idx, lisa_segment *segment)
+{
+    assert((idx >= 0) && (idx < of->segment_count));
+
+    return lisa_objfile_get_segment(of, idx, segment);
+}
+
+
+int
+lisa_objfile_segment_named(lisa_objfile *of, const char *name, lisa_segment *segment)
+{
+    if (of->segment_count == 0) {
+        errno = ENOENT;
+        return -1;
+    }
+
+    if (strlen(name) > 8) {
+        errno = ENOENT;
+        return -1;
+    }
+
+    uint64_t key = lisa_objfile_segment_key(name, 8);
+
+    size_t slot = lisa_objfile_segment_slot(key, of->segment_name_capacity);
+    while (of->segment_name_table[slot] != -1) {
+        lisa_integer idx = of->segment_name_table[slot];
+        if (of->segments[idx].key == key) return lisa_objfile_get_segment(of, idx, segment);
+        slot = (slot + 1) & (of->segment_name_capacity - 1);
+    }
+
+    errno = ENOENT;
+    return -1;
+}
+
+
+int
+lisa_objfile_segment_numbered(lisa_objfile *of, lisa_integer number, lisa_segment *segment)
+{
+    if ((number < 0) || (number >= of->segment_number_limit) || (of->segment_number_table[number] == -1)) {
+        errno = ENOENT;
+        return -1;
+    }
+
+    return lisa_objfile_get_segment(of, of->segment_number_table[number], segment);
+}
+
+
+int
+lisa_objfile_segment_at_offset(lisa_objfile *of, lisa_FileAddr offset, lisa_segment *segment)
+{
+    lisa_integer b = lisa_objfile_block_index_at_offset(of, offset);
+    lisa_integer module = (b != -1) ? lisa_objfile_module_index_containing_block(of, b) : -1;
+
+    // There are only ever a handful of segments, so just look through them.
+
+    if (module != -1) {
+        for (lisa_integer i = 0; i < of->segment_count; i++) {
+            if (of->segments[i].module == module) return lisa_objfile_get_segment(of, i, segment);
+        }
+    }
+
+    errno = ENOENT;
+    return -1;
+}
+
+
+int
+lisa_segment_unpack(const lisa_segment *segment,
+                    uint8_t *unpacked, lisa_longint *unpacked_size)
+{
+    if (*unpacked_size < segment->unpacked_size) {
+        errno = ENOBUFS;
+        return -1;
+    }
+
+    if (!segment->packed) {
+        memcpy(unpacked, segment->code, (size_t)segment->code_size);
+        *unpacked_size = segment->code_size;
+        return 0;
+    }
+
+    *unpacked_size = segment->unpacked_size;
+    int unpack_err = lisa_unpackcode(segment->code, segment->code_size,
+                                     unpacked, unpacked_size, NULL);
+    if (unpack_err != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return 0;
+}
+
+
+int
+lisa_segment_unpack_allocated(const lisa_segment *segment, const lisa_allocator * LISA_NULLABLE allocator,
+                              uint8_t * LISA_NULLABLE * LISA_NONNULL unpacked, lisa_longint *unpacked_size)
+{
+    if (allocator == NULL) allocator = lisa_default_allocator();
+
+    *unpacked = allocator_allocate(allocator, (size_t)segment->unpacked_size);
+    if (*unpacked == NULL) return -1;
+
+    *unpacked_size = segment->unpacked_size;
+    int unpack_err = lisa_segment_unpack(segment, *unpacked, unpacked_size);
+    if (unpack_err == -1) {
+        int unpack_errno = errno;
+        allocator_deallocate(allocator, *unpacked);
+        *unpacked = NULL;
+        errno = unpack_errno;
+        return -1;
+    }
+
+    return 0;
+}
+
+
+// MARK: - Jump Table
+
+/*! The memory a segment is loaded into, for resolving jump table descriptors. */
+struct lisa_objfile_segment_range {
+    lisa_MemAddr	start;
+    lisa_MemAddr	end;
+    lisa_integer	number;
+    lisa_integer	module;
+    lisa_MemAddr	code_addr;		//!< Addr of the module's code, which EntryPoint Locs are relative to
+};
+typedef struct lisa_objfile_segment_range lisa_objfile_segment_range;
+
+/*! An entry point's offset into its module's code, for naming jump table descriptors. */
+struct lisa_objfile_entry_location {
+    lisa_integer	module;
+    lisa_longint	offset;
+    const lisa_EntryPoint	*entry;
+};
+typedef struct lisa_objfile_entry_location lisa_objfile_entry_location;
+
+
+int
+lisa_objfile_segment_range_compare(const void *a, const void *b)
+{
+    const lisa_objfile_segment_range *range_a = a;
+    const lisa_objfile_segment_range *range_b = b;
+    if (range_a->start != range_b->start) return ((uint32_t)range_a->start < (uint32_t)range_b->start) ? -1 : 1;
+    return 0;
+}
+
+
+int
+lisa_objfile_entry_location_compare(const void *a, const void *b)
+{
+    const lisa_objfile_entry_location *location_a = a;
+    const lisa_objfile_entry_location *location_b = b;
+    if (location_a->module != location_b->module) return (location_a->module < location_b->module) ? -1 : 1;
+    if (location_a->offset != location_b->offset) return (location_a->offset < location_b->offset) ? -1 : 1;
+    return 0;
+}
+
+
+int
+lisa_objfile_jump_table_key_compare(const void *a, const void *b)
+{
+    const lisa_objfile_jump_table_key *key_a = a;
+    const lisa_objfile_jump_table_key *key_b = b;
+    if (key_a->address != key_b->address) return ((uint32_t)key_a->address < (uint32_t)key_b->address) ? -1 : 1;
+    return (key_a->slot < key_b->slot) ? -1 : (key_a->slot > key_b->slot);
+}
+
+
+/*! Find the segment range containing \a address, or `NULL`. */
+const lisa_objfile_segment_range * LISA_NULLABLE
+lisa_objfile_find_segment_range(const lisa_objfile_segment_range *ranges, size_t count, lisa_MemAddr address)
+{
+    // Find the last range starting at or before the address.
+
+    size_t lo = 0;
+    size_t hi = count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if ((uint32_t)ranges[mid].start <= (uint32_t)address) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    if (lo == 0) return NULL;
+    const lisa_objfile_segment_range *range = &ranges[lo - 1];
+    return ((uint32_t)address < (uint32_t)range->end) ? range : NULL;
+}
+
+
+/*! Find the entry point at \a offset into the code of \a module, or `NULL`. */
+const lisa_EntryPoint * LISA_NULLABLE
+lisa_objfile_find_entry_location(const lisa_objfile_entry_location *locations, size_t count,
+                                 lisa_integer module, lisa_longint offset)
+{
+    const lisa_objfile_entry_location key = { .module = module, .offset = offset };
+
+    size_t lo = 0;
+    size_t hi = count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int comparison = lisa_objfile_entry_location_compare(&locations[mid], &key);
+        if (comparison == 0) return locations[mid].entry;
+        if (comparison < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return NULL;
+}
+
+
+int
+lisa_objfile_index_jump_table(lisa_objfile *of)
+{
+    int result = -1;
+    lisa_objfile_segment_range *ranges = NULL;
+    lisa_objfile_entry_location *locations = NULL;
 
+    lisa_Executable *executable = lisa_objfile_executable(of);
+    if (executable == NULL) return 0;
 
-/*! Free the given object file block. */
-void
-lisa_obj_block_free(lisa_objfile_block * LISA_NULLABLE b);
+    lisa_JTSegVariantTable *jtsegs = lisa_Executable_JTSegVariantTable(executable);
+    lisa_JTVariantTable *jtvariants = lisa_Executable_JTVariantTable(executable);
+    if (jtvariants->numDescriptors <= 0) return 0;
 
+    // Gather the memory each segment is loaded into, sorted so each
+    // descriptor's segment can be found by binary search.
 
-/*! Swap the block's data from big-endian to native-endian. */
-void
-lisa_obj_block_swap(lisa_objfile_block *block);
+    size_t range_count = 0;
+    if (jtsegs->numSegs > 0) {
+        ranges = allocator_allocate(of->allocator, sizeof(lisa_objfile_segment_range) * (size_t)jtsegs->numSegs);
+        if (ranges == NULL) goto done;
+    }
 
+    for (lisa_integer i = 0; i < jtsegs->numSegs; i++) {
+        lisa_segment segment;
+        int segment_err = lisa_objfile_segment_at_offset(of, jtsegs->variants[i].SegmentAddr, &segment);
+        if (segment_err == -1) continue;
+
+        ranges[range_count++] = (lisa_objfile_segment_range){
+            .start = jtsegs->variants[i].MemLoc,
+            .end = (lisa_MemAddr)((uint32_t)jtsegs->variants[i].MemLoc + (uint32_t)segment.unpacked_size),
+            .number = segment.number,
+            .module = segment.module,
+            .code_addr = segment.addr,
+        };
+    }
 
-// MARK: - Files
+    if (range_count > 0) {
+        qsort(ranges, range_count, sizeof(lisa_objfile_segment_range), lisa_objfile_segment_range_compare);
+    }
 
-lisa_objfile * LISA_NULLABLE
-lisa_objfile_open(const char *path)
-{
-    lisa_objfile *of;
-    FILE *f = NULL;
+    // Gather those segments' entry points, sorted by module and offset.
 
-    of = calloc(sizeof(lisa_objfile), 1);
-    if (of == NULL) goto error;
+    size_t location_count = 0;
+    for (size_t r = 0; r < range_count; r++) {
+        const lisa_objfile_module *module = &of->modules[ranges[r].module];
+        for (lisa_integer b = module->first_block; b <= module->last_block; b++) {
+            if (lisa_objfile_block_at_index(of, b)->type == EntryPoint) location_count += 1;
+        }
+    }
 
-    // Read the entire file into a contiguous buffer, to support
-    // chasing of FileAddr offsets within its data structures.
+    if (location_count > 0) {
+        locations = allocator_allocate(of->allocator, sizeof(lisa_objfile_entry_location) * location_count);
+        if (locations == NULL) goto done;
+
+        size_t l = 0;
+        for (size_t r = 0; r < range_count; r++) {
+            const lisa_objfile_module *module = &of->modules[ranges[r].module];
+            for (lisa_integer b = module->first_block; b <= module->last_block; b++) {
+                lisa_objfile_block *block = lisa_objfile_block_at_index(of, b);
+                if (block->type != EntryPoint) continue;
+
+                locations[l++] = (lisa_objfile_entry_location){
+                    .module = ranges[r].module,
+                    .offset = (lisa_longint)((uint32_t)block->content.EntryPoint->Loc - (uint32_t)ranges[r].code_addr),
+                    .entry = block->content.EntryPoint,
+                };
+            }
+        }
 
-    f = fopen(path, "rb");
-    if (f == NULL) goto error;
+        qsort(locations, location_count, sizeof(lisa_objfile_entry_location), lisa_objfile_entry_location_compare);
+    }
 
-    int seek1_err = fseeko(f, 0, SEEK_END);
-    if (seek1_err == -1) goto error;
+    // Now resolve each descriptor, and index them all by address.
+
+    const size_t count = (size_t)jtvariants->numDescriptors;
+    of->jump_table = allocator_allocate_zeroed(of->allocator, sizeof(lisa_jump_table_entry) * count);
+    if (of->jump_table == NULL) goto done;
+    of->jump_table_by_address = allocator_allocate(of->allocator, sizeof(lisa_objfile_jump_table_key) * count);
+    if (of->jump_table_by_address == NULL) goto done;
+
+    for (size_t d = 0; d < count; d++) {
+        lisa_jump_table_entry *entry = &of->jump_table[d];
+        entry->slot = (lisa_integer)d;
+        entry->address = jtvariants->variants[d].AbsAddr;
+        entry->segment = -1;
+        entry->module = -1;
+
+        const lisa_objfile_segment_range *range = lisa_objfile_find_segment_range(ranges, range_count, entry->address);
+        if (range) {
+            entry->segment = range->number;
+            entry->module = range->module;
+            entry->offset = (lisa_longint)((uint32_t)entry->address - (uint32_t)range->start);
+
+            const lisa_EntryPoint *entry_point = lisa_objfile_find_entry_location(locations, location_count,
+                                                                                  range->module, entry->offset);
+            if (entry_point) lisa_ObjName_get_cstring(entry->name, entry_point->LinkName);
+        }
 
-    off_t fs = ftello(f);
-    if (fs == -1) goto error;
+        of->jump_table_by_address[d] = (lisa_objfile_jump_table_key){ .address = entry->address, .slot = entry->slot };
+    }
 
-    of->content_size = (size_t)fs;
+    qsort(of->jump_table_by_address, count, sizeof(lisa_objfile_jump_table_key), lisa_objfile_jump_table_key_compare);
+    of->jump_table_count = (lisa_integer)count;
 
-    int seek2_err = fseeko(f, 0, SEEK_SET);
-    if (seek2_err == -1) goto error;
+    result = 0;
 
-    of->content = calloc(of->content_size, 1);
-    if (of->content == NULL) goto error;
+done:
+    allocator_deallocate(of->allocator, locations);
+    allocator_deallocate(of->allocator, ranges);
+    return result;
+}
 
-    size_t read_items = fread(of->content, of->content_size, 1, f);
-    if (read_items != 1) goto error;
 
-    // Now create representations of all of the data structures in it.
+lisa_integer
+lisa_objfile_jump_table_count(lisa_objfile *of)
+{
+    return of->jump_table_count;
+}
 
-    of->blocks = ptr_array_create(8);
-    if (of->blocks == NULL) goto error;
 
-    of->read_offset = 0;
+const lisa_jump_table_entry * LISA_NULLABLE
+lisa_objfile_jump_table_entry_at_slot(lisa_objfile *of, lisa_integer slot)
+{
+    if ((slot < 0) || (slot >= of->jump_table_count)) return NULL;
 
-    lisa_objfile_block *block;
-    do {
-        block = lisa_obj_block_copy_next(of);
-        if (block) {
-            ptr_array_append(of->blocks, block);
-        }
+    return &of->jump_table[slot];
+}
 
-        // The file will be padded to page size, so stop once a logical
-        // EOF mark is encountered rather than read all the way to
-        // physical EOF.
-    } while ((block != NULL) && (block->type != EOFMark));
 
-    fclose(f);
-    f = NULL;
+const lisa_jump_table_entry * LISA_NULLABLE
+lisa_objfile_jump_table_entry_at_address(lisa_objfile *of, lisa_MemAddr address)
+{
+    // Find the first key at or after the address; ties are in slot order.
+
+    size_t lo = 0;
+    size_t hi = (size_t)of->jump_table_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if ((uint32_t)of->jump_table_by_address[mid].address < (uint32_t)address) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
 
-    return of;
+    if ((lo == (size_t)of->jump_table_count) || (of->jump_table_by_address[lo].address != address)) return NULL;
 
-error:
-    if (f) fclose(f);
-    lisa_objfile_close(of);
-    return NULL;
+    return &of->jump_table[of->jump_table_by_address[lo].slot];
 }
 
 
-void
-lisa_objfile_close(lisa_objfile * LISA_NULLABLE ef)
-{
-    if (ef) {
-        free(ef->content);
+// MARK: - Strings
 
-        if (ef->blocks) {
-            for (size_t b = 0; b < ptr_array_count(ef->blocks); b++) {
-                lisa_objfile_block *block = ptr_array_item_at_index(ef->blocks, b);
-                lisa_obj_block_free(block);
-            }
-            ptr_array_free(ef->blocks);
+int
+lisa_objfile_index_strings(lisa_objfile *of)
+{
+    // Size the table for the highest file number of any StringBlock.
+
+    lisa_integer limit = 0;
+    const lisa_integer block_count = lisa_objfile_block_count(of);
+    for (lisa_integer b = 0; b < block_count; b++) {
+        lisa_objfile_block *block = lisa_objfile_block_at_index(of, b);
+        if (block->type != StringBlock) continue;
+
+        lisa_StringBlock *stringblock = block->content.StringBlock;
+        for (lisa_integer i = 0; i < stringblock->nStrings; i++) {
+            lisa_integer number = stringblock->variants[i].FileNumber;
+            if (number >= limit) limit = (lisa_integer)(number + 1);
         }
+    }
+    if (limit == 0) return 0;
+
+    of->file_names = allocator_allocate_zeroed(of->allocator, sizeof(lisa_pstring_view) * (size_t)limit);
+    if (of->file_names == NULL) return -1;
+    of->file_number_limit = limit;
+
+    // The first name given a number wins, and names that run off the
+    // end of the file are left out.
 
-        free(ef);
+    for (lisa_integer b = 0; b < block_count; b++) {
+        lisa_objfile_block *block = lisa_objfile_block_at_index(of, b);
+        if (block->type != StringBlock) continue;
+
+        lisa_StringBlock *stringblock = block->content.StringBlock;
+        for (lisa_integer i = 0; i < stringblock->nStrings; i++) {
+            lisa_integer number = stringblock->variants[i].FileNumber;
+            if ((number < 0) || (of->file_names[number].chars != NULL)) continue;
+
+            lisa_objfile_pstring_at_offset(of, stringblock->variants[i].NameAddr, &of->file_names[number]);
+        }
     }
+
+    return 0;
 }
 
 
 lisa_integer
-lisa_objfile_block_count(lisa_objfile *of)
+lisa_objfile_file_number_limit(lisa_objfile *of)
 {
-    size_t count = ptr_array_count(of->blocks);
-    assert(count <= INT16_MAX);
+    return of->file_number_limit;
+}
 
-    return (lisa_integer)count;
+
+int
+lisa_objfile_file_name(lisa_objfile *of, lisa_integer file_number, lisa_pstring_view *name)
+{
+    if ((file_number < 0) || (file_number >= of->file_number_limit)
+        || (of->file_names[file_number].chars == NULL))
+    {
+        errno = ENOENT;
+        return -1;
+    }
+
+    *name = of->file_names[file_number];
+    return 0;
 }
 
 
-lisa_objfile_block *
-lisa_objfile_block_at_index(lisa_objfile *of, lisa_integer idx)
+int
+lisa_objfile_pstring_at_offset(lisa_objfile *of, lisa_FileAddr offset, lisa_pstring_view *view)
 {
-    return ptr_array_item_at_index(of->blocks, (size_t)idx);
+    if ((offset < 0) || ((size_t)offset >= of->content_size)) {
+        errno = ERANGE;
+        return -1;
+    }
+
+    const char *pstr = (const char *)of->content + offset;
+    const uint8_t length = (uint8_t)pstr[0];
+    if ((size_t)offset + 1 + length > of->content_size) {
+        errno = ERANGE;
+        return -1;
+    }
+
+    view->chars = &pstr[1];
+    view->length = length;
+    return 0;
 }
 
 
@@ -172,12 +1243,85 @@ lisa_objfile_block_size(lisa_objfile_block *block)
     return block->size;
 }
 
+lisa_FileAddr
+lisa_objfile_block_offset(lisa_objfile_block *block)
+{
+    return block->offset;
+}
+
+bool
+lisa_objfile_block_get_code(lisa_objfile_block *block,
+                            uint8_t * LISA_NULLABLE * LISA_NONNULL code,
+                            lisa_longint *code_size,
+                            lisa_longint *unpacked_size,
+                            lisa_MemAddr *addr)
+{
+    switch (block->type) {
+        case PackedCode: {
+            *code = block->content.PackedCode->code;
+            *code_size = block->size - 12; // header + addr + csize = 12
+            *unpacked_size = block->content.PackedCode->csize;
+            *addr = block->content.PackedCode->addr;
+            return true;
+        }
+
+        case CodeBlock: {
+            *code = block->content.CodeBlock->code;
+            *code_size = block->size - 8; // header + Addr = 8
+            *unpacked_size = *code_size;
+            *addr = block->content.CodeBlock->Addr;
+            return true;
+        }
+
+        default: {
+            return false;
+        }
+    }
+}
+
 lisa_objfile_content
 lisa_objfile_block_content(lisa_objfile_block *block)
 {
     return block->content;
 }
 
+int
+lisa_obj_block_encode(lisa_obj_block_type type,
+                      const void *content, lisa_longint content_size,
+                      uint8_t *encoded)
+{
+    if ((content_size < 0) || (content_size > 0xFFFFFF - 4)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    lisa_longint size = content_size + 4;
+    encoded[0] = (uint8_t)type;
+    encoded[1] = (uint8_t)(size >> 16);
+    encoded[2] = (uint8_t)(size >> 8);
+    encoded[3] = (uint8_t)(size >> 0);
+    if (content_size > 0) memcpy(&encoded[4], content, (size_t)content_size);
+
+    // Swap the copy, using a block that refers to it.
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    lisa_objfile_block block = {
+        .objfile = NULL,
+        .type = type,
+        .size = size,
+        .offset = 0,
+        .content.data = &encoded[4],
+    };
+    lisa_obj_block_swap(&block, false);
+#elif __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    // No swapping necessary.
+#else
+#error PDP-11 not supported
+#endif
+
+    return 0;
+}
+
 const char *
 lisa_obj_block_type_string(lisa_obj_block_type t)
 {
@@ -215,6 +1359,45 @@ lisa_obj_block_type_string(lisa_obj_block_type t)
 }
 
 
+bool
+lisa_obj_block_type_from_string(const char *s, lisa_obj_block_type *t)
+{
+    // Accept either a block type name or its numeric value.
+
+    for (int i = 0; i < 256; i++) {
+        lisa_obj_block_type candidate = (lisa_obj_block_type)i;
+        if (strncmp(lisa_obj_block_type_string(candidate), "Unknown", 7) == 0) continue;
+        if (strcasecmp(lisa_obj_block_type_string(candidate), s) == 0) {
+            *t = candidate;
+            return true;
+        }
+    }
+
+    const char *digits = (s[0] == '$') ? &s[1] : s;
+    int base = (s[0] == '$') ? 16 : 0;
+    char *end = NULL;
+    unsigned long value = strtoul(digits, &end, base);
+    if ((digits[0] != '\0') && (*end == '\0') && (value <= 0xFF)) {
+        *t = (lisa_obj_block_type)value;
+        return true;
+    }
+
+    return false;
+}
+
+
+void
+lisa_ObjName_get_cstring(char *cstr, const lisa_ObjName name)
+{
+    memcpy(cstr, name, 8);
+    cstr[8] = '\0';
+
+    // Names are blank-padded; only the part before the first blank counts.
+    char *first_blank = strchr(cstr, ' ');
+    if (first_blank) *first_blank = '\0';
+}
+
+
 const char *
 lisa_UnitType_string(lisa_UnitType t)
 {
@@ -235,7 +1418,7 @@ lisa_UnitType_string(lisa_UnitType t)
 void
 lisa_obj_block_free(lisa_objfile_block * LISA_NULLABLE b)
 {
-    free(b);
+    if (b) allocator_deallocate(b->objfile->allocator, b);
 }
 
 
@@ -256,6 +1439,99 @@ lisa_obj_read_raw(lisa_objfile *of, void *buf, size_t size)
     return 0;
 }
 
+/*!
+    Get the size a table takes up in \a content, given the offset of its
+    big-endian count and of its first variant, or `SIZE_MAX` if there
+    isn't room in \a size bytes for even its count.
+ */
+size_t
+lisa_obj_table_size(const uint8_t *content, size_t size,
+                    size_t count_offset, size_t variants_offset, size_t variant_size)
+{
+    if (size < count_offset + 2) return SIZE_MAX;
+    size_t count = (size_t)((content[count_offset] << 8) | content[count_offset + 1]);
+    return variants_offset + (count * variant_size);
+}
+
+
+/*!
+    Whether the fixed fields and counted tables of a block, as read from
+    the file before swapping, fit in its size. A damaged size or count
+    could otherwise lead to reading and swapping past the end of the block.
+ */
+bool
+lisa_obj_block_content_fits(lisa_objfile_block *block)
+{
+    const uint8_t *content = block->content.data;
+    const size_t size = (size_t)block->size - 4;
+
+    switch (block->type) {
+        case ModuleName:
+            return size >= sizeof(lisa_ModuleName);
+
+        case EndBlock:
+            return size >= sizeof(lisa_EndBlock);
+
+        case EntryPoint:
+            return size >= sizeof(lisa_EntryPoint);
+
+        case External:
+            return size >= offsetof(lisa_External, Ref);
+
+        case StartAddress:
+            return size >= sizeof(lisa_StartAddress);
+
+        case CommonRelocation:
+            return size >= offsetof(lisa_CommonRelocation, Ref);
+
+        case ShortExternal:
+            return size >= offsetof(lisa_ShortExternal, ShortRef);
+
+        case UnitBlock:
+            return size >= sizeof(lisa_UnitBlock);
+
+        case VersionCtrl:
+            return size >= sizeof(lisa_VersionCtrl);
+
+        case Executable: {
+            size_t segs_offset = sizeof(lisa_Executable);
+            size_t descriptors_offset = lisa_obj_table_size(content, size, segs_offset, segs_offset + 2,
+                                                            sizeof(lisa_JTSegVariant));
+            if (descriptors_offset == SIZE_MAX) return false;
+            return lisa_obj_table_size(content, size, descriptors_offset, descriptors_offset + 2,
+                                       sizeof(lisa_JTVariant)) <= size;
+        }
+
+        case SegmentTable:
+            return lisa_obj_table_size(content, size, 0, 2, sizeof(lisa_SegVariant)) <= size;
+
+        case UnitTable:
+            return lisa_obj_table_size(content, size, 0, 4, sizeof(lisa_UnitVariant)) <= size;
+
+        case SegLocation:
+            return lisa_obj_table_size(content, size, 0, 2, sizeof(lisa_SegLocVariant)) <= size;
+
+        case UnitLocation:
+            return lisa_obj_table_size(content, size, 0, 2, sizeof(lisa_UnitLVariant)) <= size;
+
+        case StringBlock:
+            return lisa_obj_table_size(content, size, 0, 2, sizeof(lisa_StringVariant)) <= size;
+
+        case CodeBlock:
+            return size >= 4; // Addr
+
+        case PackedCode:
+            return size >= 8; // addr + csize
+
+        case PackTable:
+            return size >= sizeof(lisa_PackTable);
+
+        default:
+            return true;
+    }
+}
+
+
 lisa_objfile_block * LISA_NULLABLE
 lisa_obj_block_copy_next(lisa_objfile *of)
 {
@@ -274,7 +1550,7 @@ lisa_obj_block_copy_next(lisa_objfile *of)
 
     // Make room for new processed block.
 
-    block = calloc(sizeof(lisa_objfile_block), 1);
+    block = allocator_allocate(of->allocator, sizeof(lisa_objfile_block));
     if (block == NULL) goto error;
 
     block->objfile = of;
@@ -282,15 +1558,33 @@ lisa_obj_block_copy_next(lisa_objfile *of)
     block->type = (lisa_obj_block_type)buf[0];
     block->size = ((buf[1] << 16) | (buf[2] << 8) | (buf[3] << 0));
 
+    // A damaged block could claim to run past the end of the file, so
+    // stop reading blocks there rather than read beyond it. An EOFMark
+    // ends the walk anyway, so one whose size doesn't fit is just taken
+    // to be its header, which is all that was read.
+
+    if ((block->size < 4) || (offset + (size_t)block->size > of->content_size)) {
+        if (block->type != EOFMark) {
+            errno = EIO;
+            goto error;
+        }
+        block->size = 4;
+    }
+
     // size includes header but data does not
     uint8_t *content_bytes = of->content;
     block->content.data = &content_bytes[of->read_offset];
     of->read_offset += (size_t) block->size - 4;
 
+    if ((block->type != EOFMark) && !lisa_obj_block_content_fits(block)) {
+        errno = EIO;
+        goto error;
+    }
+
     // Swap the block data if necessary.
 
 #if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
-    lisa_obj_block_swap(block);
+    lisa_obj_block_swap(block, true);
 #elif __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
     // No swapping necessary.
 #else
@@ -310,11 +1604,10 @@ lisa_objfile_copy_pstring_at_offset(lisa_objfile *of,
                                     char *cstr,
                                     lisa_FileAddr offset)
 {
-    char *content_chars = of->content;
-    char *pstr_in_block = &content_chars[offset];
-    size_t len = (size_t)pstr_in_block[0];
-    memcpy(cstr, &pstr_in_block[1], len);
-    cstr[len] = '\0';
+    lisa_pstring_view view = { .chars = NULL, .length = 0 };
+    lisa_objfile_pstring_at_offset(of, offset, &view);
+    if (view.length > 0) memcpy(cstr, view.chars, view.length);
+    cstr[view.length] = '\0';
 }
 
 
@@ -337,8 +1630,13 @@ lisa_Executable_JTVariantTable(lisa_Executable *executable)
 
 
 void
-lisa_obj_block_swap(lisa_objfile_block *block)
+lisa_obj_block_swap(lisa_objfile_block *block, bool to_native)
 {
+    // Fields are swapped the same way in either direction, but counts
+    // have to be read in native order to know how much to swap.
+
+    uint64_t swap_start = lisa_stats_begin();
+
     switch (lisa_objfile_block_type(block)) {
         case ModuleName: {
             lisa_ModuleName *modulename = block->content.ModuleName;
@@ -357,7 +1655,7 @@ lisa_obj_block_swap(lisa_objfile_block *block)
 
         case External: {
             lisa_External *external = block->content.External;
-            lisa_integer count = (lisa_integer)(((size_t)block->size - 12) / sizeof(lisa_SegAddr));
+            lisa_integer count = (lisa_integer)(((size_t)block->size - 20) / sizeof(lisa_SegAddr)); // header + LinkName + UserName = 20
             for (lisa_integer i = 0; i < count; i++) {
                 external->Ref[i] = swap32be(external->Ref[i]);
             }
@@ -429,17 +1727,19 @@ lisa_obj_block_swap(lisa_objfile_block *block)
             executable->MaxHeap = swap32be(executable->MaxHeap);
 
             lisa_JTSegVariantTable *jtSegVariantTable = lisa_Executable_JTSegVariantTable(executable);
+            lisa_integer numSegs = to_native ? swap16be(jtSegVariantTable->numSegs) : jtSegVariantTable->numSegs;
             jtSegVariantTable->numSegs = swap16be(jtSegVariantTable->numSegs);
-            for (lisa_integer i = 0; i < jtSegVariantTable->numSegs; i++) {
+            for (lisa_integer i = 0; i < numSegs; i++) {
                 jtSegVariantTable->variants[i].SegmentAddr = swap32be(jtSegVariantTable->variants[i].SegmentAddr);
                 jtSegVariantTable->variants[i].SizePacked = swap16be(jtSegVariantTable->variants[i].SizePacked);
                 jtSegVariantTable->variants[i].SizeUnpacked = swap16be(jtSegVariantTable->variants[i].SizeUnpacked);
                 jtSegVariantTable->variants[i].MemLoc = swap32be(jtSegVariantTable->variants[i].MemLoc);
             }
 
-            lisa_JTVariantTable *jtVariantTable = lisa_Executable_JTVariantTable(executable);
+            lisa_JTVariantTable *jtVariantTable = (lisa_JTVariantTable *)&jtSegVariantTable->variants[numSegs];
+            lisa_integer numDescriptors = to_native ? swap16be(jtVariantTable->numDescriptors) : jtVariantTable->numDescriptors;
             jtVariantTable->numDescriptors = swap16be(jtVariantTable->numDescriptors);
-            for (lisa_integer i = 0; i < jtVariantTable->numDescriptors; i++) {
+            for (lisa_integer i = 0; i < numDescriptors; i++) {
                 jtVariantTable->variants[i].JumpL = swap16be(jtVariantTable->variants[i].JumpL);
                 jtVariantTable->variants[i].AbsAddr = swap32be(jtVariantTable->variants[i].AbsAddr);
             }
@@ -457,8 +1757,9 @@ lisa_obj_block_swap(lisa_objfile_block *block)
 
         case SegmentTable: {
             lisa_SegmentTable *segmenttable = block->content.SegmentTable;
+            lisa_integer nSegments = to_native ? swap16be(segmenttable->nSegments) : segmenttable->nSegments;
             segmenttable->nSegments = swap16be(segmenttable->nSegments);
-            for (lisa_integer i = 0; i < segmenttable->nSegments; i++) {
+            for (lisa_integer i = 0; i < nSegments; i++) {
                 segmenttable->variants[i].SegNumber = swap16be(segmenttable->variants[i].SegNumber);
                 segmenttable->variants[i].Version1 = swap32be(segmenttable->variants[i].Version1);
                 segmenttable->variants[i].Version2 = swap32be(segmenttable->variants[i].Version2);
@@ -467,10 +1768,11 @@ lisa_obj_block_swap(lisa_objfile_block *block)
 
         case UnitTable: {
             lisa_UnitTable *unittable = block->content.UnitTable;
+            lisa_integer nUnits = to_native ? swap16be(unittable->nUnits) : unittable->nUnits;
             unittable->nUnits = swap16be(unittable->nUnits);
             unittable->maxunit = swap16be(unittable->maxunit);
 
-            for (lisa_integer i = 0; i < unittable->nUnits; i++) {
+            for (lisa_integer i = 0; i < nUnits; i++) {
                 unittable->variants[i].UnitNumber = swap16be(unittable->variants[i].UnitNumber);
                 unittable->variants[i].UnitType = swap16be(unittable->variants[i].UnitType);
             }
@@ -478,8 +1780,10 @@ lisa_obj_block_swap(lisa_objfile_block *block)
 
         case SegLocation: {
             lisa_SegLocation *seglocation = block->content.SegLocation;
+            lisa_integer nSegments = to_native ? swap16be(seglocation->nSegments) : seglocation->nSegments;
             seglocation->nSegments = swap16be(seglocation->nSegments);
-            for (lisa_integer i = 0; i < seglocation->nSegments; i++) {
+            for (lisa_integer i = 0; i < nSegments; i++) {
+                seglocation->variants[i].SegNumber = swap16be(seglocation->variants[i].SegNumber);
                 seglocation->variants[i].Version1 = swap32be(seglocation->variants[i].Version1);
                 seglocation->variants[i].Version2 = swap32be(seglocation->variants[i].Version2);
                 seglocation->variants[i].FileNumber = swap16be(seglocation->variants[i].FileNumber);
@@ -491,8 +1795,9 @@ lisa_obj_block_swap(lisa_objfile_block *block)
 
         case UnitLocation: {
             lisa_UnitLocation *unitlocation = block->content.UnitLocation;
+            lisa_integer nUnits = to_native ? swap16be(unitlocation->nUnits) : unitlocation->nUnits;
             unitlocation->nUnits = swap16be(unitlocation->nUnits);
-            for (lisa_integer i = 0; i < unitlocation->nUnits; i++) {
+            for (lisa_integer i = 0; i < nUnits; i++) {
                 unitlocation->variants[i].UnitNumber = swap16be(unitlocation->variants[i].UnitNumber);
                 unitlocation->variants[i].DataSize = swap32be(unitlocation->variants[i].DataSize);
             }
@@ -500,8 +1805,9 @@ lisa_obj_block_swap(lisa_objfile_block *block)
 
         case StringBlock: {
             lisa_StringBlock *stringblock = block->content.StringBlock;
+            lisa_integer nStrings = to_native ? swap16be(stringblock->nStrings) : stringblock->nStrings;
             stringblock->nStrings = swap16be(stringblock->nStrings);
-            for (lisa_integer i = 0; i < stringblock->nStrings; i++) {
+            for (lisa_integer i = 0; i < nStrings; i++) {
                 stringblock->variants[i].FileNumber = swap16be(stringblock->variants[i].FileNumber);
                 stringblock->variants[i].NameAddr = swap32be(stringblock->variants[i].NameAddr);
             }
@@ -526,14 +1832,25 @@ lisa_obj_block_swap(lisa_objfile_block *block)
         case EOFMark: {
         } break;
     }
+
+    lisa_stats_end(lisa_stats_swap, swap_start, block->size, 0);
 }
 
 
 void
 lisa_obj_block_dump(lisa_objfile_block *block)
 {
+    lisa_obj_block_fdump(block, stdout, lisa_obj_dump_flags_none);
+}
+
+
+void
+lisa_obj_block_fdump(lisa_objfile_block *block, FILE *f, lisa_obj_dump_flags flags)
+{
+    uint64_t format_start = lisa_stats_begin();
+
     // Print header info.
-    fprintf(stdout, "%s ($%02X), offset %u, %u total bytes" "\n",
+    fprintf(f, "%s ($%02X), offset %u, %u total bytes" "\n",
             lisa_obj_block_type_string(block->type), block->type,
             block->offset, block->size);
 
@@ -545,16 +1862,16 @@ lisa_obj_block_dump(lisa_objfile_block *block)
             lisa_ModuleName *modulename = block->content.ModuleName;
             memset(buf, 0, 9);
             memcpy(buf, modulename->ModuleName, 8);
-            fprintf(stdout, "\t" "ModuleName: '%s'" "\n", buf);
+            fprintf(f, "\t" "ModuleName: '%s'" "\n", buf);
             memset(buf, 0, 9);
             memcpy(buf, modulename->SegmentName, 8);
-            fprintf(stdout, "\t" "SegmentName: '%s'" "\n", buf);
-            fprintf(stdout, "\t" "CSize: %d" "\n", modulename->CSize);
+            fprintf(f, "\t" "SegmentName: '%s'" "\n", buf);
+            fprintf(f, "\t" "CSize: %d" "\n", modulename->CSize);
         } break;
 
         case EndBlock: {
             lisa_EndBlock *endblock = block->content.EndBlock;
-            fprintf(stdout, "\t" "CSize: %d" "\n", endblock->CSize);
+            fprintf(f, "\t" "CSize: %d" "\n", endblock->CSize);
         } break;
 
         case EntryPoint: {
@@ -563,11 +1880,11 @@ lisa_obj_block_dump(lisa_objfile_block *block)
             lisa_EntryPoint *entrypoint = block->content.EntryPoint;
             memset(buf, 0, 9);
             memcpy(buf, entrypoint->LinkName, 8);
-            fprintf(stdout, "\t" "LinkName: '%s'" "\n", buf);
+            fprintf(f, "\t" "LinkName: '%s'" "\n", buf);
             memset(buf, 0, 9);
             memcpy(buf, entrypoint->UserName, 8);
-            fprintf(stdout, "\t" "UserName: '%s'" "\n", buf);
-            fprintf(stdout, "\t" "Loc: $%08x" "\n", entrypoint->Loc);
+            fprintf(f, "\t" "UserName: '%s'" "\n", buf);
+            fprintf(f, "\t" "Loc: $%08x" "\n", entrypoint->Loc);
         } break;
 
         case External: {
@@ -576,42 +1893,44 @@ lisa_obj_block_dump(lisa_objfile_block *block)
             lisa_External *external = block->content.External;
             memset(buf, 0, 9);
             memcpy(buf, external->LinkName, 8);
-            fprintf(stdout, "\t" "LinkName: '%s'" "\n", buf);
+            fprintf(f, "\t" "LinkName: '%s'" "\n", buf);
             memset(buf, 0, 9);
             memcpy(buf, external->UserName, 8);
-            fprintf(stdout, "\t" "UserName: '%s'" "\n", buf);
+            fprintf(f, "\t" "UserName: '%s'" "\n", buf);
 
-            lisa_integer count = (lisa_integer)(((size_t)block->size - 12) / sizeof(lisa_SegAddr));
-            fprintf(stdout, "\t" "nRefs: %d" "\n", count);
+            lisa_integer count = (lisa_integer)(((size_t)block->size - 20) / sizeof(lisa_SegAddr));
+            fprintf(f, "\t" "nRefs: %d" "\n", count);
 
             for (lisa_integer i = 0; i < count; i++) {
-                fprintf(stdout, "\t\t" "Ref[%d]: %d" "\n", i, external->Ref[i]);
+                fprintf(f, "\t\t" "Ref[%d]: %d" "\n", i, external->Ref[i]);
             }
         } break;
 
         case StartAddress: {
             lisa_StartAddress *startaddress = block->content.StartAddress;
-            fprintf(stdout, "\t" "Start: $%08x" "\n", startaddress->Start);
-            fprintf(stdout, "\t" "GSize: %d" "\n", startaddress->GSize);
+            fprintf(f, "\t" "Start: $%08x" "\n", startaddress->Start);
+            fprintf(f, "\t" "GSize: %d" "\n", startaddress->GSize);
         } break;
 
         case CodeBlock: {
             lisa_CodeBlock *codeblock = block->content.CodeBlock;
-            fprintf(stdout, "\t" "Addr: $%08x" "\n", codeblock->Addr);
+            fprintf(f, "\t" "Addr: $%08x" "\n", codeblock->Addr);
 
             lisa_longint size = block->size - 8; // header + Addr = 8
             uint8_t *code = codeblock->code;
 
-            dumphex(code, (size_t) size, stdout);
+            if (flags & lisa_obj_dump_flags_no_code) break;
+
+            dumphex(code, (size_t) size, f);
         } break;
 
         case Relocation: {
             lisa_Relocation *relocation = block->content.Relocation;
             lisa_integer count = (lisa_integer)(((size_t)block->size - 4) / sizeof(lisa_SegAddr));
-            fprintf(stdout, "\t" "nRefs: %d" "\n", count);
+            fprintf(f, "\t" "nRefs: %d" "\n", count);
 
             for (lisa_integer i = 0; i < count; i++) {
-                fprintf(stdout, "\t\t" "Ref[%d]: %d" "\n", i, relocation->Ref[i]);
+                fprintf(f, "\t\t" "Ref[%d]: %d" "\n", i, relocation->Ref[i]);
             }
         } break;
 
@@ -621,13 +1940,13 @@ lisa_obj_block_dump(lisa_objfile_block *block)
             lisa_CommonRelocation *commonrelocation = block->content.CommonRelocation;
             memset(buf, 0, 9);
             memcpy(buf, commonrelocation->CommonName, 8);
-            fprintf(stdout, "\t" "CommonName: '%s'" "\n", buf);
+            fprintf(f, "\t" "CommonName: '%s'" "\n", buf);
 
             lisa_integer count = (lisa_integer)(((size_t)block->size - 12) / sizeof(lisa_SegAddr));
-            fprintf(stdout, "\t" "nRefs: %d" "\n", count);
+            fprintf(f, "\t" "nRefs: %d" "\n", count);
 
             for (lisa_integer i = 0; i < count; i++) {
-                fprintf(stdout, "\t\t" "Ref[%d]: %d" "\n", i, commonrelocation->Ref[i]);
+                fprintf(f, "\t\t" "Ref[%d]: %d" "\n", i, commonrelocation->Ref[i]);
             }
         } break;
 
@@ -637,22 +1956,22 @@ lisa_obj_block_dump(lisa_objfile_block *block)
             lisa_ShortExternal *shortexternal = block->content.ShortExternal;
             memset(buf, 0, 9);
             memcpy(buf, shortexternal->LinkName, 8);
-            fprintf(stdout, "\t" "LinkName: '%s'" "\n", buf);
+            fprintf(f, "\t" "LinkName: '%s'" "\n", buf);
             memset(buf, 0, 9);
             memcpy(buf, shortexternal->UserName, 8);
-            fprintf(stdout, "\t" "UserName: '%s'" "\n", buf);
+            fprintf(f, "\t" "UserName: '%s'" "\n", buf);
 
             lisa_integer count = (lisa_integer)(((size_t)block->size - 20) / sizeof(lisa_integer));
-            fprintf(stdout, "\t" "nShortRefs: %d" "\n", count);
+            fprintf(f, "\t" "nShortRefs: %d" "\n", count);
 
             for (lisa_integer i = 0; i < count; i++) {
-                fprintf(stdout, "\t\t" "ShortRef[%d]: %d" "\n", i, shortexternal->ShortRef[i]);
+                fprintf(f, "\t\t" "ShortRef[%d]: %d" "\n", i, shortexternal->ShortRef[i]);
             }
         } break;
 
         case OldExecutable: {
             // TODO: Dump OldExecutable
-            fprintf(stdout, "\t" "UNIMPLEMENTED" "\n");
+            fprintf(f, "\t" "UNIMPLEMENTED" "\n");
         } break;
 
         case UnitBlock: {
@@ -661,78 +1980,86 @@ lisa_obj_block_dump(lisa_objfile_block *block)
             lisa_UnitBlock *unitblock = block->content.UnitBlock;
             memset(buf, 0, 9);
             memcpy(buf, unitblock->UnitName, 8);
-            fprintf(stdout, "\t" "UnitName: '%s'" "\n", buf);
-            fprintf(stdout, "\t" "CodeAddr: $%08x" "\n", unitblock->CodeAddr);
-            fprintf(stdout, "\t" "TextAddr: $%08x" "\n", unitblock->TextAddr);
-            fprintf(stdout, "\t" "TextSize: %d" "\n", unitblock->TextSize);
-            fprintf(stdout, "\t" "GlobalSize: %d" "\n", unitblock->GlobalSize);
-            fprintf(stdout, "\t" "UnitType: %s" "\n", lisa_UnitType_string(unitblock->UnitType));
+            fprintf(f, "\t" "UnitName: '%s'" "\n", buf);
+            fprintf(f, "\t" "CodeAddr: $%08x" "\n", unitblock->CodeAddr);
+            fprintf(f, "\t" "TextAddr: $%08x" "\n", unitblock->TextAddr);
+            fprintf(f, "\t" "TextSize: %d" "\n", unitblock->TextSize);
+            fprintf(f, "\t" "GlobalSize: %d" "\n", unitblock->GlobalSize);
+            fprintf(f, "\t" "UnitType: %s" "\n", lisa_UnitType_string(unitblock->UnitType));
         } break;
 
         case PhysicalExec: {
             // TODO: Dump PhysicalExec
-            fprintf(stdout, "\t" "UNIMPLEMENTED" "\n");
+            fprintf(f, "\t" "UNIMPLEMENTED" "\n");
         } break;
 
         case Executable: {
             lisa_Executable *executable = block->content.Executable;
-            fprintf(stdout, "\t" "JTLaddr: $%08x" "\n", executable->JTLaddr);
-            fprintf(stdout, "\t" "JTSize: %d" "\n", executable->JTSize);
-            fprintf(stdout, "\t" "DataSize: %d" "\n", executable->DataSize);
-            fprintf(stdout, "\t" "MainSize: %d" "\n", executable->MainSize);
-            fprintf(stdout, "\t" "JTSegDelta: %d" "\n", executable->JTSegDelta);
-            fprintf(stdout, "\t" "StkSegDelta: %d" "\n", executable->StkSegDelta);
-            fprintf(stdout, "\t" "DynStack: %d" "\n", executable->DynStack);
-            fprintf(stdout, "\t" "MaxStack: %d" "\n", executable->MaxStack);
-            fprintf(stdout, "\t" "MinHeap: %d" "\n", executable->MinHeap);
-            fprintf(stdout, "\t" "MaxHeap: %d" "\n", executable->MaxHeap);
+            fprintf(f, "\t" "JTLaddr: $%08x" "\n", executable->JTLaddr);
+            fprintf(f, "\t" "JTSize: %d" "\n", executable->JTSize);
+            fprintf(f, "\t" "DataSize: %d" "\n", executable->DataSize);
+            fprintf(f, "\t" "MainSize: %d" "\n", executable->MainSize);
+            fprintf(f, "\t" "JTSegDelta: %d" "\n", executable->JTSegDelta);
+            fprintf(f, "\t" "StkSegDelta: %d" "\n", executable->StkSegDelta);
+            fprintf(f, "\t" "DynStack: %d" "\n", executable->DynStack);
+            fprintf(f, "\t" "MaxStack: %d" "\n", executable->MaxStack);
+            fprintf(f, "\t" "MinHeap: %d" "\n", executable->MinHeap);
+            fprintf(f, "\t" "MaxHeap: %d" "\n", executable->MaxHeap);
 
             lisa_JTSegVariantTable *jtSegVariantTable = lisa_Executable_JTSegVariantTable(executable);
-            fprintf(stdout, "\t" "numSegs: %d" "\n", jtSegVariantTable->numSegs);
+            fprintf(f, "\t" "numSegs: %d" "\n", jtSegVariantTable->numSegs);
             for (lisa_integer i = 0; i < jtSegVariantTable->numSegs; i++) {
-                fprintf(stdout, "\t" "[%d]{" "\n", i);
-                fprintf(stdout, "\t\t" "SegmentAddr: %d" "\n", jtSegVariantTable->variants[i].SegmentAddr);
-                fprintf(stdout, "\t\t" "SizePacked: %d" "\n", jtSegVariantTable->variants[i].SizePacked);
-                fprintf(stdout, "\t\t" "SizeUnpacked: %d" "\n", jtSegVariantTable->variants[i].SizeUnpacked);
-                fprintf(stdout, "\t\t" "MemLoc: $%08x" "\n", jtSegVariantTable->variants[i].MemLoc);
-                fprintf(stdout, "\t" "}" "\n");
+                fprintf(f, "\t" "[%d]{" "\n", i);
+                fprintf(f, "\t\t" "SegmentAddr: %d" "\n", jtSegVariantTable->variants[i].SegmentAddr);
+                fprintf(f, "\t\t" "SizePacked: %d" "\n", jtSegVariantTable->variants[i].SizePacked);
+                fprintf(f, "\t\t" "SizeUnpacked: %d" "\n", jtSegVariantTable->variants[i].SizeUnpacked);
+                fprintf(f, "\t\t" "MemLoc: $%08x" "\n", jtSegVariantTable->variants[i].MemLoc);
+                fprintf(f, "\t" "}" "\n");
             }
 
             lisa_JTVariantTable *jtVariantTable = lisa_Executable_JTVariantTable(executable);
-            fprintf(stdout, "\t" "numDescriptors: %d" "\n", jtVariantTable->numDescriptors);
+            fprintf(f, "\t" "numDescriptors: %d" "\n", jtVariantTable->numDescriptors);
             for (lisa_integer i = 0; i < jtVariantTable->numDescriptors; i++) {
-                fprintf(stdout, "\t" "[%d]{" "\n", i);
-                fprintf(stdout, "\t\t" "JumpL: $%04x" "\n", jtVariantTable->variants[i].JumpL);
-                fprintf(stdout, "\t\t" "AbsAddr: $%08x" "\n", jtVariantTable->variants[i].AbsAddr);
-                fprintf(stdout, "\t" "}" "\n");
+                fprintf(f, "\t" "[%d]{" "\n", i);
+                fprintf(f, "\t\t" "JumpL: $%04x" "\n", jtVariantTable->variants[i].JumpL);
+                fprintf(f, "\t\t" "AbsAddr: $%08x" "\n", jtVariantTable->variants[i].AbsAddr);
+
+                // Show where the descriptor leads, as resolved when the file was opened.
+                const lisa_jump_table_entry *entry = block->objfile ? lisa_objfile_jump_table_entry_at_slot(block->objfile, i) : NULL;
+                if (entry && (entry->segment != -1)) {
+                    fprintf(f, "\t\t" "Segment: %d" "\n", entry->segment);
+                    fprintf(f, "\t\t" "Offset: $%08x" "\n", entry->offset);
+                    if (entry->name[0] != '\0') fprintf(f, "\t\t" "EntryPoint: %s" "\n", entry->name);
+                }
+                fprintf(f, "\t" "}" "\n");
             }
         } break;
 
         case VersionCtrl: {
             lisa_VersionCtrl *versionctrl = block->content.VersionCtrl;
-            fprintf(stdout, "\t" "sysNum: $%08x" "\n", versionctrl->sysNum);
-            fprintf(stdout, "\t" "minSys: $%08x" "\n", versionctrl->minSys);
-            fprintf(stdout, "\t" "maxSys: $%08x" "\n", versionctrl->maxSys);
-            fprintf(stdout, "\t" "Reserv1: $%08x" "\n", versionctrl->Reserv1);
-            fprintf(stdout, "\t" "Reserv2: $%08x" "\n", versionctrl->Reserv2);
-            fprintf(stdout, "\t" "Reserv3: $%08x" "\n", versionctrl->Reserv3);
+            fprintf(f, "\t" "sysNum: $%08x" "\n", versionctrl->sysNum);
+            fprintf(f, "\t" "minSys: $%08x" "\n", versionctrl->minSys);
+            fprintf(f, "\t" "maxSys: $%08x" "\n", versionctrl->maxSys);
+            fprintf(f, "\t" "Reserv1: $%08x" "\n", versionctrl->Reserv1);
+            fprintf(f, "\t" "Reserv2: $%08x" "\n", versionctrl->Reserv2);
+            fprintf(f, "\t" "Reserv3: $%08x" "\n", versionctrl->Reserv3);
         } break;
 
         case SegmentTable: {
             char buf[9];
 
             lisa_SegmentTable *segmenttable = block->content.SegmentTable;
-            fprintf(stdout, "\t" "nSegments: %d" "\n", segmenttable->nSegments);
+            fprintf(f, "\t" "nSegments: %d" "\n", segmenttable->nSegments);
 
             for (lisa_integer i = 0; i < segmenttable->nSegments; i++) {
-                fprintf(stdout, "\t" "[%d]{" "\n", i);
+                fprintf(f, "\t" "[%d]{" "\n", i);
                 memset(buf, 0, 9);
                 memcpy(buf, segmenttable->variants[i].SegName, 8);
-                fprintf(stdout, "\t\t" "SegName: '%s'" "\n", buf);
-                fprintf(stdout, "\t\t" "SegNumber: %d" "\n", segmenttable->variants[i].SegNumber);
-                fprintf(stdout, "\t\t" "Version1: $%08x" "\n", segmenttable->variants[i].Version1);
-                fprintf(stdout, "\t\t" "Version2: $%08x" "\n", segmenttable->variants[i].Version2);
-                fprintf(stdout, "\t" "}" "\n");
+                fprintf(f, "\t\t" "SegName: '%s'" "\n", buf);
+                fprintf(f, "\t\t" "SegNumber: %d" "\n", segmenttable->variants[i].SegNumber);
+                fprintf(f, "\t\t" "Version1: $%08x" "\n", segmenttable->variants[i].Version1);
+                fprintf(f, "\t\t" "Version2: $%08x" "\n", segmenttable->variants[i].Version2);
+                fprintf(f, "\t" "}" "\n");
             }
         } break;
 
@@ -740,17 +2067,17 @@ lisa_obj_block_dump(lisa_objfile_block *block)
             char buf[9];
 
             lisa_UnitTable *unittable = block->content.UnitTable;
-            fprintf(stdout, "\t" "nUnits: %d" "\n", unittable->nUnits);
-            fprintf(stdout, "\t" "maxunit: %d" "\n", unittable->maxunit);
+            fprintf(f, "\t" "nUnits: %d" "\n", unittable->nUnits);
+            fprintf(f, "\t" "maxunit: %d" "\n", unittable->maxunit);
 
             for (lisa_integer i = 0; i < unittable->nUnits; i++) {
-                fprintf(stdout, "\t" "[%d]{" "\n", i);
+                fprintf(f, "\t" "[%d]{" "\n", i);
                 memset(buf, 0, 9);
                 memcpy(buf, unittable->variants[i].UnitName, 8);
-                fprintf(stdout, "\t\t" "UnitName: '%s'" "\n", buf);
-                fprintf(stdout, "\t\t" "UnitNumber: %d" "\n", unittable->variants[i].UnitNumber);
-                fprintf(stdout, "\t\t" "UnitType: %s" "\n", lisa_UnitType_string(unittable->variants[i].UnitType));
-                fprintf(stdout, "\t" "}" "\n");
+                fprintf(f, "\t\t" "UnitName: '%s'" "\n", buf);
+                fprintf(f, "\t\t" "UnitNumber: %d" "\n", unittable->variants[i].UnitNumber);
+                fprintf(f, "\t\t" "UnitType: %s" "\n", lisa_UnitType_string(unittable->variants[i].UnitType));
+                fprintf(f, "\t" "}" "\n");
             }
         } break;
 
@@ -758,20 +2085,20 @@ lisa_obj_block_dump(lisa_objfile_block *block)
             char buf[9];
 
             lisa_SegLocation *seglocation = block->content.SegLocation;
-            fprintf(stdout, "\t" "nSegments: %d" "\n", seglocation->nSegments);
+            fprintf(f, "\t" "nSegments: %d" "\n", seglocation->nSegments);
 
             for (lisa_integer i = 0; i < seglocation->nSegments; i++) {
-                fprintf(stdout, "\t" "[%d]{" "\n", i);
+                fprintf(f, "\t" "[%d]{" "\n", i);
                 memset(buf, 0, 9);
                 memcpy(buf, seglocation->variants[i].SegName, 8);
-                fprintf(stdout, "\t\t" "SegName: '%s'" "\n", buf);
-                fprintf(stdout, "\t\t" "Version1: $%08x" "\n", seglocation->variants[i].Version1);
-                fprintf(stdout, "\t\t" "Version2: $%08x" "\n", seglocation->variants[i].Version2);
-                fprintf(stdout, "\t\t" "FileNumber: %d" "\n", seglocation->variants[i].FileNumber);
-                fprintf(stdout, "\t\t" "FileLocation: %d" "\n", seglocation->variants[i].FileLocation);
-                fprintf(stdout, "\t\t" "SizePacked: %d" "\n", seglocation->variants[i].SizePacked);
-                fprintf(stdout, "\t\t" "SizeUnpacked: %d" "\n", seglocation->variants[i].SizeUnpacked);
-                fprintf(stdout, "\t" "}" "\n");
+                fprintf(f, "\t\t" "SegName: '%s'" "\n", buf);
+                fprintf(f, "\t\t" "Version1: $%08x" "\n", seglocation->variants[i].Version1);
+                fprintf(f, "\t\t" "Version2: $%08x" "\n", seglocation->variants[i].Version2);
+                fprintf(f, "\t\t" "FileNumber: %d" "\n", seglocation->variants[i].FileNumber);
+                fprintf(f, "\t\t" "FileLocation: %d" "\n", seglocation->variants[i].FileLocation);
+                fprintf(f, "\t\t" "SizePacked: %d" "\n", seglocation->variants[i].SizePacked);
+                fprintf(f, "\t\t" "SizeUnpacked: %d" "\n", seglocation->variants[i].SizeUnpacked);
+                fprintf(f, "\t" "}" "\n");
             }
         } break;
 
@@ -779,59 +2106,63 @@ lisa_obj_block_dump(lisa_objfile_block *block)
             char buf[9];
 
             lisa_UnitLocation *unitlocation = block->content.UnitLocation;
-            fprintf(stdout, "\t" "nUnits: %d" "\n", unitlocation->nUnits);
+            fprintf(f, "\t" "nUnits: %d" "\n", unitlocation->nUnits);
 
             for (lisa_integer i = 0; i < unitlocation->nUnits; i++) {
-                fprintf(stdout, "\t" "[%d]{" "\n", i);
+                fprintf(f, "\t" "[%d]{" "\n", i);
                 memset(buf, 0, 9);
                 memcpy(buf, unitlocation->variants[i].UnitName, 8);
-                fprintf(stdout, "\t\t" "UnitName: '%s'" "\n", buf);
-                fprintf(stdout, "\t\t" "UnitNumber: %d" "\n", unitlocation->variants[i].UnitNumber);
-                fprintf(stdout, "\t\t" "FileNumber: %d" "\n", unitlocation->variants[i].FileNumber);
-                fprintf(stdout, "\t\t" "UnitType: %s" "\n", lisa_UnitType_string(unitlocation->variants[i].UnitType));
-                fprintf(stdout, "\t\t" "DataSize: %d" "\n", unitlocation->variants[i].DataSize);
-                fprintf(stdout, "\t" "}" "\n");
+                fprintf(f, "\t\t" "UnitName: '%s'" "\n", buf);
+                fprintf(f, "\t\t" "UnitNumber: %d" "\n", unitlocation->variants[i].UnitNumber);
+                fprintf(f, "\t\t" "FileNumber: %d" "\n", unitlocation->variants[i].FileNumber);
+                fprintf(f, "\t\t" "UnitType: %s" "\n", lisa_UnitType_string(unitlocation->variants[i].UnitType));
+                fprintf(f, "\t\t" "DataSize: %d" "\n", unitlocation->variants[i].DataSize);
+                fprintf(f, "\t" "}" "\n");
             }
         } break;
 
         case StringBlock: {
             lisa_StringBlock *stringblock = block->content.StringBlock;
-            fprintf(stdout, "\t" "nStrings: %d" "\n", stringblock->nStrings);
+            fprintf(f, "\t" "nStrings: %d" "\n", stringblock->nStrings);
 
             for (lisa_integer i = 0; i < stringblock->nStrings; i++) {
-                fprintf(stdout, "\t" "[%d]{" "\n", i);
-                fprintf(stdout, "\t\t" "FileNumber: %d" "\n", stringblock->variants[i].FileNumber);
-                fprintf(stdout, "\t\t" "NameAddr: %d" "\n", stringblock->variants[i].NameAddr);
+                fprintf(f, "\t" "[%d]{" "\n", i);
+                fprintf(f, "\t\t" "FileNumber: %d" "\n", stringblock->variants[i].FileNumber);
+                fprintf(f, "\t\t" "NameAddr: %d" "\n", stringblock->variants[i].NameAddr);
 
-                char str[256];
-                lisa_objfile_copy_pstring_at_offset(block->objfile, str, stringblock->variants[i].NameAddr);
+                lisa_pstring_view name = { .chars = NULL, .length = 0 };
+                if (block->objfile) lisa_objfile_pstring_at_offset(block->objfile, stringblock->variants[i].NameAddr, &name);
 
-                fprintf(stdout, "\t\t" "Name: '%s'" "\n", str);
+                fprintf(f, "\t\t" "Name: '%.*s'" "\n", (int)name.length, name.chars ? name.chars : "");
 
-                fprintf(stdout, "\t" "}" "\n");
+                fprintf(f, "\t" "}" "\n");
             }
         } break;
 
         case PackedCode: {
             lisa_PackedCode *packedcode = block->content.PackedCode;
-            fprintf(stdout, "\t" "addr: $%08x" "\n", packedcode->addr);
-            fprintf(stdout, "\t" "csize: %d" "\n", packedcode->csize);
+            fprintf(f, "\t" "addr: $%08x" "\n", packedcode->addr);
+            fprintf(f, "\t" "csize: %d" "\n", packedcode->csize);
+
+            // Skip unpacking entirely when code isn't wanted.
+            if (flags & lisa_obj_dump_flags_no_code) break;
 
             lisa_longint packed_size = block->size - 12; // header + addr + csize = 12
             uint8_t *packed = packedcode->code;
 
+            const lisa_allocator *allocator = block->objfile ? block->objfile->allocator : lisa_default_allocator();
             lisa_longint unpacked_size = packedcode->csize;
-            uint8_t *unpacked = calloc(sizeof(uint8_t), (size_t)unpacked_size);
+            uint8_t *unpacked = allocator_allocate(allocator, (size_t)unpacked_size);
             if (unpacked) {
                 int unpack_err = lisa_unpackcode(packed, packed_size,
                                                  unpacked, &unpacked_size,
                                                  NULL);
                 if (unpack_err == 0) {
-                    dumphex(unpacked, (size_t) unpacked_size, stdout);
+                    dumphex(unpacked, (size_t) unpacked_size, f);
                 } else {
                     fprintf(stderr, "unpacking error %d" "\n", unpack_err);
                 }
-                free(unpacked);
+                allocator_deallocate(allocator, unpacked);
             } else {
                 fprintf(stderr, "error allocating storage for unpacked code" "\n");
             }
@@ -839,23 +2170,25 @@ lisa_obj_block_dump(lisa_objfile_block *block)
 
         case PackTable: {
             lisa_PackTable *packtable = block->content.PackTable;
-            fprintf(stdout, "\t" "packversion: %d" "\n", packtable->packversion);
+            fprintf(f, "\t" "packversion: %d" "\n", packtable->packversion);
 
             if (packtable->packversion == 1) {
-                dumphex(packtable->words, sizeof(lisa_integer) * 256, stdout);
+                dumphex(packtable->words, sizeof(lisa_integer) * 256, f);
             } else {
-                dumphex(packtable->words, (size_t)block->size - 8, stdout);
+                dumphex(packtable->words, (size_t)block->size - 8, f);
             }
         } break;
 
         case OSData: {
             lisa_OSData *osdata = block->content.OSData;
-            dumphex(osdata->bitmap, 16, stdout);
+            dumphex(osdata->bitmap, 16, f);
         } break;
 
         case EOFMark: {
         } break;
     }
+
+    lisa_stats_end(lisa_stats_format, format_start, block->size, 0);
 }
 
 
@@ -964,6 +2297,9 @@ lisa_unpackcode(uint8_t *packed, lisa_longint packed_size,
 
     if (packed_size % 2) return -1;
     if (*unpacked_size % 2) return -1;
+    if (packed_size < 2) return -1;
+
+    uint64_t unpack_start = lisa_stats_begin();
 
     const uint16_t * const words = packtable->words;
 
@@ -991,11 +2327,19 @@ lisa_unpackcode(uint8_t *packed, lisa_longint packed_size,
         packed_idx--; // skip slack byte
     }
 
+    if (max_bit > 7) return -1;
+
     while (packed_idx > 0) {
         uint8_t flags = packed[packed_idx--];
         for (int i = max_bit; i >= 0; i--) {
             int flag = BIT(flags, i);
 
+            // Damaged code could claim more words than there are bytes
+            // left to read, or than there's room for; either way it
+            // can't be unpacked.
+
+            if ((packed_idx < (flag ? 0 : 1)) || (unpacked_idx < 1)) return -1;
+
             if (flag) {
                 // Copy from table
                 uint8_t word_idx = packed[packed_idx--];
@@ -1025,10 +2369,23 @@ lisa_unpackcode(uint8_t *packed, lisa_longint packed_size,
         memmove(unpacked, &unpacked[last_unpacked_idx], (size_t) *unpacked_size);
     }
 
+    lisa_stats_end(lisa_stats_unpack, unpack_start, (uint64_t)packed_size, (uint64_t)*unpacked_size);
+
     return 0;
 }
 
 
+size_t
+lisa_packcode_max_size(size_t unpacked_size)
+{
+    // At worst every word is stored as is, taking up one more byte than
+    // the input when it's an odd size, with a flags byte for every eight
+    // of them, a slack byte and a final byte.
+
+    return unpacked_size + (unpacked_size / 16) + 4;
+}
+
+
 int
 lisa_packcode(uint8_t *packed, lisa_longint *packed_size,
               uint8_t *unpacked, lisa_longint unpacked_size,
@@ -1040,8 +2397,16 @@ lisa_packcode(uint8_t *packed, lisa_longint *packed_size,
 
     if (packtable->packversion != 1) return -1;
 
+    uint64_t pack_start = lisa_stats_begin();
+
     const uint16_t * const words = packtable->words;
 
+    // Most callers make room for the worst case, and then there's no
+    // need to check for room before every byte.
+
+    const lisa_longint capacity = *packed_size;
+    const bool checked = (capacity < 0) || ((size_t)capacity < lisa_packcode_max_size((size_t)unpacked_size));
+
     lisa_longint packed_count = 0;
 
     lisa_longint i = 0;
@@ -1063,6 +2428,10 @@ lisa_packcode(uint8_t *packed, lisa_longint *packed_size,
             if (words[w] == word) word_index = w;
         }
 
+        if (checked && (packed_count + ((word_index != -1) ? 1 : 2) + ((flag_bit == 7) ? 1 : 0) > capacity)) {
+            goto overflow;
+        }
+
         if (word_index != -1) {
             packed[packed_count++] = (uint8_t)word_index;
             SET_BIT(flags, flag_bit);
@@ -1082,6 +2451,18 @@ lisa_packcode(uint8_t *packed, lisa_longint *packed_size,
         }
     }
 
+    // The last group of words may not have filled its flags byte, but
+    // its flags still have to follow it.
+
+    if (checked) {
+        lisa_longint flags_count = packed_count + ((flag_bit != 0) ? 1 : 0);
+        if (flags_count + (((flags_count % 2) == 0) ? 2 : 1) > capacity) goto overflow;
+    }
+
+    if (flag_bit != 0) {
+        packed[packed_count++] = flags;
+    }
+
     // We could run out of input before the flags byte is full, i.e.
     // the input isn't a multiple of 8 bytes. That's why we always
     // output one final byte to indicate which bit we got to at the
@@ -1109,6 +2490,43 @@ lisa_packcode(uint8_t *packed, lisa_longint *packed_size,
 
     *packed_size = packed_count;
 
+    lisa_stats_end(lisa_stats_pack, pack_start, (uint64_t)unpacked_size, (uint64_t)packed_count);
+
+    return 0;
+
+overflow:
+    lisa_stats_end(lisa_stats_pack, pack_start, (uint64_t)unpacked_size, (uint64_t)packed_count);
+    errno = ERANGE;
+    return -1;
+}
+
+
+int
+lisa_packcode_allocated(uint8_t * LISA_NULLABLE * LISA_NONNULL packed, lisa_longint *packed_size,
+                        uint8_t *unpacked, lisa_longint unpacked_size,
+                        lisa_PackTable * LISA_NULLABLE table,
+                        const lisa_allocator * LISA_NULLABLE allocator)
+{
+    if (allocator == NULL) allocator = lisa_default_allocator();
+
+    const size_t max_size = lisa_packcode_max_size((size_t)unpacked_size);
+    if (max_size > INT32_MAX) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    *packed = allocator_allocate(allocator, max_size);
+    if (*packed == NULL) return -1;
+
+    *packed_size = (lisa_longint)max_size;
+    int pack_err = lisa_packcode(*packed, packed_size, unpacked, unpacked_size, table);
+    if (pack_err == -1) {
+        allocator_deallocate(allocator, *packed);
+        *packed = NULL;
+        errno = EINVAL;
+        return -1;
+    }
+
     return 0;
 }
 
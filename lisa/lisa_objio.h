@@ -7,9 +7,13 @@
 #ifndef __LISA__OBJIO__H__
 #define __LISA__OBJIO__H__
 
+#include <stdio.h>
+
 #include "lisa_defines.h"
 #include "lisa_types.h"
 
+#include "lisa_alloc.h"
+
 LISA_HEADER_BEGIN
 
 
@@ -47,6 +51,22 @@ LISA_EXTERN
 const char *
 lisa_obj_block_type_string(lisa_obj_block_type t);
 
+/*!
+    Get the block type named by \a s, which may be a block type name
+    (case-insensitive) or a number such as `$9C` or `0x9C`.
+ */
+LISA_EXTERN
+bool
+lisa_obj_block_type_from_string(const char *s, lisa_obj_block_type *t);
+
+/*!
+    Gets \a name into \a cstr as a C string, without its blank padding.
+    \a cstr must have room for 9 bytes.
+ */
+LISA_EXTERN
+void
+lisa_ObjName_get_cstring(char *cstr, const lisa_ObjName name);
+
 
 /*! A module name block. ($80) */
 struct lisa_ModuleName {
@@ -347,16 +367,138 @@ struct lisa_objfile_block;
 typedef struct lisa_objfile_block lisa_objfile_block;
 
 
+/*! A module within a Lisa executable/object file, as block indexes. */
+struct lisa_objfile_module {
+    lisa_integer		first_block;	//!< index of the ModuleName block
+    lisa_integer		last_block;		//!< index of the EndBlock, or last block of the module
+    lisa_integer		code_block;		//!< index of the CodeBlock or PackedCode, or -1
+};
+typedef struct lisa_objfile_module lisa_objfile_module;
+
+
+/*!
+    A segment of a Lisa executable/object file, as found through its
+    segment tables. Its code points directly into the file's buffer.
+
+    Segments are numbered from 1. An executable's SegLocation gives each
+    segment's SegNumber; one without a SegLocation numbers its segments
+    by their position in the JTSegVariantTable, starting at 1.
+ */
+struct lisa_segment {
+    char				name[9];
+    lisa_integer		number;			//!< SegNumber, or -1 if not in a segment table
+    lisa_integer		module;			//!< index of the module holding the code
+    lisa_MemAddr		addr;			//!< load address of the code
+    bool				packed;			//!< whether the code is packed
+    uint8_t				*code;			//!< code as stored in the file
+    lisa_longint		code_size;		//!< size of the code as stored in the file
+    lisa_longint		unpacked_size;	//!< size of the code once unpacked
+};
+typedef struct lisa_segment lisa_segment;
+
+
+/*!
+    A jump table descriptor of a Lisa executable, resolved to the code
+    it jumps to. Descriptors are resolved when the file is opened.
+ */
+struct lisa_jump_table_entry {
+    lisa_integer		slot;			//!< index of the descriptor in the JTVariantTable
+    lisa_MemAddr		address;		//!< AbsAddr of the descriptor
+    lisa_integer		segment;		//!< SegNumber of the segment jumped into, or -1
+    lisa_integer		module;			//!< index of the module holding its code, or -1
+    lisa_longint		offset;			//!< offset of the address into the segment's code
+    char				name[9];		//!< the EntryPoint there, or empty if there isn't one
+};
+typedef struct lisa_jump_table_entry lisa_jump_table_entry;
+
+
+/*!
+    A Pascal string within a Lisa executable/object file, as a view of
+    the file's buffer rather than a copy. Its characters aren't
+    NUL-terminated, and are only valid until the file is closed.
+ */
+struct lisa_pstring_view {
+    const char			* LISA_NULLABLE chars;
+    uint8_t				length;
+};
+typedef struct lisa_pstring_view lisa_pstring_view;
+
+
+/*! Options for dumping blocks. */
+enum lisa_obj_dump_flags: uint32_t {
+    lisa_obj_dump_flags_none	= 0,
+    lisa_obj_dump_flags_no_code	= 1 << 0,	//!< don't dump (or unpack) code bytes
+};
+typedef enum lisa_obj_dump_flags lisa_obj_dump_flags;
+
+
 /*! Open the given Lisa executable/object file for reading. */
 LISA_EXTERN
 lisa_objfile * LISA_NULLABLE
 lisa_objfile_open(const char *path);
 
+/*!
+    Open the given Lisa executable/object file, reading it into memory
+    from \a allocator, which is also used for every block and index
+    of the file, and for buffers needed to dump its blocks. Its content
+    isn't zeroed first, since it's read right over.
+
+    Nothing is allocated once the file is open besides dumping, so a
+    single-threaded allocator such as an arena will do as long as
+    blocks are only dumped on the thread that opened the file.
+ */
+LISA_EXTERN
+lisa_objfile * LISA_NULLABLE
+lisa_objfile_open_with_allocator(const char *path, const lisa_allocator * LISA_NULLABLE allocator);
+
+/*!
+    Open a Lisa executable/object file whose \a content_size bytes have
+    already been read into \a content, which must have been allocated
+    with `malloc`. The object file takes ownership of the content, and
+    frees it when closed, or right away if it can't be opened.
+ */
+LISA_EXTERN
+lisa_objfile * LISA_NULLABLE
+lisa_objfile_open_buffer(void *content, size_t content_size);
+
+/*!
+    Like `lisa_objfile_open_buffer`, except \a content must have been
+    allocated with \a allocator, which is also used for everything else
+    the object file needs.
+ */
+LISA_EXTERN
+lisa_objfile * LISA_NULLABLE
+lisa_objfile_open_buffer_with_allocator(void *content, size_t content_size,
+                                        const lisa_allocator * LISA_NULLABLE allocator);
+
+/*!
+    Open the given Lisa executable/object file by mapping it into memory
+    rather than reading it, so its code can be handed on without being
+    copied, for example to be spliced into a pipe.
+
+    Pages are only read as they're touched, and those holding code are
+    shared with the page cache. The file mustn't be truncated while it's
+    open.
+ */
+LISA_EXTERN
+lisa_objfile * LISA_NULLABLE
+lisa_objfile_open_mapped(const char *path);
+
+/*! Like `lisa_objfile_open_mapped`, allocating everything but the mapping with \a allocator. */
+LISA_EXTERN
+lisa_objfile * LISA_NULLABLE
+lisa_objfile_open_mapped_with_allocator(const char *path, const lisa_allocator * LISA_NULLABLE allocator);
+
 /*! Close the given Lisa executable/object file. */
 LISA_EXTERN
 void
 lisa_objfile_close(lisa_objfile * LISA_NULLABLE of);
 
+/*! Get the size of the object file, in bytes. */
+LISA_EXTERN
+size_t
+lisa_objfile_size(lisa_objfile *of);
+
 /*! Get the count of blocks in the object file. */
 LISA_EXTERN
 lisa_integer
@@ -372,25 +514,193 @@ LISA_EXTERN
 lisa_obj_block_type
 lisa_objfile_block_type(lisa_objfile_block *block);
 
+/*!
+    Get the index of the block containing \a offset, or -1 if there
+    isn't one. This is a binary search, not a walk of the file.
+ */
+LISA_EXTERN
+lisa_integer
+lisa_objfile_block_index_at_offset(lisa_objfile *of, lisa_FileAddr offset);
+
+/*! Get the object file's Executable block, or `NULL` if it isn't an executable. */
+LISA_EXTERN
+lisa_Executable * LISA_NULLABLE
+lisa_objfile_executable(lisa_objfile *of);
+
+/*! Get the count of modules in the object file. */
+LISA_EXTERN
+lisa_integer
+lisa_objfile_module_count(lisa_objfile *of);
+
+/*! Get the module at the given index. */
+LISA_EXTERN
+const lisa_objfile_module *
+lisa_objfile_module_at_index(lisa_objfile *of, lisa_integer idx);
+
+/*! Get the index of the module named \a name, or -1 if there isn't one. */
+LISA_EXTERN
+lisa_integer
+lisa_objfile_module_index_named(lisa_objfile *of, const char *name);
+
+/*! Get the count of segments in the object file. */
+LISA_EXTERN
+lisa_integer
+lisa_objfile_segment_count(lisa_objfile *of);
+
+/*! Get the segment at the given index, in segment table order. */
+LISA_EXTERN
+int
+lisa_objfile_segment_at_index(lisa_objfile *of, lisa_integer idx,
+                              lisa_segment *segment);
+
+/*!
+    Get the segment named \a name. Segments are indexed by name and
+    number when the file is opened, so this is a hash table lookup.
+ */
+LISA_EXTERN
+int
+lisa_objfile_segment_named(lisa_objfile *of, const char *name,
+                           lisa_segment *segment);
+
+/*! Get the segment with SegNumber \a number. */
+LISA_EXTERN
+int
+lisa_objfile_segment_numbered(lisa_objfile *of, lisa_integer number,
+                              lisa_segment *segment);
+
+/*!
+    Get the segment whose code is in the module containing \a offset,
+    as a JTSegVariant's SegmentAddr or a SegLocVariant's FileLocation
+    gives it.
+ */
+LISA_EXTERN
+int
+lisa_objfile_segment_at_offset(lisa_objfile *of, lisa_FileAddr offset,
+                               lisa_segment *segment);
+
+/*! Get the count of jump table descriptors in the object file. */
+LISA_EXTERN
+lisa_integer
+lisa_objfile_jump_table_count(lisa_objfile *of);
+
+/*!
+    Get the resolved jump table descriptor in \a slot, or `NULL` if
+    there isn't one. This is an array lookup.
+ */
+LISA_EXTERN
+const lisa_jump_table_entry * LISA_NULLABLE
+lisa_objfile_jump_table_entry_at_slot(lisa_objfile *of, lisa_integer slot);
+
+/*!
+    Get the resolved jump table descriptor whose AbsAddr is \a address,
+    the one in the lowest slot if there are several, or `NULL` if there
+    isn't one. This is a binary search.
+ */
+LISA_EXTERN
+const lisa_jump_table_entry * LISA_NULLABLE
+lisa_objfile_jump_table_entry_at_address(lisa_objfile *of, lisa_MemAddr address);
+
+/*!
+    Get one more than the highest FileNumber named by the StringBlock
+    of object file \a of, or 0 if it has none.
+ */
+LISA_EXTERN
+lisa_integer
+lisa_objfile_file_number_limit(lisa_objfile *of);
+
+/*!
+    Get the name the StringBlock gives \a file_number, as a view into
+    object file \a of. This is a table lookup, built when the file is
+    opened. Fails with ENOENT if the file number has no name.
+ */
+LISA_EXTERN
+int
+lisa_objfile_file_name(lisa_objfile *of, lisa_integer file_number, lisa_pstring_view *name);
+
+/*!
+    Get the unpacked code of \a segment. On input, \a unpacked_size
+    must be the size of the \a unpacked buffer, which must be at least
+    the segment's `unpacked_size`; on output, it is set to the true size
+    of the unpacked code.
+ */
+LISA_EXTERN
+int
+lisa_segment_unpack(const lisa_segment *segment,
+                    uint8_t *unpacked, lisa_longint *unpacked_size);
+
+/*!
+    Get the unpacked code of \a segment in a buffer allocated from
+    \a allocator, which the caller must free with it. The buffer isn't
+    zeroed, since it's unpacked right over.
+ */
+LISA_EXTERN
+int
+lisa_segment_unpack_allocated(const lisa_segment *segment, const lisa_allocator * LISA_NULLABLE allocator,
+                              uint8_t * LISA_NULLABLE * LISA_NONNULL unpacked, lisa_longint *unpacked_size);
+
 /*! Get the size of the block at the given index, including header. */
 LISA_EXTERN
 lisa_longint
 lisa_objfile_block_size(lisa_objfile_block *block);
 
+/*! Get the offset of the block's header within the file. */
+LISA_EXTERN
+lisa_FileAddr
+lisa_objfile_block_offset(lisa_objfile_block *block);
+
+/*!
+    Get the code of a CodeBlock or PackedCode block as stored in the
+    file, along with its unpacked size and load address. Returns false
+    for any other kind of block.
+ */
+LISA_EXTERN
+bool
+lisa_objfile_block_get_code(lisa_objfile_block *block,
+                            uint8_t * LISA_NULLABLE * LISA_NONNULL code,
+                            lisa_longint *code_size,
+                            lisa_longint *unpacked_size,
+                            lisa_MemAddr *addr);
+
 /*! Get the content of the block at the given index, without header. */
 LISA_EXTERN
 lisa_objfile_content
 lisa_objfile_block_content(lisa_objfile_block *block);
 
+/*!
+    Encode a block of type \a type into \a encoded as it appears in an
+    object file: the type byte, the 24-bit size including the 4-byte
+    header, then \a content, swapped from native to big-endian. The
+    content is given without its header, and isn't modified.
+
+    \a encoded must have room for \a content_size + 4 bytes.
+
+    Fails with EINVAL if the block is too big for its size field.
+ */
+LISA_EXTERN
+int
+lisa_obj_block_encode(lisa_obj_block_type type,
+                      const void *content, lisa_longint content_size,
+                      uint8_t *encoded);
+
 /*! A pointer to some data at the given offset within the file. */
 LISA_EXTERN
 void *
 lisa_objfile_data_at_offset(lisa_objfile *of,
                             lisa_FileAddr file_offset);
 
+/*!
+    Get a view of the Pascal string at \a offset within object file
+    \a of, without copying it. Fails with ERANGE if the string doesn't
+    lie entirely within the file.
+ */
+LISA_EXTERN
+int
+lisa_objfile_pstring_at_offset(lisa_objfile *of, lisa_FileAddr offset, lisa_pstring_view *view);
+
 /*!
     Gets the Pascal string at \a offset within object file \a of, into
-    \a cstr as a C string.
+    \a cstr as a C string. If the string doesn't lie entirely within
+    the file, \a cstr is left empty.
 
     - WARNING: `cstr` must be large enough to accommodate the string;
                the safest thing is to just use a 256-byte buffer.
@@ -406,17 +716,32 @@ LISA_EXTERN
 void
 lisa_obj_block_dump(lisa_objfile_block *block);
 
+/*! Dump the contents of a block to \a f, as controlled by \a flags. */
+LISA_EXTERN
+void
+lisa_obj_block_fdump(lisa_objfile_block *block, FILE *f, lisa_obj_dump_flags flags);
+
 /*! Get the default packing table for Lisa code. */
 LISA_EXTERN
 lisa_PackTable *
 lisa_default_packtable(void);
 
+/*!
+    Get the most that packing \a unpacked_size bytes of code can take,
+    which is when no word of it is in the table.
+ */
+LISA_EXTERN
+size_t
+lisa_packcode_max_size(size_t unpacked_size);
+
 /*!
     Packs a buffer of unpacked code using a table. Passing `NULL` for
     the table uses the default Lisa OS table.
 
     On input, \a packed_size must be the maximum size of the packed code
     buffer; on output, it is set to the true size of the packed code.
+    Fails with ERANGE if the packed code wouldn't fit, which it always
+    will in `lisa_packcode_max_size` bytes.
  */
 LISA_EXTERN
 int
@@ -424,6 +749,18 @@ lisa_packcode(uint8_t *packed, lisa_longint *packed_size,
               uint8_t *unpacked, lisa_longint unpacked_size,
               lisa_PackTable * LISA_NULLABLE table);
 
+/*!
+    Packs a buffer of unpacked code like `lisa_packcode`, into a buffer
+    allocated from \a allocator that's big enough for any code, which
+    the caller must free with it.
+ */
+LISA_EXTERN
+int
+lisa_packcode_allocated(uint8_t * LISA_NULLABLE * LISA_NONNULL packed, lisa_longint *packed_size,
+                        uint8_t *unpacked, lisa_longint unpacked_size,
+                        lisa_PackTable * LISA_NULLABLE table,
+                        const lisa_allocator * LISA_NULLABLE allocator);
+
 /*!
     Unpacks a buffer of packed code using a table. Passing `NULL` for
     the table uses the default Lisa OS table.
@@ -0,0 +1,647 @@
+//  lisa_rebuild.c
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#include "lisa_rebuild.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "thread_pool.h"
+
+
+LISA_SOURCE_BEGIN
+
+
+// MARK: - Internals
+
+/*! The repacking of a single replacement segment. */
+struct lisa_rebuild_task {
+    const lisa_rebuild_replacement	*replacement;
+    bool				changed;		//!< whether the code differs from what it replaces
+    void				* LISA_NULLABLE content;	//!< the new code block's content, native-endian
+    lisa_longint		content_size;
+    lisa_longint		stored_size;	//!< size of the code as stored, i.e. SizePacked
+    int					error;			//!< errno if repacking failed, or 0
+};
+typedef struct lisa_rebuild_task lisa_rebuild_task;
+
+
+/*! The size of a PackedCode block's content before its code. */
+#define LISA_REBUILD_PACKED_HEADER_SIZE	8
+
+/*! The size of a CodeBlock block's content before its code. */
+#define LISA_REBUILD_CODE_HEADER_SIZE	4
+
+
+/*!
+    Pack a replacement segment's code into the content of a new code
+    block, unless it's the same as the code it replaces. Packed code is
+    unpacked again to make sure it round-trips.
+ */
+void
+lisa_rebuild_segment_task(void * LISA_NULLABLE context, size_t worker)
+{
+    (void)worker;
+    lisa_rebuild_task *task = context;
+    const lisa_rebuild_replacement *replacement = task->replacement;
+    const lisa_segment *segment = &replacement->segment;
+    const size_t code_size = (size_t)replacement->code_size;
+
+    uint8_t *check = malloc(code_size ? code_size : 1);
+    if (check == NULL) goto error;
+
+    // Only repack code that actually changed.
+
+    if (replacement->code_size == segment->unpacked_size) {
+        lisa_longint check_size = segment->unpacked_size;
+        int unpack_err = lisa_segment_unpack(segment, check, &check_size);
+        if (unpack_err == -1) goto error;
+
+        if ((check_size == replacement->code_size) && (memcmp(check, replacement->code, code_size) == 0)) {
+            free(check);
+            return;
+        }
+    }
+
+    task->changed = true;
+
+    if (!segment->packed) {
+        uint8_t *content = malloc(LISA_REBUILD_CODE_HEADER_SIZE + code_size);
+        if (content == NULL) goto error;
+
+        lisa_CodeBlock *codeblock = (lisa_CodeBlock *)content;
+        codeblock->Addr = segment->addr;
+        memcpy(&content[LISA_REBUILD_CODE_HEADER_SIZE], replacement->code, code_size);
+
+        task->content = content;
+        task->content_size = (lisa_longint)(LISA_REBUILD_CODE_HEADER_SIZE + code_size);
+        task->stored_size = replacement->code_size;
+        free(check);
+        return;
+    }
+
+    lisa_longint packed_size = (lisa_longint)lisa_packcode_max_size(code_size);
+    uint8_t *content = malloc(LISA_REBUILD_PACKED_HEADER_SIZE + (size_t)packed_size);
+    if (content == NULL) goto error;
+    task->content = content;
+
+    lisa_PackedCode *packedcode = (lisa_PackedCode *)content;
+    packedcode->addr = segment->addr;
+    packedcode->csize = replacement->code_size;
+
+    uint8_t *packed = &content[LISA_REBUILD_PACKED_HEADER_SIZE];
+    int pack_err = lisa_packcode(packed, &packed_size, (uint8_t *)replacement->code, replacement->code_size, NULL);
+    if (pack_err != 0) {
+        errno = EINVAL;
+        goto error;
+    }
+
+    lisa_longint check_size = replacement->code_size;
+    int unpack_err = lisa_unpackcode(packed, packed_size, check, &check_size, NULL);
+    if ((unpack_err != 0) || (check_size != replacement->code_size)
+        || (memcmp(check, replacement->code, code_size) != 0))
+    {
+        errno = EIO;
+        goto error;
+    }
+
+    task->content_size = LISA_REBUILD_PACKED_HEADER_SIZE + packed_size;
+    task->stored_size = packed_size;
+    free(check);
+    return;
+
+error:
+    task->error = errno;
+    free(check);
+}
+
+
+/*! Repack every replacement, spread across the given number of threads. */
+int
+lisa_rebuild_repack(lisa_rebuild_task *tasks, size_t count, size_t thread_count)
+{
+    if (thread_count > count) thread_count = count;
+
+    if (thread_count <= 1) {
+        for (size_t t = 0; t < count; t++) {
+            lisa_rebuild_segment_task(&tasks[t], 0);
+        }
+    } else {
+        thread_pool *pool = thread_pool_create(thread_count);
+        if (pool == NULL) return -1;
+
+        for (size_t t = 0; t < count; t++) {
+            int submit_err = thread_pool_submit(pool, lisa_rebuild_segment_task, &tasks[t]);
+            if (submit_err == -1) tasks[t].error = ENOMEM;
+        }
+
+        thread_pool_wait(pool);
+        thread_pool_free(pool);
+    }
+
+    for (size_t t = 0; t < count; t++) {
+        if (tasks[t].error != 0) {
+            errno = tasks[t].error;
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+
+/*!
+    Whether a replacement that grows its segment would run into the next
+    segment or the jump table in memory. Segments aren't laid out again,
+    so a segment only has room up to whatever its JTSegVariant's MemLoc
+    is followed by.
+ */
+bool
+lisa_rebuild_overruns(lisa_objfile *of, lisa_Executable *executable,
+                      lisa_rebuild_task * LISA_NULLABLE * LISA_NONNULL module_tasks)
+{
+    lisa_JTSegVariantTable *jtsegs = lisa_Executable_JTSegVariantTable(executable);
+    for (lisa_integer i = 0; i < jtsegs->numSegs; i++) {
+        const lisa_JTSegVariant *variant = &jtsegs->variants[i];
+
+        lisa_segment segment;
+        if (lisa_objfile_segment_at_offset(of, variant->SegmentAddr, &segment) == -1) continue;
+
+        const lisa_rebuild_task *task = module_tasks[segment.module];
+        if ((task == NULL) || (task->replacement->code_size <= segment.unpacked_size)) continue;
+
+        const uint64_t start = (uint32_t)variant->MemLoc;
+        const uint64_t end = start + (uint64_t)task->replacement->code_size;
+
+        uint64_t limit = UINT64_MAX;
+        if ((executable->JTSize > 0) && ((uint32_t)executable->JTLaddr >= start)) {
+            limit = (uint32_t)executable->JTLaddr;
+        }
+        for (lisa_integer j = 0; j < jtsegs->numSegs; j++) {
+            const uint64_t next = (uint32_t)jtsegs->variants[j].MemLoc;
+            if ((j != i) && (next > start) && (next < limit)) limit = next;
+        }
+
+        if (end > limit) return true;
+    }
+
+    return false;
+}
+
+
+/*! Where the byte at \a offset in the original file ends up in the rebuilt one. */
+lisa_FileAddr
+lisa_rebuild_remap_offset(lisa_objfile *of, lisa_objfile_writer *writer, lisa_FileAddr offset)
+{
+    lisa_integer b = lisa_objfile_block_index_at_offset(of, offset);
+    if ((b == -1) || (b >= lisa_objfile_writer_block_count(writer))) return offset;
+
+    lisa_objfile_block *block = lisa_objfile_block_at_index(of, b);
+    return lisa_objfile_writer_block_offset(writer, b) + (offset - lisa_objfile_block_offset(block));
+}
+
+
+/*! The task that changed the segment at \a offset in the original file, if any. */
+const lisa_rebuild_task * LISA_NULLABLE
+lisa_rebuild_task_at_offset(lisa_objfile *of, lisa_rebuild_task * LISA_NULLABLE * LISA_NONNULL module_tasks,
+                            lisa_FileAddr offset)
+{
+    lisa_segment segment;
+    int segment_err = lisa_objfile_segment_at_offset(of, offset, &segment);
+    if (segment_err == -1) return NULL;
+
+    const lisa_rebuild_task *task = module_tasks[segment.module];
+    return (task && task->changed) ? task : NULL;
+}
+
+
+/*! Copy a block's content, for patching. */
+void * LISA_NULLABLE
+lisa_rebuild_copy_content(lisa_objfile_block *block)
+{
+    size_t content_size = (size_t)lisa_objfile_block_size(block) - 4;
+    void *copy = malloc(content_size ? content_size : 1);
+    if (copy == NULL) return NULL;
+
+    memcpy(copy, lisa_objfile_block_content(block).data, content_size);
+    return copy;
+}
+
+
+/*! Replace the block at index \a b with its patched copy, if patching changed anything. */
+int
+lisa_rebuild_replace_patched(lisa_objfile_writer *writer, lisa_objfile *of, lisa_integer b, void *copy)
+{
+    lisa_objfile_block *block = lisa_objfile_block_at_index(of, b);
+    lisa_longint content_size = lisa_objfile_block_size(block) - 4;
+
+    int result = 0;
+    if (memcmp(copy, lisa_objfile_block_content(block).data, (size_t)content_size) != 0) {
+        result = lisa_objfile_writer_replace_block(writer, b, lisa_objfile_block_type(block), copy, content_size);
+    }
+
+    free(copy);
+    return result;
+}
+
+
+/*!
+    Update the CSize of a changed segment's ModuleName or EndBlock, if it
+    held the segment's unpacked or stored size.
+ */
+int
+lisa_rebuild_patch_csize(lisa_objfile_writer *writer, lisa_objfile *of, lisa_integer b,
+                         const lisa_rebuild_task *task)
+{
+    lisa_objfile_block *block = lisa_objfile_block_at_index(of, b);
+    const lisa_obj_block_type type = lisa_objfile_block_type(block);
+    if ((type != ModuleName) && (type != EndBlock)) return 0;
+
+    void *copy = lisa_rebuild_copy_content(block);
+    if (copy == NULL) return -1;
+
+    lisa_longint csize = (type == ModuleName) ? ((lisa_ModuleName *)copy)->CSize : ((lisa_EndBlock *)copy)->CSize;
+    const lisa_segment *segment = &task->replacement->segment;
+
+    if (csize == segment->unpacked_size) {
+        csize = task->replacement->code_size;
+    } else if (csize == segment->code_size) {
+        csize = task->stored_size;
+    }
+
+    if (type == ModuleName) {
+        ((lisa_ModuleName *)copy)->CSize = csize;
+    } else {
+        ((lisa_EndBlock *)copy)->CSize = csize;
+    }
+
+    return lisa_rebuild_replace_patched(writer, of, b, copy);
+}
+
+
+/*! Update the sizes and locations of segments in the executable's JTSegVariantTable. */
+void
+lisa_rebuild_patch_executable(lisa_objfile_writer *writer, lisa_objfile *of,
+                              lisa_rebuild_task * LISA_NULLABLE * LISA_NONNULL module_tasks,
+                              lisa_Executable *executable)
+{
+    lisa_JTSegVariantTable *jtsegs = lisa_Executable_JTSegVariantTable(executable);
+    for (lisa_integer i = 0; i < jtsegs->numSegs; i++) {
+        lisa_JTSegVariant *variant = &jtsegs->variants[i];
+
+        const lisa_rebuild_task *task = lisa_rebuild_task_at_offset(of, module_tasks, variant->SegmentAddr);
+        if (task) {
+            variant->SizePacked = (lisa_integer)task->stored_size;
+            variant->SizeUnpacked = (lisa_integer)task->replacement->code_size;
+        }
+
+        variant->SegmentAddr = lisa_rebuild_remap_offset(of, writer, variant->SegmentAddr);
+    }
+}
+
+
+/*! Update the sizes and locations of segments in a SegLocation block. */
+void
+lisa_rebuild_patch_seglocation(lisa_objfile_writer *writer, lisa_objfile *of,
+                               lisa_rebuild_task * LISA_NULLABLE * LISA_NONNULL module_tasks,
+                               lisa_SegLocation *seglocation)
+{
+    for (lisa_integer i = 0; i < seglocation->nSegments; i++) {
+        lisa_SegLocVariant *variant = &seglocation->variants[i];
+        if (variant->FileNumber != 0) continue;	// held in another file, so left as is
+
+        const lisa_rebuild_task *task = lisa_rebuild_task_at_offset(of, module_tasks, variant->FileLocation);
+        if (task) {
+            variant->SizePacked = (lisa_integer)task->stored_size;
+            variant->SizeUnpacked = (lisa_integer)task->replacement->code_size;
+        }
+
+        variant->FileLocation = lisa_rebuild_remap_offset(of, writer, variant->FileLocation);
+    }
+}
+
+
+/*! Update the locations of the names in a StringBlock. */
+void
+lisa_rebuild_patch_stringblock(lisa_objfile_writer *writer, lisa_objfile *of, lisa_StringBlock *stringblock)
+{
+    for (lisa_integer i = 0; i < stringblock->nStrings; i++) {
+        lisa_StringVariant *variant = &stringblock->variants[i];
+        variant->NameAddr = lisa_rebuild_remap_offset(of, writer, variant->NameAddr);
+    }
+}
+
+
+/*!
+    Patch every block that refers to the location or size of a segment,
+    once the changed code blocks are in place so the new locations are
+    known. None of these blocks change size, so patching them doesn't
+    move anything further.
+ */
+int
+lisa_rebuild_patch_tables(lisa_objfile_writer *writer, lisa_objfile *of,
+                          lisa_rebuild_task * LISA_NULLABLE * LISA_NONNULL module_tasks)
+{
+    const lisa_integer block_count = lisa_objfile_writer_block_count(writer);
+    for (lisa_integer b = 0; b < block_count; b++) {
+        lisa_objfile_block *block = lisa_objfile_block_at_index(of, b);
+        const lisa_obj_block_type type = lisa_objfile_block_type(block);
+        if ((type != Executable) && (type != SegLocation) && (type != StringBlock)) continue;
+
+        void *copy = lisa_rebuild_copy_content(block);
+        if (copy == NULL) return -1;
+
+        switch (type) {
+            case Executable:
+                lisa_rebuild_patch_executable(writer, of, module_tasks, copy);
+                break;
+
+            case SegLocation:
+                lisa_rebuild_patch_seglocation(writer, of, module_tasks, copy);
+                break;
+
+            default:
+                lisa_rebuild_patch_stringblock(writer, of, copy);
+                break;
+        }
+
+        int replace_err = lisa_rebuild_replace_patched(writer, of, b, copy);
+        if (replace_err == -1) return -1;
+    }
+
+    return 0;
+}
+
+
+/*!
+    Whether a segment table entry gives the sizes of the segment at
+    \a location in the rebuilt file, if it's one that changed.
+ */
+bool
+lisa_rebuild_location_matches(lisa_objfile *rebuilt, lisa_rebuild_task * LISA_NULLABLE * LISA_NONNULL module_tasks,
+                              lisa_FileAddr location, lisa_integer size_packed, lisa_integer size_unpacked)
+{
+    lisa_segment segment;
+    if (lisa_objfile_segment_at_offset(rebuilt, location, &segment) == -1) return true;
+
+    const lisa_rebuild_task *task = module_tasks[segment.module];
+    if ((task == NULL) || !task->changed) return true;
+
+    // Sizes are 16-bit fields, but segments can be up to 64KB.
+
+    return ((lisa_longint)(uint16_t)size_packed == segment.code_size)
+           && ((lisa_longint)(uint16_t)size_unpacked == segment.unpacked_size);
+}
+
+
+/*!
+    Whether the SegLocation block and JTSegVariantTable of the rebuilt
+    file give the new sizes of every changed segment.
+ */
+bool
+lisa_rebuild_tables_match(lisa_objfile *rebuilt, lisa_rebuild_task * LISA_NULLABLE * LISA_NONNULL module_tasks)
+{
+    const lisa_integer block_count = lisa_objfile_block_count(rebuilt);
+    for (lisa_integer b = 0; b < block_count; b++) {
+        lisa_objfile_block *block = lisa_objfile_block_at_index(rebuilt, b);
+        lisa_objfile_content content = lisa_objfile_block_content(block);
+
+        if (lisa_objfile_block_type(block) == SegLocation) {
+            lisa_SegLocation *seglocation = content.SegLocation;
+            for (lisa_integer i = 0; i < seglocation->nSegments; i++) {
+                lisa_SegLocVariant *variant = &seglocation->variants[i];
+                if (variant->FileNumber != 0) continue;	// held in another file
+
+                if (!lisa_rebuild_location_matches(rebuilt, module_tasks, variant->FileLocation,
+                                                   variant->SizePacked, variant->SizeUnpacked))
+                {
+                    return false;
+                }
+            }
+        } else if (lisa_objfile_block_type(block) == Executable) {
+            lisa_JTSegVariantTable *jtsegs = lisa_Executable_JTSegVariantTable(content.Executable);
+            for (lisa_integer i = 0; i < jtsegs->numSegs; i++) {
+                lisa_JTSegVariant *variant = &jtsegs->variants[i];
+                if (!lisa_rebuild_location_matches(rebuilt, module_tasks, variant->SegmentAddr,
+                                                   variant->SizePacked, variant->SizeUnpacked))
+                {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+
+/*!
+    Open the rebuilt file and check every segment against what was
+    meant to be written: the replacements' code, unpacked again, and
+    the original code for everything else, and the segment tables'
+    sizes for the segments that changed.
+ */
+int
+lisa_rebuild_verify(lisa_objfile *of, const char *path,
+                    lisa_rebuild_task * LISA_NULLABLE * LISA_NONNULL module_tasks)
+{
+    int result = -1;
+    uint8_t *unpacked = NULL;
+    lisa_longint unpacked_capacity = 0;
+
+    lisa_objfile *rebuilt = lisa_objfile_open(path);
+    if (rebuilt == NULL) return -1;
+
+    const lisa_integer segment_count = lisa_objfile_segment_count(of);
+    if (lisa_objfile_segment_count(rebuilt) != segment_count) goto mismatch;
+    if (lisa_objfile_module_count(rebuilt) != lisa_objfile_module_count(of)) goto mismatch;
+
+    for (lisa_integer s = 0; s < segment_count; s++) {
+        lisa_segment original, segment;
+        if (lisa_objfile_segment_at_index(of, s, &original) == -1) goto done;
+        if (lisa_objfile_segment_at_index(rebuilt, s, &segment) == -1) goto mismatch;
+
+        if ((strcmp(original.name, segment.name) != 0) || (original.number != segment.number)
+            || (original.packed != segment.packed))
+        {
+            goto mismatch;
+        }
+
+        const lisa_rebuild_task *task = module_tasks[original.module];
+        if ((task == NULL) || !task->changed) {
+            if ((segment.code_size != original.code_size) || (segment.unpacked_size != original.unpacked_size)
+                || (memcmp(segment.code, original.code, (size_t)original.code_size) != 0))
+            {
+                goto mismatch;
+            }
+            continue;
+        }
+
+        const lisa_rebuild_replacement *replacement = task->replacement;
+        if (segment.unpacked_size != replacement->code_size) goto mismatch;
+
+        if ((unpacked == NULL) || (unpacked_capacity < segment.unpacked_size)) {
+            uint8_t *grown = realloc(unpacked, segment.unpacked_size ? (size_t)segment.unpacked_size : 1);
+            if (grown == NULL) goto done;
+            unpacked = grown;
+            unpacked_capacity = segment.unpacked_size;
+        }
+
+        lisa_longint unpacked_size = unpacked_capacity;
+        if (lisa_segment_unpack(&segment, unpacked, &unpacked_size) == -1) goto mismatch;
+        if ((unpacked_size != replacement->code_size)
+            || ((unpacked_size > 0) && (memcmp(unpacked, replacement->code, (size_t)unpacked_size) != 0)))
+        {
+            goto mismatch;
+        }
+    }
+
+    if (!lisa_rebuild_tables_match(rebuilt, module_tasks)) goto mismatch;
+
+    result = 0;
+    goto done;
+
+mismatch:
+    errno = EIO;
+
+done:
+    free(unpacked);
+    lisa_objfile_close(rebuilt);
+    return result;
+}
+
+
+// MARK: - Rebuilding
+
+int
+lisa_objfile_rebuild(lisa_objfile *of, const char *path,
+                     const char * LISA_NULLABLE original_path,
+                     const lisa_rebuild_replacement *replacements, size_t count,
+                     const lisa_rebuild_options *options,
+                     lisa_rebuild_stats * LISA_NULLABLE stats)
+{
+    int result = -1;
+    int rebuild_errno = 0;
+    bool written = false;
+    lisa_rebuild_task *tasks = NULL;
+    lisa_rebuild_task **module_tasks = NULL;
+    lisa_objfile_writer *writer = NULL;
+    lisa_rebuild_stats rebuild_stats = { 0 };
+
+    if (lisa_objfile_executable(of) == NULL) {
+        errno = EINVAL;
+        goto done;
+    }
+
+    const lisa_integer module_count = lisa_objfile_module_count(of);
+    tasks = calloc(sizeof(lisa_rebuild_task), count ? count : 1);
+    module_tasks = calloc(sizeof(lisa_rebuild_task *), module_count ? (size_t)module_count : 1);
+    if ((tasks == NULL) || (module_tasks == NULL)) goto done;
+
+    // Each segment can only be replaced once, and only by whole words.
+    // Segment sizes are only 16 bits wide in the segment tables.
+
+    for (size_t r = 0; r < count; r++) {
+        const lisa_rebuild_replacement *replacement = &replacements[r];
+        const lisa_integer module = replacement->segment.module;
+
+        if (replacement->code_size > UINT16_MAX) {
+            errno = EFBIG;
+            goto done;
+        }
+
+        if ((replacement->code_size < 0) || (replacement->code_size % 2)
+            || (module < 0) || (module >= module_count) || module_tasks[module]
+            || (lisa_objfile_module_at_index(of, module)->code_block == -1))
+        {
+            errno = EINVAL;
+            goto done;
+        }
+
+        tasks[r].replacement = replacement;
+        module_tasks[module] = &tasks[r];
+    }
+
+    if (lisa_rebuild_overruns(of, lisa_objfile_executable(of), module_tasks)) {
+        errno = EFBIG;
+        goto done;
+    }
+
+    size_t thread_count = options->thread_count ? options->thread_count : thread_pool_default_thread_count();
+    int repack_err = lisa_rebuild_repack(tasks, count, thread_count);
+    if (repack_err == -1) goto done;
+
+    for (size_t r = 0; r < count; r++) {
+        if (tasks[r].changed && (tasks[r].stored_size > UINT16_MAX)) {
+            errno = EFBIG;
+            goto done;
+        }
+    }
+
+    // Put the changed code in place first, so that everything after it
+    // has its final location by the time the tables are patched.
+
+    writer = lisa_objfile_writer_create(of);
+    if (writer == NULL) goto done;
+
+    for (size_t r = 0; r < count; r++) {
+        const lisa_rebuild_task *task = &tasks[r];
+        if (!task->changed) {
+            rebuild_stats.segments_unchanged += 1;
+            continue;
+        }
+
+        const lisa_objfile_module *module = lisa_objfile_module_at_index(of, task->replacement->segment.module);
+        lisa_objfile_block *code_block = lisa_objfile_block_at_index(of, module->code_block);
+
+        int replace_err = lisa_objfile_writer_replace_block(writer, module->code_block,
+                                                            lisa_objfile_block_type(code_block),
+                                                            task->content, task->content_size);
+        if (replace_err == -1) goto done;
+
+        int name_err = lisa_rebuild_patch_csize(writer, of, module->first_block, task);
+        if (name_err == -1) goto done;
+
+        int end_err = lisa_rebuild_patch_csize(writer, of, module->last_block, task);
+        if (end_err == -1) goto done;
+
+        rebuild_stats.segments_repacked += 1;
+    }
+
+    int patch_err = lisa_rebuild_patch_tables(writer, of, module_tasks);
+    if (patch_err == -1) goto done;
+
+    int write_err = lisa_objfile_writer_write(writer, path, original_path, &rebuild_stats.write);
+    if (write_err == -1) goto done;
+    written = true;
+
+    int verify_err = lisa_rebuild_verify(of, path, module_tasks);
+    if (verify_err == -1) goto done;
+
+    if (stats) *stats = rebuild_stats;
+    result = 0;
+
+done:
+    rebuild_errno = errno;
+
+    // Don't leave a bad file behind, unless it's all that's left of the original.
+    if ((result == -1) && written && !(original_path && (strcmp(path, original_path) == 0))) unlink(path);
+
+    lisa_objfile_writer_free(writer);
+    if (tasks) {
+        for (size_t r = 0; r < count; r++) free(tasks[r].content);
+    }
+    free(tasks);
+    free(module_tasks);
+
+    errno = rebuild_errno;
+    return result;
+}
+
+
+LISA_SOURCE_END
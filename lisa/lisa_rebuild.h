@@ -0,0 +1,82 @@
+//  lisa_rebuild.h
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#ifndef __LISA__REBUILD__H__
+#define __LISA__REBUILD__H__
+
+#include <stddef.h>
+
+#include "lisa_defines.h"
+#include "lisa_types.h"
+
+#include "lisa_objio.h"
+#include "lisa_writer.h"
+
+LISA_HEADER_BEGIN
+
+
+/*! New unpacked code for one of an executable's segments. */
+struct lisa_rebuild_replacement {
+    lisa_segment		segment;		//!< as looked up in the executable being rebuilt
+    const uint8_t		*code;			//!< the segment's new code, unpacked
+    lisa_longint		code_size;		//!< must be a whole number of words
+};
+typedef struct lisa_rebuild_replacement lisa_rebuild_replacement;
+
+
+/*! How to rebuild an executable. */
+struct lisa_rebuild_options {
+    size_t				thread_count;	//!< for repacking segments; 0 for one per CPU
+};
+typedef struct lisa_rebuild_options lisa_rebuild_options;
+
+
+/*! What rebuilding an executable did, for reporting. */
+struct lisa_rebuild_stats {
+    size_t				segments_repacked;	//!< replacements whose code differed
+    size_t				segments_unchanged;	//!< replacements identical to what they replaced
+    lisa_objfile_writer_stats	write;
+};
+typedef struct lisa_rebuild_stats lisa_rebuild_stats;
+
+
+/*!
+    Write a copy of the executable \a of to \a path with the code of
+    some of its segments replaced.
+
+    Replacements whose code is the same as the segment's existing code
+    are skipped. The rest are packed with `lisa_packcode` in parallel,
+    and each is unpacked again to make sure it comes back the same.
+    Their sizes, and the file locations of any segments that move, are
+    then updated in the SegLocation block and the executable's
+    JTSegVariantTable, and their modules' CSize fields are updated to
+    match. A segment whose new code, or the code as stored, would be
+    more than the 64KB those tables can give fails with EFBIG, as does
+    one that grows into the next segment or the jump table in memory,
+    since segments keep their MemLoc.
+
+    Every other block is carried over byte-for-byte: given the path of
+    the original file in \a original_path, untouched blocks are copied
+    straight from it (see `lisa_objfile_writer_write`).
+
+    Once written, the file is opened again and every segment is checked
+    against what was meant to be written; if any differs, it fails with
+    EIO and the file is removed (unless it replaced the original).
+
+    If \a stats is given, it's set to what was done.
+ */
+LISA_EXTERN
+int
+lisa_objfile_rebuild(lisa_objfile *of, const char *path,
+                     const char * LISA_NULLABLE original_path,
+                     const lisa_rebuild_replacement *replacements, size_t count,
+                     const lisa_rebuild_options *options,
+                     lisa_rebuild_stats * LISA_NULLABLE stats);
+
+
+LISA_HEADER_END
+
+#endif /* __LISA__REBUILD__H__ */
@@ -0,0 +1,439 @@
+//  lisa_relocate.c
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#include "lisa_relocate.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+LISA_SOURCE_BEGIN
+
+
+// MARK: - Internals
+
+/*! A single field of a module's code to patch. */
+struct lisa_relocation {
+    uint32_t			offset;			//!< into the module's code
+    uint32_t			addend;			//!< added to the field, modulo its width
+    uint32_t			width;			//!< 2 or 4 bytes
+};
+typedef struct lisa_relocation lisa_relocation;
+
+struct lisa_relocator {
+    const lisa_relocate_options	*options;
+
+    lisa_relocation		* LISA_NULLABLE relocations;	//!< reused from module to module
+    size_t				count;
+    size_t				capacity;
+
+    const lisa_EntryPoint	* LISA_NULLABLE * LISA_NULLABLE entries;	//!< the module's own entry points
+    size_t				entry_count;
+    size_t				entry_capacity;
+};
+
+
+/*! Add \a count references to the relocator's list, all with the same addend. */
+int
+lisa_relocator_add(lisa_relocator *relocator, const void *refs, size_t count, uint32_t width,
+                   lisa_SegAddr code_addr, uint32_t addend)
+{
+    if (relocator->count + count > relocator->capacity) {
+        size_t new_capacity = relocator->capacity ? relocator->capacity * 2 : 256;
+        while (new_capacity < relocator->count + count) new_capacity *= 2;
+        lisa_relocation *relocations = realloc(relocator->relocations, sizeof(lisa_relocation) * new_capacity);
+        if (relocations == NULL) return -1;
+        relocator->relocations = relocations;
+        relocator->capacity = new_capacity;
+    }
+
+    // References are addresses within the module; the code starts at
+    // code_addr within it. The blocks are packed, so copy each one out.
+
+    const uint8_t *ref_bytes = refs;
+    for (size_t r = 0; r < count; r++) {
+        int64_t ref;
+        if (width == 4) {
+            lisa_SegAddr long_ref;
+            memcpy(&long_ref, &ref_bytes[r * sizeof(long_ref)], sizeof(long_ref));
+            ref = long_ref;
+        } else {
+            lisa_integer short_ref;
+            memcpy(&short_ref, &ref_bytes[r * sizeof(short_ref)], sizeof(short_ref));
+            ref = (uint16_t)short_ref;
+        }
+
+        int64_t offset = ref - code_addr;
+        if ((offset < 0) || (offset > UINT32_MAX)) {
+            errno = EINVAL;
+            return -1;
+        }
+
+        relocator->relocations[relocator->count++] = (lisa_relocation){
+            .offset = (uint32_t)offset,
+            .addend = addend,
+            .width = width,
+        };
+    }
+
+    return 0;
+}
+
+
+/*! Gather the module's own entry points, for resolving its references to itself. */
+int
+lisa_relocator_gather_entries(lisa_relocator *relocator, lisa_objfile *of, const lisa_objfile_module *module)
+{
+    relocator->entry_count = 0;
+
+    for (lisa_integer b = module->first_block; b <= module->last_block; b++) {
+        lisa_objfile_block *block = lisa_objfile_block_at_index(of, b);
+        if (lisa_objfile_block_type(block) != EntryPoint) continue;
+
+        if (relocator->entry_count == relocator->entry_capacity) {
+            size_t new_capacity = relocator->entry_capacity ? relocator->entry_capacity * 2 : 16;
+            const lisa_EntryPoint **entries = realloc(relocator->entries, sizeof(lisa_EntryPoint *) * new_capacity);
+            if (entries == NULL) return -1;
+            relocator->entries = entries;
+            relocator->entry_capacity = new_capacity;
+        }
+
+        relocator->entries[relocator->entry_count++] = lisa_objfile_block_content(block).EntryPoint;
+    }
+
+    return 0;
+}
+
+
+/*! Resolve the symbol \a name, returning whether it was found. */
+bool
+lisa_relocator_resolve(lisa_relocator *relocator, const lisa_ObjName name, lisa_SegAddr code_addr,
+                       uint32_t *address)
+{
+    lisa_MemAddr symbol_address;
+    if (relocator->options->local_symbols
+        && lisa_symbol_table_lookup_ObjName(relocator->options->local_symbols, name, &symbol_address))
+    {
+        *address = (uint32_t)symbol_address;
+        return true;
+    }
+    if (relocator->options->symbols
+        && lisa_symbol_table_lookup_ObjName(relocator->options->symbols, name, &symbol_address))
+    {
+        *address = (uint32_t)symbol_address;
+        return true;
+    }
+
+    for (size_t e = 0; e < relocator->entry_count; e++) {
+        const lisa_EntryPoint *entry = relocator->entries[e];
+        if (memcmp(entry->LinkName, name, sizeof(lisa_ObjName)) == 0) {
+            *address = (uint32_t)relocator->options->base + (uint32_t)(entry->Loc - code_addr);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+int
+lisa_relocation_compare(const void *a, const void *b)
+{
+    const lisa_relocation *relocation_a = a;
+    const lisa_relocation *relocation_b = b;
+    if (relocation_a->offset != relocation_b->offset) {
+        return (relocation_a->offset < relocation_b->offset) ? -1 : 1;
+    }
+    return (int)relocation_a->width - (int)relocation_b->width;
+}
+
+
+/*!
+    Sort the relocator's list by offset and merge references to the
+    same field, so the code can be patched in a single pass. Fails if
+    any field is out of range or overlaps another.
+ */
+int
+lisa_relocator_sort(lisa_relocator *relocator, size_t code_size)
+{
+    if (relocator->count == 0) return 0;
+
+    qsort(relocator->relocations, relocator->count, sizeof(lisa_relocation), lisa_relocation_compare);
+
+    size_t merged = 0;
+    for (size_t r = 0; r < relocator->count; r++) {
+        lisa_relocation *relocation = &relocator->relocations[r];
+
+        if ((size_t)relocation->offset + relocation->width > code_size) {
+            errno = EINVAL;
+            return -1;
+        }
+
+        if (merged > 0) {
+            lisa_relocation *previous = &relocator->relocations[merged - 1];
+            if ((previous->offset == relocation->offset) && (previous->width == relocation->width)) {
+                previous->addend += relocation->addend;
+                continue;
+            }
+            if (previous->offset + previous->width > relocation->offset) {
+                errno = EINVAL;
+                return -1;
+            }
+        }
+
+        relocator->relocations[merged++] = *relocation;
+    }
+
+    relocator->count = merged;
+    return 0;
+}
+
+
+// MARK: - Relocation
+
+size_t
+lisa_relocate_reference_count(lisa_objfile_block *block)
+{
+    const size_t size = (size_t)lisa_objfile_block_size(block);
+    size_t header_size, ref_size;
+
+    switch (lisa_objfile_block_type(block)) {
+        case Relocation:		header_size = 4;	ref_size = sizeof(lisa_SegAddr);	break;
+        case CommonRelocation:	header_size = 12;	ref_size = sizeof(lisa_SegAddr);	break;
+        case External:			header_size = 20;	ref_size = sizeof(lisa_SegAddr);	break;
+        case ShortExternal:		header_size = 20;	ref_size = sizeof(lisa_integer);	break;
+        default:				return 0;
+    }
+
+    return (size > header_size) ? (size - header_size) / ref_size : 0;
+}
+
+
+lisa_relocator * LISA_NULLABLE
+lisa_relocator_create(const lisa_relocate_options *options)
+{
+    lisa_relocator *relocator = calloc(sizeof(lisa_relocator), 1);
+    if (relocator == NULL) return NULL;
+
+    relocator->options = options;
+    return relocator;
+}
+
+
+void
+lisa_relocator_free(lisa_relocator * LISA_NULLABLE relocator)
+{
+    if (relocator) {
+        free(relocator->relocations);
+        free(relocator->entries);
+        free(relocator);
+    }
+}
+
+
+int
+lisa_relocator_apply(lisa_relocator *relocator, lisa_objfile *of, lisa_integer module_index,
+                     uint8_t *code, size_t code_size,
+                     lisa_relocate_stats * LISA_NULLABLE stats)
+{
+    lisa_relocate_stats module_stats = { 0 };
+    const lisa_objfile_module *module = lisa_objfile_module_at_index(of, module_index);
+
+    if (module->code_block == -1) {
+        errno = ENOENT;
+        return -1;
+    }
+
+    uint8_t *stored_code;
+    lisa_longint stored_size, unpacked_size;
+    lisa_MemAddr code_addr;
+    lisa_objfile_block_get_code(lisa_objfile_block_at_index(of, module->code_block),
+                                &stored_code, &stored_size, &unpacked_size, &code_addr);
+
+    int gather_err = lisa_relocator_gather_entries(relocator, of, module);
+    if (gather_err == -1) return -1;
+
+    // First gather every reference in the module, resolving each block's
+    // symbol just once.
+
+    relocator->count = 0;
+
+    for (lisa_integer b = module->first_block; b <= module->last_block; b++) {
+        lisa_objfile_block *block = lisa_objfile_block_at_index(of, b);
+        lisa_objfile_content content = lisa_objfile_block_content(block);
+        size_t count = lisa_relocate_reference_count(block);
+        if (count == 0) continue;
+
+        const void *refs = NULL;
+        const char *name = NULL;
+        uint32_t width = 4;
+
+        switch (lisa_objfile_block_type(block)) {
+            case Relocation:
+                refs = content.Relocation->Ref;
+                break;
+
+            case CommonRelocation:
+                refs = content.CommonRelocation->Ref;
+                name = content.CommonRelocation->CommonName;
+                break;
+
+            case External:
+                refs = content.External->Ref;
+                name = content.External->LinkName;
+                break;
+
+            case ShortExternal:
+                refs = content.ShortExternal->ShortRef;
+                name = content.ShortExternal->LinkName;
+                width = 2;
+                break;
+
+            default:
+                continue;
+        }
+
+        uint32_t addend = (uint32_t)relocator->options->base - (uint32_t)code_addr;
+        if (name && !lisa_relocator_resolve(relocator, name, code_addr, &addend)) {
+            module_stats.unresolved += count;
+            continue;
+        }
+
+        int add_err = lisa_relocator_add(relocator, refs, count, width, code_addr, addend);
+        if (add_err == -1) return -1;
+    }
+
+    int sort_err = lisa_relocator_sort(relocator, code_size);
+    if (sort_err == -1) return -1;
+
+    // Then patch them all in order, in a single pass through the code.
+
+    for (size_t r = 0; r < relocator->count; r++) {
+        const lisa_relocation *relocation = &relocator->relocations[r];
+        uint8_t *field = &code[relocation->offset];
+
+        if (relocation->width == 4) {
+            uint32_t value = ((uint32_t)field[0] << 24) | ((uint32_t)field[1] << 16)
+                           | ((uint32_t)field[2] << 8) | (uint32_t)field[3];
+            value += relocation->addend;
+            field[0] = (uint8_t)(value >> 24);
+            field[1] = (uint8_t)(value >> 16);
+            field[2] = (uint8_t)(value >> 8);
+            field[3] = (uint8_t)value;
+        } else {
+            int16_t original = (int16_t)(((uint16_t)field[0] << 8) | (uint16_t)field[1]);
+            int64_t value = (int64_t)original + (int64_t)(int32_t)relocation->addend;
+            if ((value < INT16_MIN) || (value > UINT16_MAX)) module_stats.truncated += 1;
+            field[0] = (uint8_t)((uint64_t)value >> 8);
+            field[1] = (uint8_t)value;
+        }
+
+        module_stats.applied += 1;
+    }
+
+    if (stats) *stats = module_stats;
+    return 0;
+}
+
+
+bool
+lisa_objfile_module_has_references(lisa_objfile *of, lisa_integer module_index)
+{
+    const lisa_objfile_module *module = lisa_objfile_module_at_index(of, module_index);
+
+    for (lisa_integer b = module->first_block; b <= module->last_block; b++) {
+        if (lisa_relocate_reference_count(lisa_objfile_block_at_index(of, b)) > 0) return true;
+    }
+
+    return false;
+}
+
+
+int
+lisa_objfile_module_mask_references(lisa_objfile *of, lisa_integer module_index,
+                                    uint8_t *code, size_t code_size,
+                                    size_t * LISA_NULLABLE masked)
+{
+    const lisa_objfile_module *module = lisa_objfile_module_at_index(of, module_index);
+
+    if (module->code_block == -1) {
+        errno = ENOENT;
+        return -1;
+    }
+
+    uint8_t *stored_code;
+    lisa_longint stored_size, unpacked_size;
+    lisa_MemAddr code_addr;
+    lisa_objfile_block_get_code(lisa_objfile_block_at_index(of, module->code_block),
+                                &stored_code, &stored_size, &unpacked_size, &code_addr);
+
+    // Zeroing is the same however many references share a field, so
+    // unlike relocating there's no need to sort or merge them first.
+
+    size_t fields = 0;
+    for (lisa_integer b = module->first_block; b <= module->last_block; b++) {
+        lisa_objfile_block *block = lisa_objfile_block_at_index(of, b);
+        lisa_objfile_content content = lisa_objfile_block_content(block);
+        size_t count = lisa_relocate_reference_count(block);
+        if (count == 0) continue;
+
+        const uint8_t *refs = NULL;
+        size_t width = 4;
+
+        switch (lisa_objfile_block_type(block)) {
+            case Relocation:		refs = (const uint8_t *)content.Relocation->Ref;					break;
+            case CommonRelocation:	refs = (const uint8_t *)content.CommonRelocation->Ref;				break;
+            case External:			refs = (const uint8_t *)content.External->Ref;						break;
+            case ShortExternal:		refs = (const uint8_t *)content.ShortExternal->ShortRef;	width = 2;	break;
+            default:				continue;
+        }
+
+        for (size_t r = 0; r < count; r++) {
+            int64_t ref;
+            if (width == 4) {
+                lisa_SegAddr long_ref;
+                memcpy(&long_ref, &refs[r * sizeof(long_ref)], sizeof(long_ref));
+                ref = long_ref;
+            } else {
+                lisa_integer short_ref;
+                memcpy(&short_ref, &refs[r * sizeof(short_ref)], sizeof(short_ref));
+                ref = (uint16_t)short_ref;
+            }
+
+            int64_t offset = ref - code_addr;
+            if ((offset < 0) || ((uint64_t)offset + width > code_size)) continue;
+
+            memset(&code[offset], 0, width);
+            fields += 1;
+        }
+    }
+
+    if (masked) *masked = fields;
+    return 0;
+}
+
+
+int
+lisa_objfile_module_relocate(lisa_objfile *of, lisa_integer module,
+                             uint8_t *code, size_t code_size,
+                             const lisa_relocate_options *options,
+                             lisa_relocate_stats * LISA_NULLABLE stats)
+{
+    lisa_relocator *relocator = lisa_relocator_create(options);
+    if (relocator == NULL) return -1;
+
+    int result = lisa_relocator_apply(relocator, of, module, code, code_size, stats);
+
+    int relocate_errno = errno;
+    lisa_relocator_free(relocator);
+    errno = relocate_errno;
+
+    return result;
+}
+
+
+LISA_SOURCE_END
@@ -0,0 +1,129 @@
+//  lisa_relocate.h
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#ifndef __LISA__RELOCATE__H__
+#define __LISA__RELOCATE__H__
+
+#include <stddef.h>
+
+#include "lisa_defines.h"
+#include "lisa_types.h"
+
+#include "lisa_objio.h"
+#include "lisa_symbols.h"
+
+LISA_HEADER_BEGIN
+
+
+/*! How to relocate a module's code. */
+struct lisa_relocate_options {
+    lisa_MemAddr		base;			//!< address the module's code is loaded at
+    const lisa_symbol_table	* LISA_NULLABLE symbols;	//!< addresses of external symbols
+    const lisa_symbol_table	* LISA_NULLABLE local_symbols;	//!< looked up before `symbols`
+};
+typedef struct lisa_relocate_options lisa_relocate_options;
+
+
+/*! What relocating a module did, for reporting. */
+struct lisa_relocate_stats {
+    size_t				applied;		//!< fields patched
+    size_t				unresolved;		//!< references to unknown symbols, left as they were
+    size_t				truncated;		//!< 16-bit fields whose new value didn't fit
+};
+typedef struct lisa_relocate_stats lisa_relocate_stats;
+
+
+/*!
+    Relocates the code of modules, reusing its working storage from one
+    module to the next. (Opaque!)
+
+    Each module's references are gathered from its Relocation,
+    CommonRelocation, External and ShortExternal blocks into a single
+    list, which is sorted by offset and merged, and then the code is
+    patched in one pass from start to end:
+
+    - Each Relocation field, a 32-bit address within the module, has the
+      base address added to it.
+    - Each External and CommonRelocation field, a 32-bit offset from the
+      symbol it names, has the symbol's address added to it.
+    - Each ShortExternal field is the same, but 16 bits.
+
+    Symbols are looked up in the options' local and then main symbol
+    tables first, and then among the module's own entry points, relative
+    to the base address. References to any other symbols are left as
+    they are.
+
+    A relocator isn't thread-safe, but any number of them can be used at
+    once with the same options. The options are read afresh for each
+    module, so they can be changed between modules, e.g. to relocate
+    each one to a different base address.
+ */
+struct lisa_relocator;
+typedef struct lisa_relocator lisa_relocator;
+
+
+/*! Create a relocator with the given options, which must outlive it. */
+LISA_EXTERN
+lisa_relocator * LISA_NULLABLE
+lisa_relocator_create(const lisa_relocate_options *options);
+
+/*! Free the given relocator. */
+LISA_EXTERN
+void
+lisa_relocator_free(lisa_relocator * LISA_NULLABLE relocator);
+
+/*!
+    Relocates the \a code_size bytes of \a module of \a of, already
+    unpacked into \a code, in place.
+
+    Returns -1 with errno set to EINVAL if a reference lies outside the
+    code or overlaps another, leaving the code untouched.
+ */
+LISA_EXTERN
+int
+lisa_relocator_apply(lisa_relocator *relocator, lisa_objfile *of, lisa_integer module,
+                     uint8_t *code, size_t code_size,
+                     lisa_relocate_stats * LISA_NULLABLE stats);
+
+/*!
+    Get the number of references in a Relocation, CommonRelocation,
+    External or ShortExternal block, or 0 for any other block.
+ */
+LISA_EXTERN
+size_t
+lisa_relocate_reference_count(lisa_objfile_block *block);
+
+/*! Whether \a module of \a of has any references to relocate. */
+LISA_EXTERN
+bool
+lisa_objfile_module_has_references(lisa_objfile *of, lisa_integer module);
+
+/*!
+    Zero every field of the \a code_size bytes of \a module of \a of,
+    already unpacked into \a code, that a Relocation, CommonRelocation,
+    External or ShortExternal block refers to, so code that differs only
+    in where it was relocated to compares the same. References outside
+    the code are ignored. If \a masked is given, it's set to the number
+    of fields zeroed.
+ */
+LISA_EXTERN
+int
+lisa_objfile_module_mask_references(lisa_objfile *of, lisa_integer module,
+                                    uint8_t *code, size_t code_size,
+                                    size_t * LISA_NULLABLE masked);
+
+/*! Relocates a single module; see `lisa_relocator_apply`. */
+LISA_EXTERN
+int
+lisa_objfile_module_relocate(lisa_objfile *of, lisa_integer module,
+                             uint8_t *code, size_t code_size,
+                             const lisa_relocate_options *options,
+                             lisa_relocate_stats * LISA_NULLABLE stats);
+
+
+LISA_HEADER_END
+
+#endif /* __LISA__RELOCATE__H__ */
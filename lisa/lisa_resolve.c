@@ -0,0 +1,351 @@
+//  lisa_resolve.c
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#include "lisa_resolve.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lisa_relocate.h"
+
+
+LISA_SOURCE_BEGIN
+
+
+// MARK: - Internals
+
+/*! A reference or definition, as gathered from an object file. */
+struct lisa_resolve_item {
+    uint64_t			key;			//!< blank-padded name
+    uint32_t			symbol;			//!< interned name, once merged
+    bool				definition;
+    lisa_resolve_location	location;
+    lisa_SegAddr		address;		//!< for definitions
+    size_t				ref_count;		//!< for references
+};
+typedef struct lisa_resolve_item lisa_resolve_item;
+
+/*! A growable list of items. */
+struct lisa_resolve_items {
+    lisa_resolve_item	* LISA_NULLABLE items;
+    size_t				count;
+    size_t				capacity;
+};
+typedef struct lisa_resolve_items lisa_resolve_items;
+
+struct lisa_resolver {
+    pthread_mutex_t		lock;
+
+    uint64_t			* LISA_NULLABLE names;	//!< interned names, by symbol
+    size_t				name_count;
+    size_t				name_capacity;
+    uint32_t			* LISA_NULLABLE table;	//!< open-addressed hash of names to symbol + 1, 0 if empty
+    size_t				table_capacity;			//!< always a power of 2
+
+    lisa_resolve_items	items;
+};
+
+
+/*! Make sure \a list has room for \a count more items. */
+int
+lisa_resolve_items_reserve(lisa_resolve_items *list, size_t count)
+{
+    if (list->count + count <= list->capacity) return 0;
+
+    size_t new_capacity = list->capacity ? list->capacity * 2 : 64;
+    while (new_capacity < list->count + count) new_capacity *= 2;
+    lisa_resolve_item *items = realloc(list->items, sizeof(lisa_resolve_item) * new_capacity);
+    if (items == NULL) return -1;
+    list->items = items;
+    list->capacity = new_capacity;
+    return 0;
+}
+
+
+/*! Hash a name into a table of the given (power of 2) capacity. */
+size_t
+lisa_resolve_slot(uint64_t key, size_t capacity)
+{
+    return (size_t)((key * UINT64_C(0x9E3779B97F4A7C15)) >> 32) & (capacity - 1);
+}
+
+
+/*! Double the capacity of the resolver's name table, rehashing every name. */
+int
+lisa_resolver_grow_table(lisa_resolver *resolver)
+{
+    size_t new_capacity = resolver->table_capacity ? resolver->table_capacity * 2 : 1024;
+    uint32_t *table = calloc(sizeof(uint32_t), new_capacity);
+    if (table == NULL) return -1;
+
+    for (size_t n = 0; n < resolver->name_count; n++) {
+        size_t slot = lisa_resolve_slot(resolver->names[n], new_capacity);
+        while (table[slot] != 0) slot = (slot + 1) & (new_capacity - 1);
+        table[slot] = (uint32_t)n + 1;
+    }
+
+    free(resolver->table);
+    resolver->table = table;
+    resolver->table_capacity = new_capacity;
+    return 0;
+}
+
+
+/*! Intern \a key, getting back its symbol. The resolver must be locked. */
+int
+lisa_resolver_intern(lisa_resolver *resolver, uint64_t key, uint32_t *symbol)
+{
+    // Keep the table at most half full, so probes stay short.
+
+    if ((resolver->name_count + 1) * 2 > resolver->table_capacity) {
+        int grow_err = lisa_resolver_grow_table(resolver);
+        if (grow_err == -1) return -1;
+    }
+
+    size_t slot = lisa_resolve_slot(key, resolver->table_capacity);
+    while (resolver->table[slot] != 0) {
+        uint32_t existing = resolver->table[slot] - 1;
+        if (resolver->names[existing] == key) {
+            *symbol = existing;
+            return 0;
+        }
+        slot = (slot + 1) & (resolver->table_capacity - 1);
+    }
+
+    if (resolver->name_count == resolver->name_capacity) {
+        size_t new_capacity = resolver->name_capacity ? resolver->name_capacity * 2 : 512;
+        uint64_t *names = realloc(resolver->names, sizeof(uint64_t) * new_capacity);
+        if (names == NULL) return -1;
+        resolver->names = names;
+        resolver->name_capacity = new_capacity;
+    }
+
+    *symbol = (uint32_t)resolver->name_count;
+    resolver->names[resolver->name_count++] = key;
+    resolver->table[slot] = *symbol + 1;
+    return 0;
+}
+
+
+/*! Gather the references and definitions of every module of \a of into \a list. */
+int
+lisa_resolve_gather(lisa_objfile *of, const char *path, lisa_resolve_items *list)
+{
+    const lisa_integer module_count = lisa_objfile_module_count(of);
+    for (lisa_integer m = 0; m < module_count; m++) {
+        const lisa_objfile_module *module = lisa_objfile_module_at_index(of, m);
+        lisa_objfile_block *name_block = lisa_objfile_block_at_index(of, module->first_block);
+
+        lisa_resolve_location location = { .path = path };
+        lisa_ObjName_get_cstring(location.module, lisa_objfile_block_content(name_block).ModuleName->ModuleName);
+
+        for (lisa_integer b = module->first_block; b <= module->last_block; b++) {
+            lisa_objfile_block *block = lisa_objfile_block_at_index(of, b);
+            lisa_objfile_content content = lisa_objfile_block_content(block);
+
+            lisa_resolve_item item = { 0 };
+            const char *name;
+
+            switch (lisa_objfile_block_type(block)) {
+                case EntryPoint:
+                    name = content.EntryPoint->LinkName;
+                    item.definition = true;
+                    item.address = content.EntryPoint->Loc;
+                    break;
+
+                case External:
+                    name = content.External->LinkName;
+                    item.ref_count = lisa_relocate_reference_count(block);
+                    break;
+
+                case ShortExternal:
+                    name = content.ShortExternal->LinkName;
+                    item.ref_count = lisa_relocate_reference_count(block);
+                    break;
+
+                default:
+                    continue;
+            }
+
+            memcpy(&item.key, name, sizeof(lisa_ObjName));
+            item.location = location;
+            item.location.offset = lisa_objfile_block_offset(block);
+
+            if (lisa_resolve_items_reserve(list, 1) == -1) return -1;
+            list->items[list->count++] = item;
+        }
+    }
+
+    return 0;
+}
+
+
+int
+lisa_resolve_location_compare(const lisa_resolve_location *a, const lisa_resolve_location *b)
+{
+    if (a->path != b->path) {
+        int path_comparison = strcmp(a->path, b->path);
+        if (path_comparison != 0) return path_comparison;
+    }
+    if (a->offset != b->offset) return (a->offset < b->offset) ? -1 : 1;
+    return 0;
+}
+
+
+/*! Order items by symbol, with definitions first, then by location. */
+int
+lisa_resolve_item_compare(const void *a, const void *b)
+{
+    const lisa_resolve_item *item_a = a;
+    const lisa_resolve_item *item_b = b;
+    if (item_a->symbol != item_b->symbol) return (item_a->symbol < item_b->symbol) ? -1 : 1;
+    if (item_a->definition != item_b->definition) return item_a->definition ? -1 : 1;
+    return lisa_resolve_location_compare(&item_a->location, &item_b->location);
+}
+
+
+int
+lisa_resolve_result_compare(const void *a, const void *b)
+{
+    const lisa_resolve_result *result_a = a;
+    const lisa_resolve_result *result_b = b;
+    int location_comparison = lisa_resolve_location_compare(&result_a->location, &result_b->location);
+    if (location_comparison != 0) return location_comparison;
+    return (int)result_a->kind - (int)result_b->kind;
+}
+
+
+// MARK: - Resolution
+
+lisa_resolver * LISA_NULLABLE
+lisa_resolver_create(void)
+{
+    lisa_resolver *resolver = calloc(sizeof(lisa_resolver), 1);
+    if (resolver == NULL) return NULL;
+
+    pthread_mutex_init(&resolver->lock, NULL);
+    return resolver;
+}
+
+
+void
+lisa_resolver_free(lisa_resolver * LISA_NULLABLE resolver)
+{
+    if (resolver) {
+        free(resolver->names);
+        free(resolver->table);
+        free(resolver->items.items);
+        pthread_mutex_destroy(&resolver->lock);
+        free(resolver);
+    }
+}
+
+
+int
+lisa_resolver_add(lisa_resolver *resolver, lisa_objfile *of, const char *path)
+{
+    int result = -1;
+    lisa_resolve_items list = { 0 };
+
+    // Walk the file without the lock, so files can be gathered in
+    // parallel, then merge everything into the resolver at once.
+
+    int gather_err = lisa_resolve_gather(of, path, &list);
+    if (gather_err == -1) goto done;
+    if (list.count == 0) {
+        result = 0;
+        goto done;
+    }
+
+    pthread_mutex_lock(&resolver->lock);
+
+    if (lisa_resolve_items_reserve(&resolver->items, list.count) == -1) goto unlock;
+
+    for (size_t i = 0; i < list.count; i++) {
+        lisa_resolve_item *item = &list.items[i];
+        int intern_err = lisa_resolver_intern(resolver, item->key, &item->symbol);
+        if (intern_err == -1) goto unlock;
+    }
+
+    memcpy(&resolver->items.items[resolver->items.count], list.items, sizeof(lisa_resolve_item) * list.count);
+    resolver->items.count += list.count;
+    result = 0;
+
+unlock:
+    pthread_mutex_unlock(&resolver->lock);
+
+done:
+    free(list.items);
+    return result;
+}
+
+
+int
+lisa_resolver_report(lisa_resolver *resolver, lisa_resolve_fn fn, void * LISA_NULLABLE context,
+                     lisa_resolve_stats * LISA_NULLABLE stats)
+{
+    lisa_resolve_stats report_stats = { .symbols = resolver->name_count };
+    lisa_resolve_items *list = &resolver->items;
+
+    if (list->count == 0) {
+        if (stats) *stats = report_stats;
+        return 0;
+    }
+
+    lisa_resolve_result *results = calloc(sizeof(lisa_resolve_result), list->count);
+    if (results == NULL) return -1;
+
+    // With each symbol's definitions first and in order, the first of
+    // them is the one its references resolve to.
+
+    qsort(list->items, list->count, sizeof(lisa_resolve_item), lisa_resolve_item_compare);
+
+    size_t result_count = 0;
+    const lisa_resolve_item *first_definition = NULL;
+
+    for (size_t i = 0; i < list->count; i++) {
+        const lisa_resolve_item *item = &list->items[i];
+        if ((i == 0) || (item->symbol != list->items[i - 1].symbol)) {
+            first_definition = item->definition ? item : NULL;
+            if (first_definition) continue;
+        }
+
+        lisa_resolve_result *result = &results[result_count++];
+        lisa_ObjName_get_cstring(result->name, (const char *)&resolver->names[item->symbol]);
+        result->location = item->location;
+        result->ref_count = item->ref_count;
+
+        if (first_definition) {
+            result->kind = item->definition ? lisa_resolve_duplicate : lisa_resolve_resolved;
+            result->definition = first_definition->location;
+            result->address = first_definition->address;
+        } else {
+            result->kind = lisa_resolve_unresolved;
+        }
+
+        switch (result->kind) {
+            case lisa_resolve_resolved:		report_stats.resolved += 1;		break;
+            case lisa_resolve_unresolved:	report_stats.unresolved += 1;	break;
+            case lisa_resolve_duplicate:	report_stats.duplicates += 1;	break;
+        }
+    }
+
+    qsort(results, result_count, sizeof(lisa_resolve_result), lisa_resolve_result_compare);
+
+    for (size_t r = 0; r < result_count; r++) {
+        fn(&results[r], context);
+    }
+
+    free(results);
+
+    if (stats) *stats = report_stats;
+    return 0;
+}
+
+
+LISA_SOURCE_END
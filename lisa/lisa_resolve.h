@@ -0,0 +1,116 @@
+//  lisa_resolve.h
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#ifndef __LISA__RESOLVE__H__
+#define __LISA__RESOLVE__H__
+
+#include <stddef.h>
+
+#include "lisa_defines.h"
+#include "lisa_types.h"
+
+#include "lisa_objio.h"
+
+LISA_HEADER_BEGIN
+
+
+/*!
+    Resolves the external references of a set of object files against
+    the entry points they define, as the linker would. (Opaque!)
+
+    Every External and ShortExternal block is a reference, and every
+    EntryPoint block a definition, of the symbol it names. Names are
+    interned as they're added, so each distinct name is hashed into the
+    resolver's symbol table just once, however many files use it.
+
+    Files can be added from any number of threads at once: each file's
+    symbols are gathered without holding any lock, then merged into the
+    symbol table in one go.
+ */
+struct lisa_resolver;
+typedef struct lisa_resolver lisa_resolver;
+
+
+/*! Where a symbol is referenced or defined. */
+struct lisa_resolve_location {
+    const char			*path;			//!< of the object file
+    char				module[9];		//!< name of the module, or empty if outside any
+    lisa_FileAddr		offset;			//!< of the External, ShortExternal or EntryPoint block
+};
+typedef struct lisa_resolve_location lisa_resolve_location;
+
+
+/*! What became of a reference, or of a definition. */
+enum lisa_resolve_kind: uint32_t {
+    lisa_resolve_resolved		= 0,	//!< a reference to a defined symbol
+    lisa_resolve_unresolved		= 1,	//!< a reference to a symbol defined nowhere
+    lisa_resolve_duplicate		= 2,	//!< a definition of a symbol already defined
+};
+typedef enum lisa_resolve_kind lisa_resolve_kind;
+
+
+/*! A single resolved or unresolved reference, or duplicate definition. */
+struct lisa_resolve_result {
+    lisa_resolve_kind	kind;
+    char				name[9];		//!< link name of the symbol
+    lisa_resolve_location	location;	//!< of the reference, or the duplicate definition
+    lisa_resolve_location	definition;	//!< of the first definition, unless unresolved
+    lisa_SegAddr		address;		//!< Loc of the first definition, unless unresolved
+    size_t				ref_count;		//!< references made by the block, for references
+};
+typedef struct lisa_resolve_result lisa_resolve_result;
+
+
+/*! What resolution found, for reporting. */
+struct lisa_resolve_stats {
+    size_t				symbols;		//!< distinct names seen
+    size_t				resolved;		//!< reference blocks resolved
+    size_t				unresolved;		//!< reference blocks left unresolved
+    size_t				duplicates;		//!< definitions of already-defined symbols
+};
+typedef struct lisa_resolve_stats lisa_resolve_stats;
+
+
+/*! Called by `lisa_resolver_report` for each result, in order. */
+typedef void (*lisa_resolve_fn)(const lisa_resolve_result *result, void * LISA_NULLABLE context);
+
+
+/*! Create an empty resolver. */
+LISA_EXTERN
+lisa_resolver * LISA_NULLABLE
+lisa_resolver_create(void);
+
+/*! Free the given resolver. */
+LISA_EXTERN
+void
+lisa_resolver_free(lisa_resolver * LISA_NULLABLE resolver);
+
+/*!
+    Add the references and definitions of \a of, which was opened from
+    \a path. The path must outlive the resolver, but the object file
+    needn't.
+
+    This may be called from multiple threads at once.
+ */
+LISA_EXTERN
+int
+lisa_resolver_add(lisa_resolver *resolver, lisa_objfile *of, const char *path);
+
+/*!
+    Resolve every reference added so far, calling \a fn for each
+    reference and each duplicate definition, sorted by path and then by
+    offset. References to symbols defined more than once resolve to the
+    first definition in that same order.
+ */
+LISA_EXTERN
+int
+lisa_resolver_report(lisa_resolver *resolver, lisa_resolve_fn fn, void * LISA_NULLABLE context,
+                     lisa_resolve_stats * LISA_NULLABLE stats);
+
+
+LISA_HEADER_END
+
+#endif /* __LISA__RESOLVE__H__ */
@@ -0,0 +1,779 @@
+//  lisa_similar.c
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#include "lisa_similar.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "endian_utils.h"
+#include "file_utils.h"
+#include "hash_utils.h"
+#include "lisa_relocate.h"
+
+
+LISA_SOURCE_BEGIN
+
+
+// MARK: - Internals
+
+/*! Mixed into every shingle before it's hashed. */
+#define LISA_SIMILAR_SEED		0x9E3779B97F4A7C15ULL
+
+/*! How far apart the values borrowed by successive empty bins are pushed. */
+#define LISA_SIMILAR_DENSIFY_STEP	0xC2B2AE3D27D4EB4FULL
+
+/*! The number of records, sketches or bands read or written at a time. */
+#define LISA_SIMILAR_IO_CHUNK	4096
+
+
+/*! A segment in an index. */
+struct lisa_similar_entry {
+    uint32_t			path;			//!< offset of its file's path in the name table
+    char				name[9];
+    lisa_longint		size;
+};
+typedef struct lisa_similar_entry lisa_similar_entry;
+
+/*! A band of a segment's sketch, by its hash. */
+struct lisa_similar_band {
+    uint64_t			hash;
+    uint32_t			segment;
+};
+typedef struct lisa_similar_band lisa_similar_band;
+
+struct lisa_similar_index {
+    pthread_mutex_t		lock;
+
+    lisa_similar_entry	* LISA_NULLABLE entries;
+    lisa_similar_sketch	* LISA_NULLABLE sketches;	//!< one per entry
+    size_t				count;
+    size_t				capacity;
+
+    lisa_similar_band	* LISA_NULLABLE bands;	//!< `LISA_SIMILAR_BANDS` per entry
+    bool				sorted;			//!< whether the bands are sorted by hash
+
+    char				* LISA_NULLABLE names;	//!< paths, each followed by a NUL
+    size_t				names_size;
+    size_t				names_capacity;
+};
+
+
+/*! Scramble the bits of \a value (the MurmurHash3 finalizer). */
+uint64_t
+lisa_similar_mix(uint64_t value)
+{
+    value ^= value >> 33;
+    value *= 0xFF51AFD7ED558CCDULL;
+    value ^= value >> 33;
+    value *= 0xC4CEB9FE1A85EC53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+
+/*!
+    Hash band \a band of \a sketch. The hashes are taken big-endian, so
+    an index written on one machine can be queried on any other.
+ */
+uint64_t
+lisa_similar_band_hash(const lisa_similar_sketch *sketch, size_t band)
+{
+    uint32_t rows[LISA_SIMILAR_ROWS];
+    for (size_t r = 0; r < LISA_SIMILAR_ROWS; r++) {
+        rows[r] = swapu32be(sketch->hashes[band * LISA_SIMILAR_ROWS + r]);
+    }
+    return hash_xxh64(rows, sizeof(rows), band);
+}
+
+
+int
+lisa_similar_band_compare(const void *a, const void *b)
+{
+    const lisa_similar_band *band_a = a;
+    const lisa_similar_band *band_b = b;
+    if (band_a->hash != band_b->hash) return (band_a->hash < band_b->hash) ? -1 : 1;
+    if (band_a->segment != band_b->segment) return (band_a->segment < band_b->segment) ? -1 : 1;
+    return 0;
+}
+
+
+/*! Make sure the index has room for \a count more segments. */
+int
+lisa_similar_index_reserve(lisa_similar_index *index, size_t count)
+{
+    if (index->count + count <= index->capacity) return 0;
+
+    size_t new_capacity = index->capacity ? index->capacity * 2 : 256;
+    while (new_capacity < index->count + count) new_capacity *= 2;
+
+    lisa_similar_entry *entries = realloc(index->entries, sizeof(lisa_similar_entry) * new_capacity);
+    if (entries == NULL) return -1;
+    index->entries = entries;
+
+    lisa_similar_sketch *sketches = realloc(index->sketches, sizeof(lisa_similar_sketch) * new_capacity);
+    if (sketches == NULL) return -1;
+    index->sketches = sketches;
+
+    lisa_similar_band *bands = realloc(index->bands, sizeof(lisa_similar_band) * LISA_SIMILAR_BANDS * new_capacity);
+    if (bands == NULL) return -1;
+    index->bands = bands;
+
+    index->capacity = new_capacity;
+    return 0;
+}
+
+
+/*! Add \a path to the index's name table, getting back its offset. */
+int64_t
+lisa_similar_index_add_name(lisa_similar_index *index, const char *path)
+{
+    size_t length = strlen(path) + 1;
+    if (index->names_size + length > UINT32_MAX) {
+        errno = EFBIG;
+        return -1;
+    }
+
+    if (index->names_size + length > index->names_capacity) {
+        size_t new_capacity = index->names_capacity ? index->names_capacity * 2 : 4096;
+        while (new_capacity < index->names_size + length) new_capacity *= 2;
+        char *names = realloc(index->names, new_capacity);
+        if (names == NULL) return -1;
+        index->names = names;
+        index->names_capacity = new_capacity;
+    }
+
+    int64_t offset = (int64_t)index->names_size;
+    memcpy(&index->names[index->names_size], path, length);
+    index->names_size += length;
+    return offset;
+}
+
+
+/*! Sort the bands by hash, if they aren't already. */
+void
+lisa_similar_index_prepare(lisa_similar_index *index)
+{
+    pthread_mutex_lock(&index->lock);
+    if (!index->sorted) {
+        qsort(index->bands, index->count * LISA_SIMILAR_BANDS, sizeof(lisa_similar_band),
+              lisa_similar_band_compare);
+        index->sorted = true;
+    }
+    pthread_mutex_unlock(&index->lock);
+}
+
+
+/*! Find the first band with hash \a hash or greater. */
+size_t
+lisa_similar_index_band_lower_bound(const lisa_similar_index *index, uint64_t hash)
+{
+    size_t low = 0;
+    size_t high = index->count * LISA_SIMILAR_BANDS;
+
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (index->bands[middle].hash < hash) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+
+/*! A candidate match, while ranking them. */
+struct lisa_similar_candidate {
+    uint32_t			segment;
+    double				similarity;
+    const char			*path;
+    const char			*name;
+};
+typedef struct lisa_similar_candidate lisa_similar_candidate;
+
+
+int
+lisa_similar_candidate_compare(const void *a, const void *b)
+{
+    const lisa_similar_candidate *candidate_a = a;
+    const lisa_similar_candidate *candidate_b = b;
+    if (candidate_a->similarity != candidate_b->similarity) {
+        return (candidate_a->similarity > candidate_b->similarity) ? -1 : 1;
+    }
+
+    // Segments are added in whatever order the files were read, so ties
+    // are broken by path and name to keep the ranking the same each time.
+
+    int path_order = strcmp(candidate_a->path, candidate_b->path);
+    if (path_order != 0) return path_order;
+    int name_order = strcmp(candidate_a->name, candidate_b->name);
+    if (name_order != 0) return name_order;
+    return (candidate_a->segment > candidate_b->segment) - (candidate_a->segment < candidate_b->segment);
+}
+
+
+int
+lisa_similar_segment_compare(const void *a, const void *b)
+{
+    uint32_t segment_a = *(const uint32_t *)a;
+    uint32_t segment_b = *(const uint32_t *)b;
+    return (segment_a > segment_b) - (segment_a < segment_b);
+}
+
+
+/*! Write \a size bytes to \a f. */
+int
+lisa_similar_fwrite(FILE *f, const void *buf, size_t size)
+{
+    if ((size > 0) && (fwrite(buf, size, 1, f) != 1)) return -1;
+    return 0;
+}
+
+
+/*! Read \a size bytes from \a f, failing with EINVAL if there aren't that many. */
+int
+lisa_similar_fread(FILE *f, void *buf, size_t size)
+{
+    if ((size > 0) && (fread(buf, size, 1, f) != 1)) {
+        if (!ferror(f)) errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+
+/*! Store a big-endian 32-bit value at \a p. */
+void
+lisa_similar_put32(uint8_t *p, uint32_t value)
+{
+    uint32_t value_be = swapu32be(value);
+    memcpy(p, &value_be, sizeof(value_be));
+}
+
+
+/*! Load a big-endian 32-bit value from \a p. */
+uint32_t
+lisa_similar_get32(const uint8_t *p)
+{
+    uint32_t value_be;
+    memcpy(&value_be, p, sizeof(value_be));
+    return swapu32be(value_be);
+}
+
+
+/*! Store a big-endian 64-bit value at \a p. */
+void
+lisa_similar_put64(uint8_t *p, uint64_t value)
+{
+    uint64_t value_be = swapu64be(value);
+    memcpy(p, &value_be, sizeof(value_be));
+}
+
+
+/*! Load a big-endian 64-bit value from \a p. */
+uint64_t
+lisa_similar_get64(const uint8_t *p)
+{
+    uint64_t value_be;
+    memcpy(&value_be, p, sizeof(value_be));
+    return swapu64be(value_be);
+}
+
+
+/*! Write the index's records, sketches, bands and names to \a f. */
+int
+lisa_similar_index_fwrite(lisa_similar_index *index, FILE *f)
+{
+    uint8_t header[LISA_SIMILAR_HEADER_SIZE] = { 0 };
+    memcpy(&header[0], LISA_SIMILAR_MAGIC, 8);
+    lisa_similar_put32(&header[8], LISA_SIMILAR_VERSION);
+    header[12] = (uint8_t)(LISA_SIMILAR_HASHES >> 8);
+    header[13] = (uint8_t)LISA_SIMILAR_HASHES;
+    header[14] = (uint8_t)(LISA_SIMILAR_BANDS >> 8);
+    header[15] = (uint8_t)LISA_SIMILAR_BANDS;
+    lisa_similar_put64(&header[16], (uint64_t)index->count);
+    lisa_similar_put64(&header[24], (uint64_t)index->names_size);
+    if (lisa_similar_fwrite(f, header, sizeof(header)) == -1) return -1;
+
+    uint8_t *chunk = malloc(LISA_SIMILAR_IO_CHUNK * sizeof(lisa_similar_sketch));
+    if (chunk == NULL) return -1;
+
+    int result = -1;
+
+    for (size_t first = 0; first < index->count; first += LISA_SIMILAR_IO_CHUNK) {
+        size_t count = index->count - first;
+        if (count > LISA_SIMILAR_IO_CHUNK) count = LISA_SIMILAR_IO_CHUNK;
+
+        for (size_t i = 0; i < count; i++) {
+            const lisa_similar_entry *entry = &index->entries[first + i];
+            uint8_t *record = &chunk[i * LISA_SIMILAR_RECORD_SIZE];
+            lisa_similar_put32(&record[0], entry->path);
+            memset(&record[4], ' ', 8);
+            memcpy(&record[4], entry->name, strlen(entry->name));
+            lisa_similar_put32(&record[12], (uint32_t)entry->size);
+        }
+        if (lisa_similar_fwrite(f, chunk, count * LISA_SIMILAR_RECORD_SIZE) == -1) goto done;
+    }
+
+    for (size_t first = 0; first < index->count; first += LISA_SIMILAR_IO_CHUNK) {
+        size_t count = index->count - first;
+        if (count > LISA_SIMILAR_IO_CHUNK) count = LISA_SIMILAR_IO_CHUNK;
+
+        for (size_t i = 0; i < count; i++) {
+            for (size_t h = 0; h < LISA_SIMILAR_HASHES; h++) {
+                lisa_similar_put32(&chunk[(i * LISA_SIMILAR_HASHES + h) * 4], index->sketches[first + i].hashes[h]);
+            }
+        }
+        if (lisa_similar_fwrite(f, chunk, count * sizeof(lisa_similar_sketch)) == -1) goto done;
+    }
+
+    const size_t band_count = index->count * LISA_SIMILAR_BANDS;
+    for (size_t first = 0; first < band_count; first += LISA_SIMILAR_IO_CHUNK) {
+        size_t count = band_count - first;
+        if (count > LISA_SIMILAR_IO_CHUNK) count = LISA_SIMILAR_IO_CHUNK;
+
+        for (size_t i = 0; i < count; i++) {
+            uint8_t *band = &chunk[i * LISA_SIMILAR_BAND_SIZE];
+            lisa_similar_put64(&band[0], index->bands[first + i].hash);
+            lisa_similar_put32(&band[8], index->bands[first + i].segment);
+        }
+        if (lisa_similar_fwrite(f, chunk, count * LISA_SIMILAR_BAND_SIZE) == -1) goto done;
+    }
+
+    if (lisa_similar_fwrite(f, index->names, index->names_size) == -1) goto done;
+
+    result = 0;
+
+done:
+    free(chunk);
+    return result;
+}
+
+
+/*! Read the records, sketches, bands and names of an index from \a f. */
+int
+lisa_similar_index_fread(lisa_similar_index *index, FILE *f)
+{
+    uint8_t header[LISA_SIMILAR_HEADER_SIZE];
+    if (lisa_similar_fread(f, header, sizeof(header)) == -1) return -1;
+
+    uint64_t count = lisa_similar_get64(&header[16]);
+    uint64_t names_size = lisa_similar_get64(&header[24]);
+    if ((memcmp(&header[0], LISA_SIMILAR_MAGIC, 8) != 0)
+        || (lisa_similar_get32(&header[8]) != LISA_SIMILAR_VERSION)
+        || (((header[12] << 8) | header[13]) != LISA_SIMILAR_HASHES)
+        || (((header[14] << 8) | header[15]) != LISA_SIMILAR_BANDS)
+        || (count > UINT32_MAX) || (names_size > UINT32_MAX)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (lisa_similar_index_reserve(index, (size_t)count) == -1) return -1;
+
+    index->names = malloc((size_t)names_size + 1);
+    if (index->names == NULL) return -1;
+    index->names_capacity = (size_t)names_size + 1;
+
+    uint8_t *chunk = malloc(LISA_SIMILAR_IO_CHUNK * sizeof(lisa_similar_sketch));
+    if (chunk == NULL) return -1;
+
+    int result = -1;
+
+    for (size_t first = 0; first < count; first += LISA_SIMILAR_IO_CHUNK) {
+        size_t chunk_count = (size_t)count - first;
+        if (chunk_count > LISA_SIMILAR_IO_CHUNK) chunk_count = LISA_SIMILAR_IO_CHUNK;
+        if (lisa_similar_fread(f, chunk, chunk_count * LISA_SIMILAR_RECORD_SIZE) == -1) goto done;
+
+        for (size_t i = 0; i < chunk_count; i++) {
+            lisa_similar_entry *entry = &index->entries[first + i];
+            const uint8_t *record = &chunk[i * LISA_SIMILAR_RECORD_SIZE];
+            entry->path = lisa_similar_get32(&record[0]);
+            lisa_ObjName_get_cstring(entry->name, (const char *)&record[4]);
+            entry->size = (lisa_longint)lisa_similar_get32(&record[12]);
+
+            if (entry->path >= names_size) {
+                errno = EINVAL;
+                goto done;
+            }
+        }
+    }
+
+    for (size_t first = 0; first < count; first += LISA_SIMILAR_IO_CHUNK) {
+        size_t chunk_count = (size_t)count - first;
+        if (chunk_count > LISA_SIMILAR_IO_CHUNK) chunk_count = LISA_SIMILAR_IO_CHUNK;
+        if (lisa_similar_fread(f, chunk, chunk_count * sizeof(lisa_similar_sketch)) == -1) goto done;
+
+        for (size_t i = 0; i < chunk_count; i++) {
+            for (size_t h = 0; h < LISA_SIMILAR_HASHES; h++) {
+                index->sketches[first + i].hashes[h] = lisa_similar_get32(&chunk[(i * LISA_SIMILAR_HASHES + h) * 4]);
+            }
+        }
+    }
+
+    const size_t band_count = (size_t)count * LISA_SIMILAR_BANDS;
+    for (size_t first = 0; first < band_count; first += LISA_SIMILAR_IO_CHUNK) {
+        size_t chunk_count = band_count - first;
+        if (chunk_count > LISA_SIMILAR_IO_CHUNK) chunk_count = LISA_SIMILAR_IO_CHUNK;
+        if (lisa_similar_fread(f, chunk, chunk_count * LISA_SIMILAR_BAND_SIZE) == -1) goto done;
+
+        for (size_t i = 0; i < chunk_count; i++) {
+            const uint8_t *band = &chunk[i * LISA_SIMILAR_BAND_SIZE];
+            index->bands[first + i].hash = lisa_similar_get64(&band[0]);
+            index->bands[first + i].segment = lisa_similar_get32(&band[8]);
+
+            if (index->bands[first + i].segment >= count) {
+                errno = EINVAL;
+                goto done;
+            }
+        }
+    }
+
+    if (lisa_similar_fread(f, index->names, (size_t)names_size) == -1) goto done;
+    if ((names_size > 0) && (index->names[names_size - 1] != '\0')) {
+        errno = EINVAL;
+        goto done;
+    }
+
+    index->count = (size_t)count;
+    index->names_size = (size_t)names_size;
+    index->sorted = true;
+    result = 0;
+
+done:
+    free(chunk);
+    return result;
+}
+
+
+// MARK: - Sketches
+
+int
+lisa_similar_sketch_code(const uint8_t *code, size_t code_size, lisa_similar_sketch *sketch)
+{
+    const size_t words = code_size / 2;
+    if (words == 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    bool filled[LISA_SIMILAR_HASHES] = { false };
+    for (size_t b = 0; b < LISA_SIMILAR_HASHES; b++) {
+        sketch->hashes[b] = UINT32_MAX;
+    }
+
+    // Each shingle is hashed just once. The top of the hash picks the
+    // bin and the bottom is the value, keeping the smallest in each bin.
+
+    const size_t shingles = (words >= LISA_SIMILAR_SHINGLE_WORDS) ? words - LISA_SIMILAR_SHINGLE_WORDS + 1 : 1;
+    uint64_t shingle = 0;
+    size_t next_word = 0;
+
+    for (size_t s = 0; s < shingles; s++) {
+        while ((next_word < s + LISA_SIMILAR_SHINGLE_WORDS) && (next_word < words)) {
+            shingle = (shingle << 16) | ((uint64_t)code[next_word * 2] << 8) | code[next_word * 2 + 1];
+            next_word += 1;
+        }
+
+        uint64_t hash = lisa_similar_mix(shingle ^ LISA_SIMILAR_SEED);
+        size_t bin = (size_t)(((hash >> 32) * LISA_SIMILAR_HASHES) >> 32);
+        uint32_t value = (uint32_t)hash;
+
+        if (!filled[bin] || (value < sketch->hashes[bin])) {
+            sketch->hashes[bin] = value;
+            filled[bin] = true;
+        }
+    }
+
+    // Empty bins borrow from the next filled bin along, pushed apart by
+    // how far along it is so that neighbouring empty bins differ.
+
+    for (size_t b = 0; b < LISA_SIMILAR_HASHES; b++) {
+        if (filled[b]) continue;
+
+        for (size_t distance = 1; distance < LISA_SIMILAR_HASHES; distance++) {
+            size_t source = (b + distance) % LISA_SIMILAR_HASHES;
+            if (!filled[source]) continue;
+
+            uint64_t borrowed = (uint64_t)sketch->hashes[source] + distance * LISA_SIMILAR_DENSIFY_STEP;
+            sketch->hashes[b] = (uint32_t)lisa_similar_mix(borrowed);
+            break;
+        }
+    }
+
+    return 0;
+}
+
+
+int
+lisa_segment_sketch(lisa_objfile *of, const lisa_segment *segment,
+                    lisa_similar_sketch *sketch, size_t * LISA_NULLABLE masked)
+{
+    uint8_t *code = malloc((size_t)segment->unpacked_size + 1);
+    if (code == NULL) return -1;
+
+    int result = -1;
+    lisa_longint code_size = segment->unpacked_size + 1;
+    if (lisa_segment_unpack(segment, code, &code_size) == -1) goto done;
+
+    size_t module_masked = 0;
+    if (lisa_objfile_module_has_references(of, segment->module)) {
+        int mask_err = lisa_objfile_module_mask_references(of, segment->module, code, (size_t)code_size, &module_masked);
+        if (mask_err == -1) goto done;
+    }
+
+    if (lisa_similar_sketch_code(code, (size_t)code_size, sketch) == -1) goto done;
+
+    if (masked) *masked = module_masked;
+    result = 0;
+
+done:
+    free(code);
+    return result;
+}
+
+
+double
+lisa_similar_sketch_compare(const lisa_similar_sketch *a, const lisa_similar_sketch *b)
+{
+    size_t same = 0;
+    for (size_t h = 0; h < LISA_SIMILAR_HASHES; h++) {
+        same += (a->hashes[h] == b->hashes[h]);
+    }
+    return (double)same / LISA_SIMILAR_HASHES;
+}
+
+
+// MARK: - Indexes
+
+lisa_similar_index * LISA_NULLABLE
+lisa_similar_index_create(void)
+{
+    lisa_similar_index *index = calloc(sizeof(lisa_similar_index), 1);
+    if (index == NULL) return NULL;
+
+    pthread_mutex_init(&index->lock, NULL);
+    index->sorted = true;
+    return index;
+}
+
+
+void
+lisa_similar_index_free(lisa_similar_index * LISA_NULLABLE index)
+{
+    if (index) {
+        pthread_mutex_destroy(&index->lock);
+        free(index->entries);
+        free(index->sketches);
+        free(index->bands);
+        free(index->names);
+        free(index);
+    }
+}
+
+
+size_t
+lisa_similar_index_count(lisa_similar_index *index)
+{
+    return index->count;
+}
+
+
+int
+lisa_similar_index_add(lisa_similar_index *index, lisa_objfile *of, const char *path,
+                       lisa_similar_stats * LISA_NULLABLE stats)
+{
+    lisa_similar_stats file_stats = { 0 };
+    const lisa_integer segment_count = lisa_objfile_segment_count(of);
+
+    lisa_similar_entry *entries = calloc(sizeof(lisa_similar_entry), (size_t)segment_count + 1);
+    lisa_similar_sketch *sketches = calloc(sizeof(lisa_similar_sketch), (size_t)segment_count + 1);
+    if ((entries == NULL) || (sketches == NULL)) {
+        free(entries);
+        free(sketches);
+        return -1;
+    }
+
+    // Sketch every segment first, without holding the lock. Segments
+    // without a whole word of code have nothing to compare.
+
+    int result = -1;
+    size_t count = 0;
+    for (lisa_integer s = 0; s < segment_count; s++) {
+        lisa_segment segment;
+        if (lisa_objfile_segment_at_index(of, s, &segment) == -1) continue;
+        if (segment.unpacked_size < 2) continue;
+
+        size_t masked;
+        if (lisa_segment_sketch(of, &segment, &sketches[count], &masked) == -1) goto done;
+
+        memcpy(entries[count].name, segment.name, sizeof(segment.name));
+        entries[count].size = segment.unpacked_size;
+        file_stats.masked += masked;
+        count += 1;
+    }
+
+    pthread_mutex_lock(&index->lock);
+
+    int reserve_err = lisa_similar_index_reserve(index, count);
+    int64_t path_offset = (reserve_err == -1) ? -1 : lisa_similar_index_add_name(index, path);
+    if ((path_offset == -1) || (index->count + count > UINT32_MAX)) {
+        if (errno == 0) errno = EFBIG;
+        pthread_mutex_unlock(&index->lock);
+        goto done;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        const size_t segment = index->count + i;
+        index->entries[segment] = entries[i];
+        index->entries[segment].path = (uint32_t)path_offset;
+        index->sketches[segment] = sketches[i];
+
+        for (size_t b = 0; b < LISA_SIMILAR_BANDS; b++) {
+            index->bands[segment * LISA_SIMILAR_BANDS + b] = (lisa_similar_band){
+                .hash = lisa_similar_band_hash(&sketches[i], b),
+                .segment = (uint32_t)segment,
+            };
+        }
+    }
+    index->count += count;
+    if (count > 0) index->sorted = false;
+
+    pthread_mutex_unlock(&index->lock);
+
+    file_stats.segments = count;
+    if (stats) *stats = file_stats;
+    result = 0;
+
+done:
+    free(entries);
+    free(sketches);
+    return result;
+}
+
+
+int
+lisa_similar_index_query(lisa_similar_index *index, const lisa_similar_sketch *sketch,
+                         double min_similarity, size_t limit,
+                         lisa_similar_match *matches, size_t *count)
+{
+    lisa_similar_index_prepare(index);
+
+    // Gather every segment sharing a band with the sketch, then compare
+    // the whole sketch against each one just once.
+
+    uint32_t *segments = NULL;
+    size_t segment_count = 0, segment_capacity = 0;
+    lisa_similar_candidate *candidates = NULL;
+    int result = -1;
+
+    for (size_t b = 0; b < LISA_SIMILAR_BANDS; b++) {
+        uint64_t hash = lisa_similar_band_hash(sketch, b);
+        const size_t band_count = index->count * LISA_SIMILAR_BANDS;
+
+        for (size_t i = lisa_similar_index_band_lower_bound(index, hash);
+             (i < band_count) && (index->bands[i].hash == hash); i++) {
+            if (segment_count == segment_capacity) {
+                size_t new_capacity = segment_capacity ? segment_capacity * 2 : 64;
+                uint32_t *grown = realloc(segments, sizeof(uint32_t) * new_capacity);
+                if (grown == NULL) goto done;
+                segments = grown;
+                segment_capacity = new_capacity;
+            }
+            segments[segment_count++] = index->bands[i].segment;
+        }
+    }
+
+    candidates = calloc(sizeof(lisa_similar_candidate), segment_count + 1);
+    if (candidates == NULL) goto done;
+
+    size_t candidate_count = 0;
+    if (segment_count > 0) {
+        qsort(segments, segment_count, sizeof(uint32_t), lisa_similar_segment_compare);
+    }
+    for (size_t i = 0; i < segment_count; i++) {
+        if ((i > 0) && (segments[i] == segments[i - 1])) continue;
+
+        double similarity = lisa_similar_sketch_compare(sketch, &index->sketches[segments[i]]);
+        if (similarity < min_similarity) continue;
+
+        const lisa_similar_entry *entry = &index->entries[segments[i]];
+        candidates[candidate_count++] = (lisa_similar_candidate){
+            .segment = segments[i],
+            .similarity = similarity,
+            .path = &index->names[entry->path],
+            .name = entry->name,
+        };
+    }
+
+    qsort(candidates, candidate_count, sizeof(lisa_similar_candidate), lisa_similar_candidate_compare);
+
+    if (candidate_count > limit) candidate_count = limit;
+    for (size_t i = 0; i < candidate_count; i++) {
+        const lisa_similar_entry *entry = &index->entries[candidates[i].segment];
+        matches[i] = (lisa_similar_match){
+            .path = candidates[i].path,
+            .size = entry->size,
+            .similarity = candidates[i].similarity,
+        };
+        memcpy(matches[i].name, entry->name, sizeof(entry->name));
+    }
+
+    *count = candidate_count;
+    result = 0;
+
+done:
+    free(segments);
+    free(candidates);
+    return result;
+}
+
+
+/*! Write the index given as \a context to \a f, for `write_file_atomically`. */
+int
+lisa_similar_index_file_writer(FILE *f, void * LISA_NULLABLE context)
+{
+    return lisa_similar_index_fwrite(context, f);
+}
+
+
+int
+lisa_similar_index_write(lisa_similar_index *index, const char *path)
+{
+    lisa_similar_index_prepare(index);
+
+    // Write to a temporary file alongside, so a reader never sees a
+    // partly-written index.
+
+    return write_file_atomically(path, lisa_similar_index_file_writer, index);
+}
+
+
+lisa_similar_index * LISA_NULLABLE
+lisa_similar_index_read(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return NULL;
+
+    lisa_similar_index *index = lisa_similar_index_create();
+    if ((index == NULL) || (lisa_similar_index_fread(index, f) == -1)) {
+        int read_errno = errno;
+        lisa_similar_index_free(index);
+        fclose(f);
+        errno = read_errno;
+        return NULL;
+    }
+
+    fclose(f);
+    return index;
+}
+
+
+LISA_SOURCE_END
@@ -0,0 +1,185 @@
+//  lisa_similar.h
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#ifndef __LISA__SIMILAR__H__
+#define __LISA__SIMILAR__H__
+
+#include <stddef.h>
+
+#include "lisa_defines.h"
+#include "lisa_types.h"
+
+#include "lisa_objio.h"
+
+LISA_HEADER_BEGIN
+
+
+/*! The number of minimum hashes in a sketch. */
+#define LISA_SIMILAR_HASHES			128
+
+/*! The number of bands a sketch is split into for the index, each of `LISA_SIMILAR_ROWS` hashes. */
+#define LISA_SIMILAR_BANDS			32
+#define LISA_SIMILAR_ROWS			(LISA_SIMILAR_HASHES / LISA_SIMILAR_BANDS)
+
+/*! The number of consecutive 16-bit code words in each shingle. */
+#define LISA_SIMILAR_SHINGLE_WORDS	4
+
+
+/*!
+    A MinHash sketch of a segment's unpacked code, from which the
+    similarity of two segments (the Jaccard similarity of their sets of
+    shingles) can be estimated as the fraction of hashes they share.
+
+    Each shingle of `LISA_SIMILAR_SHINGLE_WORDS` code words is hashed
+    once, and the hash both picks one of the sketch's bins and gives
+    the value kept if it's the bin's smallest (one-permutation hashing).
+    Bins no shingle fell into borrow from the next bin that has one, so
+    small segments still compare properly.
+ */
+struct lisa_similar_sketch {
+    uint32_t			hashes[LISA_SIMILAR_HASHES];
+};
+typedef struct lisa_similar_sketch lisa_similar_sketch;
+
+
+/*!
+    An index of segment sketches, for finding segments similar to a
+    given one without comparing it against every segment. (Opaque!)
+
+    Each sketch is split into `LISA_SIMILAR_BANDS` bands, and a segment
+    is a candidate match if any band of its sketch is identical to the
+    same band of the query's (locality-sensitive hashing). With 32
+    bands of 4 hashes, segments 50% similar are found 87% of the time,
+    and 70% similar ones better than 99% of the time, while dissimilar
+    ones are rarely even looked at.
+
+    An index can be written to a file and read back. The format is
+    uncompressed, and all integers are big-endian:
+
+    - A 32-byte header: the magic `LISASIM\0`, a 32-bit version (1), the
+      16-bit hash and band counts, the 64-bit number of segments, and the
+      64-bit size of the name table.
+    - A 16-byte record per segment: the 32-bit offset of its file's path
+      in the name table, its 8-byte blank-padded name, and its 32-bit
+      unpacked size.
+    - The segments' sketches, `LISA_SIMILAR_HASHES` 32-bit hashes each.
+    - The band table, a 12-byte entry per band of each segment: the
+      64-bit hash of the band and the 32-bit index of the segment, sorted
+      by hash.
+    - The name table, holding each path followed by a NUL.
+ */
+struct lisa_similar_index;
+typedef struct lisa_similar_index lisa_similar_index;
+
+
+#define LISA_SIMILAR_MAGIC			"LISASIM"
+#define LISA_SIMILAR_VERSION		1
+#define LISA_SIMILAR_HEADER_SIZE	32
+#define LISA_SIMILAR_RECORD_SIZE	16
+#define LISA_SIMILAR_BAND_SIZE		12
+
+
+/*! A segment found by a query. */
+struct lisa_similar_match {
+    const char			*path;			//!< of the object file, owned by the index
+    char				name[9];		//!< of the segment
+    lisa_longint		size;			//!< of the segment's unpacked code
+    double				similarity;		//!< estimated, from 0 to 1
+};
+typedef struct lisa_similar_match lisa_similar_match;
+
+
+/*! What adding an object file to an index did, for reporting. */
+struct lisa_similar_stats {
+    size_t				segments;		//!< sketched and added
+    size_t				masked;			//!< relocated fields left out of sketches
+};
+typedef struct lisa_similar_stats lisa_similar_stats;
+
+
+/*!
+    Sketch the \a code_size bytes of unpacked \a code into \a sketch.
+    Fails with EINVAL if there isn't a whole word of code.
+ */
+LISA_EXTERN
+int
+lisa_similar_sketch_code(const uint8_t *code, size_t code_size, lisa_similar_sketch *sketch);
+
+/*!
+    Sketch \a segment of \a of. Its code is unpacked, and any fields its
+    module's reference blocks refer to are zeroed first (see
+    `lisa_objfile_module_mask_references`), so segments that differ only
+    in where they were relocated to sketch the same. Executables carry
+    no reference blocks, so their segments are sketched as they are.
+
+    If \a masked is given, it's set to the number of fields zeroed.
+ */
+LISA_EXTERN
+int
+lisa_segment_sketch(lisa_objfile *of, const lisa_segment *segment,
+                    lisa_similar_sketch *sketch, size_t * LISA_NULLABLE masked);
+
+/*! Estimate the similarity of the segments two sketches were made from, from 0 to 1. */
+LISA_EXTERN
+double
+lisa_similar_sketch_compare(const lisa_similar_sketch *a, const lisa_similar_sketch *b);
+
+
+/*! Create an empty index. */
+LISA_EXTERN
+lisa_similar_index * LISA_NULLABLE
+lisa_similar_index_create(void);
+
+/*! Free the given index. */
+LISA_EXTERN
+void
+lisa_similar_index_free(lisa_similar_index * LISA_NULLABLE index);
+
+/*! Get the number of segments in the index. */
+LISA_EXTERN
+size_t
+lisa_similar_index_count(lisa_similar_index *index);
+
+/*!
+    Sketch every segment of \a of, which was opened from \a path, and
+    add them to the index. The path is copied.
+
+    This may be called from multiple threads at once: the sketches are
+    made without holding any lock, then added in one go.
+ */
+LISA_EXTERN
+int
+lisa_similar_index_add(lisa_similar_index *index, lisa_objfile *of, const char *path,
+                       lisa_similar_stats * LISA_NULLABLE stats);
+
+/*!
+    Find up to \a limit segments in the index whose similarity to the
+    segment \a sketch was made from is at least \a min_similarity,
+    most similar first. Sets \a count to the number found.
+
+    Once everything has been added, any number of queries may be made at
+    once from multiple threads.
+ */
+LISA_EXTERN
+int
+lisa_similar_index_query(lisa_similar_index *index, const lisa_similar_sketch *sketch,
+                         double min_similarity, size_t limit,
+                         lisa_similar_match *matches, size_t *count);
+
+/*! Write the index to a file at \a path, replacing any file already there. */
+LISA_EXTERN
+int
+lisa_similar_index_write(lisa_similar_index *index, const char *path);
+
+/*! Read an index written by `lisa_similar_index_write`. Fails with EINVAL if it isn't one. */
+LISA_EXTERN
+lisa_similar_index * LISA_NULLABLE
+lisa_similar_index_read(const char *path);
+
+
+LISA_HEADER_END
+
+#endif /* __LISA__SIMILAR__H__ */
@@ -0,0 +1,144 @@
+//  lisa_stats.c
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#include "lisa_stats.h"
+
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <time.h>
+
+
+LISA_SOURCE_BEGIN
+
+
+// MARK: - Internals
+
+/*! What's been recorded for a single phase, added to from any thread. */
+struct lisa_stats_counters {
+    atomic_uint_fast64_t	count;
+    atomic_uint_fast64_t	nanoseconds;
+    atomic_uint_fast64_t	bytes_in;
+    atomic_uint_fast64_t	bytes_out;
+};
+typedef struct lisa_stats_counters lisa_stats_counters;
+
+
+static atomic_bool lisa_stats_on = false;
+static lisa_stats_counters lisa_stats_phases[LISA_STATS_PHASE_COUNT];
+
+
+/*! Get the monotonic time in nanoseconds. */
+uint64_t
+lisa_stats_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+
+// MARK: - Recording
+
+void
+lisa_stats_set_enabled(bool enabled)
+{
+    atomic_store_explicit(&lisa_stats_on, enabled, memory_order_relaxed);
+}
+
+
+bool
+lisa_stats_enabled(void)
+{
+    return atomic_load_explicit(&lisa_stats_on, memory_order_relaxed);
+}
+
+
+void
+lisa_stats_reset(void)
+{
+    for (size_t p = 0; p < LISA_STATS_PHASE_COUNT; p++) {
+        atomic_store_explicit(&lisa_stats_phases[p].count, 0, memory_order_relaxed);
+        atomic_store_explicit(&lisa_stats_phases[p].nanoseconds, 0, memory_order_relaxed);
+        atomic_store_explicit(&lisa_stats_phases[p].bytes_in, 0, memory_order_relaxed);
+        atomic_store_explicit(&lisa_stats_phases[p].bytes_out, 0, memory_order_relaxed);
+    }
+}
+
+
+uint64_t
+lisa_stats_begin(void)
+{
+    if (!atomic_load_explicit(&lisa_stats_on, memory_order_relaxed)) return 0;
+    return lisa_stats_now();
+}
+
+
+void
+lisa_stats_end(lisa_stats_phase phase, uint64_t start, uint64_t bytes_in, uint64_t bytes_out)
+{
+    if ((start == 0) || (phase >= LISA_STATS_PHASE_COUNT)) return;
+
+    uint64_t elapsed = lisa_stats_now() - start;
+
+    lisa_stats_counters *counters = &lisa_stats_phases[phase];
+    atomic_fetch_add_explicit(&counters->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&counters->nanoseconds, elapsed, memory_order_relaxed);
+    if (bytes_in) atomic_fetch_add_explicit(&counters->bytes_in, bytes_in, memory_order_relaxed);
+    if (bytes_out) atomic_fetch_add_explicit(&counters->bytes_out, bytes_out, memory_order_relaxed);
+}
+
+
+// MARK: - Reporting
+
+const char *
+lisa_stats_phase_string(lisa_stats_phase phase)
+{
+    switch (phase) {
+        case lisa_stats_read:			return "read";
+        case lisa_stats_header_walk:	return "header_walk";
+        case lisa_stats_swap:			return "swap";
+        case lisa_stats_index:			return "index";
+        case lisa_stats_unpack:			return "unpack";
+        case lisa_stats_pack:			return "pack";
+        case lisa_stats_format:			return "format";
+        case lisa_stats_write:			return "write";
+        case lisa_stats_allocate:		return "allocate";
+    }
+    return "unknown";
+}
+
+
+void
+lisa_objfile_stats_get(lisa_objfile_stats *stats)
+{
+    for (size_t p = 0; p < LISA_STATS_PHASE_COUNT; p++) {
+        lisa_stats_counters *counters = &lisa_stats_phases[p];
+        stats->phases[p] = (lisa_phase_stats){
+            .count = atomic_load_explicit(&counters->count, memory_order_relaxed),
+            .nanoseconds = atomic_load_explicit(&counters->nanoseconds, memory_order_relaxed),
+            .bytes_in = atomic_load_explicit(&counters->bytes_in, memory_order_relaxed),
+            .bytes_out = atomic_load_explicit(&counters->bytes_out, memory_order_relaxed),
+        };
+    }
+}
+
+
+int
+lisa_objfile_stats_fprint_json(const lisa_objfile_stats *stats, FILE *f)
+{
+    fprintf(f, "{");
+    for (size_t p = 0; p < LISA_STATS_PHASE_COUNT; p++) {
+        const lisa_phase_stats *phase = &stats->phases[p];
+        fprintf(f, "%s\"%s\": {\"count\": %" PRIu64 ", \"seconds\": %.6f, \"bytes_in\": %" PRIu64 ", \"bytes_out\": %" PRIu64 "}",
+                (p > 0) ? ", " : "", lisa_stats_phase_string((lisa_stats_phase)p),
+                phase->count, (double)phase->nanoseconds / 1e9, phase->bytes_in, phase->bytes_out);
+    }
+    fprintf(f, "}" "\n");
+    return ferror(f) ? -1 : 0;
+}
+
+
+LISA_SOURCE_END
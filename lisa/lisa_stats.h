@@ -0,0 +1,114 @@
+//  lisa_stats.h
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#ifndef __LISA__STATS__H__
+#define __LISA__STATS__H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "lisa_defines.h"
+#include "lisa_types.h"
+
+LISA_HEADER_BEGIN
+
+
+/*!
+    A phase of working with object files that's timed and counted.
+    Phases can nest: the header walk includes swapping each block, and
+    formatting a packed block includes unpacking it.
+ */
+enum lisa_stats_phase: uint32_t {
+    lisa_stats_read			= 0,	//!< reading or mapping files, out is bytes read
+    lisa_stats_header_walk	= 1,	//!< walking block headers as files are opened
+    lisa_stats_swap			= 2,	//!< swapping blocks between big-endian and native, in is bytes swapped
+    lisa_stats_index		= 3,	//!< building module, segment and jump table indexes
+    lisa_stats_unpack		= 4,	//!< unpacking code, in is packed bytes and out is unpacked
+    lisa_stats_pack			= 5,	//!< packing code, in is unpacked bytes and out is packed
+    lisa_stats_format		= 6,	//!< formatting blocks as text
+    lisa_stats_write		= 7,	//!< writing output files, in is bytes written
+    lisa_stats_allocate		= 8,	//!< allocating with `lisa_default_allocator`, out is bytes allocated
+};
+typedef enum lisa_stats_phase lisa_stats_phase;
+
+#define LISA_STATS_PHASE_COUNT	9
+
+
+/*! What was recorded for a single phase. */
+struct lisa_phase_stats {
+    uint64_t			count;			//!< times the phase was entered
+    uint64_t			nanoseconds;	//!< spent in it, by the monotonic clock, across all threads
+    uint64_t			bytes_in;
+    uint64_t			bytes_out;
+};
+typedef struct lisa_phase_stats lisa_phase_stats;
+
+
+/*! What was recorded for every phase, since stats were enabled or reset. */
+struct lisa_objfile_stats {
+    lisa_phase_stats	phases[LISA_STATS_PHASE_COUNT];
+};
+typedef struct lisa_objfile_stats lisa_objfile_stats;
+
+
+/*!
+    Turn recording stats on or off for the whole process; it's off to
+    start with. Recording is always compiled in, but while it's off,
+    each phase only costs a check of whether it's on.
+ */
+LISA_EXTERN
+void
+lisa_stats_set_enabled(bool enabled);
+
+/*! Whether stats are being recorded. */
+LISA_EXTERN
+bool
+lisa_stats_enabled(void);
+
+/*! Forget everything recorded so far. */
+LISA_EXTERN
+void
+lisa_stats_reset(void);
+
+/*! Get everything recorded so far. This may be called while other threads are recording. */
+LISA_EXTERN
+void
+lisa_objfile_stats_get(lisa_objfile_stats *stats);
+
+/*! Write stats as a JSON object, with a member for each phase. */
+LISA_EXTERN
+int
+lisa_objfile_stats_fprint_json(const lisa_objfile_stats *stats, FILE *f);
+
+/*! Get the name of a phase, as used in JSON. */
+LISA_EXTERN
+const char *
+lisa_stats_phase_string(lisa_stats_phase phase);
+
+
+/*!
+    Start timing a phase, returning what to give `lisa_stats_end`: the
+    monotonic time in nanoseconds, or 0 if stats aren't being recorded.
+ */
+LISA_EXTERN
+uint64_t
+lisa_stats_begin(void);
+
+/*!
+    Finish timing a phase begun at \a start, adding the given byte counts
+    to it. Does nothing if \a start is 0.
+
+    This may be called from multiple threads at once.
+ */
+LISA_EXTERN
+void
+lisa_stats_end(lisa_stats_phase phase, uint64_t start, uint64_t bytes_in, uint64_t bytes_out);
+
+
+LISA_HEADER_END
+
+#endif /* __LISA__STATS__H__ */
@@ -0,0 +1,229 @@
+//  lisa_store.c
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#include "lisa_store.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "hash_utils.h"
+
+#include "lisa_stats.h"
+
+
+LISA_SOURCE_BEGIN
+
+
+// MARK: - Internals
+
+struct lisa_store {
+    char				*path;
+    atomic_uint_fast64_t	next_temp;	//!< to give each temporary file its own name
+};
+
+
+/*! Write all of \a buf to \a fd. */
+int
+lisa_store_write_fd(int fd, const uint8_t *buf, size_t size)
+{
+    uint64_t write_start = lisa_stats_begin();
+
+    size_t written = 0;
+    while (written < size) {
+        ssize_t n = write(fd, &buf[written], size - written);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        written += (size_t)n;
+    }
+    lisa_stats_end(lisa_stats_write, write_start, size, 0);
+    return 0;
+}
+
+
+/*! Create the directory at \a path, unless it's already there. */
+int
+lisa_store_make_directory(const char *path)
+{
+    if ((mkdir(path, 0777) == -1) && (errno != EEXIST)) return -1;
+    return 0;
+}
+
+
+// MARK: - Stores
+
+lisa_store * LISA_NULLABLE
+lisa_store_open(const char *path)
+{
+    lisa_store *store = calloc(sizeof(lisa_store), 1);
+    if (store == NULL) return NULL;
+
+    store->path = strdup(path);
+    if (store->path == NULL) goto error;
+
+    // Every shard is made up front, so putting an object never has to
+    // wonder whether its directory is there yet.
+
+    if (lisa_store_make_directory(path) == -1) goto error;
+
+    for (int shard = 0; shard < 256; shard++) {
+        char shard_path[PATH_MAX];
+        if (snprintf(shard_path, sizeof(shard_path), "%s/%02x", path, shard) >= (int)sizeof(shard_path)) {
+            errno = ENAMETOOLONG;
+            goto error;
+        }
+        if (lisa_store_make_directory(shard_path) == -1) goto error;
+    }
+
+    return store;
+
+error:
+    {
+        int open_errno = errno;
+        lisa_store_close(store);
+        errno = open_errno;
+    }
+    return NULL;
+}
+
+
+void
+lisa_store_close(lisa_store * LISA_NULLABLE store)
+{
+    if (store) {
+        free(store->path);
+        free(store);
+    }
+}
+
+
+void
+lisa_store_digest_string(const uint8_t digest[LISA_STORE_DIGEST_SIZE],
+                         char string[LISA_STORE_DIGEST_STRING_SIZE])
+{
+    static const char digits[] = "0123456789abcdef";
+
+    for (size_t i = 0; i < LISA_STORE_DIGEST_SIZE; i++) {
+        string[i * 2] = digits[digest[i] >> 4];
+        string[i * 2 + 1] = digits[digest[i] & 0xF];
+    }
+    string[LISA_STORE_DIGEST_SIZE * 2] = '\0';
+}
+
+
+bool
+lisa_store_digest_parse(const char *string, uint8_t digest[LISA_STORE_DIGEST_SIZE])
+{
+    for (size_t i = 0; i < LISA_STORE_DIGEST_SIZE * 2; i++) {
+        char c = string[i];
+        uint8_t value;
+        if ((c >= '0') && (c <= '9')) {
+            value = (uint8_t)(c - '0');
+        } else if ((c >= 'a') && (c <= 'f')) {
+            value = (uint8_t)(c - 'a' + 10);
+        } else if ((c >= 'A') && (c <= 'F')) {
+            value = (uint8_t)(c - 'A' + 10);
+        } else {
+            return false;
+        }
+
+        if (i % 2 == 0) {
+            digest[i / 2] = (uint8_t)(value << 4);
+        } else {
+            digest[i / 2] |= value;
+        }
+    }
+
+    return string[LISA_STORE_DIGEST_SIZE * 2] == '\0';
+}
+
+
+int
+lisa_store_object_path(lisa_store *store, const uint8_t digest[LISA_STORE_DIGEST_SIZE],
+                       char *path, size_t path_size)
+{
+    char string[LISA_STORE_DIGEST_STRING_SIZE];
+    lisa_store_digest_string(digest, string);
+
+    int length = snprintf(path, path_size, "%s/%.2s/%s", store->path, string, &string[2]);
+    if ((length < 0) || ((size_t)length >= path_size)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    return 0;
+}
+
+
+bool
+lisa_store_contains(lisa_store *store, const uint8_t digest[LISA_STORE_DIGEST_SIZE], uint64_t size)
+{
+    char path[PATH_MAX];
+    if (lisa_store_object_path(store, digest, path, sizeof(path)) == -1) return false;
+
+    struct stat st;
+    if (stat(path, &st) == -1) return false;
+    return S_ISREG(st.st_mode) && ((uint64_t)st.st_size == size);
+}
+
+
+int
+lisa_store_put(lisa_store *store, const void *buf, size_t size,
+               uint8_t digest[LISA_STORE_DIGEST_SIZE], bool * LISA_NULLABLE added)
+{
+    hash_sha256(buf, size, digest);
+
+    if (added) *added = false;
+    if (lisa_store_contains(store, digest, size)) return 0;
+
+    char path[PATH_MAX];
+    if (lisa_store_object_path(store, digest, path, sizeof(path)) == -1) return -1;
+
+    // Another writer may be putting the same object at the same time;
+    // each uses its own temporary file, and whichever is renamed into
+    // place last wins, with the same content either way.
+
+    char temp_path[PATH_MAX];
+    uint64_t temp = atomic_fetch_add(&store->next_temp, 1);
+    if (snprintf(temp_path, sizeof(temp_path), "%s.%ld.%llu.tmp", path,
+                 (long)getpid(), (unsigned long long)temp) >= (int)sizeof(temp_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+
+    int fd = open(temp_path, O_WRONLY | O_CREAT | O_EXCL, 0666);
+    if (fd == -1) return -1;
+
+    int write_err = lisa_store_write_fd(fd, buf, size);
+    int write_errno = errno;
+    int close_err = close(fd);
+    if ((write_err == -1) || (close_err == -1)) {
+        if (write_err == 0) write_errno = errno;
+        unlink(temp_path);
+        errno = write_errno;
+        return -1;
+    }
+
+    if (rename(temp_path, path) == -1) {
+        int rename_errno = errno;
+        unlink(temp_path);
+        errno = rename_errno;
+        return -1;
+    }
+
+    if (added) *added = true;
+    return 0;
+}
+
+
+LISA_SOURCE_END
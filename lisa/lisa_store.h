@@ -0,0 +1,86 @@
+//  lisa_store.h
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#ifndef __LISA__STORE__H__
+#define __LISA__STORE__H__
+
+#include <stddef.h>
+
+#include "lisa_defines.h"
+#include "lisa_types.h"
+
+LISA_HEADER_BEGIN
+
+
+/*! The size of the digests objects are stored under, in bytes (SHA-256). */
+#define LISA_STORE_DIGEST_SIZE		32
+
+/*! The size of a digest as a string of hex digits, including the NUL. */
+#define LISA_STORE_DIGEST_STRING_SIZE	(LISA_STORE_DIGEST_SIZE * 2 + 1)
+
+
+/*!
+    A content-addressed store of extracted code, so code that's the same
+    everywhere it's extracted from is only kept once. (Opaque!)
+
+    A store is a directory of objects, each named by the SHA-256 digest
+    of its content in hex and sharded by the first two digits of it:
+    `store/ab/cdef...`. Objects are never modified once written, and are
+    written to a temporary file in their shard and renamed into place,
+    so any number of threads and processes can add to a store at once.
+ */
+struct lisa_store;
+typedef struct lisa_store lisa_store;
+
+
+/*! Open the store at \a path, creating it if it isn't there. */
+LISA_EXTERN
+lisa_store * LISA_NULLABLE
+lisa_store_open(const char *path);
+
+/*! Close and free the given store. */
+LISA_EXTERN
+void
+lisa_store_close(lisa_store * LISA_NULLABLE store);
+
+/*! Write \a digest as lowercase hex digits into \a string. */
+LISA_EXTERN
+void
+lisa_store_digest_string(const uint8_t digest[LISA_STORE_DIGEST_SIZE],
+                         char string[LISA_STORE_DIGEST_STRING_SIZE]);
+
+/*! Parse a digest of exactly `LISA_STORE_DIGEST_SIZE * 2` hex digits. */
+LISA_EXTERN
+bool
+lisa_store_digest_parse(const char *string, uint8_t digest[LISA_STORE_DIGEST_SIZE]);
+
+/*! Get the path of the object with the given digest, whether or not it's there. */
+LISA_EXTERN
+int
+lisa_store_object_path(lisa_store *store, const uint8_t digest[LISA_STORE_DIGEST_SIZE],
+                       char *path, size_t path_size);
+
+/*! Whether the store holds an object with the given digest and size. */
+LISA_EXTERN
+bool
+lisa_store_contains(lisa_store *store, const uint8_t digest[LISA_STORE_DIGEST_SIZE], uint64_t size);
+
+/*!
+    Hash the \a size bytes at \a buf into \a digest, and write them to
+    the store unless it already holds them. If \a added is given, it's
+    set to whether they were written.
+
+    This may be called from multiple threads at once.
+ */
+LISA_EXTERN
+int
+lisa_store_put(lisa_store *store, const void *buf, size_t size,
+               uint8_t digest[LISA_STORE_DIGEST_SIZE], bool * LISA_NULLABLE added);
+
+
+LISA_HEADER_END
+
+#endif /* __LISA__STORE__H__ */
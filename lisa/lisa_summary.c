@@ -0,0 +1,189 @@
+//  lisa_summary.c
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#include "lisa_summary.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+LISA_SOURCE_BEGIN
+
+
+int
+lisa_summary_size_bucket(lisa_longint size)
+{
+    int bucket = 0;
+    while ((bucket < LISA_SUMMARY_SIZE_BUCKETS - 1) && (size >> (bucket + 1)) != 0) {
+        bucket += 1;
+    }
+    return bucket;
+}
+
+
+int
+lisa_summary_ratio_bucket(lisa_longint packed_size, lisa_longint unpacked_size)
+{
+    if (unpacked_size <= 0) return LISA_SUMMARY_RATIO_BUCKETS - 1;
+
+    int64_t tenths = ((int64_t)packed_size * 10) / unpacked_size;
+    if (tenths > LISA_SUMMARY_RATIO_BUCKETS - 1) tenths = LISA_SUMMARY_RATIO_BUCKETS - 1;
+    return (int)tenths;
+}
+
+
+int
+lisa_objfile_summarize(lisa_objfile *of, lisa_objfile_summary *summary)
+{
+    memset(summary, 0, sizeof(lisa_objfile_summary));
+
+    summary->file_size = (lisa_longint)lisa_objfile_size(of);
+    summary->block_count = lisa_objfile_block_count(of);
+    summary->module_count = lisa_objfile_module_count(of);
+
+    // Count blocks and symbols, touching only headers and fixed fields.
+
+    lisa_integer unit_blocks = 0;
+    lisa_integer unit_table_units = 0;
+
+    for (lisa_integer b = 0; b < summary->block_count; b++) {
+        lisa_objfile_block *block = lisa_objfile_block_at_index(of, b);
+        lisa_objfile_content content = lisa_objfile_block_content(block);
+        lisa_longint size = lisa_objfile_block_size(block);
+        lisa_obj_block_type type = lisa_objfile_block_type(block);
+
+        summary->block_type_counts[type] += 1;
+
+        switch (type) {
+            case EntryPoint: {
+                summary->entry_count += 1;
+            } break;
+
+            case External: {
+                summary->external_count += 1;
+                summary->reference_count += (size - 20) / (lisa_longint)sizeof(lisa_SegAddr);
+            } break;
+
+            case ShortExternal: {
+                summary->external_count += 1;
+                summary->reference_count += (size - 20) / (lisa_longint)sizeof(lisa_integer);
+            } break;
+
+            case Relocation: {
+                summary->reference_count += (size - 4) / (lisa_longint)sizeof(lisa_SegAddr);
+            } break;
+
+            case CommonRelocation: {
+                summary->reference_count += (size - 12) / (lisa_longint)sizeof(lisa_SegAddr);
+            } break;
+
+            case UnitBlock: {
+                unit_blocks += 1;
+            } break;
+
+            case UnitTable: {
+                if (content.UnitTable->nUnits > unit_table_units) unit_table_units = content.UnitTable->nUnits;
+            } break;
+
+            case UnitLocation: {
+                if (content.UnitLocation->nUnits > unit_table_units) unit_table_units = content.UnitLocation->nUnits;
+            } break;
+
+            default: {
+            } break;
+        }
+    }
+
+    // Both the unit table and unit location blocks of an executable list
+    // the same units, so only count one of them.
+
+    summary->unit_count = (lisa_integer)(unit_blocks + unit_table_units);
+
+    // Gather per-segment sizes from the module index.
+
+    if (summary->module_count > 0) {
+        summary->segments = calloc(sizeof(lisa_segment_summary), (size_t)summary->module_count);
+        if (summary->segments == NULL) return -1;
+    }
+
+    for (lisa_integer m = 0; m < summary->module_count; m++) {
+        const lisa_objfile_module *module = lisa_objfile_module_at_index(of, m);
+        if (module->code_block == -1) continue;
+
+        lisa_objfile_block *name_block = lisa_objfile_block_at_index(of, module->first_block);
+        lisa_objfile_block *code_block = lisa_objfile_block_at_index(of, module->code_block);
+        lisa_objfile_content name_content = lisa_objfile_block_content(name_block);
+        lisa_objfile_content code_content = lisa_objfile_block_content(code_block);
+
+        lisa_segment_summary *segment = &summary->segments[summary->segment_count];
+        summary->segment_count += 1;
+
+        lisa_ObjName_get_cstring(segment->module_name, name_content.ModuleName->ModuleName);
+        lisa_ObjName_get_cstring(segment->segment_name, name_content.ModuleName->SegmentName);
+
+        if (lisa_objfile_block_type(code_block) == PackedCode) {
+            segment->packed = true;
+            segment->addr = code_content.PackedCode->addr;
+            segment->packed_size = lisa_objfile_block_size(code_block) - 12; // header + addr + csize = 12
+            segment->unpacked_size = code_content.PackedCode->csize;
+
+            int ratio_bucket = lisa_summary_ratio_bucket(segment->packed_size, segment->unpacked_size);
+            summary->ratio_histogram[ratio_bucket] += 1;
+        } else {
+            segment->packed = false;
+            segment->addr = code_content.CodeBlock->Addr;
+            segment->packed_size = lisa_objfile_block_size(code_block) - 8; // header + Addr = 8
+            segment->unpacked_size = segment->packed_size;
+        }
+
+        summary->code_packed_size += segment->packed_size;
+        summary->code_unpacked_size += segment->unpacked_size;
+
+        int size_bucket = lisa_summary_size_bucket(segment->unpacked_size);
+        summary->size_histogram[size_bucket] += 1;
+    }
+
+    return 0;
+}
+
+
+void
+lisa_objfile_summary_free(lisa_objfile_summary *summary)
+{
+    free(summary->segments);
+    summary->segments = NULL;
+    summary->segment_count = 0;
+}
+
+
+void
+lisa_summary_totals_add(lisa_summary_totals *totals, const lisa_objfile_summary *summary)
+{
+    totals->file_count += 1;
+    totals->file_size += summary->file_size;
+    totals->block_count += (uint64_t)summary->block_count;
+    totals->module_count += (uint64_t)summary->module_count;
+    totals->entry_count += (uint64_t)summary->entry_count;
+    totals->external_count += (uint64_t)summary->external_count;
+    totals->reference_count += summary->reference_count;
+    totals->unit_count += (uint64_t)summary->unit_count;
+    totals->code_packed_size += summary->code_packed_size;
+    totals->code_unpacked_size += summary->code_unpacked_size;
+    totals->segment_count += (uint64_t)summary->segment_count;
+
+    for (int t = 0; t < 256; t++) {
+        totals->block_type_counts[t] += (uint64_t)summary->block_type_counts[t];
+    }
+    for (int i = 0; i < LISA_SUMMARY_SIZE_BUCKETS; i++) {
+        totals->size_histogram[i] += (uint64_t)summary->size_histogram[i];
+    }
+    for (int i = 0; i < LISA_SUMMARY_RATIO_BUCKETS; i++) {
+        totals->ratio_histogram[i] += (uint64_t)summary->ratio_histogram[i];
+    }
+}
+
+
+LISA_SOURCE_END
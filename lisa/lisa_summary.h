@@ -0,0 +1,121 @@
+//  lisa_summary.h
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#ifndef __LISA__SUMMARY__H__
+#define __LISA__SUMMARY__H__
+
+#include "lisa_defines.h"
+#include "lisa_types.h"
+
+#include "lisa_objio.h"
+
+LISA_HEADER_BEGIN
+
+
+/*! Number of buckets in a summary's size histogram, one per power of 2. */
+#define LISA_SUMMARY_SIZE_BUCKETS	32
+
+/*! Number of buckets in a summary's compression ratio histogram. */
+#define LISA_SUMMARY_RATIO_BUCKETS	11
+
+
+/*! Summary of a single segment (module with code) in an object file. */
+struct lisa_segment_summary {
+    char				module_name[9];
+    char				segment_name[9];
+    lisa_MemAddr		addr;
+    bool				packed;			//!< whether the code is in a PackedCode block
+    lisa_longint		packed_size;	//!< size of the code as stored in the file
+    lisa_longint		unpacked_size;	//!< size of the code once unpacked
+};
+typedef struct lisa_segment_summary lisa_segment_summary;
+
+
+/*!
+    Summary of an object file, gathered from block headers and fixed
+    fields only; code is never unpacked.
+ */
+struct lisa_objfile_summary {
+    lisa_longint		file_size;
+    lisa_integer		block_count;
+    lisa_integer		block_type_counts[256];	//!< indexed by `lisa_obj_block_type`
+    lisa_integer		module_count;
+    lisa_integer		entry_count;			//!< EntryPoint symbols
+    lisa_integer		external_count;			//!< External and ShortExternal symbols
+    lisa_longint		reference_count;		//!< references from externals and relocations
+    lisa_integer		unit_count;
+    lisa_longint		code_packed_size;		//!< total code bytes as stored
+    lisa_longint		code_unpacked_size;		//!< total code bytes once unpacked
+
+    /*! Segments by unpacked size; bucket `n` holds sizes in [2^n, 2^(n+1)), and bucket 0 holds 0 too. */
+    lisa_integer		size_histogram[LISA_SUMMARY_SIZE_BUCKETS];
+
+    /*! Packed segments by packed/unpacked ratio, in tenths; the last bucket is 100% and up. */
+    lisa_integer		ratio_histogram[LISA_SUMMARY_RATIO_BUCKETS];
+
+    lisa_integer		segment_count;
+    lisa_segment_summary	* LISA_NULLABLE segments;
+};
+typedef struct lisa_objfile_summary lisa_objfile_summary;
+
+
+/*!
+    Totals of the summaries of many object files. Unlike a single file's
+    summary, these are wide enough not to wrap however many files there
+    are.
+ */
+struct lisa_summary_totals {
+    uint64_t			file_count;
+    int64_t				file_size;
+    uint64_t			block_count;
+    uint64_t			block_type_counts[256];	//!< indexed by `lisa_obj_block_type`
+    uint64_t			module_count;
+    uint64_t			entry_count;
+    uint64_t			external_count;
+    int64_t				reference_count;
+    uint64_t			unit_count;
+    int64_t				code_packed_size;
+    int64_t				code_unpacked_size;
+    uint64_t			size_histogram[LISA_SUMMARY_SIZE_BUCKETS];
+    uint64_t			ratio_histogram[LISA_SUMMARY_RATIO_BUCKETS];
+    uint64_t			segment_count;
+};
+typedef struct lisa_summary_totals lisa_summary_totals;
+
+
+/*!
+    Summarize the object file \a of into \a summary.
+
+    - WARNING: Caller must free with `lisa_objfile_summary_free`.
+ */
+LISA_EXTERN
+int
+lisa_objfile_summarize(lisa_objfile *of, lisa_objfile_summary *summary);
+
+/*! Free the storage held by a summary, but not the summary itself. */
+LISA_EXTERN
+void
+lisa_objfile_summary_free(lisa_objfile_summary *summary);
+
+/*! Add \a summary of one more object file into \a totals. */
+LISA_EXTERN
+void
+lisa_summary_totals_add(lisa_summary_totals *totals, const lisa_objfile_summary *summary);
+
+/*! Get the size histogram bucket for a segment of \a size bytes. */
+LISA_EXTERN
+int
+lisa_summary_size_bucket(lisa_longint size);
+
+/*! Get the ratio histogram bucket for a segment packed from \a unpacked_size to \a packed_size bytes. */
+LISA_EXTERN
+int
+lisa_summary_ratio_bucket(lisa_longint packed_size, lisa_longint unpacked_size);
+
+
+LISA_HEADER_END
+
+#endif /* __LISA__SUMMARY__H__ */
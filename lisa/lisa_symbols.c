@@ -0,0 +1,249 @@
+//  lisa_symbols.c
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#include "lisa_symbols.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+LISA_SOURCE_BEGIN
+
+
+// MARK: - Internals
+
+/*! A single symbol, keyed by its blank-padded name. */
+struct lisa_symbol_entry {
+    uint64_t			key;			//!< 0 for an empty slot
+    lisa_MemAddr		address;
+};
+typedef struct lisa_symbol_entry lisa_symbol_entry;
+
+/*! An open-addressed hash table of symbols. */
+struct lisa_symbol_table {
+    lisa_symbol_entry	*entries;
+    size_t				capacity;		//!< always a power of 2
+    size_t				count;
+};
+
+
+/*! Get the key for \a name, blank-padded to 8 characters. */
+uint64_t
+lisa_symbol_key(const char *name, size_t max_length)
+{
+    char padded[8];
+    memset(padded, ' ', 8);
+    for (size_t i = 0; (i < max_length) && (i < 8); i++) {
+        if (name[i] == '\0') break;
+        padded[i] = name[i];
+    }
+
+    uint64_t key;
+    memcpy(&key, padded, 8);
+    return key;
+}
+
+
+/*! Hash a key into a table of the given (power of 2) capacity. */
+size_t
+lisa_symbol_slot(uint64_t key, size_t capacity)
+{
+    return (size_t)((key * UINT64_C(0x9E3779B97F4A7C15)) >> 32) & (capacity - 1);
+}
+
+
+/*! Find the slot for \a key: either its entry, or the empty slot it would go in. */
+lisa_symbol_entry *
+lisa_symbol_table_find(const lisa_symbol_table *table, uint64_t key)
+{
+    size_t slot = lisa_symbol_slot(key, table->capacity);
+    while ((table->entries[slot].key != 0) && (table->entries[slot].key != key)) {
+        slot = (slot + 1) & (table->capacity - 1);
+    }
+    return &table->entries[slot];
+}
+
+
+/*! Double the table's capacity, rehashing every entry. */
+int
+lisa_symbol_table_grow(lisa_symbol_table *table)
+{
+    lisa_symbol_table grown = {
+        .entries = calloc(sizeof(lisa_symbol_entry), table->capacity * 2),
+        .capacity = table->capacity * 2,
+        .count = table->count,
+    };
+    if (grown.entries == NULL) return -1;
+
+    for (size_t e = 0; e < table->capacity; e++) {
+        if (table->entries[e].key == 0) continue;
+        *lisa_symbol_table_find(&grown, table->entries[e].key) = table->entries[e];
+    }
+
+    free(table->entries);
+    *table = grown;
+    return 0;
+}
+
+
+int
+lisa_symbol_table_add_key(lisa_symbol_table *table, uint64_t key, lisa_MemAddr address)
+{
+    // Keep the table at most half full, so probes stay short.
+
+    if ((table->count + 1) * 2 > table->capacity) {
+        int grow_err = lisa_symbol_table_grow(table);
+        if (grow_err == -1) return -1;
+    }
+
+    lisa_symbol_entry *entry = lisa_symbol_table_find(table, key);
+    if (entry->key == 0) {
+        entry->key = key;
+        table->count += 1;
+    }
+    entry->address = address;
+    return 0;
+}
+
+
+bool
+lisa_symbol_table_lookup_key(const lisa_symbol_table *table, uint64_t key, lisa_MemAddr *address)
+{
+    lisa_symbol_entry *entry = lisa_symbol_table_find(table, key);
+    if (entry->key == 0) return false;
+
+    *address = entry->address;
+    return true;
+}
+
+
+// MARK: - Symbol Tables
+
+lisa_symbol_table * LISA_NULLABLE
+lisa_symbol_table_create(void)
+{
+    lisa_symbol_table *table = calloc(sizeof(lisa_symbol_table), 1);
+    if (table == NULL) return NULL;
+
+    table->capacity = 64;
+    table->entries = calloc(sizeof(lisa_symbol_entry), table->capacity);
+    if (table->entries == NULL) {
+        free(table);
+        return NULL;
+    }
+
+    return table;
+}
+
+
+void
+lisa_symbol_table_free(lisa_symbol_table * LISA_NULLABLE table)
+{
+    if (table) {
+        free(table->entries);
+        free(table);
+    }
+}
+
+
+int
+lisa_symbol_table_add(lisa_symbol_table *table, const char *name, lisa_MemAddr address)
+{
+    if ((name[0] == '\0') || (strlen(name) > 8)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return lisa_symbol_table_add_key(table, lisa_symbol_key(name, 8), address);
+}
+
+
+int
+lisa_symbol_table_add_ObjName(lisa_symbol_table *table, const lisa_ObjName name, lisa_MemAddr address)
+{
+    return lisa_symbol_table_add_key(table, lisa_symbol_key(name, 8), address);
+}
+
+
+bool
+lisa_symbol_table_lookup(const lisa_symbol_table *table, const char *name, lisa_MemAddr *address)
+{
+    if (strlen(name) > 8) return false;
+
+    return lisa_symbol_table_lookup_key(table, lisa_symbol_key(name, 8), address);
+}
+
+
+bool
+lisa_symbol_table_lookup_ObjName(const lisa_symbol_table *table, const lisa_ObjName name,
+                                 lisa_MemAddr *address)
+{
+    return lisa_symbol_table_lookup_key(table, lisa_symbol_key(name, 8), address);
+}
+
+
+size_t
+lisa_symbol_table_count(const lisa_symbol_table *table)
+{
+    return table->count;
+}
+
+
+int
+lisa_symbol_table_read(lisa_symbol_table *table, FILE *f, size_t * LISA_NULLABLE line)
+{
+    int result = -1;
+    char *text = NULL;
+    size_t text_capacity = 0;
+    size_t line_number = 0;
+
+    while (getline(&text, &text_capacity, f) != -1) {
+        line_number += 1;
+
+        char *name = text;
+        while (isspace((unsigned char)*name)) name++;
+        if ((*name == '\0') || (*name == '#')) continue;
+
+        char *name_end = name;
+        while ((*name_end != '\0') && !isspace((unsigned char)*name_end)) name_end++;
+        if (*name_end == '\0') goto invalid;
+        *name_end = '\0';
+
+        char *value = name_end + 1;
+        while (isspace((unsigned char)*value)) value++;
+
+        const char *digits = (value[0] == '$') ? &value[1] : value;
+        int base = (value[0] == '$') ? 16 : 0;
+        char *end = NULL;
+
+        errno = 0;
+        long long address = strtoll(digits, &end, base);
+        if ((errno != 0) || (end == digits)) goto invalid;
+        while (isspace((unsigned char)*end)) end++;
+        if ((*end != '\0') || (address < INT32_MIN) || (address > UINT32_MAX)) goto invalid;
+
+        int add_err = lisa_symbol_table_add(table, name, (lisa_MemAddr)(uint32_t)address);
+        if (add_err == -1) goto invalid;
+    }
+
+    if (ferror(f)) goto done;
+
+    result = 0;
+    goto done;
+
+invalid:
+    if (line) *line = line_number;
+    errno = EINVAL;
+
+done:
+    free(text);
+    return result;
+}
+
+
+LISA_SOURCE_END
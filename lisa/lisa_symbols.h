@@ -0,0 +1,81 @@
+//  lisa_symbols.h
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#ifndef __LISA__SYMBOLS__H__
+#define __LISA__SYMBOLS__H__
+
+#include <stdio.h>
+
+#include "lisa_defines.h"
+#include "lisa_types.h"
+
+LISA_HEADER_BEGIN
+
+
+/*!
+    A map from link names to addresses, for resolving references to
+    external symbols. Names are compared as the linker does, blank-padded
+    to 8 characters and case-sensitive. (Opaque!)
+ */
+struct lisa_symbol_table;
+typedef struct lisa_symbol_table lisa_symbol_table;
+
+
+/*! Create an empty symbol table. */
+LISA_EXTERN
+lisa_symbol_table * LISA_NULLABLE
+lisa_symbol_table_create(void);
+
+/*! Free the given symbol table. */
+LISA_EXTERN
+void
+lisa_symbol_table_free(lisa_symbol_table * LISA_NULLABLE table);
+
+/*!
+    Set the address of the symbol \a name, a C string of up to 8
+    characters, replacing any address it already had.
+ */
+LISA_EXTERN
+int
+lisa_symbol_table_add(lisa_symbol_table *table, const char *name, lisa_MemAddr address);
+
+/*! Set the address of the symbol with the blank-padded \a name. */
+LISA_EXTERN
+int
+lisa_symbol_table_add_ObjName(lisa_symbol_table *table, const lisa_ObjName name, lisa_MemAddr address);
+
+/*! Look up the address of the symbol \a name, a C string. */
+LISA_EXTERN
+bool
+lisa_symbol_table_lookup(const lisa_symbol_table *table, const char *name, lisa_MemAddr *address);
+
+/*! Look up the address of the symbol with the blank-padded \a name. */
+LISA_EXTERN
+bool
+lisa_symbol_table_lookup_ObjName(const lisa_symbol_table *table, const lisa_ObjName name,
+                                 lisa_MemAddr *address);
+
+/*! Get the number of symbols in the table. */
+LISA_EXTERN
+size_t
+lisa_symbol_table_count(const lisa_symbol_table *table);
+
+/*!
+    Add the symbols listed in \a f, one per line as a name followed by
+    an address in decimal, `0x` hex or `$` hex. Blank lines and lines
+    starting with `#` are ignored.
+
+    Returns -1 with errno set to EINVAL, and \a line set to the
+    offending line number, if a line can't be parsed.
+ */
+LISA_EXTERN
+int
+lisa_symbol_table_read(lisa_symbol_table *table, FILE *f, size_t * LISA_NULLABLE line);
+
+
+LISA_HEADER_END
+
+#endif /* __LISA__SYMBOLS__H__ */
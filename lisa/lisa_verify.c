@@ -0,0 +1,451 @@
+//  lisa_verify.c
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#include "lisa_verify.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "thread_pool.h"
+
+
+LISA_SOURCE_BEGIN
+
+
+// MARK: - Internals
+
+/*! The most problems a single PackedCode block can have. */
+#define LISA_VERIFY_BLOCK_PROBLEMS	2
+
+
+/*! Per-worker state, so buffers are reused across blocks. */
+struct lisa_verify_worker {
+    uint8_t				* LISA_NULLABLE unpacked;
+    size_t				unpacked_capacity;
+    uint8_t				* LISA_NULLABLE packed;
+    size_t				packed_capacity;
+};
+typedef struct lisa_verify_worker lisa_verify_worker;
+
+/*! State shared by every block verification of a single file. */
+struct lisa_verify_job {
+    lisa_objfile		*objfile;
+    lisa_PackTable		* LISA_NULLABLE table;	//!< the file's own, or NULL for the default
+    bool				no_repack;
+    lisa_verify_worker	* LISA_NULLABLE workers;
+};
+typedef struct lisa_verify_job lisa_verify_job;
+
+/*! A single PackedCode block to verify, as submitted to the thread pool. */
+struct lisa_verify_task {
+    lisa_verify_job		*job;
+    lisa_integer		block;
+    size_t				packed_size;
+    size_t				unpacked_size;
+    bool				unpacked;		//!< whether the code unpacked at all
+    lisa_verify_result	results[LISA_VERIFY_BLOCK_PROBLEMS];
+    size_t				result_count;
+    int					error;			//!< errno if verification couldn't be done, or 0
+};
+typedef struct lisa_verify_task lisa_verify_task;
+
+
+/*! Make sure \a buffer can hold \a size bytes. */
+int
+lisa_verify_reserve(uint8_t * LISA_NULLABLE * LISA_NONNULL buffer, size_t *capacity, size_t size)
+{
+    if (*capacity >= size) return 0;
+
+    uint8_t *grown = realloc(*buffer, size);
+    if (grown == NULL) return -1;
+    *buffer = grown;
+    *capacity = size;
+    return 0;
+}
+
+
+/*! Set up a result for a problem in \a block. */
+lisa_verify_result
+lisa_verify_result_make(lisa_objfile *of, lisa_integer b, lisa_verify_problem problem,
+                        int64_t expected, int64_t actual)
+{
+    lisa_objfile_block *block = lisa_objfile_block_at_index(of, b);
+    lisa_verify_result result = {
+        .problem = problem,
+        .type = lisa_objfile_block_type(block),
+        .block = b,
+        .offset = lisa_objfile_block_offset(block),
+        .entry = -1,
+        .expected = expected,
+        .actual = actual,
+    };
+
+    lisa_segment segment;
+    if (lisa_objfile_segment_at_offset(of, result.offset, &segment) == 0) {
+        memcpy(result.name, segment.name, sizeof(result.name));
+    }
+
+    return result;
+}
+
+
+/*! Record a problem found in a task's block. */
+void
+lisa_verify_task_add(lisa_verify_task *task, lisa_verify_problem problem, int64_t expected, int64_t actual)
+{
+    if (task->result_count == LISA_VERIFY_BLOCK_PROBLEMS) return;
+    task->results[task->result_count++] = lisa_verify_result_make(task->job->objfile, task->block,
+                                                                  problem, expected, actual);
+}
+
+
+/*! Unpack and repack a single PackedCode block using the given worker's buffers. */
+void
+lisa_verify_block(lisa_verify_job *job, lisa_verify_task *task, lisa_verify_worker *worker)
+{
+    lisa_objfile_block *block = lisa_objfile_block_at_index(job->objfile, task->block);
+
+    uint8_t *code;
+    lisa_longint code_size, csize;
+    lisa_MemAddr addr;
+    lisa_objfile_block_get_code(block, &code, &code_size, &csize, &addr);
+    task->packed_size = (size_t)code_size;
+
+    // Every word takes at least a byte of packed code, so it can't
+    // unpack to more than twice its size; unpacking into that much room
+    // finds out how big it really is, even if csize is wrong.
+
+    size_t capacity = (size_t)code_size * 2;
+    if ((csize > 0) && ((size_t)csize > capacity)) capacity = (size_t)csize;
+    capacity = (capacity + 1) & ~(size_t)1;
+    if (capacity == 0) capacity = 2;
+
+    if (lisa_verify_reserve(&worker->unpacked, &worker->unpacked_capacity, capacity) == -1) {
+        task->error = errno;
+        return;
+    }
+
+    lisa_longint unpacked_size = (lisa_longint)capacity;
+    int unpack_err = lisa_unpackcode(code, code_size, worker->unpacked, &unpacked_size, job->table);
+    if (unpack_err != 0) {
+        lisa_verify_task_add(task, lisa_verify_unpack_failed, csize, -1);
+        return;
+    }
+
+    task->unpacked = true;
+    task->unpacked_size = (size_t)unpacked_size;
+    if (unpacked_size != csize) {
+        lisa_verify_task_add(task, lisa_verify_unpacked_size, csize, unpacked_size);
+    }
+
+    if (job->no_repack) return;
+
+    size_t packed_capacity = lisa_packcode_max_size((size_t)unpacked_size);
+    if (lisa_verify_reserve(&worker->packed, &worker->packed_capacity, packed_capacity) == -1) {
+        task->error = errno;
+        return;
+    }
+
+    lisa_longint packed_size = (lisa_longint)packed_capacity;
+    int pack_err = lisa_packcode(worker->packed, &packed_size, worker->unpacked, unpacked_size, job->table);
+    if ((pack_err != 0) || (packed_size != code_size)
+        || (memcmp(worker->packed, code, (size_t)code_size) != 0))
+    {
+        lisa_verify_task_add(task, lisa_verify_repack_differs, code_size, (pack_err != 0) ? -1 : packed_size);
+    }
+}
+
+
+/*! Verify a single PackedCode block; runs on a worker thread. */
+void
+lisa_verify_block_task(void * LISA_NULLABLE context, size_t worker_index)
+{
+    lisa_verify_task *task = context;
+    lisa_verify_block(task->job, task, &task->job->workers[worker_index]);
+}
+
+
+/*! What's needed to report problems once every block has been checked. */
+struct lisa_verify_report {
+    lisa_objfile		*objfile;
+    lisa_verify_task	*tasks;			//!< in block order
+    size_t				task_count;
+    lisa_verify_fn		fn;
+    void				* LISA_NULLABLE context;
+    lisa_verify_stats	stats;
+};
+typedef struct lisa_verify_report lisa_verify_report;
+
+
+/*! Report a problem, counting it. */
+void
+lisa_verify_report_problem(lisa_verify_report *report, const lisa_verify_result *result)
+{
+    report->stats.problems += 1;
+    report->fn(result, report->context);
+}
+
+
+/*!
+    Get the size \a segment's code actually unpacked to, falling back to
+    the size its code says it unpacks to if that couldn't be found.
+ */
+lisa_longint
+lisa_verify_segment_unpacked_size(lisa_verify_report *report, const lisa_segment *segment)
+{
+    const lisa_objfile_module *module = lisa_objfile_module_at_index(report->objfile, segment->module);
+    if (!segment->packed || (module == NULL)) return segment->unpacked_size;
+
+    size_t lo = 0, hi = report->task_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (report->tasks[mid].block < module->code_block) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    if ((lo < report->task_count) && (report->tasks[lo].block == module->code_block) && report->tasks[lo].unpacked) {
+        return (lisa_longint)report->tasks[lo].unpacked_size;
+    }
+    return segment->unpacked_size;
+}
+
+
+/*!
+    Check a segment table entry's location and sizes against the segment
+    it leads to, reporting any problems.
+ */
+void
+lisa_verify_location(lisa_verify_report *report, lisa_integer b, lisa_integer entry,
+                     lisa_FileAddr location, lisa_integer size_packed, lisa_integer size_unpacked,
+                     const char * LISA_NULLABLE name)
+{
+    lisa_objfile *of = report->objfile;
+    lisa_verify_result result = lisa_verify_result_make(of, b, lisa_verify_location_missing, location, -1);
+    result.entry = entry;
+    if (name) memcpy(result.name, name, sizeof(result.name));
+    report->stats.locations += 1;
+
+    lisa_segment segment;
+    if (lisa_objfile_segment_at_offset(of, location, &segment) == -1) {
+        lisa_verify_report_problem(report, &result);
+        return;
+    }
+    if (name == NULL) memcpy(result.name, segment.name, sizeof(result.name));
+
+    // Sizes are 16-bit fields, but segments can be up to 64KB.
+
+    if ((lisa_longint)(uint16_t)size_packed != segment.code_size) {
+        result.problem = lisa_verify_location_packed_size;
+        result.expected = (uint16_t)size_packed;
+        result.actual = segment.code_size;
+        lisa_verify_report_problem(report, &result);
+    }
+
+    lisa_longint unpacked_size = lisa_verify_segment_unpacked_size(report, &segment);
+    if ((lisa_longint)(uint16_t)size_unpacked != unpacked_size) {
+        result.problem = lisa_verify_location_unpacked_size;
+        result.expected = (uint16_t)size_unpacked;
+        result.actual = unpacked_size;
+        lisa_verify_report_problem(report, &result);
+    }
+}
+
+
+/*! Check every entry of a SegLocation or Executable block's tables. */
+void
+lisa_verify_tables(lisa_verify_report *report, lisa_integer b)
+{
+    lisa_objfile *of = report->objfile;
+    lisa_objfile_block *block = lisa_objfile_block_at_index(of, b);
+    lisa_objfile_content content = lisa_objfile_block_content(block);
+
+    if (lisa_objfile_block_type(block) == SegLocation) {
+        lisa_SegLocation *seglocation = content.SegLocation;
+        for (lisa_integer i = 0; i < seglocation->nSegments; i++) {
+            lisa_SegLocVariant *variant = &seglocation->variants[i];
+            if (variant->FileNumber != 0) continue;	// held in another file
+
+            char name[9];
+            lisa_ObjName_get_cstring(name, variant->SegName);
+
+            lisa_verify_location(report, b, i, variant->FileLocation,
+                                 variant->SizePacked, variant->SizeUnpacked, name);
+        }
+        return;
+    }
+
+    lisa_Executable *executable = content.Executable;
+    lisa_JTSegVariantTable *jtsegs = lisa_Executable_JTSegVariantTable(executable);
+    for (lisa_integer i = 0; i < jtsegs->numSegs; i++) {
+        lisa_JTSegVariant *variant = &jtsegs->variants[i];
+        lisa_verify_location(report, b, i, variant->SegmentAddr,
+                             variant->SizePacked, variant->SizeUnpacked, NULL);
+    }
+
+    lisa_JTVariantTable *jtvariants = lisa_Executable_JTVariantTable(executable);
+    int64_t descriptors_size = (int64_t)(jtvariants->numDescriptors > 0 ? jtvariants->numDescriptors : 0)
+                               * (int64_t)sizeof(lisa_JTVariant);
+    if (executable->JTSize != descriptors_size) {
+        lisa_verify_result result = lisa_verify_result_make(of, b, lisa_verify_jump_table_size,
+                                                            executable->JTSize, descriptors_size);
+        result.name[0] = '\0';
+        lisa_verify_report_problem(report, &result);
+    }
+}
+
+
+/*! Run every task, spread across the given number of threads. */
+int
+lisa_verify_run(lisa_verify_job *job, lisa_verify_task *tasks, size_t count, size_t thread_count)
+{
+    if (thread_count > count) thread_count = count;
+
+    if (thread_count <= 1) {
+        lisa_verify_worker worker = { 0 };
+        for (size_t t = 0; t < count; t++) {
+            lisa_verify_block(job, &tasks[t], &worker);
+        }
+        free(worker.unpacked);
+        free(worker.packed);
+        return 0;
+    }
+
+    job->workers = calloc(sizeof(lisa_verify_worker), thread_count);
+    if (job->workers == NULL) return -1;
+
+    thread_pool *pool = thread_pool_create(thread_count);
+    if (pool == NULL) {
+        free(job->workers);
+        job->workers = NULL;
+        return -1;
+    }
+
+    for (size_t t = 0; t < count; t++) {
+        int submit_err = thread_pool_submit(pool, lisa_verify_block_task, &tasks[t]);
+        if (submit_err == -1) tasks[t].error = ENOMEM;
+    }
+
+    thread_pool_wait(pool);
+    thread_pool_free(pool);
+
+    for (size_t w = 0; w < thread_count; w++) {
+        free(job->workers[w].unpacked);
+        free(job->workers[w].packed);
+    }
+    free(job->workers);
+    job->workers = NULL;
+    return 0;
+}
+
+
+// MARK: - Verification
+
+const char *
+lisa_verify_problem_string(lisa_verify_problem problem)
+{
+    switch (problem) {
+        case lisa_verify_unpack_failed:				return "packed code doesn't unpack";
+        case lisa_verify_unpacked_size:				return "unpacked size differs from csize";
+        case lisa_verify_repack_differs:			return "unpacked code doesn't pack back the same";
+        case lisa_verify_location_missing:			return "file location isn't a segment";
+        case lisa_verify_location_packed_size:		return "SizePacked differs from the code as stored";
+        case lisa_verify_location_unpacked_size:	return "SizeUnpacked differs from the code unpacked";
+        case lisa_verify_jump_table_size:			return "JTSize differs from the descriptors";
+    }
+    return "unknown problem";
+}
+
+
+int
+lisa_objfile_verify(lisa_objfile *of, const lisa_verify_options * LISA_NULLABLE options,
+                    lisa_verify_fn fn, void * LISA_NULLABLE context,
+                    lisa_verify_stats * LISA_NULLABLE stats)
+{
+    lisa_verify_options default_options = { 0 };
+    if (options == NULL) options = &default_options;
+
+    lisa_verify_job job = {
+        .objfile = of,
+        .table = NULL,
+        .no_repack = options->no_repack,
+        .workers = NULL,
+    };
+
+    // Gather the PackedCode blocks up front, noting the file's own
+    // PackTable on the way, if it has one.
+
+    const lisa_integer block_count = lisa_objfile_block_count(of);
+    size_t task_count = 0;
+    for (lisa_integer b = 0; b < block_count; b++) {
+        lisa_objfile_block *block = lisa_objfile_block_at_index(of, b);
+        lisa_obj_block_type type = lisa_objfile_block_type(block);
+        if (type == PackedCode) task_count += 1;
+        if ((type == PackTable) && (job.table == NULL)) job.table = lisa_objfile_block_content(block).PackTable;
+    }
+
+    lisa_verify_task *tasks = calloc(sizeof(lisa_verify_task), task_count + 1);
+    if (tasks == NULL) return -1;
+
+    size_t t = 0;
+    for (lisa_integer b = 0; b < block_count; b++) {
+        if (lisa_objfile_block_type(lisa_objfile_block_at_index(of, b)) != PackedCode) continue;
+        tasks[t++] = (lisa_verify_task){ .job = &job, .block = b };
+    }
+
+    size_t thread_count = options->thread_count ? options->thread_count : thread_pool_default_thread_count();
+    if (lisa_verify_run(&job, tasks, task_count, thread_count) == -1) {
+        free(tasks);
+        return -1;
+    }
+
+    for (t = 0; t < task_count; t++) {
+        if (tasks[t].error != 0) {
+            errno = tasks[t].error;
+            free(tasks);
+            return -1;
+        }
+    }
+
+    // Then report everything in block order, checking the segment
+    // tables against what the blocks actually held as they come up.
+
+    lisa_verify_report report = {
+        .objfile = of,
+        .tasks = tasks,
+        .task_count = task_count,
+        .fn = fn,
+        .context = context,
+    };
+
+    t = 0;
+    for (lisa_integer b = 0; b < block_count; b++) {
+        lisa_obj_block_type type = lisa_objfile_block_type(lisa_objfile_block_at_index(of, b));
+
+        if ((type == SegLocation) || (type == Executable)) {
+            lisa_verify_tables(&report, b);
+        } else if (type == PackedCode) {
+            lisa_verify_task *task = &tasks[t++];
+            report.stats.packed_blocks += 1;
+            report.stats.packed_bytes += task->packed_size;
+            report.stats.unpacked_bytes += task->unpacked_size;
+            for (size_t r = 0; r < task->result_count; r++) {
+                lisa_verify_report_problem(&report, &task->results[r]);
+            }
+        }
+    }
+
+    free(tasks);
+
+    if (stats) *stats = report.stats;
+    return 0;
+}
+
+
+LISA_SOURCE_END
@@ -0,0 +1,103 @@
+//  lisa_verify.h
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#ifndef __LISA__VERIFY__H__
+#define __LISA__VERIFY__H__
+
+#include <stddef.h>
+
+#include "lisa_defines.h"
+#include "lisa_types.h"
+
+#include "lisa_objio.h"
+
+LISA_HEADER_BEGIN
+
+
+/*! A problem found by verifying an object file. */
+enum lisa_verify_problem: uint32_t {
+    lisa_verify_unpack_failed			= 0,	//!< packed code doesn't unpack at all
+    lisa_verify_unpacked_size			= 1,	//!< packed code unpacks to other than its csize
+    lisa_verify_repack_differs			= 2,	//!< unpacked code doesn't pack back to the same bytes
+    lisa_verify_location_missing		= 3,	//!< a table's file location doesn't lead to a segment
+    lisa_verify_location_packed_size	= 4,	//!< a table's SizePacked isn't the size of the code as stored
+    lisa_verify_location_unpacked_size	= 5,	//!< a table's SizeUnpacked isn't the size of the code unpacked
+    lisa_verify_jump_table_size			= 6,	//!< JTSize isn't the size of the descriptors
+};
+typedef enum lisa_verify_problem lisa_verify_problem;
+
+
+/*! A single problem, and where it was found. */
+struct lisa_verify_result {
+    lisa_verify_problem	problem;
+    lisa_obj_block_type	type;			//!< of the block it's in
+    lisa_integer		block;			//!< index of the block it's in
+    lisa_FileAddr		offset;			//!< of the block it's in
+    char				name[9];		//!< of the segment or module, if known
+    lisa_integer		entry;			//!< index into the block's table, or -1
+    int64_t				expected;		//!< what the file says, where there's a size
+    int64_t				actual;			//!< what was found instead
+};
+typedef struct lisa_verify_result lisa_verify_result;
+
+
+/*! How to verify an object file. */
+struct lisa_verify_options {
+    size_t				thread_count;	//!< worker threads to use, 0 for one per CPU
+    bool				no_repack;		//!< only check that packed code unpacks to its csize
+};
+typedef struct lisa_verify_options lisa_verify_options;
+
+
+/*! What verifying an object file checked, for reporting. */
+struct lisa_verify_stats {
+    size_t				packed_blocks;	//!< PackedCode blocks checked
+    size_t				packed_bytes;	//!< of code as stored in them
+    size_t				unpacked_bytes;	//!< of code once unpacked
+    size_t				locations;		//!< SegLocation and JTSegVariant entries checked
+    size_t				problems;
+};
+typedef struct lisa_verify_stats lisa_verify_stats;
+
+
+/*! Called by `lisa_objfile_verify` for each problem, in order. */
+typedef void (*lisa_verify_fn)(const lisa_verify_result *result, void * LISA_NULLABLE context);
+
+
+/*!
+    Verify the packed code and segment tables of \a of, calling \a fn
+    for each problem found.
+
+    Every PackedCode block is unpacked, using the file's own PackTable
+    if it has one, and must unpack to exactly its csize; unless the
+    options say otherwise, the unpacked code must then pack back to the
+    same bytes. Blocks are checked in parallel, each worker reusing its
+    buffers across blocks, and problems are reported in block order.
+
+    Every entry of the SegLocation block and of the Executable block's
+    segment table must lead to a segment, with SizePacked and
+    SizeUnpacked matching its code as stored and unpacked, and JTSize
+    must be the size of the jump table's descriptors.
+
+    Damaged code is reported rather than failing verification; this only
+    fails if there isn't enough memory. If \a stats is given, it's set
+    to what was checked.
+ */
+LISA_EXTERN
+int
+lisa_objfile_verify(lisa_objfile *of, const lisa_verify_options * LISA_NULLABLE options,
+                    lisa_verify_fn fn, void * LISA_NULLABLE context,
+                    lisa_verify_stats * LISA_NULLABLE stats);
+
+/*! Describe a problem, for reporting. */
+LISA_EXTERN
+const char *
+lisa_verify_problem_string(lisa_verify_problem problem);
+
+
+LISA_HEADER_END
+
+#endif /* __LISA__VERIFY__H__ */
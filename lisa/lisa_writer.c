@@ -0,0 +1,456 @@
+//  lisa_writer.c
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#include "lisa_writer.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "zero_copy.h"
+
+#include "lisa_stats.h"
+
+
+LISA_SOURCE_BEGIN
+
+
+// MARK: - Internals
+
+/*! The size encoded blocks are gathered up to before being written. */
+#define LISA_WRITER_STAGING_SIZE ((size_t)1 << 20)
+
+
+/*! A block to be written. */
+struct lisa_objfile_writer_block {
+    lisa_objfile_block	* LISA_NULLABLE original;	//!< the block in the object file, if any
+    lisa_obj_block_type	type;
+    void				* LISA_NULLABLE content;	//!< replacement content, native-endian
+    lisa_longint		size;						//!< total size including 4-byte header
+    bool				modified;					//!< whether it must be encoded again
+    lisa_FileAddr		offset;						//!< of its header in the output, once laid out
+};
+typedef struct lisa_objfile_writer_block lisa_objfile_writer_block;
+
+struct lisa_objfile_writer {
+    lisa_objfile		* LISA_NULLABLE objfile;
+
+    lisa_objfile_writer_block	* LISA_NULLABLE blocks;
+    lisa_integer		block_count;
+    lisa_integer		block_capacity;
+
+    bool				laid_out;		//!< whether the blocks' offsets are current
+    size_t				size;			//!< through the EOFMark, once laid out
+};
+
+/*! Encoded blocks waiting to be written to a contiguous range of the output. */
+struct lisa_objfile_writer_staging {
+    uint8_t				* LISA_NULLABLE data;
+    size_t				used;
+    size_t				capacity;
+    off_t				offset;			//!< of the first staged byte in the output
+};
+typedef struct lisa_objfile_writer_staging lisa_objfile_writer_staging;
+
+
+/*! Make sure \a writer has room for another block. */
+int
+lisa_objfile_writer_reserve(lisa_objfile_writer *writer)
+{
+    if (writer->block_count < writer->block_capacity) return 0;
+
+    lisa_integer new_capacity = writer->block_capacity ? writer->block_capacity * 2 : 64;
+    lisa_objfile_writer_block *blocks = realloc(writer->blocks, sizeof(lisa_objfile_writer_block) * (size_t)new_capacity);
+    if (blocks == NULL) return -1;
+    writer->blocks = blocks;
+    writer->block_capacity = new_capacity;
+    return 0;
+}
+
+
+/*! Make a copy of a block's content, checking that it fits its size field. */
+void * LISA_NULLABLE
+lisa_objfile_writer_copy_content(const void *content, lisa_longint content_size)
+{
+    if ((content_size < 0) || (content_size > 0xFFFFFF - 4)) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    // Always allocate something, so empty content isn't mistaken for none.
+    void *copy = malloc((content_size > 0) ? (size_t)content_size : 1);
+    if (copy == NULL) return NULL;
+
+    if (content_size > 0) memcpy(copy, content, (size_t)content_size);
+    return copy;
+}
+
+
+/*! Assign each block its offset in the output. */
+void
+lisa_objfile_writer_lay_out(lisa_objfile_writer *writer)
+{
+    if (writer->laid_out) return;
+
+    size_t offset = 0;
+    for (lisa_integer b = 0; b < writer->block_count; b++) {
+        writer->blocks[b].offset = (lisa_FileAddr)offset;
+        offset += (size_t)writer->blocks[b].size;
+    }
+
+    writer->size = offset + 4; // EOFMark
+    writer->laid_out = true;
+}
+
+
+/*! Whether the block can be copied straight from the original file. */
+bool
+lisa_objfile_writer_block_is_untouched(const lisa_objfile_writer_block *block)
+{
+    return (block->original != NULL) && (block->content == NULL) && !block->modified;
+}
+
+
+/*! Write out everything staged so far. */
+int
+lisa_objfile_writer_flush(lisa_objfile_writer_staging *staging, int fd)
+{
+    uint64_t write_start = lisa_stats_begin();
+
+    size_t written = 0;
+    while (written < staging->used) {
+        ssize_t n = pwrite(fd, &staging->data[written], staging->used - written, staging->offset + (off_t)written);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        written += (size_t)n;
+    }
+
+    lisa_stats_end(lisa_stats_write, write_start, staging->used, 0);
+
+    staging->offset += (off_t)staging->used;
+    staging->used = 0;
+    return 0;
+}
+
+
+/*!
+    Encode a block at \a offset in the output into the staging buffer,
+    writing out what's already staged first if the block won't fit or
+    doesn't follow it.
+ */
+int
+lisa_objfile_writer_stage(lisa_objfile_writer_staging *staging, int fd, off_t offset,
+                          lisa_obj_block_type type, const void *content, lisa_longint size)
+{
+    if ((staging->used > 0)
+        && ((staging->used + (size_t)size > staging->capacity)
+            || (staging->offset + (off_t)staging->used != offset)))
+    {
+        int flush_err = lisa_objfile_writer_flush(staging, fd);
+        if (flush_err == -1) return -1;
+    }
+
+    // Blocks can be bigger than the usual staging size.
+
+    if ((size_t)size > staging->capacity) {
+        uint8_t *data = realloc(staging->data, (size_t)size);
+        if (data == NULL) return -1;
+        staging->data = data;
+        staging->capacity = (size_t)size;
+    }
+
+    if (staging->used == 0) staging->offset = offset;
+
+    int encode_err = lisa_obj_block_encode(type, content, size - 4, &staging->data[staging->used]);
+    if (encode_err == -1) return -1;
+
+    staging->used += (size_t)size;
+    return 0;
+}
+
+
+/*! Write every block, the EOFMark and the padding to \a fd. */
+int
+lisa_objfile_writer_write_blocks(lisa_objfile_writer *writer, int fd, int original_fd,
+                                 lisa_objfile_writer_stats *stats)
+{
+    int result = -1;
+    lisa_objfile_writer_staging staging = { 0 };
+
+    staging.data = malloc(LISA_WRITER_STAGING_SIZE);
+    if (staging.data == NULL) goto done;
+    staging.capacity = LISA_WRITER_STAGING_SIZE;
+
+    for (lisa_integer b = 0; b < writer->block_count; b++) {
+        const lisa_objfile_writer_block *block = &writer->blocks[b];
+
+        // Untouched blocks that were contiguous in the original file are
+        // still contiguous, so each run of them is copied all at once.
+
+        if ((original_fd != -1) && lisa_objfile_writer_block_is_untouched(block)) {
+            lisa_FileAddr original_offset = lisa_objfile_block_offset(block->original);
+            size_t run_size = (size_t)block->size;
+            size_t run_count = 1;
+
+            while (b + 1 < writer->block_count) {
+                const lisa_objfile_writer_block *next = &writer->blocks[b + 1];
+                if (!lisa_objfile_writer_block_is_untouched(next)) break;
+                if ((size_t)lisa_objfile_block_offset(next->original) != (size_t)original_offset + run_size) break;
+
+                run_size += (size_t)next->size;
+                run_count += 1;
+                b += 1;
+            }
+
+            int flush_err = lisa_objfile_writer_flush(&staging, fd);
+            if (flush_err == -1) goto done;
+
+            uint64_t copy_start = lisa_stats_begin();
+            int copy_err = zero_copy_file_range(fd, (off_t)block->offset, original_fd, (off_t)original_offset, run_size);
+            if (copy_err == -1) goto done;
+            lisa_stats_end(lisa_stats_write, copy_start, run_size, 0);
+
+            stats->blocks_copied += run_count;
+            stats->bytes_copied += run_size;
+            continue;
+        }
+
+        const void *content = block->content;
+        if (content == NULL) content = lisa_objfile_block_content(block->original).data;
+
+        int stage_err = lisa_objfile_writer_stage(&staging, fd, (off_t)block->offset, block->type, content, block->size);
+        if (stage_err == -1) goto done;
+
+        stats->blocks_encoded += 1;
+        stats->bytes_encoded += (size_t)block->size;
+    }
+
+    int eof_err = lisa_objfile_writer_stage(&staging, fd, (off_t)(writer->size - 4), EOFMark, "", 4);
+    if (eof_err == -1) goto done;
+    stats->blocks_encoded += 1;
+    stats->bytes_encoded += 4;
+
+    int flush_err = lisa_objfile_writer_flush(&staging, fd);
+    if (flush_err == -1) goto done;
+
+    // The padding is left for the file system to fill with zeroes.
+
+    stats->file_size = (writer->size + (LISA_WRITER_PAGE_SIZE - 1)) & ~(size_t)(LISA_WRITER_PAGE_SIZE - 1);
+    int truncate_err = ftruncate(fd, (off_t)stats->file_size);
+    if (truncate_err == -1) goto done;
+
+    result = 0;
+
+done:
+    free(staging.data);
+    return result;
+}
+
+
+// MARK: - Writing
+
+lisa_objfile_writer * LISA_NULLABLE
+lisa_objfile_writer_create(lisa_objfile * LISA_NULLABLE of)
+{
+    lisa_objfile_writer *writer = calloc(sizeof(lisa_objfile_writer), 1);
+    if (writer == NULL) return NULL;
+
+    writer->objfile = of;
+
+    if (of) {
+        const lisa_integer block_count = lisa_objfile_block_count(of);
+        for (lisa_integer b = 0; b < block_count; b++) {
+            lisa_objfile_block *original = lisa_objfile_block_at_index(of, b);
+            if (lisa_objfile_block_type(original) == EOFMark) break;
+
+            if (lisa_objfile_writer_reserve(writer) == -1) goto error;
+            writer->blocks[writer->block_count++] = (lisa_objfile_writer_block){
+                .original = original,
+                .type = lisa_objfile_block_type(original),
+                .size = lisa_objfile_block_size(original),
+            };
+        }
+    }
+
+    return writer;
+
+error:
+    lisa_objfile_writer_free(writer);
+    return NULL;
+}
+
+
+void
+lisa_objfile_writer_free(lisa_objfile_writer * LISA_NULLABLE writer)
+{
+    if (writer) {
+        for (lisa_integer b = 0; b < writer->block_count; b++) {
+            free(writer->blocks[b].content);
+        }
+        free(writer->blocks);
+        free(writer);
+    }
+}
+
+
+lisa_integer
+lisa_objfile_writer_block_count(lisa_objfile_writer *writer)
+{
+    return writer->block_count;
+}
+
+
+int
+lisa_objfile_writer_replace_block(lisa_objfile_writer *writer, lisa_integer index,
+                                  lisa_obj_block_type type,
+                                  const void *content, lisa_longint content_size)
+{
+    if ((index < 0) || (index >= writer->block_count)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    void *copy = lisa_objfile_writer_copy_content(content, content_size);
+    if (copy == NULL) return -1;
+
+    lisa_objfile_writer_block *block = &writer->blocks[index];
+    free(block->content);
+    block->type = type;
+    block->content = copy;
+    block->size = content_size + 4;
+    block->modified = true;
+
+    writer->laid_out = false;
+    return 0;
+}
+
+
+int
+lisa_objfile_writer_mark_modified(lisa_objfile_writer *writer, lisa_integer index)
+{
+    if ((index < 0) || (index >= writer->block_count)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    writer->blocks[index].modified = true;
+    return 0;
+}
+
+
+lisa_integer
+lisa_objfile_writer_append_block(lisa_objfile_writer *writer,
+                                 lisa_obj_block_type type,
+                                 const void *content, lisa_longint content_size)
+{
+    if (lisa_objfile_writer_reserve(writer) == -1) return -1;
+
+    void *copy = lisa_objfile_writer_copy_content(content, content_size);
+    if (copy == NULL) return -1;
+
+    writer->blocks[writer->block_count] = (lisa_objfile_writer_block){
+        .type = type,
+        .content = copy,
+        .size = content_size + 4,
+        .modified = true,
+    };
+
+    writer->laid_out = false;
+    return writer->block_count++;
+}
+
+
+lisa_FileAddr
+lisa_objfile_writer_block_offset(lisa_objfile_writer *writer, lisa_integer index)
+{
+    if ((index < 0) || (index >= writer->block_count)) return -1;
+
+    lisa_objfile_writer_lay_out(writer);
+    return writer->blocks[index].offset;
+}
+
+
+int
+lisa_objfile_writer_write(lisa_objfile_writer *writer, const char *path,
+                          const char * LISA_NULLABLE original_path,
+                          lisa_objfile_writer_stats * LISA_NULLABLE stats)
+{
+    int result = -1;
+    int write_errno = 0;
+    int fd = -1;
+    int original_fd = -1;
+    bool created = false;
+    char *temporary_path = NULL;
+    lisa_objfile_writer_stats write_stats = { 0 };
+
+    lisa_objfile_writer_lay_out(writer);
+    if (writer->size > INT32_MAX) {
+        errno = EINVAL;
+        goto done;
+    }
+
+    // Make sure the original file is the one the blocks came from, since
+    // their offsets are taken on trust.
+
+    if (original_path && writer->objfile) {
+        original_fd = open(original_path, O_RDONLY);
+        if (original_fd == -1) goto done;
+
+        struct stat st;
+        int stat_err = fstat(original_fd, &st);
+        if (stat_err == -1) goto done;
+
+        if ((uint64_t)st.st_size != (uint64_t)lisa_objfile_size(writer->objfile)) {
+            errno = EINVAL;
+            goto done;
+        }
+    }
+
+    size_t temporary_path_size = strlen(path) + 5;
+    temporary_path = malloc(temporary_path_size);
+    if (temporary_path == NULL) goto done;
+    snprintf(temporary_path, temporary_path_size, "%s.tmp", path);
+
+    fd = open(temporary_path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd == -1) goto done;
+    created = true;
+
+    int write_err = lisa_objfile_writer_write_blocks(writer, fd, original_fd, &write_stats);
+    if (write_err == -1) goto done;
+
+    int close_err = close(fd);
+    fd = -1;
+    if (close_err == -1) goto done;
+
+    int rename_err = rename(temporary_path, path);
+    if (rename_err == -1) goto done;
+    created = false;
+
+    if (stats) *stats = write_stats;
+    result = 0;
+
+done:
+    write_errno = errno;
+
+    if (fd != -1) close(fd);
+    if (original_fd != -1) close(original_fd);
+
+    // Don't leave a partial file behind.
+    if ((result == -1) && created) unlink(temporary_path);
+    free(temporary_path);
+
+    errno = write_errno;
+    return result;
+}
+
+
+LISA_SOURCE_END
@@ -0,0 +1,132 @@
+//  lisa_writer.h
+//  Part of LisaUtils.
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#ifndef __LISA__WRITER__H__
+#define __LISA__WRITER__H__
+
+#include <stddef.h>
+
+#include "lisa_defines.h"
+#include "lisa_types.h"
+
+#include "lisa_objio.h"
+
+LISA_HEADER_BEGIN
+
+
+/*!
+    Writes an object file out as a list of blocks, starting from the
+    blocks of an open object file and replacing, modifying or adding to
+    them. (Opaque!)
+
+    Blocks are written as they appear in an object file: a type byte, a
+    24-bit size, and big-endian content. An EOFMark always ends the file,
+    which is padded with zeroes to a whole number of Lisa pages.
+
+    Only blocks that were replaced, modified or added are encoded again.
+    Given the path of the original file, runs of untouched blocks are
+    copied straight from it, by the kernel where the platform allows, so
+    they come through byte-for-byte and never pass through user space.
+ */
+struct lisa_objfile_writer;
+typedef struct lisa_objfile_writer lisa_objfile_writer;
+
+
+/*! The size of a Lisa page, to which object files are padded. */
+#define LISA_WRITER_PAGE_SIZE	512
+
+
+/*! What writing an object file did, for reporting. */
+struct lisa_objfile_writer_stats {
+    size_t				blocks_copied;	//!< untouched blocks copied from the original file
+    size_t				bytes_copied;
+    size_t				blocks_encoded;	//!< blocks encoded from memory, including the EOFMark
+    size_t				bytes_encoded;
+    size_t				file_size;		//!< including padding
+};
+typedef struct lisa_objfile_writer_stats lisa_objfile_writer_stats;
+
+
+/*!
+    Create a writer holding the blocks of \a of up to its EOFMark, or no
+    blocks at all if \a of is `NULL`. The object file must stay open for
+    as long as the writer is used.
+ */
+LISA_EXTERN
+lisa_objfile_writer * LISA_NULLABLE
+lisa_objfile_writer_create(lisa_objfile * LISA_NULLABLE of);
+
+/*! Free the given writer. */
+LISA_EXTERN
+void
+lisa_objfile_writer_free(lisa_objfile_writer * LISA_NULLABLE writer);
+
+/*! Get the number of blocks the writer will write, not counting the EOFMark. */
+LISA_EXTERN
+lisa_integer
+lisa_objfile_writer_block_count(lisa_objfile_writer *writer);
+
+/*!
+    Replace the block at \a index with a block of type \a type and the
+    given content, which is in native byte order and doesn't include the
+    block's header. The content is copied.
+ */
+LISA_EXTERN
+int
+lisa_objfile_writer_replace_block(lisa_objfile_writer *writer, lisa_integer index,
+                                  lisa_obj_block_type type,
+                                  const void *content, lisa_longint content_size);
+
+/*!
+    Note that the content of the original block at \a index was changed
+    in place, through `lisa_objfile_block_content`, so it must be
+    encoded again rather than copied. Its size must not have changed.
+ */
+LISA_EXTERN
+int
+lisa_objfile_writer_mark_modified(lisa_objfile_writer *writer, lisa_integer index);
+
+/*!
+    Add a block of type \a type and the given content after all the
+    others, as with `lisa_objfile_writer_replace_block`, getting back
+    its index.
+ */
+LISA_EXTERN
+lisa_integer
+lisa_objfile_writer_append_block(lisa_objfile_writer *writer,
+                                 lisa_obj_block_type type,
+                                 const void *content, lisa_longint content_size);
+
+/*!
+    Get the offset at which the block at \a index will be written, for
+    fixing up the FileAddr fields that refer to it. Returns -1 if there's
+    no such block.
+ */
+LISA_EXTERN
+lisa_FileAddr
+lisa_objfile_writer_block_offset(lisa_objfile_writer *writer, lisa_integer index);
+
+/*!
+    Write the blocks to a file at \a path, replacing any file already
+    there. The file is written alongside and then renamed into place, so
+    \a path may also be the original file.
+
+    If \a original_path is given, it must be the file the writer's
+    object file was opened from, which untouched blocks are copied from;
+    otherwise they're encoded again from memory.
+
+    If \a stats is given, it's set to what was written.
+ */
+LISA_EXTERN
+int
+lisa_objfile_writer_write(lisa_objfile_writer *writer, const char *path,
+                          const char * LISA_NULLABLE original_path,
+                          lisa_objfile_writer_stats * LISA_NULLABLE stats);
+
+
+LISA_HEADER_END
+
+#endif /* __LISA__WRITER__H__ */
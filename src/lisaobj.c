@@ -6,7 +6,9 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <inttypes.h>
 #include <limits.h>
+#include <pthread.h>
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stdlib.h>
@@ -14,8 +16,11 @@
 #include <stdio.h>
 #include <string.h>
 #include <sysexits.h>
+#include <unistd.h>
 
+#include "alloc_utils.h"
 #include "endian_utils.h"
+#include "zero_copy.h"
 
 #include "lisa.h"
 
@@ -27,14 +32,44 @@ LISA_SOURCE_BEGIN
 enum lisaobj_command {
     lisaobj_command_dump = 0,
     lisaobj_command_extract = 1,
+    lisaobj_command_stats = 2,
+    lisaobj_command_cat = 3,
+    lisaobj_command_image = 4,
+    lisaobj_command_resolve = 5,
+    lisaobj_command_rebuild = 6,
+    lisaobj_command_link = 7,
+    lisaobj_command_diff = 8,
+    lisaobj_command_similar = 9,
+    lisaobj_command_verify = 10,
+    lisaobj_command_checksum = 11,
 };
 typedef enum lisaobj_command lisaobj_command;
 
 
+/*! The object files a command runs over, and how many to run at once. */
+struct lisaobj_files {
+    char			** LISA_NULLABLE paths;
+    size_t			count;
+    size_t			capacity;
+    size_t			thread_count;		//!< 0 for one per CPU
+    lisa_batch_io	io;
+    size_t			queue_depth;		//!< 0 for the default
+    bool			io_stats;			//!< report I/O throughput to stderr
+    bool			stats;				//!< report time spent in each phase to stderr, as JSON
+    bool			arena;				//!< open each file with its worker's arena
+};
+typedef struct lisaobj_files lisaobj_files;
+
+
+/*!
+    Handles a command's own option \a arg, given the argument after it
+    (if any) as \a value. Returns the number of arguments used, 0 if the
+    option isn't known, or -1 after reporting an invalid option.
+ */
+typedef int (*lisaobj_option_fn)(void *options, const char *arg, const char * LISA_NULLABLE value);
+
+
 const char *program_name = NULL;
-const char *objfile_path = NULL;
-lisa_objfile *objfile = NULL;
-lisaobj_command command;
 
 
 void
@@ -48,9 +83,74 @@ print_usagev(const char *errfmt, va_list args)
     fprintf(stderr, "\n");
     fprintf(stderr, "Usage:" "\n");
     fprintf(stderr, " %s object-file <command> [args]" "\n", program_name);
+    fprintf(stderr, " %s <command> [args] object-file..." "\n", program_name);
     fprintf(stderr, " Commands are:" "\n");
     fprintf(stderr, "  dump"    "\t\t" "dump"    "\t\t" "dump content to stdout" "\n");
     fprintf(stderr, "  extract" "\t"   "extract" "\t\t" "extract unpacked code to files" "\n");
+    fprintf(stderr, "  stats"   "\t\t" "stats"   "\t\t" "summarize object files" "\n");
+    fprintf(stderr, "  cat"     "\t\t" "cat"     "\t\t" "write segments' code as stored to stdout" "\n");
+    fprintf(stderr, "  image"   "\t\t" "image"   "\t\t" "build a memory image of an executable" "\n");
+    fprintf(stderr, "  resolve" "\t"   "resolve" "\t\t" "resolve external references across object files" "\n");
+    fprintf(stderr, "  rebuild" "\t"   "rebuild" "\t\t" "rebuild an executable with replacement segment code" "\n");
+    fprintf(stderr, "  link"    "\t\t" "link"    "\t\t" "link object files into an executable" "\n");
+    fprintf(stderr, "  diff"    "\t\t" "diff"    "\t\t" "compare two object files by segment and block" "\n");
+    fprintf(stderr, "  similar" "\t"   "similar" "\t\t" "find similar segments using an index" "\n");
+    fprintf(stderr, "  verify"  "\t\t" "verify"  "\t\t" "check packed code and segment tables" "\n");
+    fprintf(stderr, "  checksum" "\t"  "checksum" "\t" "checksum blocks and segments into a manifest" "\n");
+    fprintf(stderr, " Options for all commands are:" "\n");
+    fprintf(stderr, "  -j N"              "\t\t"  "use N worker threads" "\n");
+    fprintf(stderr, "  --files-from LIST" "\t"   "also process the files listed in LIST, one per line" "\n");
+    fprintf(stderr, "  --io MODE"         "\t"   "read files with stdio, async (io_uring) or threads" "\n");
+    fprintf(stderr, "  --queue-depth N"   "\t"   "keep N reads in flight for async I/O" "\n");
+    fprintf(stderr, "  --io-stats"        "\t"   "report I/O throughput and queue depth" "\n");
+    fprintf(stderr, "  --stats"           "\t\t"  "report time and bytes for each phase, as JSON" "\n");
+    fprintf(stderr, "  --arena"           "\t\t"  "open files with a reusable arena per thread" "\n");
+    fprintf(stderr, " Options for dump are:" "\n");
+    fprintf(stderr, "  --type T[,T...]" "\t"   "only blocks of the given types, by name or number" "\n");
+    fprintf(stderr, "  --blocks N[-M]"  "\t"   "only blocks with indexes N through M" "\n");
+    fprintf(stderr, "  --offset A[-B]"  "\t"   "only blocks overlapping file offsets A through B" "\n");
+    fprintf(stderr, "  --module NAME"   "\t"   "only blocks of the named module" "\n");
+    fprintf(stderr, "  --no-code"       "\t"   "don't dump code bytes" "\n");
+    fprintf(stderr, " Options for extract are:" "\n");
+    fprintf(stderr, "  -p"              "\t\t"  "write code as stored, without unpacking" "\n");
+    fprintf(stderr, "  --segment NAME"  "\t"   "extract only the named (or numbered) segment" "\n");
+    fprintf(stderr, "  --archive FILE"  "\t"   "write code to a single archive instead of to files" "\n");
+    fprintf(stderr, "  --incremental"   "\t"   "only rewrite code that changed since the last extraction" "\n");
+    fprintf(stderr, "  --store DIR"     "\t"   "write code to a content-addressed store, each only once" "\n");
+    fprintf(stderr, "  --relocate BASE" "\t"   "relocate code as if loaded at address BASE" "\n");
+    fprintf(stderr, "  --symbols FILE"  "\t"   "resolve external references with the names and addresses in FILE" "\n");
+    fprintf(stderr, " Options for stats are:" "\n");
+    fprintf(stderr, "  --json"          "\t\t"  "write JSON instead of a table" "\n");
+    fprintf(stderr, "  --segments"      "\t"   "include per-segment sizes in the table" "\n");
+    fprintf(stderr, " Options for cat are:" "\n");
+    fprintf(stderr, "  --segment NAME"  "\t"   "write the named (or numbered) segment; may be repeated" "\n");
+    fprintf(stderr, " Options for image are:" "\n");
+    fprintf(stderr, "  -o FILE"         "\t\t"  "write the image to FILE rather than object-file.img" "\n");
+    fprintf(stderr, " Options for resolve are:" "\n");
+    fprintf(stderr, "  --unresolved"    "\t"   "only report unresolved references and duplicate definitions" "\n");
+    fprintf(stderr, " Options for rebuild are:" "\n");
+    fprintf(stderr, "  --segment NAME=FILE" "\t" "replace the named (or numbered) segment's code with FILE, unpacked" "\n");
+    fprintf(stderr, "  -o FILE"         "\t\t"  "write the executable to FILE rather than object-file.new" "\n");
+    fprintf(stderr, " Options for link are:" "\n");
+    fprintf(stderr, "  -o FILE"         "\t\t"  "write the executable to FILE (required)" "\n");
+    fprintf(stderr, "  --map FILE"      "\t"   "write a link map to FILE, or - for stdout" "\n");
+    fprintf(stderr, "  --base ADDR"     "\t"   "load the first segment at ADDR rather than $10000" "\n");
+    fprintf(stderr, "  --allow-unresolved" "\t" "write the executable even if references are unresolved" "\n");
+    fprintf(stderr, " Options for diff are:" "\n");
+    fprintf(stderr, "  --segments"      "\t"   "only compare segments, not other blocks" "\n");
+    fprintf(stderr, "  --brief"         "\t"   "don't list the byte ranges that differ" "\n");
+    fprintf(stderr, " Options for similar are:" "\n");
+    fprintf(stderr, "  --build INDEX"   "\t"   "index every segment of the object files into INDEX" "\n");
+    fprintf(stderr, "  --index INDEX"   "\t"   "find segments in INDEX similar to the object files' segments" "\n");
+    fprintf(stderr, "  --segment NAME"  "\t"   "only look for the named (or numbered) segment" "\n");
+    fprintf(stderr, "  --top N"         "\t\t"  "list at most N matches per segment (default 10)" "\n");
+    fprintf(stderr, "  --min PERCENT"   "\t"   "only list matches at least PERCENT similar (default 50)" "\n");
+    fprintf(stderr, " Options for verify are:" "\n");
+    fprintf(stderr, "  --no-repack"     "\t"   "only check that packed code unpacks to its size" "\n");
+    fprintf(stderr, " Options for checksum are:" "\n");
+    fprintf(stderr, "  -o MANIFEST"     "\t"   "write the manifest to MANIFEST rather than stdout" "\n");
+    fprintf(stderr, "  --update"        "\t"   "keep the checksums of other files already in MANIFEST" "\n");
+    fprintf(stderr, "  --verify MANIFEST" "\t" "check the files against MANIFEST instead" "\n");
 }
 
 void
@@ -63,183 +163,379 @@ print_usage(const char *errfmt, ...)
 }
 
 
+/*!
+    Parse a number as used on the command line: decimal, `0x` hex, or
+    `$` hex as in dump output.
+ */
+bool
+parse_number(const char *s, long *value)
+{
+    const char *digits = (s[0] == '$') ? &s[1] : s;
+    int base = (s[0] == '$') ? 16 : 0;
+    char *end = NULL;
+
+    if (digits[0] == '\0') return false;
+
+    errno = 0;
+    *value = strtol(digits, &end, base);
+    return (errno == 0) && (*end == '\0');
+}
+
+/*!
+    Parse a range of the form `N`, `N-M`, or `N-` into \a lo and \a hi,
+    leaving \a hi alone for an open range.
+ */
+bool
+parse_range(const char *s, long *lo, long *hi)
+{
+    char buf[64];
+    strlcpy(buf, s, sizeof(buf));
+
+    char *dash = strchr(buf, '-');
+    if (dash == NULL) {
+        if (!parse_number(buf, lo)) return false;
+        *hi = *lo;
+        return true;
+    }
+
+    *dash = '\0';
+    if (!parse_number(buf, lo)) return false;
+    if (dash[1] == '\0') return true;
+    return parse_number(&dash[1], hi) && (*lo <= *hi);
+}
+
+
+// MARK: - Files
+
+/*! Add a copy of \a path to the files a command runs over. */
+bool
+lisaobj_files_add(lisaobj_files *files, const char *path)
+{
+    if (files->count == files->capacity) {
+        size_t new_capacity = files->capacity ? files->capacity * 2 : 16;
+        char **paths = realloc(files->paths, sizeof(char *) * new_capacity);
+        if (paths == NULL) return false;
+        files->paths = paths;
+        files->capacity = new_capacity;
+    }
+
+    char *copy = strdup(path);
+    if (copy == NULL) return false;
+
+    files->paths[files->count] = copy;
+    files->count += 1;
+    return true;
+}
+
+/*!
+    Add each line of the file at \a list_path, or of stdin if it's `-`,
+    to the files a command runs over. Blank lines are skipped.
+ */
+bool
+lisaobj_files_add_list(lisaobj_files *files, const char *list_path)
+{
+    bool use_stdin = (strcmp(list_path, "-") == 0);
+    FILE *list = use_stdin ? stdin : fopen(list_path, "r");
+    if (list == NULL) return false;
+
+    bool ok = true;
+    char *line = NULL;
+    size_t line_capacity = 0;
+    ssize_t length;
+
+    while ((length = getline(&line, &line_capacity, list)) != -1) {
+        while ((length > 0) && ((line[length - 1] == '\n') || (line[length - 1] == '\r'))) {
+            line[--length] = '\0';
+        }
+        if (length == 0) continue;
+
+        ok = lisaobj_files_add(files, line);
+        if (!ok) break;
+    }
+
+    if (ferror(list)) ok = false;
+
+    free(line);
+    if (!use_stdin) fclose(list);
+    return ok;
+}
+
+void
+lisaobj_files_free(lisaobj_files *files)
+{
+    for (size_t p = 0; p < files->count; p++) {
+        free(files->paths[p]);
+    }
+    free(files->paths);
+    files->paths = NULL;
+    files->count = 0;
+    files->capacity = 0;
+}
+
+
+/*!
+    Parse the arguments to a command, whose name is in \a argv[0]. Its
+    own options are handled by \a option_fn; `-j N`, `--files-from LIST`
+    and object file paths are common to every command and are collected
+    into \a files. Returns `EX_OK` or an exit status after reporting an
+    error.
+ */
 int
-lisaobj_dump(int argc, const char * LISA_NULLABLE argv[])
+lisaobj_parse_arguments(int argc, const char * LISA_NULLABLE argv[],
+                        lisaobj_option_fn option_fn, void *options,
+                        lisaobj_files *files)
 {
-    const lisa_integer block_count = lisa_objfile_block_count(objfile);
-    for (lisa_integer b = 0; b < block_count; b++) {
-        lisa_objfile_block *block = lisa_objfile_block_at_index(objfile, b);
-        lisa_obj_block_dump(block);
+    bool only_paths = false;
+
+    for (int a = 1; a < argc; a++) {
+        const char *arg = argv[a];
+        const char *value = (a + 1 < argc) ? argv[a + 1] : NULL;
+
+        if (only_paths || (arg[0] != '-') || (strcmp(arg, "-") == 0)) {
+            if (!lisaobj_files_add(files, arg)) {
+                fprintf(stderr, "%s" "\n", strerror(errno));
+                return EX_OSERR;
+            }
+            continue;
+        }
+
+        if (strcmp(arg, "--") == 0) {
+            only_paths = true;
+        } else if (strcmp(arg, "-j") == 0 && value) {
+            long threads;
+            if (!parse_number(value, &threads) || (threads < 1)) {
+                print_usage("Invalid thread count: %s", value);
+                return EX_USAGE;
+            }
+            files->thread_count = (size_t)threads;
+            a++;
+        } else if (strcmp(arg, "--io") == 0 && value) {
+            if (strcmp(value, "stdio") == 0) {
+                files->io = lisa_batch_io_stdio;
+            } else if (strcmp(value, "async") == 0) {
+                files->io = lisa_batch_io_async;
+            } else if (strcmp(value, "threads") == 0) {
+                files->io = lisa_batch_io_threads;
+            } else {
+                print_usage("Unknown I/O mode: %s", value);
+                return EX_USAGE;
+            }
+            a++;
+        } else if (strcmp(arg, "--queue-depth") == 0 && value) {
+            long depth;
+            if (!parse_number(value, &depth) || (depth < 1) || (depth > 4096)) {
+                print_usage("Invalid queue depth: %s", value);
+                return EX_USAGE;
+            }
+            files->queue_depth = (size_t)depth;
+            a++;
+        } else if (strcmp(arg, "--io-stats") == 0) {
+            files->io_stats = true;
+        } else if (strcmp(arg, "--stats") == 0) {
+            files->stats = true;
+            lisa_stats_set_enabled(true);
+        } else if (strcmp(arg, "--arena") == 0) {
+            files->arena = true;
+        } else if (strcmp(arg, "--files-from") == 0 && value) {
+            if (!lisaobj_files_add_list(files, value)) {
+                fprintf(stderr, "%s: %s" "\n", value, strerror(errno));
+                return EX_NOINPUT;
+            }
+            a++;
+        } else {
+            int used = option_fn(options, arg, value);
+            if (used == -1) return EX_USAGE;
+            if (used == 0) {
+                print_usage("Unknown %s option: %s", argv[0], arg);
+                return EX_USAGE;
+            }
+            a += used - 1;
+        }
+    }
+
+    if (files->count == 0) {
+        print_usage("No object files given");
+        return EX_USAGE;
     }
 
     return EX_OK;
 }
 
 
+/*!
+    Run \a fn over every file, in parallel, writing their output to
+    stdout in order and returning the first failing exit status.
+ */
+int
+lisaobj_run_batch(lisaobj_files *files, lisa_batch_fn fn, void *context,
+                  const char * LISA_NULLABLE separator)
+{
+    lisa_batch_stats stats;
+    lisa_batch_options options = {
+        .thread_count = files->thread_count,
+        .max_bytes_in_flight = 0,
+        .separator = separator,
+        .io = files->io,
+        .queue_depth = files->queue_depth,
+        .stats = &stats,
+        .arena_size = files->arena ? ARENA_DEFAULT_CHUNK_SIZE : 0,
+    };
+
+    int status = lisa_batch_process((const char * const *)files->paths, files->count,
+                                    fn, context, stdout, &options);
+    if (status == -1) {
+        fprintf(stderr, "%s" "\n", strerror(errno));
+        return EX_OSERR;
+    }
+
+    if (files->io_stats) {
+        double megabytes = (double)stats.bytes_read / (1024.0 * 1024.0);
+        fprintf(stderr, "%zu files, %.1f MB read, %.3f s total (%.1f MB/s) using %s, queue depth %zu max, %.1f mean" "\n",
+                stats.files_read, megabytes, stats.seconds,
+                (stats.seconds > 0) ? (megabytes / stats.seconds) : 0.0,
+                stats.io_backend, stats.max_queue_depth, stats.mean_queue_depth);
+    }
+
+    return status;
+}
+
+
+/*! Look a segment up by name first, then by number. */
+int
+lisaobj_find_segment(lisa_objfile *of, const char *name, lisa_segment *segment)
+{
+    long number;
+    int lookup_err = lisa_objfile_segment_named(of, name, segment);
+    if ((lookup_err == -1) && parse_number(name, &number) && (number >= 0) && (number <= INT16_MAX)) {
+        lookup_err = lisa_objfile_segment_numbered(of, (lisa_integer)number, segment);
+    }
+    return lookup_err;
+}
+
+
+/*! Report a file that couldn't be opened, for a batch function. */
 int
-lisaobj_extract(int argc, const char * LISA_NULLABLE argv[])
-{
-    bool extract_packed = false;
-
-    if (argc > 1) {
-        if (strcmp(argv[1], "-p") == 0) {
-            // -p -- preserve raw bytes
-            extract_packed = true;
-        }
-    }
-
-    char current_module_name[9] = { 0 };
-    char current_segment_name[9] = { 0 };
-    char *first_blank;
-    uint8_t *current_code = NULL;
-    lisa_longint current_code_size = 0;
-    lisa_MemAddr current_code_address = 0x00000000;
-
-    const lisa_integer block_count = lisa_objfile_block_count(objfile);
-    for (lisa_integer b = 0; b < block_count; b++) {
-        lisa_objfile_block *block = lisa_objfile_block_at_index(objfile, b);
-        lisa_objfile_content content = lisa_objfile_block_content(block);
-
-        switch (lisa_objfile_block_type(block)) {
-            case ModuleName: {
-                // A ModuleName block starts a module segment, and
-                // contains both the module name and the segment name.
-                // These are space-padded fixed-length strings, rather
-                // than length-prefixed strings, so make them into nice
-                // C strings for constructing paths.
-
-                memset(current_module_name, 0, 9);
-                memcpy(current_module_name, content.ModuleName->ModuleName, 8);
-                current_module_name[8] = '\0';
-                first_blank = strchr(current_module_name, ' ');
-                if (first_blank) *first_blank = '\0';
-
-                memset(current_segment_name, 0, 9);
-                memcpy(current_segment_name, content.ModuleName->SegmentName, 8);
-                current_segment_name[8] = '\0';
-                first_blank = strchr(current_segment_name, ' ');
-                if (first_blank) *first_blank = '\0';
-            } break;
-
-            case PackedCode: {
-                // A PackedCode block contains code for the current module,
-                // as well as the start address. Save those off. If the
-                // user doesn't want the code unpacked, then just put the
-                // packed code in current_code.
-
-                if (extract_packed) {
-                    current_code_size = lisa_objfile_block_size(block) - 12;
-                    // header + size + addr = 12
-                    current_code_address = content.PackedCode->addr;
-
-                    assert(current_code == NULL);
-                    current_code = calloc(sizeof(uint8_t), (size_t)current_code_size);
-                    if (current_code == NULL) {
-                        // TODO: Handle error.
-                        assert(current_code != NULL);
-                    }
-
-                    memcpy(current_code, content.PackedCode->code, (size_t)current_code_size);
-                } else {
-                    current_code_size = content.PackedCode->csize;
-                    current_code_address = content.PackedCode->addr;
-
-                    assert(current_code == NULL);
-                    current_code = calloc(sizeof(uint8_t), (size_t)current_code_size);
-                    if (current_code == NULL) {
-                        // TODO: Handle error.
-                        assert(current_code != NULL);
-                    }
-
-                    uint8_t *packed_code = content.PackedCode->code;
-                    lisa_longint packed_code_size = lisa_objfile_block_size(block) - 12;
-                    // header + size + addr = 12
-
-                    int unpack_err = lisa_unpackcode(packed_code, packed_code_size,
-                                                     current_code, &current_code_size,
-                                                     NULL);
-                    if (unpack_err != 0) {
-                        // TODO: Handle error.
-                        assert(unpack_err == 0);
-                    }
-                }
-            } break;
-
-            case CodeBlock: {
-                // A CodeBlock contains code for the current module, as well
-                // as the start address. Save those off.
-
-                current_code_size = lisa_objfile_block_size(block) - 8;
-                current_code_address = content.CodeBlock->Addr;
-                // header + addr = 8
-
-                assert(current_code == NULL);
-                current_code = calloc(sizeof(uint8_t), (size_t)current_code_size);
-                if (current_code == NULL) {
-                    // TODO: Handle error.
-                    assert(current_code != NULL);
-                }
-
-                memcpy(current_code, content.CodeBlock->code, (size_t)current_code_size);
-            } break;
-
-            case EndBlock: {
-                // An EndBlock block ends the current module. Write it
-                // to an appropriately-named file and clean up.
-
-                // For the output file name, we use the input file name
-                // and add -modulename[-segmentname][-address].bin so
-                // it carries all of its important metadata with it.
-                // (If there's no segment or the address is 0, we skip
-                // those.)
-
-                assert(current_code != NULL);
-
-                char path[PATH_MAX];
-                strlcpy(path, objfile_path, PATH_MAX);
-                strlcat(path, "-", PATH_MAX);
-                strlcat(path, current_module_name, PATH_MAX);
-
-                if (current_segment_name[0] != '\0') {
-                    strlcat(path, "-", PATH_MAX);
-                    strlcat(path, current_segment_name, PATH_MAX);
-                }
-
-                if (current_code_address != 0) {
-                    char addrbuf[10];
-                    strlcat(path, "-", PATH_MAX);
-                    snprintf(addrbuf, 10, "$%08x", current_code_address);
-                    strlcat(path, addrbuf, PATH_MAX);
-                }
-
-                strlcat(path, ".bin", PATH_MAX);
-
-                FILE *outfile = fopen(path, "wb");
-                if (outfile == NULL) {
-                    // TODO: Handle error.
-                    assert(outfile != NULL);
-                }
-
-                size_t items_written = fwrite(current_code, (size_t)current_code_size, 1, outfile);
-                if (items_written != 1) {
-                    // TODO: Handle error.
-                    assert(items_written == 1);
-                }
-
-                fclose(outfile);
-
-                free(current_code);
-                current_code = NULL;
-            } break;
-
-            default: {
-                // Skip every other kind of block.
-            } break;
-        }
-    }
-
-    if (current_code != NULL) {
-        free(current_code);
+lisaobj_open_failed(const char *path)
+{
+    fprintf(stderr, "%s: %s" "\n", path, strerror(errno));
+    return EX_NOINPUT;
+}
+
+
+// MARK: - Dump
+
+/*! Which blocks to dump, as given on the command line. */
+struct lisaobj_dump_options {
+    lisa_obj_dump_flags	flags;
+    bool				type_filter;
+    bool				types[256];
+    long				blocks_lo;
+    long				blocks_hi;
+    bool				offset_filter;
+    long				offset_lo;
+    long				offset_hi;
+    const char			* LISA_NULLABLE module_name;
+    bool				headers;			//!< name each file before its blocks
+};
+typedef struct lisaobj_dump_options lisaobj_dump_options;
+
+
+int
+lisaobj_dump_option(void *context, const char *arg, const char * LISA_NULLABLE value)
+{
+    lisaobj_dump_options *options = context;
+
+    if (strcmp(arg, "--no-code") == 0) {
+        options->flags |= lisa_obj_dump_flags_no_code;
+        return 1;
+    } else if (strcmp(arg, "--type") == 0 && value) {
+        char buf[256];
+        strlcpy(buf, value, sizeof(buf));
+        for (char *name = strtok(buf, ","); name; name = strtok(NULL, ",")) {
+            lisa_obj_block_type t;
+            if (!lisa_obj_block_type_from_string(name, &t)) {
+                print_usage("Unknown block type: %s", name);
+                return -1;
+            }
+            options->types[t] = true;
+        }
+        options->type_filter = true;
+        return 2;
+    } else if (strcmp(arg, "--blocks") == 0 && value) {
+        long lo, hi = LONG_MAX;
+        if (!parse_range(value, &lo, &hi)) {
+            print_usage("Invalid block range: %s", value);
+            return -1;
+        }
+        if (lo > options->blocks_lo) options->blocks_lo = lo;
+        if (hi < options->blocks_hi) options->blocks_hi = hi;
+        return 2;
+    } else if (strcmp(arg, "--offset") == 0 && value) {
+        long lo, hi = LONG_MAX;
+        if (!parse_range(value, &lo, &hi) || (lo < 0)) {
+            print_usage("Invalid offset range: %s", value);
+            return -1;
+        }
+        if (lo > options->offset_lo) options->offset_lo = lo;
+        if (hi < options->offset_hi) options->offset_hi = hi;
+        options->offset_filter = true;
+        return 2;
+    } else if (strcmp(arg, "--module") == 0 && value) {
+        options->module_name = value;
+        return 2;
+    }
+
+    return 0;
+}
+
+
+int
+lisaobj_dump_file(lisa_objfile * LISA_NULLABLE of, const char *path, FILE *out, void * LISA_NULLABLE context)
+{
+    lisaobj_dump_options *options = context;
+    if (of == NULL) return lisaobj_open_failed(path);
+
+    const lisa_integer block_count = lisa_objfile_block_count(of);
+
+    // The selected blocks are always a contiguous range of indexes, so
+    // narrow that range using the offset and module indexes rather than
+    // walking every block; only the type filter is checked per block.
+
+    long first = options->blocks_lo;
+    long last = (options->blocks_hi < block_count - 1) ? options->blocks_hi : block_count - 1;
+
+    if (options->offset_filter) {
+        long lo = options->offset_lo, hi = options->offset_hi;
+        lisa_integer lo_block = (lo > INT32_MAX) ? -1 : lisa_objfile_block_index_at_offset(of, (lisa_FileAddr)lo);
+        lisa_integer hi_block = (hi > INT32_MAX) ? -1 : lisa_objfile_block_index_at_offset(of, (lisa_FileAddr)hi);
+        if (lo_block == -1) {
+            // Nothing starts at or before an offset past the end.
+            first = block_count;
+        } else if (lo_block > first) {
+            first = lo_block;
+        }
+        if ((hi_block != -1) && (hi_block < last)) last = hi_block;
+    }
+
+    if (options->module_name) {
+        lisa_integer m = lisa_objfile_module_index_named(of, options->module_name);
+        if (m == -1) {
+            fprintf(stderr, "%s: no module named '%s'" "\n", path, options->module_name);
+            return EX_DATAERR;
+        }
+        const lisa_objfile_module *module = lisa_objfile_module_at_index(of, m);
+        if (module->first_block > first) first = module->first_block;
+        if (module->last_block < last) last = module->last_block;
+    }
+
+    if (options->headers) {
+        fprintf(out, "%s:" "\n", path);
+    }
+
+    for (long b = first; b <= last; b++) {
+        lisa_objfile_block *block = lisa_objfile_block_at_index(of, (lisa_integer)b);
+        if (options->type_filter && !options->types[lisa_objfile_block_type(block)]) continue;
+        lisa_obj_block_fdump(block, out, options->flags);
     }
 
     return EX_OK;
@@ -247,47 +543,1942 @@ lisaobj_extract(int argc, const char * LISA_NULLABLE argv[])
 
 
 int
-main(int argc, const char * LISA_NULLABLE argv[])
+lisaobj_dump(int argc, const char * LISA_NULLABLE argv[], lisaobj_files *files)
 {
-    program_name = argv[0];
+    lisaobj_dump_options options = {
+        .flags = lisa_obj_dump_flags_none,
+        .blocks_lo = 0,
+        .blocks_hi = LONG_MAX,
+        .offset_lo = 0,
+        .offset_hi = LONG_MAX,
+    };
+
+    int parse_result = lisaobj_parse_arguments(argc, argv, lisaobj_dump_option, &options, files);
+    if (parse_result != EX_OK) return parse_result;
+
+    options.headers = (files->count > 1);
+
+    return lisaobj_run_batch(files, lisaobj_dump_file, &options, NULL);
+}
+
+
+// MARK: - Extract
+
+/*! How to extract code, as given on the command line, and what it's done so far. */
+struct lisaobj_extract_options {
+    lisa_extract_options	extract;
+    const char				* LISA_NULLABLE segment_name;
+    const char				* LISA_NULLABLE archive_path;
+    const char				* LISA_NULLABLE store_path;
+    bool					relocate;
+    lisa_relocate_options	relocation;
+    const char				* LISA_NULLABLE symbols_path;
+
+    pthread_mutex_t			lock;
+    lisa_extract_stats		totals;
+};
+typedef struct lisaobj_extract_options lisaobj_extract_options;
+
+
+int
+lisaobj_extract_option(void *context, const char *arg, const char * LISA_NULLABLE value)
+{
+    lisaobj_extract_options *options = context;
+
+    if (strcmp(arg, "-p") == 0) {
+        // -p -- preserve raw bytes
+        options->extract.packed = true;
+        return 1;
+    } else if (strcmp(arg, "--segment") == 0 && value) {
+        options->segment_name = value;
+        return 2;
+    } else if (strcmp(arg, "--archive") == 0 && value) {
+        options->archive_path = value;
+        return 2;
+    } else if (strcmp(arg, "--store") == 0 && value) {
+        options->store_path = value;
+        return 2;
+    } else if (strcmp(arg, "--incremental") == 0) {
+        options->extract.incremental = true;
+        return 1;
+    } else if (strcmp(arg, "--relocate") == 0 && value) {
+        long base;
+        if (!parse_number(value, &base) || (base < 0) || (base > (long)UINT32_MAX)) {
+            print_usage("Invalid base address: %s", value);
+            return -1;
+        }
+        options->relocate = true;
+        options->relocation.base = (lisa_MemAddr)(uint32_t)base;
+        return 2;
+    } else if (strcmp(arg, "--symbols") == 0 && value) {
+        options->symbols_path = value;
+        return 2;
+    }
+
+    return 0;
+}
+
+
+int
+lisaobj_extract_file(lisa_objfile * LISA_NULLABLE of, const char *path, FILE *out, void * LISA_NULLABLE context)
+{
+    lisaobj_extract_options *options = context;
+    if (of == NULL) return lisaobj_open_failed(path);
+
+    // Each file gets its own stats, since files are extracted at once.
+
+    lisa_extract_stats stats = { 0 };
+    lisa_extract_options extract_options = options->extract;
+    extract_options.stats = &stats;
+
+    if (options->segment_name) {
+        lisa_segment segment;
+        int lookup_err = lisaobj_find_segment(of, options->segment_name, &segment);
+        if (lookup_err == -1) {
+            fprintf(stderr, "%s: no segment '%s'" "\n", path, options->segment_name);
+            return EX_DATAERR;
+        }
+
+        int extract_err = lisa_objfile_extract_module(of, segment.module, path, &extract_options);
+        if (extract_err == -1) {
+            fprintf(stderr, "%s: extraction failed: %s" "\n", path, strerror(errno));
+            return (errno == EINVAL || errno == ENOENT) ? EX_DATAERR : EX_CANTCREAT;
+        }
+    } else {
+        int extract_err = lisa_objfile_extract(of, path, &extract_options);
+        if (extract_err == -1) {
+            fprintf(stderr, "%s: extraction failed: %s" "\n", path, strerror(errno));
+            return (errno == EINVAL) ? EX_DATAERR : EX_CANTCREAT;
+        }
+    }
+
+    if (options->extract.incremental) {
+        fprintf(out, "%s: %zu written, %zu unchanged, %zu removed" "\n",
+                path, stats.written, stats.unchanged, stats.removed);
+    } else if (options->extract.store) {
+        fprintf(out, "%s: %zu stored, %zu already stored, %zu unchanged" "\n",
+                path, stats.written, stats.deduplicated, stats.unchanged);
+    }
+
+    if (stats.unresolved > 0) {
+        fprintf(stderr, "%s: %zu references to unknown symbols left unrelocated" "\n", path, stats.unresolved);
+    }
+
+    pthread_mutex_lock(&options->lock);
+    options->totals.written += stats.written;
+    options->totals.deduplicated += stats.deduplicated;
+    options->totals.unchanged += stats.unchanged;
+    options->totals.removed += stats.removed;
+    pthread_mutex_unlock(&options->lock);
+
+    return EX_OK;
+}
+
+
+int
+lisaobj_extract(int argc, const char * LISA_NULLABLE argv[], lisaobj_files *files)
+{
+    lisaobj_extract_options options = { 0 };
+
+    int parse_result = lisaobj_parse_arguments(argc, argv, lisaobj_extract_option, &options, files);
+    if (parse_result != EX_OK) return parse_result;
+
+    if (options.archive_path && options.extract.incremental) {
+        print_usage("--incremental can't be used with --archive");
+        return EX_USAGE;
+    }
+
+    if (options.store_path && (options.archive_path || options.extract.incremental)) {
+        print_usage("--store can't be used with --archive or --incremental");
+        return EX_USAGE;
+    }
+
+    if (options.relocate && (options.extract.packed || options.extract.incremental)) {
+        print_usage("--relocate can't be used with -p or --incremental");
+        return EX_USAGE;
+    }
 
-    if (argc < 3) {
-        print_usage("Insufficient arguments");
+    if (options.symbols_path && !options.relocate) {
+        print_usage("--symbols can only be used with --relocate");
         return EX_USAGE;
     }
 
-    objfile_path = argv[1];
-    const char *command_name = argv[2];
+    lisa_symbol_table *symbols = NULL;
+    if (options.symbols_path) {
+        FILE *symbols_file = fopen(options.symbols_path, "r");
+        if (symbols_file == NULL) {
+            fprintf(stderr, "%s: %s" "\n", options.symbols_path, strerror(errno));
+            return EX_NOINPUT;
+        }
+
+        size_t line = 0;
+        symbols = lisa_symbol_table_create();
+        int read_err = symbols ? lisa_symbol_table_read(symbols, symbols_file, &line) : -1;
+        int read_errno = errno;
+        fclose(symbols_file);
+
+        if (read_err == -1) {
+            if (read_errno == EINVAL) {
+                fprintf(stderr, "%s:%zu: expected a name and an address" "\n", options.symbols_path, line);
+            } else {
+                fprintf(stderr, "%s: %s" "\n", options.symbols_path, strerror(read_errno));
+            }
+            lisa_symbol_table_free(symbols);
+            return EX_DATAERR;
+        }
+    }
+
+    if (options.relocate) {
+        options.relocation.symbols = symbols;
+        options.extract.relocate = &options.relocation;
+    }
+
+    // A single file spreads its modules across the threads; many files
+    // are spread across the threads instead, each extracted serially.
 
-    if (strcmp(command_name, "dump") == 0) {
-        command = lisaobj_command_dump;
-    } else if (strcmp(command_name, "extract") == 0) {
-        command = lisaobj_command_extract;
+    if (files->count == 1) {
+        options.extract.thread_count = files->thread_count;
     } else {
-        print_usage("Unknown command: %s", argv[1]);
+        options.extract.thread_count = 1;
     }
 
-    objfile = lisa_objfile_open(objfile_path);
-    if (objfile == NULL) {
-        const char *errstr = strerror(errno);
-        print_usage(errstr);
-        return EX_NOINPUT;
+    if (options.archive_path) {
+        options.extract.archive = lisa_archive_writer_create(options.archive_path);
+        if (options.extract.archive == NULL) {
+            fprintf(stderr, "%s: %s" "\n", options.archive_path, strerror(errno));
+            lisa_symbol_table_free(symbols);
+            return EX_CANTCREAT;
+        }
     }
 
-    int command_result;
-    int command_argc = argc - 2;
-    const char **command_argv = &argv[2];
-    switch (command) {
-        case lisaobj_command_dump:
-            command_result = lisaobj_dump(command_argc, command_argv);
-            break;
+    if (options.store_path) {
+        options.extract.store = lisa_store_open(options.store_path);
+        if (options.extract.store == NULL) {
+            fprintf(stderr, "%s: %s" "\n", options.store_path, strerror(errno));
+            lisa_symbol_table_free(symbols);
+            return EX_CANTCREAT;
+        }
+    }
 
-        case lisaobj_command_extract:
-            command_result = lisaobj_extract(command_argc, command_argv);
+    pthread_mutex_init(&options.lock, NULL);
+    int result = lisaobj_run_batch(files, lisaobj_extract_file, &options, NULL);
+    pthread_mutex_destroy(&options.lock);
+
+    if (options.extract.incremental && (files->count > 1)) {
+        fprintf(stdout, "%zu files: %zu written, %zu unchanged, %zu removed" "\n",
+                files->count, options.totals.written, options.totals.unchanged, options.totals.removed);
+    } else if (options.extract.store && (files->count > 1)) {
+        fprintf(stdout, "%zu files: %zu stored, %zu already stored, %zu unchanged" "\n",
+                files->count, options.totals.written, options.totals.deduplicated, options.totals.unchanged);
+    }
+
+    lisa_store_close(options.extract.store);
+
+    if (options.extract.archive) {
+        int close_err = lisa_archive_writer_close(options.extract.archive);
+        if (close_err == -1) {
+            fprintf(stderr, "%s: %s" "\n", options.archive_path, strerror(errno));
+            if (result == EX_OK) result = EX_IOERR;
+        }
+    }
+
+    lisa_symbol_table_free(symbols);
+
+    return result;
+}
+
+
+// MARK: - Cat
+
+/*! Which segments to write, as given on the command line. */
+struct lisaobj_cat_options {
+    const char		** LISA_NULLABLE segment_names;	//!< all of them if none are given
+    size_t			segment_count;
+};
+typedef struct lisaobj_cat_options lisaobj_cat_options;
+
+
+int
+lisaobj_cat_option(void *context, const char *arg, const char * LISA_NULLABLE value)
+{
+    lisaobj_cat_options *options = context;
+
+    if (strcmp(arg, "--segment") == 0 && value) {
+        const char **names = realloc(options->segment_names, sizeof(char *) * (options->segment_count + 1));
+        if (names == NULL) {
+            fprintf(stderr, "%s" "\n", strerror(errno));
+            return -1;
+        }
+        names[options->segment_count] = value;
+        options->segment_names = names;
+        options->segment_count += 1;
+        return 2;
+    }
+
+    return 0;
+}
+
+
+/*! Write a segment's code, as stored, to stdout. */
+int
+lisaobj_cat_segment(const char *path, lisa_segment *segment)
+{
+    int write_err = zero_copy_write(STDOUT_FILENO, segment->code, (size_t)segment->code_size, NULL);
+    if (write_err == -1) {
+        fprintf(stderr, "%s: %s: %s" "\n", path, segment->name, strerror(errno));
+        return EX_IOERR;
+    }
+
+    return EX_OK;
+}
+
+
+int
+lisaobj_cat_file(lisaobj_cat_options *options, const char *path)
+{
+    // The file is mapped so its code can be spliced straight from the
+    // page cache into a pipe, rather than read and then written.
+
+    lisa_objfile *of = lisa_objfile_open_mapped(path);
+    if (of == NULL) return lisaobj_open_failed(path);
+
+    int result = EX_OK;
+
+    if (options->segment_count == 0) {
+        for (lisa_integer s = 0; (s < lisa_objfile_segment_count(of)) && (result == EX_OK); s++) {
+            lisa_segment segment;
+            int segment_err = lisa_objfile_segment_at_index(of, s, &segment);
+            if (segment_err == -1) continue;
+            result = lisaobj_cat_segment(path, &segment);
+        }
+    }
+
+    for (size_t n = 0; (n < options->segment_count) && (result == EX_OK); n++) {
+        lisa_segment segment;
+        int lookup_err = lisaobj_find_segment(of, options->segment_names[n], &segment);
+        if (lookup_err == -1) {
+            fprintf(stderr, "%s: no segment '%s'" "\n", path, options->segment_names[n]);
+            result = EX_DATAERR;
             break;
+        }
+        result = lisaobj_cat_segment(path, &segment);
+    }
+
+    lisa_objfile_close(of);
+    return result;
+}
+
+
+int
+lisaobj_cat(int argc, const char * LISA_NULLABLE argv[], lisaobj_files *files)
+{
+    lisaobj_cat_options options = { 0 };
+
+    int result = lisaobj_parse_arguments(argc, argv, lisaobj_cat_option, &options, files);
+    if (result != EX_OK) goto done;
+
+    // Code goes straight to stdout rather than through a batch's
+    // buffers, so files are written one at a time, in order.
+
+    fflush(stdout);
+
+    for (size_t f = 0; (f < files->count) && (result == EX_OK); f++) {
+        result = lisaobj_cat_file(&options, files->paths[f]);
+    }
+
+done:
+    free(options.segment_names);
+    return result;
+}
+
+
+// MARK: - Image
+
+/*! How to build memory images, as given on the command line. */
+struct lisaobj_image_options {
+    lisa_image_options	image;
+    const char			* LISA_NULLABLE output_path;
+};
+typedef struct lisaobj_image_options lisaobj_image_options;
+
+
+int
+lisaobj_image_option(void *context, const char *arg, const char * LISA_NULLABLE value)
+{
+    lisaobj_image_options *options = context;
+
+    if (strcmp(arg, "-o") == 0 && value) {
+        options->output_path = value;
+        return 2;
+    }
+
+    return 0;
+}
+
+
+int
+lisaobj_image_file(lisa_objfile * LISA_NULLABLE of, const char *path, FILE *out, void * LISA_NULLABLE context)
+{
+    lisaobj_image_options *options = context;
+    if (of == NULL) return lisaobj_open_failed(path);
+    (void)out;
+
+    if (lisa_objfile_executable(of) == NULL) {
+        fprintf(stderr, "%s: not an executable" "\n", path);
+        return EX_DATAERR;
+    }
+
+    char image_path[PATH_MAX];
+    if (options->output_path) {
+        snprintf(image_path, sizeof(image_path), "%s", options->output_path);
+    } else if (snprintf(image_path, sizeof(image_path), "%s.img", path) >= (int)sizeof(image_path)) {
+        fprintf(stderr, "%s: %s" "\n", path, strerror(ENAMETOOLONG));
+        return EX_CANTCREAT;
+    }
+
+    int image_err = lisa_objfile_build_image(of, image_path, &options->image);
+    if (image_err == -1) {
+        fprintf(stderr, "%s: image failed: %s" "\n", path, strerror(errno));
+        return (errno == EINVAL || errno == ENOENT) ? EX_DATAERR : EX_CANTCREAT;
+    }
+
+    return EX_OK;
+}
+
+
+int
+lisaobj_image(int argc, const char * LISA_NULLABLE argv[], lisaobj_files *files)
+{
+    lisaobj_image_options options = { 0 };
+
+    int parse_result = lisaobj_parse_arguments(argc, argv, lisaobj_image_option, &options, files);
+    if (parse_result != EX_OK) return parse_result;
+
+    if (options.output_path && (files->count > 1)) {
+        print_usage("-o can only be used with a single object file");
+        return EX_USAGE;
+    }
+
+    // As with extract, a single file spreads its segments across the
+    // threads, while many files are spread across the threads instead.
+
+    options.image.thread_count = (files->count == 1) ? files->thread_count : 1;
+
+    return lisaobj_run_batch(files, lisaobj_image_file, &options, NULL);
+}
+
+
+// MARK: - Resolve
+
+/*! How to resolve references, as given on the command line. */
+struct lisaobj_resolve_options {
+    bool				unresolved_only;
+    lisa_resolver		*resolver;
+};
+typedef struct lisaobj_resolve_options lisaobj_resolve_options;
+
+
+int
+lisaobj_resolve_option(void *context, const char *arg, const char * LISA_NULLABLE value)
+{
+    lisaobj_resolve_options *options = context;
+    (void)value;
+
+    if (strcmp(arg, "--unresolved") == 0) {
+        options->unresolved_only = true;
+        return 1;
+    }
+
+    return 0;
+}
+
+
+int
+lisaobj_resolve_file(lisa_objfile * LISA_NULLABLE of, const char *path, FILE *out, void * LISA_NULLABLE context)
+{
+    lisaobj_resolve_options *options = context;
+    if (of == NULL) return lisaobj_open_failed(path);
+    (void)out;
+
+    int add_err = lisa_resolver_add(options->resolver, of, path);
+    if (add_err == -1) {
+        fprintf(stderr, "%s: %s" "\n", path, strerror(errno));
+        return EX_OSERR;
+    }
+
+    return EX_OK;
+}
+
+
+/*! Print a result as tab-separated kind, name, location and definition. */
+void
+lisaobj_resolve_print(const lisa_resolve_result *result, void * LISA_NULLABLE context)
+{
+    const lisaobj_resolve_options *options = context;
+    if (options->unresolved_only && (result->kind == lisa_resolve_resolved)) return;
+
+    static const char * const kinds[] = { "resolved", "unresolved", "duplicate" };
+
+    fprintf(stdout, "%s" "\t" "%s" "\t" "%s:%s@%u",
+            kinds[result->kind], result->name,
+            result->location.path, result->location.module, result->location.offset);
+    if (result->kind == lisa_resolve_unresolved) {
+        fprintf(stdout, "\t" "-" "\n");
+    } else {
+        fprintf(stdout, "\t" "%s:%s@%u" "\n",
+                result->definition.path, result->definition.module, result->definition.offset);
+    }
+}
+
+
+int
+lisaobj_resolve(int argc, const char * LISA_NULLABLE argv[], lisaobj_files *files)
+{
+    lisaobj_resolve_options options = { 0 };
+
+    int parse_result = lisaobj_parse_arguments(argc, argv, lisaobj_resolve_option, &options, files);
+    if (parse_result != EX_OK) return parse_result;
+
+    options.resolver = lisa_resolver_create();
+    if (options.resolver == NULL) {
+        fprintf(stderr, "%s" "\n", strerror(errno));
+        return EX_OSERR;
+    }
+
+    // Every file is loaded into the one resolver before anything can be
+    // resolved, so the report comes once the whole batch is done.
+
+    int result = lisaobj_run_batch(files, lisaobj_resolve_file, &options, NULL);
+
+    lisa_resolve_stats stats;
+    int report_err = lisa_resolver_report(options.resolver, lisaobj_resolve_print, &options, &stats);
+    if (report_err == -1) {
+        fprintf(stderr, "%s" "\n", strerror(errno));
+        if (result == EX_OK) result = EX_OSERR;
+    } else {
+        fflush(stdout);
+        fprintf(stderr, "%zu symbols: %zu resolved, %zu unresolved, %zu duplicate" "\n",
+                stats.symbols, stats.resolved, stats.unresolved, stats.duplicates);
+    }
+
+    lisa_resolver_free(options.resolver);
+
+    return result;
+}
+
+
+// MARK: - Rebuild
+
+/*! A segment to replace, as given on the command line. */
+struct lisaobj_rebuild_segment {
+    const char			*name;			//!< not NUL-terminated
+    size_t				name_length;
+    const char			*path;			//!< of its new unpacked code
+};
+typedef struct lisaobj_rebuild_segment lisaobj_rebuild_segment;
+
+/*! How to rebuild an executable, as given on the command line. */
+struct lisaobj_rebuild_options {
+    lisa_rebuild_options	rebuild;
+    const char			* LISA_NULLABLE output_path;
+    lisaobj_rebuild_segment	* LISA_NULLABLE segments;
+    size_t				segment_count;
+};
+typedef struct lisaobj_rebuild_options lisaobj_rebuild_options;
+
+
+int
+lisaobj_rebuild_option(void *context, const char *arg, const char * LISA_NULLABLE value)
+{
+    lisaobj_rebuild_options *options = context;
+
+    if (strcmp(arg, "-o") == 0 && value) {
+        options->output_path = value;
+        return 2;
+    } else if (strcmp(arg, "--segment") == 0 && value) {
+        const char *equals = strchr(value, '=');
+        if ((equals == NULL) || (equals == value) || (equals[1] == '\0')) {
+            print_usage("Invalid segment replacement: %s", value);
+            return -1;
+        }
+
+        lisaobj_rebuild_segment *segments = realloc(options->segments, sizeof(lisaobj_rebuild_segment) * (options->segment_count + 1));
+        if (segments == NULL) {
+            fprintf(stderr, "%s" "\n", strerror(errno));
+            return -1;
+        }
+        segments[options->segment_count] = (lisaobj_rebuild_segment){
+            .name = value,
+            .name_length = (size_t)(equals - value),
+            .path = &equals[1],
+        };
+        options->segments = segments;
+        options->segment_count += 1;
+        return 2;
+    }
+
+    return 0;
+}
+
+
+/*! Read the whole of the file at \a path into a new buffer. */
+uint8_t * LISA_NULLABLE
+lisaobj_read_file(const char *path, size_t *size)
+{
+    uint8_t *content = NULL;
+
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return NULL;
+
+    if (fseeko(f, 0, SEEK_END) == -1) goto error;
+    off_t fs = ftello(f);
+    if (fs == -1) goto error;
+    if (fseeko(f, 0, SEEK_SET) == -1) goto error;
+
+    *size = (size_t)fs;
+    content = malloc(*size ? *size : 1);
+    if (content == NULL) goto error;
+
+    if ((*size > 0) && (fread(content, *size, 1, f) != 1)) {
+        errno = EIO;
+        goto error;
+    }
+
+    fclose(f);
+    return content;
+
+error:
+    fclose(f);
+    free(content);
+    return NULL;
+}
+
+
+int
+lisaobj_rebuild_file(lisa_objfile * LISA_NULLABLE of, const char *path, FILE *out, void * LISA_NULLABLE context)
+{
+    lisaobj_rebuild_options *options = context;
+    if (of == NULL) return lisaobj_open_failed(path);
+    (void)out;
+
+    if (lisa_objfile_executable(of) == NULL) {
+        fprintf(stderr, "%s: not an executable" "\n", path);
+        return EX_DATAERR;
+    }
+
+    char output_path[PATH_MAX];
+    if (options->output_path) {
+        snprintf(output_path, sizeof(output_path), "%s", options->output_path);
+    } else if (snprintf(output_path, sizeof(output_path), "%s.new", path) >= (int)sizeof(output_path)) {
+        fprintf(stderr, "%s: %s" "\n", path, strerror(ENAMETOOLONG));
+        return EX_CANTCREAT;
+    }
+
+    int result = EX_OK;
+    size_t count = 0;
+    lisa_rebuild_replacement *replacements = calloc(sizeof(lisa_rebuild_replacement),
+                                                    options->segment_count ? options->segment_count : 1);
+    if (replacements == NULL) {
+        fprintf(stderr, "%s" "\n", strerror(errno));
+        return EX_OSERR;
+    }
+
+    for (; count < options->segment_count; count++) {
+        const lisaobj_rebuild_segment *spec = &options->segments[count];
+        lisa_rebuild_replacement *replacement = &replacements[count];
+
+        char name[32];
+        snprintf(name, sizeof(name), "%.*s", (int)spec->name_length, spec->name);
+        int lookup_err = lisaobj_find_segment(of, name, &replacement->segment);
+        if ((lookup_err == -1) || (spec->name_length >= sizeof(name))) {
+            fprintf(stderr, "%s: no segment '%.*s'" "\n", path, (int)spec->name_length, spec->name);
+            result = EX_DATAERR;
+            goto done;
+        }
+
+        size_t code_size;
+        uint8_t *code = lisaobj_read_file(spec->path, &code_size);
+        if (code == NULL) {
+            fprintf(stderr, "%s: %s" "\n", spec->path, strerror(errno));
+            result = EX_NOINPUT;
+            goto done;
+        }
+        if ((code_size > INT32_MAX) || (code_size % 2)) {
+            fprintf(stderr, "%s: not a whole number of words" "\n", spec->path);
+            free(code);
+            result = EX_DATAERR;
+            goto done;
+        }
+
+        replacement->code = code;
+        replacement->code_size = (lisa_longint)code_size;
+    }
+
+    lisa_rebuild_stats stats;
+    int rebuild_err = lisa_objfile_rebuild(of, output_path, path, replacements, count, &options->rebuild, &stats);
+    if (rebuild_err == -1) {
+        fprintf(stderr, "%s: rebuild failed: %s" "\n", path, strerror(errno));
+        result = (errno == EINVAL || errno == ENOENT || errno == EFBIG) ? EX_DATAERR : EX_CANTCREAT;
+        goto done;
+    }
+
+    fprintf(stderr, "%s: %zu segments repacked, %zu unchanged; %zu blocks copied, %zu encoded" "\n",
+            output_path, stats.segments_repacked, stats.segments_unchanged,
+            stats.write.blocks_copied, stats.write.blocks_encoded);
+
+done:
+    for (size_t r = 0; r < count; r++) {
+        free((void *)replacements[r].code);
+    }
+    free(replacements);
+    return result;
+}
+
+
+int
+lisaobj_rebuild(int argc, const char * LISA_NULLABLE argv[], lisaobj_files *files)
+{
+    lisaobj_rebuild_options options = { 0 };
+
+    int result = lisaobj_parse_arguments(argc, argv, lisaobj_rebuild_option, &options, files);
+    if (result != EX_OK) goto done;
+
+    if (options.output_path && (files->count > 1)) {
+        print_usage("-o can only be used with a single object file");
+        result = EX_USAGE;
+        goto done;
+    }
+
+    // As with image, a single file spreads its segments across the
+    // threads, while many files are spread across the threads instead.
+
+    options.rebuild.thread_count = (files->count == 1) ? files->thread_count : 1;
+
+    result = lisaobj_run_batch(files, lisaobj_rebuild_file, &options, NULL);
+
+done:
+    free(options.segments);
+    return result;
+}
+
+
+// MARK: - Stats
+
+/*! Write \a s to \a f as a JSON string literal. */
+void
+fprint_json_string(FILE *f, const char *s)
+{
+    fputc('"', f);
+    for (const unsigned char *c = (const unsigned char *)s; *c; c++) {
+        if ((*c == '"') || (*c == '\\')) {
+            fprintf(f, "\\%c", *c);
+        } else if (*c < 0x20) {
+            fprintf(f, "\\u%04x", *c);
+        } else {
+            fputc(*c, f);
+        }
+    }
+    fputc('"', f);
+}
+
+/*! Write \a count integers from \a values to \a f as a JSON array. */
+void
+fprint_json_integers(FILE *f, const lisa_integer *values, int count)
+{
+    fprintf(f, "[");
+    for (int i = 0; i < count; i++) {
+        fprintf(f, "%s%d", (i > 0) ? "," : "", values[i]);
+    }
+    fprintf(f, "]");
+}
+
+/*! Write \a count counts from \a values to \a f as a JSON array. */
+void
+fprint_json_counts(FILE *f, const uint64_t *values, int count)
+{
+    fprintf(f, "[");
+    for (int i = 0; i < count; i++) {
+        fprintf(f, "%s%" PRIu64, (i > 0) ? "," : "", values[i]);
+    }
+    fprintf(f, "]");
+}
+
+/*! Whether all \a count counts from \a values are zero. */
+bool
+counts_empty(const uint64_t *values, int count)
+{
+    for (int i = 0; i < count; i++) {
+        if (values[i] != 0) return false;
+    }
+    return true;
+}
+
+/*! Get a packed/unpacked ratio as a percentage, for display. */
+double
+ratio_percent(int64_t packed_size, int64_t unpacked_size)
+{
+    return (unpacked_size > 0) ? (100.0 * packed_size / unpacked_size) : 0.0;
+}
+
+/*! Write one file's summary as a JSON object. */
+void
+lisaobj_stats_print_json(FILE *out, const char *path, lisa_objfile_summary *summary)
+{
+    fprintf(out, "{\"path\":");
+    fprint_json_string(out, path);
+    fprintf(out, ",\"size\":%d,\"blocks\":%d,\"block_types\":{",
+            summary->file_size, summary->block_count);
+    bool first = true;
+    for (int t = 0; t < 256; t++) {
+        if (summary->block_type_counts[t] == 0) continue;
+        fprintf(out, "%s", first ? "" : ",");
+        fprint_json_string(out, lisa_obj_block_type_string((lisa_obj_block_type)t));
+        fprintf(out, ":%d", summary->block_type_counts[t]);
+        first = false;
+    }
+    fprintf(out, "},\"modules\":%d,\"entries\":%d,\"externals\":%d,\"references\":%d,\"units\":%d,",
+            summary->module_count, summary->entry_count, summary->external_count,
+            summary->reference_count, summary->unit_count);
+    fprintf(out, "\"code_packed_size\":%d,\"code_unpacked_size\":%d,\"segments\":[",
+            summary->code_packed_size, summary->code_unpacked_size);
+    for (lisa_integer i = 0; i < summary->segment_count; i++) {
+        lisa_segment_summary *segment = &summary->segments[i];
+        fprintf(out, "%s{\"module\":", (i > 0) ? "," : "");
+        fprint_json_string(out, segment->module_name);
+        fprintf(out, ",\"segment\":");
+        fprint_json_string(out, segment->segment_name);
+        fprintf(out, ",\"addr\":%d,\"packed\":%s,\"packed_size\":%d,\"unpacked_size\":%d}",
+                segment->addr, segment->packed ? "true" : "false",
+                segment->packed_size, segment->unpacked_size);
+    }
+    fprintf(out, "],\"size_histogram\":");
+    fprint_json_integers(out, summary->size_histogram, LISA_SUMMARY_SIZE_BUCKETS);
+    fprintf(out, ",\"ratio_histogram\":");
+    fprint_json_integers(out, summary->ratio_histogram, LISA_SUMMARY_RATIO_BUCKETS);
+    fprintf(out, "}");
+}
+
+/*! Write one file's summary as a table row, and optionally its segments. */
+void
+lisaobj_stats_print_row(FILE *out, const char *path, lisa_objfile_summary *summary, bool segments)
+{
+    fprintf(out, "%-32s %9d %6d %5d %5d %9d %9d %5.1f%% %5d %5d %6d %4d" "\n",
+            path, summary->file_size, summary->block_count,
+            summary->module_count, summary->segment_count,
+            summary->code_packed_size, summary->code_unpacked_size,
+            ratio_percent(summary->code_packed_size, summary->code_unpacked_size),
+            summary->entry_count, summary->external_count,
+            summary->reference_count, summary->unit_count);
+
+    if (!segments) return;
+
+    for (lisa_integer i = 0; i < summary->segment_count; i++) {
+        lisa_segment_summary *segment = &summary->segments[i];
+        fprintf(out, "\t" "%-8s %-8s $%08x %s %9d %9d %5.1f%%" "\n",
+                segment->module_name, segment->segment_name, segment->addr,
+                segment->packed ? "packed" : "raw   ",
+                segment->packed_size, segment->unpacked_size,
+                ratio_percent(segment->packed_size, segment->unpacked_size));
+    }
+}
+
+
+/*! How to summarize files, and the totals across all of them so far. */
+struct lisaobj_stats_options {
+    bool					json;
+    bool					segments;
+
+    pthread_mutex_t			lock;
+    lisa_summary_totals		totals;			//!< per-file summaries aren't kept
+};
+typedef struct lisaobj_stats_options lisaobj_stats_options;
+
+
+int
+lisaobj_stats_option(void *context, const char *arg, const char * LISA_NULLABLE value)
+{
+    lisaobj_stats_options *options = context;
+    (void)value;
+
+    if (strcmp(arg, "--json") == 0) {
+        options->json = true;
+        return 1;
+    } else if (strcmp(arg, "--segments") == 0) {
+        options->segments = true;
+        return 1;
+    }
+
+    return 0;
+}
+
+
+int
+lisaobj_stats_file(lisa_objfile * LISA_NULLABLE of, const char *path, FILE *out, void * LISA_NULLABLE context)
+{
+    lisaobj_stats_options *options = context;
+    if (of == NULL) return lisaobj_open_failed(path);
+
+    lisa_objfile_summary summary;
+    int summarize_err = lisa_objfile_summarize(of, &summary);
+    if (summarize_err == -1) {
+        fprintf(stderr, "%s: %s" "\n", path, strerror(errno));
+        return EX_SOFTWARE;
+    }
+
+    if (options->json) {
+        lisaobj_stats_print_json(out, path, &summary);
+    } else {
+        lisaobj_stats_print_row(out, path, &summary, options->segments);
+    }
+
+    pthread_mutex_lock(&options->lock);
+
+    lisa_summary_totals_add(&options->totals, &summary);
+
+    pthread_mutex_unlock(&options->lock);
+
+    lisa_objfile_summary_free(&summary);
+
+    return EX_OK;
+}
+
+
+int
+lisaobj_stats(int argc, const char * LISA_NULLABLE argv[], lisaobj_files *files)
+{
+    lisaobj_stats_options options;
+    memset(&options, 0, sizeof(options));
+
+    int parse_result = lisaobj_parse_arguments(argc, argv, lisaobj_stats_option, &options, files);
+    if (parse_result != EX_OK) return parse_result;
+
+    if (options.json) {
+        fprintf(stdout, "{\"files\":[");
+    } else {
+        fprintf(stdout, "%-32s %9s %6s %5s %5s %9s %9s %6s %5s %5s %6s %4s" "\n",
+                "file", "size", "blocks", "mods", "segs", "packed", "unpacked",
+                "ratio", "entry", "extrn", "refs", "unit");
+    }
+
+    pthread_mutex_init(&options.lock, NULL);
+    int result = lisaobj_run_batch(files, lisaobj_stats_file, &options, options.json ? "," : NULL);
+    pthread_mutex_destroy(&options.lock);
+
+    const lisa_summary_totals *totals = &options.totals;
+
+    if (options.json) {
+        fprintf(stdout, "],\"totals\":{\"files\":%" PRIu64 ",\"size\":%" PRId64 ",\"blocks\":%" PRIu64
+                ",\"modules\":%" PRIu64 ",\"segments\":%" PRIu64 ",",
+                totals->file_count, totals->file_size, totals->block_count,
+                totals->module_count, totals->segment_count);
+        fprintf(stdout, "\"entries\":%" PRIu64 ",\"externals\":%" PRIu64 ",\"references\":%" PRId64
+                ",\"units\":%" PRIu64 ",",
+                totals->entry_count, totals->external_count, totals->reference_count, totals->unit_count);
+        fprintf(stdout, "\"code_packed_size\":%" PRId64 ",\"code_unpacked_size\":%" PRId64 ",\"block_types\":{",
+                totals->code_packed_size, totals->code_unpacked_size);
+        bool first = true;
+        for (int t = 0; t < 256; t++) {
+            if (totals->block_type_counts[t] == 0) continue;
+            fprintf(stdout, "%s", first ? "" : ",");
+            fprint_json_string(stdout, lisa_obj_block_type_string((lisa_obj_block_type)t));
+            fprintf(stdout, ":%" PRIu64, totals->block_type_counts[t]);
+            first = false;
+        }
+        fprintf(stdout, "},\"size_histogram\":");
+        fprint_json_counts(stdout, totals->size_histogram, LISA_SUMMARY_SIZE_BUCKETS);
+        fprintf(stdout, ",\"ratio_histogram\":");
+        fprint_json_counts(stdout, totals->ratio_histogram, LISA_SUMMARY_RATIO_BUCKETS);
+        fprintf(stdout, "}}" "\n");
+        return result;
+    }
+
+    fprintf(stdout, "%" PRIu64 " files, %" PRId64 " bytes, %" PRId64 " code bytes packed to %" PRId64 " (%.1f%%)" "\n",
+            totals->file_count, totals->file_size, totals->code_unpacked_size, totals->code_packed_size,
+            ratio_percent(totals->code_packed_size, totals->code_unpacked_size));
+
+    // Sections with nothing in them are left out altogether.
+
+    if (!counts_empty(totals->block_type_counts, 256)) fprintf(stdout, "Block types:" "\n");
+    for (int t = 0; t < 256; t++) {
+        if (totals->block_type_counts[t] == 0) continue;
+        fprintf(stdout, "\t" "%-16s %" PRIu64 "\n",
+                lisa_obj_block_type_string((lisa_obj_block_type)t), totals->block_type_counts[t]);
+    }
+
+    if (!counts_empty(totals->size_histogram, LISA_SUMMARY_SIZE_BUCKETS)) fprintf(stdout, "Unpacked segment sizes:" "\n");
+    for (int i = 0; i < LISA_SUMMARY_SIZE_BUCKETS; i++) {
+        if (totals->size_histogram[i] == 0) continue;
+        if (i == 0) {
+            // The first bucket holds empty segments too.
+            fprintf(stdout, "\t" "<  %-10d %" PRIu64 "\n", 2, totals->size_histogram[i]);
+        } else {
+            fprintf(stdout, "\t" ">= %-10lld %" PRIu64 "\n", 1LL << i, totals->size_histogram[i]);
+        }
+    }
+
+    if (!counts_empty(totals->ratio_histogram, LISA_SUMMARY_RATIO_BUCKETS)) fprintf(stdout, "Compression ratios:" "\n");
+    for (int i = 0; i < LISA_SUMMARY_RATIO_BUCKETS; i++) {
+        if (totals->ratio_histogram[i] == 0) continue;
+        if (i < LISA_SUMMARY_RATIO_BUCKETS - 1) {
+            fprintf(stdout, "\t" "%3d-%3d%%    %" PRIu64 "\n", i * 10, i * 10 + 9, totals->ratio_histogram[i]);
+        } else {
+            fprintf(stdout, "\t" "%3d%%+       %" PRIu64 "\n", i * 10, totals->ratio_histogram[i]);
+        }
+    }
+
+    return result;
+}
+
+
+// MARK: - Link
+
+/*! How to link object files, as given on the command line. */
+struct lisaobj_link_options {
+    lisa_link_options	link;
+    const char			* LISA_NULLABLE output_path;
+    const char			* LISA_NULLABLE map_path;
+};
+typedef struct lisaobj_link_options lisaobj_link_options;
+
+
+int
+lisaobj_link_option(void *context, const char *arg, const char * LISA_NULLABLE value)
+{
+    lisaobj_link_options *options = context;
+
+    if (strcmp(arg, "-o") == 0 && value) {
+        options->output_path = value;
+        return 2;
+    } else if (strcmp(arg, "--map") == 0 && value) {
+        options->map_path = value;
+        return 2;
+    } else if (strcmp(arg, "--base") == 0 && value) {
+        long base;
+        if (!parse_number(value, &base) || (base < 0) || (base > (long)UINT32_MAX)) {
+            print_usage("Invalid base address: %s", value);
+            return -1;
+        }
+        options->link.base = (lisa_MemAddr)(uint32_t)base;
+        return 2;
+    } else if (strcmp(arg, "--allow-unresolved") == 0) {
+        options->link.allow_unresolved = true;
+        return 1;
+    }
+
+    return 0;
+}
+
+
+int
+lisaobj_link(int argc, const char * LISA_NULLABLE argv[], lisaobj_files *files)
+{
+    lisaobj_link_options options = { 0 };
+    lisa_link_input *inputs = NULL;
+    size_t count = 0;
+
+    int result = lisaobj_parse_arguments(argc, argv, lisaobj_link_option, &options, files);
+    if (result != EX_OK) return result;
+
+    if (options.output_path == NULL) {
+        print_usage("link needs an output file, given with -o");
+        return EX_USAGE;
+    }
+    if (files->count == 0) {
+        print_usage("link needs at least one object file");
+        return EX_USAGE;
+    }
+
+    // Unlike the other commands, linking needs every file at once, so
+    // they're all opened up front rather than run through as a batch.
+
+    inputs = calloc(sizeof(lisa_link_input), files->count);
+    if (inputs == NULL) {
+        fprintf(stderr, "%s" "\n", strerror(errno));
+        return EX_OSERR;
+    }
+
+    for (; count < files->count; count++) {
+        const char *path = files->paths[count];
+        lisa_objfile *of = lisa_objfile_open(path);
+        if (of == NULL) {
+            result = lisaobj_open_failed(path);
+            goto done;
+        }
+        if (lisa_objfile_executable(of) != NULL) {
+            fprintf(stderr, "%s: already an executable" "\n", path);
+            lisa_objfile_close(of);
+            result = EX_DATAERR;
+            goto done;
+        }
+        inputs[count] = (lisa_link_input){ .objfile = of, .path = path };
+    }
+
+    if (options.map_path) {
+        options.link.map = (strcmp(options.map_path, "-") == 0) ? stdout : fopen(options.map_path, "w");
+        if (options.link.map == NULL) {
+            fprintf(stderr, "%s: %s" "\n", options.map_path, strerror(errno));
+            result = EX_CANTCREAT;
+            goto done;
+        }
+    }
+
+    options.link.thread_count = files->thread_count;
+
+    lisa_link_stats stats = { 0 };
+    int link_err = lisa_link(inputs, count, options.output_path, &options.link, &stats);
+    if ((link_err == -1) && (errno == ENOENT) && (stats.unresolved > 0)) {
+        fprintf(stderr, "%s: %zu unresolved references; see 'resolve --unresolved', or use --allow-unresolved" "\n",
+                options.output_path, stats.unresolved);
+        result = EX_DATAERR;
+        goto done;
+    } else if (link_err == -1) {
+        fprintf(stderr, "%s: link failed: %s" "\n", options.output_path, strerror(errno));
+        result = (errno == EINVAL || errno == EFBIG) ? EX_DATAERR : EX_CANTCREAT;
+        goto done;
+    }
+
+    fprintf(stderr, "%s: %zu modules in %zu segments, %zu symbols, %zu jump table entries, %zu relocations" "\n",
+            options.output_path, stats.modules, stats.segments, stats.symbols,
+            stats.jump_table_entries, stats.relocations);
+    if (stats.duplicates || stats.unresolved || stats.truncated) {
+        fprintf(stderr, "%s: %zu duplicate definitions, %zu unresolved references, %zu truncated fields" "\n",
+                options.output_path, stats.duplicates, stats.unresolved, stats.truncated);
+    }
+    fprintf(stderr, "%s: %zu code bytes packed to %zu (%.1f%%)" "\n",
+            options.output_path, stats.code_size, stats.packed_size,
+            ratio_percent((int64_t)stats.packed_size, (int64_t)stats.code_size));
+
+done:
+    if (options.link.map && (options.link.map != stdout)) fclose(options.link.map);
+    for (size_t i = 0; i < count; i++) {
+        lisa_objfile_close(inputs[i].objfile);
+    }
+    free(inputs);
+    return result;
+}
+
+
+// MARK: - Diff
+
+/*! How to compare two object files, as given on the command line. */
+struct lisaobj_diff_options {
+    lisa_diff_options	diff;
+};
+typedef struct lisaobj_diff_options lisaobj_diff_options;
+
+
+int
+lisaobj_diff_option(void *context, const char *arg, const char * LISA_NULLABLE value)
+{
+    lisaobj_diff_options *options = context;
+    (void)value;
+
+    if (strcmp(arg, "--segments") == 0) {
+        options->diff.segments_only = true;
+        return 1;
+    } else if (strcmp(arg, "--brief") == 0) {
+        options->diff.ranges = false;
+        return 1;
+    }
+
+    return 0;
+}
+
+
+/*! Print a difference, with any byte ranges indented below it. */
+void
+lisaobj_diff_print(const lisa_diff_result *result, void * LISA_NULLABLE context)
+{
+    static const char * const kinds[] = { "added", "removed", "changed" };
+    (void)context;
+
+    if (result->item == lisa_diff_item_segment) {
+        fprintf(stdout, "%s" "\t" "segment" "\t" "%s" "\t" "%d -> %d bytes" "\n",
+                kinds[result->kind], result->name, result->old_size, result->new_size);
+
+        for (size_t r = 0; r < result->range_count; r++) {
+            const lisa_diff_range *range = &result->ranges[r];
+            fprintf(stdout, "\t" "$%06x+%d" "\t" "$%06x+%d" "\n",
+                    range->old_offset, range->old_size, range->new_offset, range->new_size);
+        }
+        return;
+    }
+
+    fprintf(stdout, "%s" "\t" "block" "\t" "%s" "\t" "%s",
+            kinds[result->kind], result->name[0] ? result->name : "-",
+            lisa_obj_block_type_string(result->type));
+    if (result->old_index != -1) {
+        fprintf(stdout, "\t" "old #%d@%d", result->old_index, result->old_offset);
+    }
+    if (result->new_index != -1) {
+        fprintf(stdout, "\t" "new #%d@%d", result->new_index, result->new_offset);
+    }
+    fprintf(stdout, "\n");
+}
+
+
+int
+lisaobj_diff(int argc, const char * LISA_NULLABLE argv[], lisaobj_files *files)
+{
+    lisaobj_diff_options options = { .diff.ranges = true };
+
+    int result = lisaobj_parse_arguments(argc, argv, lisaobj_diff_option, &options, files);
+    if (result != EX_OK) return result;
+
+    if (files->count != 2) {
+        print_usage("diff compares exactly two object files");
+        return EX_USAGE;
+    }
+
+    // Both files are needed at once, so they're opened directly rather
+    // than run through as a batch.
+
+    const char *old_path = files->paths[0];
+    const char *new_path = files->paths[1];
+    lisa_objfile *old_of = lisa_objfile_open(old_path);
+    if (old_of == NULL) return lisaobj_open_failed(old_path);
+    lisa_objfile *new_of = lisa_objfile_open(new_path);
+    if (new_of == NULL) {
+        lisa_objfile_close(old_of);
+        return lisaobj_open_failed(new_path);
+    }
+
+    lisa_diff_stats stats;
+    int diff_err = lisa_objfile_diff(old_of, new_of, &options.diff, lisaobj_diff_print, NULL, &stats);
+    if (diff_err == -1) {
+        fprintf(stderr, "%s: %s: %s" "\n", old_path, new_path, strerror(errno));
+        result = EX_SOFTWARE;
+    } else {
+        fflush(stdout);
+        fprintf(stderr, "segments: %zu same (%zu as stored), %zu changed, %zu added, %zu removed; %zu bytes differ" "\n",
+                stats.segments_same, stats.segments_same_packed, stats.segments_changed,
+                stats.segments_added, stats.segments_removed, stats.bytes_changed);
+        if (!options.diff.segments_only) {
+            fprintf(stderr, "blocks: %zu same, %zu changed, %zu added, %zu removed" "\n",
+                    stats.blocks_same, stats.blocks_changed, stats.blocks_added, stats.blocks_removed);
+        }
+
+        // As with diff(1), finding differences is reported in the exit status.
+
+        bool differ = stats.segments_changed || stats.segments_added || stats.segments_removed
+                    || stats.blocks_changed || stats.blocks_added || stats.blocks_removed;
+        result = differ ? 1 : EX_OK;
+    }
+
+    lisa_objfile_close(old_of);
+    lisa_objfile_close(new_of);
+    return result;
+}
+
+
+// MARK: - Similar
+
+/*! How to build or query a similarity index, as given on the command line. */
+struct lisaobj_similar_options {
+    const char			* LISA_NULLABLE build_path;
+    const char			* LISA_NULLABLE index_path;
+    const char			* LISA_NULLABLE segment_name;
+    size_t				top;
+    double				min_similarity;
+
+    lisa_similar_index	* LISA_NULLABLE index;
+    pthread_mutex_t		lock;
+    size_t				files;			//!< added to the index
+    lisa_similar_stats	totals;
+};
+typedef struct lisaobj_similar_options lisaobj_similar_options;
+
+
+int
+lisaobj_similar_option(void *context, const char *arg, const char * LISA_NULLABLE value)
+{
+    lisaobj_similar_options *options = context;
+
+    if (strcmp(arg, "--build") == 0 && value) {
+        options->build_path = value;
+        return 2;
+    } else if (strcmp(arg, "--index") == 0 && value) {
+        options->index_path = value;
+        return 2;
+    } else if (strcmp(arg, "--segment") == 0 && value) {
+        options->segment_name = value;
+        return 2;
+    } else if (strcmp(arg, "--top") == 0 && value) {
+        long top;
+        if (!parse_number(value, &top) || (top < 1) || (top > 100000)) {
+            print_usage("Invalid match count: %s", value);
+            return -1;
+        }
+        options->top = (size_t)top;
+        return 2;
+    } else if (strcmp(arg, "--min") == 0 && value) {
+        long percent;
+        if (!parse_number(value, &percent) || (percent < 0) || (percent > 100)) {
+            print_usage("Invalid similarity: %s", value);
+            return -1;
+        }
+        options->min_similarity = (double)percent / 100.0;
+        return 2;
+    }
+
+    return 0;
+}
+
+
+int
+lisaobj_similar_build_file(lisa_objfile * LISA_NULLABLE of, const char *path, FILE *out, void * LISA_NULLABLE context)
+{
+    lisaobj_similar_options *options = context;
+    if (of == NULL) return lisaobj_open_failed(path);
+    (void)out;
+
+    lisa_similar_stats stats;
+    int add_err = lisa_similar_index_add(options->index, of, path, &stats);
+    if (add_err == -1) {
+        fprintf(stderr, "%s: %s" "\n", path, strerror(errno));
+        return EX_DATAERR;
+    }
+
+    pthread_mutex_lock(&options->lock);
+    options->files += 1;
+    options->totals.segments += stats.segments;
+    options->totals.masked += stats.masked;
+    pthread_mutex_unlock(&options->lock);
+
+    return EX_OK;
+}
+
+
+/*! Print the segments in the index most similar to \a segment, leaving out the segment itself. */
+int
+lisaobj_similar_query_segment(lisaobj_similar_options *options, lisa_objfile *of, const char *path,
+                              const lisa_segment *segment, lisa_similar_match *matches, FILE *out)
+{
+    if (segment->unpacked_size < 2) return EX_OK;
+
+    lisa_similar_sketch sketch;
+    if (lisa_segment_sketch(of, segment, &sketch, NULL) == -1) {
+        fprintf(stderr, "%s: %s: %s" "\n", path, segment->name, strerror(errno));
+        return EX_DATAERR;
+    }
+
+    size_t count;
+    int query_err = lisa_similar_index_query(options->index, &sketch, options->min_similarity,
+                                             options->top + 1, matches, &count);
+    if (query_err == -1) {
+        fprintf(stderr, "%s: %s: %s" "\n", path, segment->name, strerror(errno));
+        return EX_OSERR;
+    }
+
+    fprintf(out, "%s:%s" "\n", path, segment->name);
+
+    size_t printed = 0;
+    for (size_t m = 0; (m < count) && (printed < options->top); m++) {
+        const lisa_similar_match *match = &matches[m];
+        if ((strcmp(match->path, path) == 0) && (strcmp(match->name, segment->name) == 0)) continue;
+
+        fprintf(out, "  " "%5.1f%%" "\t" "%s:%s" "\t" "%d bytes" "\n",
+                match->similarity * 100.0, match->path, match->name, match->size);
+        printed += 1;
+    }
+
+    return EX_OK;
+}
+
+
+int
+lisaobj_similar_query_file(lisa_objfile * LISA_NULLABLE of, const char *path, FILE *out, void * LISA_NULLABLE context)
+{
+    lisaobj_similar_options *options = context;
+    if (of == NULL) return lisaobj_open_failed(path);
+
+    lisa_similar_match *matches = calloc(sizeof(lisa_similar_match), options->top + 1);
+    if (matches == NULL) {
+        fprintf(stderr, "%s" "\n", strerror(errno));
+        return EX_OSERR;
+    }
+
+    int result = EX_OK;
+    if (options->segment_name) {
+        lisa_segment segment;
+        if (lisaobj_find_segment(of, options->segment_name, &segment) == -1) {
+            fprintf(stderr, "%s: no segment '%s'" "\n", path, options->segment_name);
+            result = EX_DATAERR;
+        } else {
+            result = lisaobj_similar_query_segment(options, of, path, &segment, matches, out);
+        }
+    } else {
+        const lisa_integer segment_count = lisa_objfile_segment_count(of);
+        for (lisa_integer s = 0; (s < segment_count) && (result == EX_OK); s++) {
+            lisa_segment segment;
+            if (lisa_objfile_segment_at_index(of, s, &segment) == -1) continue;
+            result = lisaobj_similar_query_segment(options, of, path, &segment, matches, out);
+        }
+    }
+
+    free(matches);
+    return result;
+}
+
+
+int
+lisaobj_similar(int argc, const char * LISA_NULLABLE argv[], lisaobj_files *files)
+{
+    lisaobj_similar_options options = { .top = 10, .min_similarity = 0.5 };
+
+    int result = lisaobj_parse_arguments(argc, argv, lisaobj_similar_option, &options, files);
+    if (result != EX_OK) return result;
+
+    if ((options.build_path == NULL) == (options.index_path == NULL)) {
+        print_usage("similar needs either --build or --index");
+        return EX_USAGE;
+    }
+
+    pthread_mutex_init(&options.lock, NULL);
+
+    if (options.build_path) {
+        options.index = lisa_similar_index_create();
+        if (options.index == NULL) {
+            fprintf(stderr, "%s" "\n", strerror(errno));
+            result = EX_OSERR;
+            goto done;
+        }
+
+        result = lisaobj_run_batch(files, lisaobj_similar_build_file, &options, NULL);
+        if (result != EX_OK) goto done;
+
+        if (lisa_similar_index_write(options.index, options.build_path) == -1) {
+            fprintf(stderr, "%s: %s" "\n", options.build_path, strerror(errno));
+            result = EX_CANTCREAT;
+            goto done;
+        }
+
+        fprintf(stderr, "%s: %zu segments from %zu files, %zu relocated fields masked" "\n",
+                options.build_path, options.totals.segments, options.files, options.totals.masked);
+    } else {
+        options.index = lisa_similar_index_read(options.index_path);
+        if (options.index == NULL) {
+            fprintf(stderr, "%s: %s" "\n", options.index_path,
+                    (errno == EINVAL) ? "not a similarity index" : strerror(errno));
+            result = EX_NOINPUT;
+            goto done;
+        }
+
+        result = lisaobj_run_batch(files, lisaobj_similar_query_file, &options, NULL);
+    }
+
+done:
+    lisa_similar_index_free(options.index);
+    pthread_mutex_destroy(&options.lock);
+    return result;
+}
+
+
+// MARK: - Verify
+
+/*! How to verify object files, as given on the command line, and what's been checked so far. */
+struct lisaobj_verify_options {
+    lisa_verify_options	verify;
+
+    pthread_mutex_t		lock;
+    size_t				failed_files;
+    lisa_verify_stats	totals;
+};
+typedef struct lisaobj_verify_options lisaobj_verify_options;
+
+
+/*! Where a file's problems are printed, and the file they're in. */
+struct lisaobj_verify_report {
+    const char			*path;
+    FILE				*out;
+};
+typedef struct lisaobj_verify_report lisaobj_verify_report;
+
+
+int
+lisaobj_verify_option(void *context, const char *arg, const char * LISA_NULLABLE value)
+{
+    lisaobj_verify_options *options = context;
+    (void)value;
+
+    if (strcmp(arg, "--no-repack") == 0) {
+        options->verify.no_repack = true;
+        return 1;
+    }
+
+    return 0;
+}
+
+
+/*! Print a problem as the block it's in, the segment, and what's wrong. */
+void
+lisaobj_verify_print(const lisa_verify_result *result, void * LISA_NULLABLE context)
+{
+    const lisaobj_verify_report *report = context;
+
+    fprintf(report->out, "%s: block %d %s at $%06x", report->path,
+            result->block, lisa_obj_block_type_string(result->type), result->offset);
+    if (result->entry >= 0) fprintf(report->out, " entry %d", result->entry);
+    if (result->name[0] != '\0') fprintf(report->out, " (%s)", result->name);
+    fprintf(report->out, ": %s", lisa_verify_problem_string(result->problem));
+
+    switch (result->problem) {
+        case lisa_verify_unpack_failed:
+        case lisa_verify_repack_differs:
+            if (result->actual >= 0) {
+                fprintf(report->out, " (%lld bytes, packed back to %lld)",
+                        (long long)result->expected, (long long)result->actual);
+            }
+            break;
+
+        case lisa_verify_location_missing:
+            fprintf(report->out, " ($%06llx)", (unsigned long long)result->expected);
+            break;
+
+        default:
+            fprintf(report->out, " (%lld, not %lld)",
+                    (long long)result->actual, (long long)result->expected);
+            break;
+    }
+    fprintf(report->out, "\n");
+}
+
+
+int
+lisaobj_verify_file(lisa_objfile * LISA_NULLABLE of, const char *path, FILE *out, void * LISA_NULLABLE context)
+{
+    lisaobj_verify_options *options = context;
+    if (of == NULL) return lisaobj_open_failed(path);
+
+    lisaobj_verify_report report = { .path = path, .out = out };
+    lisa_verify_stats stats;
+    int verify_err = lisa_objfile_verify(of, &options->verify, lisaobj_verify_print, &report, &stats);
+    if (verify_err == -1) {
+        fprintf(stderr, "%s: %s" "\n", path, strerror(errno));
+        return EX_OSERR;
+    }
+
+    if (stats.problems == 0) {
+        fprintf(out, "%s: ok, %zu packed blocks, %zu segment table entries" "\n",
+                path, stats.packed_blocks, stats.locations);
+    } else {
+        fprintf(out, "%s: %zu problem%s in %zu packed blocks, %zu segment table entries" "\n",
+                path, stats.problems, (stats.problems == 1) ? "" : "s", stats.packed_blocks, stats.locations);
+    }
+
+    pthread_mutex_lock(&options->lock);
+    if (stats.problems > 0) options->failed_files += 1;
+    options->totals.packed_blocks += stats.packed_blocks;
+    options->totals.packed_bytes += stats.packed_bytes;
+    options->totals.unpacked_bytes += stats.unpacked_bytes;
+    options->totals.locations += stats.locations;
+    options->totals.problems += stats.problems;
+    pthread_mutex_unlock(&options->lock);
+
+    return (stats.problems == 0) ? EX_OK : EX_DATAERR;
+}
+
+
+int
+lisaobj_verify(int argc, const char * LISA_NULLABLE argv[], lisaobj_files *files)
+{
+    lisaobj_verify_options options = { 0 };
+
+    int parse_result = lisaobj_parse_arguments(argc, argv, lisaobj_verify_option, &options, files);
+    if (parse_result != EX_OK) return parse_result;
+
+    // As with extract, a single file spreads its blocks across the
+    // threads; many files are spread across the threads instead.
+
+    if (files->count == 1) {
+        options.verify.thread_count = files->thread_count;
+    } else {
+        options.verify.thread_count = 1;
+    }
+
+    pthread_mutex_init(&options.lock, NULL);
+    int result = lisaobj_run_batch(files, lisaobj_verify_file, &options, NULL);
+    pthread_mutex_destroy(&options.lock);
+
+    if (files->count > 1) {
+        fprintf(stdout, "%zu files: %zu with problems, %zu problem%s in %zu packed blocks (%zu bytes, %zu unpacked)" "\n",
+                files->count, options.failed_files, options.totals.problems, (options.totals.problems == 1) ? "" : "s",
+                options.totals.packed_blocks, options.totals.packed_bytes, options.totals.unpacked_bytes);
+    }
+
+    return result;
+}
+
+
+// MARK: - Checksum
+
+/*! How to checksum object files, as given on the command line, and what's been checked so far. */
+struct lisaobj_checksum_options {
+    const char				* LISA_NULLABLE output_path;
+    const char				* LISA_NULLABLE verify_path;
+    bool					update;
+
+    lisa_checksum_manifest	* LISA_NULLABLE manifest;
+    pthread_mutex_t			lock;
+    size_t					checksums;
+    size_t					failed_files;
+    size_t					differences;
+};
+typedef struct lisaobj_checksum_options lisaobj_checksum_options;
+
+
+/*! Where a file's differences are printed. */
+struct lisaobj_checksum_report {
+    FILE					*out;
+};
+typedef struct lisaobj_checksum_report lisaobj_checksum_report;
+
+
+int
+lisaobj_checksum_option(void *context, const char *arg, const char * LISA_NULLABLE value)
+{
+    lisaobj_checksum_options *options = context;
+
+    if (strcmp(arg, "-o") == 0 && value) {
+        options->output_path = value;
+        return 2;
+    } else if (strcmp(arg, "--update") == 0) {
+        options->update = true;
+        return 1;
+    } else if (strcmp(arg, "--verify") == 0 && value) {
+        options->verify_path = value;
+        return 2;
+    }
+
+    return 0;
+}
+
+
+int
+lisaobj_checksum_file(lisa_objfile * LISA_NULLABLE of, const char *path, FILE *out, void * LISA_NULLABLE context)
+{
+    lisaobj_checksum_options *options = context;
+    if (of == NULL) return lisaobj_open_failed(path);
+    (void)out;
+
+    lisa_checksum *checksums;
+    size_t count;
+    if (lisa_objfile_checksums(of, &checksums, &count) == -1) {
+        fprintf(stderr, "%s: %s" "\n", path,
+                (errno == EINVAL) ? "a segment's code doesn't unpack" : strerror(errno));
+        return EX_DATAERR;
+    }
+
+    int set_err = lisa_checksum_manifest_set(options->manifest, path, checksums, count);
+    free(checksums);
+    if (set_err == -1) {
+        fprintf(stderr, "%s: %s" "\n", path, strerror(errno));
+        return EX_OSERR;
+    }
+
+    pthread_mutex_lock(&options->lock);
+    options->checksums += count;
+    pthread_mutex_unlock(&options->lock);
+
+    return EX_OK;
+}
+
+
+/*! Print a difference as the checksum it's about, and what each side has. */
+void
+lisaobj_checksum_print(lisa_checksum_difference difference, const char *path,
+                       const lisa_checksum * LISA_NULLABLE expected, const lisa_checksum * LISA_NULLABLE actual,
+                       void * LISA_NULLABLE context)
+{
+    const lisaobj_checksum_report *report = context;
+    const lisa_checksum *checksum = expected ? expected : actual;
+    static const char * const differences[] = { "changed", "missing", "added" };
+
+    fprintf(report->out, "%s: %s %u %s %s", path,
+            lisa_checksum_kind_string(checksum->kind), checksum->index, checksum->name, differences[difference]);
+    if (expected) {
+        fprintf(report->out, ", was %" PRIu64 " bytes %08" PRIx32 " %016" PRIx64,
+                expected->size, expected->crc32c, expected->xxh64);
+    }
+    if (actual) {
+        fprintf(report->out, ", %s %" PRIu64 " bytes %08" PRIx32 " %016" PRIx64,
+                expected ? "now" : "is", actual->size, actual->crc32c, actual->xxh64);
+    }
+    fprintf(report->out, "\n");
+}
+
+
+int
+lisaobj_checksum_verify_file(lisa_objfile * LISA_NULLABLE of, const char *path, FILE *out, void * LISA_NULLABLE context)
+{
+    lisaobj_checksum_options *options = context;
+    if (of == NULL) return lisaobj_open_failed(path);
+
+    lisa_checksum *checksums;
+    size_t count;
+    if (lisa_objfile_checksums(of, &checksums, &count) == -1) {
+        fprintf(out, "%s: %s" "\n", path,
+                (errno == EINVAL) ? "a segment's code doesn't unpack" : strerror(errno));
+        pthread_mutex_lock(&options->lock);
+        options->failed_files += 1;
+        pthread_mutex_unlock(&options->lock);
+        return EX_DATAERR;
+    }
+
+    lisaobj_checksum_report report = { .out = out };
+    size_t differences = 0;
+    int compare_err = lisa_checksum_manifest_compare(options->manifest, path, checksums, count,
+                                                     lisaobj_checksum_print, &report, &differences);
+    int compare_errno = errno;
+    free(checksums);
+
+    if ((compare_err == -1) && (compare_errno != ENOENT)) {
+        fprintf(stderr, "%s: %s" "\n", path, strerror(compare_errno));
+        return EX_OSERR;
+    }
+
+    if (compare_err == -1) {
+        fprintf(out, "%s: not in manifest" "\n", path);
+    } else if (differences == 0) {
+        fprintf(out, "%s: ok, %zu checksums" "\n", path, count);
+    } else {
+        fprintf(out, "%s: %zu difference%s in %zu checksums" "\n",
+                path, differences, (differences == 1) ? "" : "s", count);
+    }
+
+    bool failed = (compare_err == -1) || (differences > 0);
+
+    pthread_mutex_lock(&options->lock);
+    options->checksums += count;
+    options->differences += differences;
+    if (failed) options->failed_files += 1;
+    pthread_mutex_unlock(&options->lock);
+
+    return failed ? EX_DATAERR : EX_OK;
+}
+
+
+int
+lisaobj_checksum(int argc, const char * LISA_NULLABLE argv[], lisaobj_files *files)
+{
+    lisaobj_checksum_options options = { 0 };
+
+    int result = lisaobj_parse_arguments(argc, argv, lisaobj_checksum_option, &options, files);
+    if (result != EX_OK) return result;
+
+    if (options.verify_path && (options.output_path || options.update)) {
+        print_usage("--verify can't be used with -o or --update");
+        return EX_USAGE;
+    }
+
+    if (options.update && (options.output_path == NULL)) {
+        print_usage("--update needs -o");
+        return EX_USAGE;
+    }
+
+    pthread_mutex_init(&options.lock, NULL);
+
+    if (options.verify_path) {
+        // Any of the files in a manifest can be checked against it, so a
+        // large archive can be checked a part at a time.
+
+        options.manifest = lisa_checksum_manifest_read(options.verify_path);
+        if (options.manifest == NULL) {
+            fprintf(stderr, "%s: %s" "\n", options.verify_path,
+                    (errno == EINVAL) ? "not a checksum manifest" : strerror(errno));
+            result = EX_NOINPUT;
+            goto done;
+        }
+
+        result = lisaobj_run_batch(files, lisaobj_checksum_verify_file, &options, NULL);
+
+        if (files->count > 1) {
+            fprintf(stdout, "%zu files: %zu failed, %zu difference%s in %zu checksums" "\n",
+                    files->count, options.failed_files, options.differences,
+                    (options.differences == 1) ? "" : "s", options.checksums);
+        }
+        goto done;
+    }
+
+    // Updating a manifest replaces the checksums of the files given and
+    // keeps everyone else's.
+
+    if (options.update) {
+        options.manifest = lisa_checksum_manifest_read(options.output_path);
+        if ((options.manifest == NULL) && (errno != ENOENT)) {
+            fprintf(stderr, "%s: %s" "\n", options.output_path,
+                    (errno == EINVAL) ? "not a checksum manifest" : strerror(errno));
+            result = EX_NOINPUT;
+            goto done;
+        }
+    }
+    if (options.manifest == NULL) options.manifest = lisa_checksum_manifest_create();
+    if (options.manifest == NULL) {
+        fprintf(stderr, "%s" "\n", strerror(errno));
+        result = EX_OSERR;
+        goto done;
+    }
+
+    // Files that can't be checksummed are reported and left out, so
+    // one damaged file doesn't keep the rest from being recorded.
+
+    result = lisaobj_run_batch(files, lisaobj_checksum_file, &options, NULL);
+    if (result == EX_OSERR) goto done;
+
+    if (options.output_path) {
+        if (lisa_checksum_manifest_write(options.manifest, options.output_path) == -1) {
+            fprintf(stderr, "%s: %s" "\n", options.output_path, strerror(errno));
+            result = EX_CANTCREAT;
+            goto done;
+        }
+
+        fprintf(stderr, "%s: %zu checksums of %zu file%s, %zu in all" "\n",
+                options.output_path, options.checksums, files->count, (files->count == 1) ? "" : "s",
+                lisa_checksum_manifest_file_count(options.manifest));
+    } else {
+        if (lisa_checksum_manifest_fwrite(options.manifest, stdout) == -1) {
+            fprintf(stderr, "%s" "\n", strerror(errno));
+            result = EX_IOERR;
+        }
+    }
+
+done:
+    lisa_checksum_manifest_free(options.manifest);
+    pthread_mutex_destroy(&options.lock);
+    return result;
+}
+
+
+/*! Look up a command by name. */
+bool
+lisaobj_command_named(const char *name, lisaobj_command *command)
+{
+    if (strcmp(name, "dump") == 0) {
+        *command = lisaobj_command_dump;
+    } else if (strcmp(name, "extract") == 0) {
+        *command = lisaobj_command_extract;
+    } else if (strcmp(name, "stats") == 0) {
+        *command = lisaobj_command_stats;
+    } else if (strcmp(name, "cat") == 0) {
+        *command = lisaobj_command_cat;
+    } else if (strcmp(name, "image") == 0) {
+        *command = lisaobj_command_image;
+    } else if (strcmp(name, "resolve") == 0) {
+        *command = lisaobj_command_resolve;
+    } else if (strcmp(name, "rebuild") == 0) {
+        *command = lisaobj_command_rebuild;
+    } else if (strcmp(name, "link") == 0) {
+        *command = lisaobj_command_link;
+    } else if (strcmp(name, "diff") == 0) {
+        *command = lisaobj_command_diff;
+    } else if (strcmp(name, "similar") == 0) {
+        *command = lisaobj_command_similar;
+    } else if (strcmp(name, "verify") == 0) {
+        *command = lisaobj_command_verify;
+    } else if (strcmp(name, "checksum") == 0) {
+        *command = lisaobj_command_checksum;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+
+int
+main(int argc, const char * LISA_NULLABLE argv[])
+{
+    program_name = argv[0];
+
+    lisaobj_files files = { 0 };
+    lisaobj_command command;
+    int command_argc;
+    const char **command_argv;
+
+    // Either the command comes first and is followed by any number of
+    // files, or a single file comes first and is followed by the command.
+
+    if ((argc > 1) && lisaobj_command_named(argv[1], &command)) {
+        command_argc = argc - 1;
+        command_argv = &argv[1];
+    } else {
+        if (argc < 3) {
+            print_usage("Insufficient arguments");
+            return EX_USAGE;
+        }
+
+        const char *command_name = argv[2];
+        if (!lisaobj_command_named(command_name, &command)) {
+            print_usage("Unknown command: %s", command_name);
+            return EX_USAGE;
+        }
+
+        if (!lisaobj_files_add(&files, argv[1])) {
+            fprintf(stderr, "%s" "\n", strerror(errno));
+            return EX_OSERR;
+        }
+
+        command_argc = argc - 2;
+        command_argv = &argv[2];
+    }
+
+    int command_result = EX_SOFTWARE;
+    switch (command) {
+        case lisaobj_command_dump:
+            command_result = lisaobj_dump(command_argc, command_argv, &files);
+            break;
+
+        case lisaobj_command_extract:
+            command_result = lisaobj_extract(command_argc, command_argv, &files);
+            break;
+
+        case lisaobj_command_stats:
+            command_result = lisaobj_stats(command_argc, command_argv, &files);
+            break;
+
+        case lisaobj_command_cat:
+            command_result = lisaobj_cat(command_argc, command_argv, &files);
+            break;
+
+        case lisaobj_command_image:
+            command_result = lisaobj_image(command_argc, command_argv, &files);
+            break;
+
+        case lisaobj_command_resolve:
+            command_result = lisaobj_resolve(command_argc, command_argv, &files);
+            break;
+
+        case lisaobj_command_rebuild:
+            command_result = lisaobj_rebuild(command_argc, command_argv, &files);
+            break;
+
+        case lisaobj_command_link:
+            command_result = lisaobj_link(command_argc, command_argv, &files);
+            break;
+
+        case lisaobj_command_diff:
+            command_result = lisaobj_diff(command_argc, command_argv, &files);
+            break;
+
+        case lisaobj_command_similar:
+            command_result = lisaobj_similar(command_argc, command_argv, &files);
+            break;
+
+        case lisaobj_command_verify:
+            command_result = lisaobj_verify(command_argc, command_argv, &files);
+            break;
+
+        case lisaobj_command_checksum:
+            command_result = lisaobj_checksum(command_argc, command_argv, &files);
+            break;
+    }
+
+    if (files.stats) {
+        lisa_objfile_stats stats;
+        lisa_objfile_stats_get(&stats);
+        lisa_objfile_stats_fprint_json(&stats, stderr);
     }
 
-    lisa_objfile_close(objfile);
+    lisaobj_files_free(&files);
 
     return command_result;
 }
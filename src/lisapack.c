@@ -4,6 +4,7 @@
 //  Copyright © 2026 Christopher M. Hanson. All rights reserved.
 //  See file COPYING for details.
 
+#include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -23,7 +24,14 @@ int main(int argc, const char * LISA_NULLABLE argv[])
     uint8_t *inbuf = NULL;
     uint8_t *outbuf = NULL;
 
-    // Process arguments.
+    // Process arguments, after any --stats before the command.
+
+    bool stats = (argc > 1) && (strcmp(argv[1], "--stats") == 0);
+    if (stats) {
+        lisa_stats_set_enabled(true);
+        argc -= 1;
+        argv = &argv[1];
+    }
 
     if (argc < 2) {
         fprintf(stderr, "Error: Insufficient arguments" "\n");
@@ -65,11 +73,13 @@ int main(int argc, const char * LISA_NULLABLE argv[])
     // Set up our input buffer.
 
     size_t inbuf_size = 32768;
-    inbuf = calloc(sizeof(uint8_t), inbuf_size);
+    inbuf = malloc(inbuf_size);
     if (inbuf == NULL) goto error;
 
     // Fill our entire input buffer before behavior.
 
+    uint64_t read_start = lisa_stats_begin();
+
     lisa_longint inbuf_count = 0;
     do {
         uint8_t b;
@@ -88,6 +98,8 @@ int main(int argc, const char * LISA_NULLABLE argv[])
         }
     } while ((feof(infile) == 0) && (ferror(infile) == 0));
 
+    lisa_stats_end(lisa_stats_read, read_start, 0, (uint64_t)inbuf_count);
+
     // In the worst case, packed output can be 1.0625 times the size of
     // the input (16 input bytes passed striaght through, plus one flag
     // byte), plus 2 bytes for the footer.
@@ -100,7 +112,7 @@ int main(int argc, const char * LISA_NULLABLE argv[])
     // the input buffer.
 
     size_t outbuf_size = inbuf_size * 2;
-    outbuf = calloc(sizeof(uint8_t), outbuf_size);
+    outbuf = malloc(outbuf_size);
     if (outbuf == NULL) goto error;
     if (outbuf_size > INT32_MAX) goto error;
 
@@ -138,9 +150,19 @@ int main(int argc, const char * LISA_NULLABLE argv[])
 
     // Write the output buffer.
 
+    uint64_t write_start = lisa_stats_begin();
+
     size_t items_written = fwrite(outbuf, outbuf_count, 1, outfile);
     if (items_written != 1) goto error;
 
+    lisa_stats_end(lisa_stats_write, write_start, outbuf_count, 0);
+
+    if (stats) {
+        lisa_objfile_stats objfile_stats;
+        lisa_objfile_stats_get(&objfile_stats);
+        lisa_objfile_stats_fprint_json(&objfile_stats, stderr);
+    }
+
     // Clean up.
 
     fclose(infile);
@@ -0,0 +1,315 @@
+//  alloc_utils.c
+//  General-Purpose Utilities
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#include "alloc_utils.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+UTILS_SOURCE_BEGIN
+
+
+// MARK: - Allocators
+
+void * UTILS_NULLABLE
+allocator_malloc(size_t size, void * UTILS_NULLABLE context)
+{
+    (void)context;
+    return malloc(size);
+}
+
+
+void * UTILS_NULLABLE
+allocator_realloc(void * UTILS_NULLABLE ptr, size_t old_size, size_t new_size, void * UTILS_NULLABLE context)
+{
+    (void)old_size;
+    (void)context;
+    return realloc(ptr, new_size);
+}
+
+
+void
+allocator_free(void * UTILS_NULLABLE ptr, void * UTILS_NULLABLE context)
+{
+    (void)context;
+    free(ptr);
+}
+
+
+static const allocator allocator_malloc_hooks = {
+    .allocate = allocator_malloc,
+    .reallocate = allocator_realloc,
+    .deallocate = allocator_free,
+    .context = NULL,
+};
+
+
+const allocator *
+allocator_default(void)
+{
+    return &allocator_malloc_hooks;
+}
+
+
+void * UTILS_NULLABLE
+allocator_allocate(const allocator * UTILS_NULLABLE a, size_t size)
+{
+    if (a == NULL) a = &allocator_malloc_hooks;
+
+    // Not every allocator gives back something for nothing.
+    return a->allocate(size ? size : 1, a->context);
+}
+
+
+void * UTILS_NULLABLE
+allocator_allocate_zeroed(const allocator * UTILS_NULLABLE a, size_t size)
+{
+    if ((a == NULL) || (a == &allocator_malloc_hooks)) return calloc(size ? size : 1, 1);
+
+    void *ptr = a->allocate(size ? size : 1, a->context);
+    if (ptr) memset(ptr, 0, size);
+    return ptr;
+}
+
+
+void * UTILS_NULLABLE
+allocator_reallocate(const allocator * UTILS_NULLABLE a, void * UTILS_NULLABLE ptr,
+                     size_t old_size, size_t new_size)
+{
+    if (a == NULL) a = &allocator_malloc_hooks;
+    return a->reallocate(ptr, old_size, new_size ? new_size : 1, a->context);
+}
+
+
+void
+allocator_deallocate(const allocator * UTILS_NULLABLE a, void * UTILS_NULLABLE ptr)
+{
+    if (a == NULL) a = &allocator_malloc_hooks;
+    a->deallocate(ptr, a->context);
+}
+
+
+// MARK: - Arenas
+
+#define ARENA_ALIGNMENT		16
+#define ARENA_ROUND(n)		(((n) + (ARENA_ALIGNMENT - 1)) & ~(size_t)(ARENA_ALIGNMENT - 1))
+
+/*! A chunk of an arena, with its memory following the header. */
+struct arena_chunk {
+    struct arena_chunk	* UTILS_NULLABLE next;
+    size_t				size;		//!< bytes of memory, not counting the header
+    size_t				used;
+};
+typedef struct arena_chunk arena_chunk;
+
+#define ARENA_CHUNK_HEADER_SIZE		ARENA_ROUND(sizeof(arena_chunk))
+
+struct arena {
+    allocator			hooks;					//!< handed out, with the arena as context
+    const allocator		*backing;
+    size_t				chunk_size;
+    arena_chunk			* UTILS_NULLABLE chunks;	//!< the first is the one being allocated from
+    uint8_t				* UTILS_NULLABLE last;	//!< the most recent allocation, in the first chunk
+    size_t				last_size;
+    arena_stats			stats;
+};
+
+
+/*! Get the memory of a chunk. */
+uint8_t *
+arena_chunk_memory(arena_chunk *chunk)
+{
+    return (uint8_t *)chunk + ARENA_CHUNK_HEADER_SIZE;
+}
+
+
+/*! Allocate a chunk with \a size bytes of memory from the arena's backing allocator. */
+arena_chunk * UTILS_NULLABLE
+arena_chunk_create(arena *a, size_t size)
+{
+    arena_chunk *chunk = allocator_allocate(a->backing, ARENA_CHUNK_HEADER_SIZE + size);
+    if (chunk == NULL) return NULL;
+
+    chunk->next = NULL;
+    chunk->size = size;
+    chunk->used = 0;
+
+    a->stats.chunk_allocations += 1;
+    a->stats.bytes_reserved += ARENA_CHUNK_HEADER_SIZE + size;
+    return chunk;
+}
+
+
+/*! Free every chunk of an arena. */
+void
+arena_free_chunks(arena *a)
+{
+    arena_chunk *chunk = a->chunks;
+    while (chunk) {
+        arena_chunk *next = chunk->next;
+        a->stats.bytes_reserved -= ARENA_CHUNK_HEADER_SIZE + chunk->size;
+        allocator_deallocate(a->backing, chunk);
+        chunk = next;
+    }
+    a->chunks = NULL;
+    a->last = NULL;
+    a->last_size = 0;
+}
+
+
+void * UTILS_NULLABLE
+arena_allocate(size_t size, void * UTILS_NULLABLE context)
+{
+    arena *a = context;
+    if (size > SIZE_MAX / 2) return NULL;
+
+    const size_t rounded = ARENA_ROUND(size ? size : 1);
+    arena_chunk *current = a->chunks;
+
+    uint8_t *ptr;
+    if (current && (current->size - current->used >= rounded)) {
+        ptr = &arena_chunk_memory(current)[current->used];
+        current->used += rounded;
+        a->last = ptr;
+        a->last_size = rounded;
+    } else if (current && (rounded > a->chunk_size / 2)) {
+        // Something this big gets a chunk of its own, put behind the
+        // current one so that what's left of that still gets used.
+
+        arena_chunk *chunk = arena_chunk_create(a, rounded);
+        if (chunk == NULL) return NULL;
+        chunk->used = rounded;
+        chunk->next = current->next;
+        current->next = chunk;
+        ptr = arena_chunk_memory(chunk);
+    } else {
+        arena_chunk *chunk = arena_chunk_create(a, (rounded > a->chunk_size) ? rounded : a->chunk_size);
+        if (chunk == NULL) return NULL;
+        chunk->used = rounded;
+        chunk->next = current;
+        a->chunks = chunk;
+        ptr = arena_chunk_memory(chunk);
+        a->last = ptr;
+        a->last_size = rounded;
+    }
+
+    a->stats.allocations += 1;
+    a->stats.bytes_allocated += size;
+    return ptr;
+}
+
+
+void * UTILS_NULLABLE
+arena_reallocate(void * UTILS_NULLABLE ptr, size_t old_size, size_t new_size, void * UTILS_NULLABLE context)
+{
+    arena *a = context;
+    if (ptr == NULL) return arena_allocate(new_size, a);
+
+    // The most recent allocation can grow or shrink where it is, if
+    // there's room.
+
+    if ((ptr == a->last) && (a->chunks != NULL) && (new_size <= SIZE_MAX / 2)) {
+        arena_chunk *current = a->chunks;
+        const size_t rounded = ARENA_ROUND(new_size ? new_size : 1);
+        const size_t base = current->used - a->last_size;
+        if (current->size - base >= rounded) {
+            current->used = base + rounded;
+            a->last_size = rounded;
+            a->stats.allocations += 1;
+            a->stats.bytes_allocated += new_size;
+            return ptr;
+        }
+    }
+
+    void *moved = arena_allocate(new_size, a);
+    if (moved == NULL) return NULL;
+    memcpy(moved, ptr, (old_size < new_size) ? old_size : new_size);
+    return moved;
+}
+
+
+void
+arena_deallocate(void * UTILS_NULLABLE ptr, void * UTILS_NULLABLE context)
+{
+    arena *a = context;
+
+    if ((ptr != NULL) && (ptr == a->last) && (a->chunks != NULL)) {
+        a->chunks->used -= a->last_size;
+        a->last = NULL;
+        a->last_size = 0;
+    }
+}
+
+
+arena * UTILS_NULLABLE
+arena_create(size_t chunk_size, const allocator * UTILS_NULLABLE backing)
+{
+    if (backing == NULL) backing = &allocator_malloc_hooks;
+
+    arena *a = allocator_allocate_zeroed(backing, sizeof(arena));
+    if (a == NULL) return NULL;
+
+    a->hooks = (allocator){
+        .allocate = arena_allocate,
+        .reallocate = arena_reallocate,
+        .deallocate = arena_deallocate,
+        .context = a,
+    };
+    a->backing = backing;
+    a->chunk_size = ARENA_ROUND(chunk_size ? chunk_size : ARENA_DEFAULT_CHUNK_SIZE);
+
+    return a;
+}
+
+
+void
+arena_free(arena * UTILS_NULLABLE a)
+{
+    if (a) {
+        arena_free_chunks(a);
+        allocator_deallocate(a->backing, a);
+    }
+}
+
+
+void
+arena_reset(arena *a)
+{
+    if ((a->chunks != NULL) && (a->chunks->next == NULL)) {
+        a->chunks->used = 0;
+        a->last = NULL;
+        a->last_size = 0;
+        return;
+    }
+
+    // Everything didn't fit in one chunk, so replace them all with a
+    // single one that would have held the lot.
+
+    size_t total = 0;
+    for (arena_chunk *chunk = a->chunks; chunk; chunk = chunk->next) total += chunk->size;
+
+    arena_free_chunks(a);
+    if (total > a->chunk_size) a->chunk_size = total;
+}
+
+
+const allocator *
+arena_allocator(arena *a)
+{
+    return &a->hooks;
+}
+
+
+void
+arena_get_stats(arena *a, arena_stats *stats)
+{
+    *stats = a->stats;
+}
+
+
+UTILS_SOURCE_END
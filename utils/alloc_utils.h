@@ -0,0 +1,120 @@
+//  alloc_utils.h
+//  General-Purpose Utilities
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#ifndef __ALLOC_UTILS__H__
+#define __ALLOC_UTILS__H__
+
+#include "utils_defines.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+UTILS_HEADER_BEGIN
+
+
+/*!
+    Hooks for allocating memory, so callers can decide where it comes
+    from. Memory from `allocate` needn't be zeroed. `reallocate` is given
+    the old size, and is called with NULL to allocate; `deallocate` may
+    be called with NULL, and may do nothing at all.
+ */
+struct allocator {
+    void * UTILS_NULLABLE (*allocate)(size_t size, void * UTILS_NULLABLE context);
+    void * UTILS_NULLABLE (*reallocate)(void * UTILS_NULLABLE ptr, size_t old_size, size_t new_size,
+                                        void * UTILS_NULLABLE context);
+    void (*deallocate)(void * UTILS_NULLABLE ptr, void * UTILS_NULLABLE context);
+    void * UTILS_NULLABLE context;
+};
+typedef struct allocator allocator;
+
+
+/*! Get hooks for `malloc`, `realloc` and `free`. */
+UTILS_EXTERN
+const allocator *
+allocator_default(void);
+
+/*! Allocate \a size bytes with \a a, or with the default if it's NULL. */
+UTILS_EXTERN
+void * UTILS_NULLABLE
+allocator_allocate(const allocator * UTILS_NULLABLE a, size_t size);
+
+/*! Allocate \a size bytes with \a a, or with the default if it's NULL, and zero them. */
+UTILS_EXTERN
+void * UTILS_NULLABLE
+allocator_allocate_zeroed(const allocator * UTILS_NULLABLE a, size_t size);
+
+/*! Resize \a ptr, allocated with \a a, from \a old_size to \a new_size bytes. */
+UTILS_EXTERN
+void * UTILS_NULLABLE
+allocator_reallocate(const allocator * UTILS_NULLABLE a, void * UTILS_NULLABLE ptr,
+                     size_t old_size, size_t new_size);
+
+/*! Free \a ptr, allocated with \a a. */
+UTILS_EXTERN
+void
+allocator_deallocate(const allocator * UTILS_NULLABLE a, void * UTILS_NULLABLE ptr);
+
+
+/*!
+    A bump allocator: memory is handed out from large chunks in order,
+    and only given back all at once, when the arena is reset or freed.
+    (Opaque!)
+
+    Freeing or growing the most recent allocation happens in place;
+    freeing anything else does nothing until the arena is reset.
+    Resetting keeps a single chunk big enough for everything allocated
+    since the last reset, so a steady stream of similar requests soon
+    stops allocating from the backing allocator altogether.
+
+    An arena isn't thread-safe; give each thread its own.
+ */
+struct arena;
+typedef struct arena arena;
+
+/*! What an arena has done, for reporting. */
+struct arena_stats {
+    uint64_t			allocations;		//!< requests handed out since the arena was created
+    uint64_t			bytes_allocated;	//!< bytes those requests asked for
+    uint64_t			chunk_allocations;	//!< allocations from the backing allocator
+    uint64_t			bytes_reserved;		//!< bytes held in chunks right now
+};
+typedef struct arena_stats arena_stats;
+
+/*! The default size of an arena's chunks, 256KB. */
+#define ARENA_DEFAULT_CHUNK_SIZE	((size_t)256 * 1024)
+
+/*!
+    Create an arena whose chunks are \a chunk_size bytes, or the default
+    if 0, allocated from \a backing, or with the default if it's NULL.
+ */
+UTILS_EXTERN
+arena * UTILS_NULLABLE
+arena_create(size_t chunk_size, const allocator * UTILS_NULLABLE backing);
+
+/*! Free an arena and everything allocated from it. */
+UTILS_EXTERN
+void
+arena_free(arena * UTILS_NULLABLE a);
+
+/*! Free everything allocated from an arena, so its memory can be used again. */
+UTILS_EXTERN
+void
+arena_reset(arena *a);
+
+/*! Get hooks that allocate from an arena, valid for as long as it is. */
+UTILS_EXTERN
+const allocator *
+arena_allocator(arena *a);
+
+/*! Get what an arena has done so far. */
+UTILS_EXTERN
+void
+arena_get_stats(arena *a, arena_stats *stats);
+
+
+UTILS_HEADER_END
+
+#endif /* __ALLOC_UTILS__H__ */
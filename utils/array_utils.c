@@ -16,18 +16,29 @@ struct ptr_array {
     void **storage;
     size_t count;
     size_t capacity;
+    const allocator * UTILS_NULLABLE allocator;
 };
 
 
 ptr_array * UTILS_NULLABLE
 ptr_array_create(size_t capacity)
+{
+    return ptr_array_create_with_allocator(capacity, NULL);
+}
+
+
+ptr_array * UTILS_NULLABLE
+ptr_array_create_with_allocator(size_t capacity, const allocator * UTILS_NULLABLE a)
 {
     const size_t real_capacity = capacity > 0 ? capacity : 8;
 
-    ptr_array *array = calloc(sizeof(ptr_array), 1);
+    ptr_array *array = allocator_allocate_zeroed(a, sizeof(ptr_array));
     if (array == NULL) goto error;
 
-    array->storage = calloc(sizeof(void *), real_capacity);
+    array->allocator = a;
+
+    // Items are only ever read once they've been appended.
+    array->storage = allocator_allocate(a, sizeof(void *) * real_capacity);
     if (array->storage == NULL) goto error;
 
     array->count = 0;
@@ -45,8 +56,9 @@ void
 ptr_array_free(ptr_array * UTILS_NULLABLE array)
 {
     if (array) {
-        free(array->storage);
-        free(array);
+        const allocator *a = array->allocator;
+        allocator_deallocate(a, array->storage);
+        allocator_deallocate(a, array);
     }
 }
 
@@ -71,8 +83,10 @@ void
 ptr_array_grow_if_needed(ptr_array *array)
 {
     if (array->count == array->capacity) {
-        const size_t new_capacity = array->capacity + 8;
-        array->storage = realloc(array->storage, sizeof(void *) * new_capacity);
+        const size_t new_capacity = array->capacity * 2;
+        array->storage = allocator_reallocate(array->allocator, array->storage,
+                                              sizeof(void *) * array->capacity,
+                                              sizeof(void *) * new_capacity);
         assert(array->storage != NULL);
         array->capacity = new_capacity;
     }
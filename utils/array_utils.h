@@ -11,6 +11,8 @@
 
 #include <stdlib.h>
 
+#include "alloc_utils.h"
+
 UTILS_HEADER_BEGIN
 
 
@@ -24,6 +26,11 @@ UTILS_EXTERN
 ptr_array * UTILS_NULLABLE
 ptr_array_create(size_t capacity);
 
+/*! Create a new pointer array with an initial capacity, allocating with \a a. */
+UTILS_EXTERN
+ptr_array * UTILS_NULLABLE
+ptr_array_create_with_allocator(size_t capacity, const allocator * UTILS_NULLABLE a);
+
 /*! Free a pointer array. */
 UTILS_EXTERN
 void
@@ -0,0 +1,507 @@
+//  async_reader.c
+//  General-Purpose Utilities
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#include "async_reader.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#define ASYNC_READER_HAVE_IO_URING 1
+#endif
+
+#include "thread_pool.h"
+
+UTILS_SOURCE_BEGIN
+
+
+/*! The queue depth used when none is given. */
+#define ASYNC_READER_DEFAULT_QUEUE_DEPTH 32
+
+/*! The most requested from the kernel in a single read. */
+#define ASYNC_READER_MAX_READ_SIZE ((size_t)1 << 30)
+
+
+/*! A single file being read. */
+struct async_read {
+    async_reader			* UTILS_NULLABLE reader;
+    char					* UTILS_NULLABLE path;		//!< only kept for the threads backend
+    int						fd;
+    uint8_t					* UTILS_NULLABLE buffer;
+    size_t					size;
+    size_t					offset;						//!< bytes read so far
+    void					* UTILS_NULLABLE context;
+    int						error;
+    struct async_read		* UTILS_NULLABLE next;		//!< in the ready list
+};
+typedef struct async_read async_read;
+
+struct async_reader {
+    async_reader_backend	backend;
+    size_t					queue_depth;
+    size_t					outstanding;			//!< submitted but not yet waited for
+
+    pthread_mutex_t			lock;
+    pthread_cond_t			ready_available;
+    async_read				* UTILS_NULLABLE ready_head;	//!< finished reads, oldest first
+    async_read				* UTILS_NULLABLE ready_tail;
+
+    thread_pool				* UTILS_NULLABLE pool;		//!< threads backend
+
+#if ASYNC_READER_HAVE_IO_URING
+    int						ring_fd;
+    void					* UTILS_NULLABLE sq_ring;
+    size_t					sq_ring_size;
+    void					* UTILS_NULLABLE cq_ring;
+    size_t					cq_ring_size;
+    struct io_uring_sqe		* UTILS_NULLABLE sqes;
+    size_t					sqes_size;
+    unsigned				*sq_tail;
+    unsigned				*sq_mask;
+    unsigned				*sq_array;
+    unsigned				*cq_head;
+    unsigned				*cq_tail;
+    unsigned				*cq_mask;
+    struct io_uring_cqe		*cqes;
+    unsigned				to_submit;				//!< queued SQEs the kernel hasn't seen yet
+#endif
+};
+
+
+// MARK: - Reads
+
+/*! Hand a finished read back to the caller of `async_reader_wait`. */
+void
+async_read_finish(async_read *read)
+{
+    async_reader *reader = read->reader;
+
+    if (read->fd != -1) {
+        close(read->fd);
+        read->fd = -1;
+    }
+
+    if (read->error != 0) {
+        free(read->buffer);
+        read->buffer = NULL;
+        read->size = 0;
+    }
+
+    pthread_mutex_lock(&reader->lock);
+    read->next = NULL;
+    if (reader->ready_tail) {
+        reader->ready_tail->next = read;
+    } else {
+        reader->ready_head = read;
+    }
+    reader->ready_tail = read;
+    pthread_cond_signal(&reader->ready_available);
+    pthread_mutex_unlock(&reader->lock);
+}
+
+
+/*! Open the file to read and allocate its buffer. */
+bool
+async_read_open(async_read *read, const char *path)
+{
+    read->fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (read->fd == -1) goto error;
+
+    struct stat st;
+    int stat_err = fstat(read->fd, &st);
+    if (stat_err == -1) goto error;
+
+    read->size = (size_t)st.st_size;
+
+    // Always allocate something, so an empty file still has a buffer.
+    read->buffer = malloc(read->size ? read->size : 1);
+    if (read->buffer == NULL) goto error;
+
+    return true;
+
+error:
+    read->error = errno;
+    return false;
+}
+
+
+/*! Read a whole file with blocking reads; runs on a worker thread. */
+void
+async_read_task(void * UTILS_NULLABLE context, size_t worker)
+{
+    async_read *read = context;
+    (void)worker;
+
+    if (async_read_open(read, read->path)) {
+        while (read->offset < read->size) {
+            ssize_t n = pread(read->fd, &read->buffer[read->offset], read->size - read->offset, (off_t)read->offset);
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                read->error = errno;
+                break;
+            }
+            if (n == 0) {
+                // The file shrank since it was opened.
+                read->size = read->offset;
+                break;
+            }
+            read->offset += (size_t)n;
+        }
+    }
+
+    free(read->path);
+    read->path = NULL;
+
+    async_read_finish(read);
+}
+
+
+// MARK: - io_uring
+
+#if ASYNC_READER_HAVE_IO_URING
+
+/*! Set up an io_uring instance, returning false if it's unavailable. */
+bool
+async_reader_uring_setup(async_reader *reader)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    int ring_fd = (int)syscall(__NR_io_uring_setup, (unsigned)reader->queue_depth, &params);
+    if (ring_fd == -1) return false;
+
+    reader->ring_fd = ring_fd;
+
+    // IORING_OP_READ arrived in the same kernel release as this feature,
+    // so without it there's no way to read into a plain buffer.
+    if ((params.features & IORING_FEAT_RW_CUR_POS) == 0) goto error;
+
+    reader->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    reader->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    reader->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap && (reader->cq_ring_size > reader->sq_ring_size)) {
+        reader->sq_ring_size = reader->cq_ring_size;
+    }
+
+    void *sq_ring = mmap(NULL, reader->sq_ring_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+    if (sq_ring == MAP_FAILED) goto error;
+    reader->sq_ring = sq_ring;
+
+    if (single_mmap) {
+        reader->cq_ring = sq_ring;
+    } else {
+        void *cq_ring = mmap(NULL, reader->cq_ring_size, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+        if (cq_ring == MAP_FAILED) goto error;
+        reader->cq_ring = cq_ring;
+    }
+
+    void *sqes = mmap(NULL, reader->sqes_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) goto error;
+    reader->sqes = sqes;
+
+    uint8_t *sq = sq_ring;
+    uint8_t *cq = reader->cq_ring;
+    reader->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+    reader->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+    reader->sq_array = (unsigned *)(sq + params.sq_off.array);
+    reader->cq_head = (unsigned *)(cq + params.cq_off.head);
+    reader->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+    reader->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+    reader->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+
+    // Each file in flight has at most one read queued at a time.
+    if (params.sq_entries < reader->queue_depth) reader->queue_depth = params.sq_entries;
+
+    return true;
+
+error:
+    if (reader->sqes) munmap(reader->sqes, reader->sqes_size);
+    if (reader->cq_ring && (reader->cq_ring != reader->sq_ring)) munmap(reader->cq_ring, reader->cq_ring_size);
+    if (reader->sq_ring) munmap(reader->sq_ring, reader->sq_ring_size);
+    reader->sqes = NULL;
+    reader->cq_ring = NULL;
+    reader->sq_ring = NULL;
+    close(ring_fd);
+    reader->ring_fd = -1;
+    return false;
+}
+
+
+void
+async_reader_uring_teardown(async_reader *reader)
+{
+    if (reader->ring_fd == -1) return;
+
+    munmap(reader->sqes, reader->sqes_size);
+    if (reader->cq_ring != reader->sq_ring) munmap(reader->cq_ring, reader->cq_ring_size);
+    munmap(reader->sq_ring, reader->sq_ring_size);
+    close(reader->ring_fd);
+    reader->ring_fd = -1;
+}
+
+
+/*! Queue a read of the rest of \a read's file; the kernel sees it on the next enter. */
+void
+async_reader_uring_queue_read(async_reader *reader, async_read *read)
+{
+    unsigned tail = *reader->sq_tail;
+    unsigned index = tail & *reader->sq_mask;
+
+    size_t length = read->size - read->offset;
+    if (length > ASYNC_READER_MAX_READ_SIZE) length = ASYNC_READER_MAX_READ_SIZE;
+
+    struct io_uring_sqe *sqe = &reader->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = read->fd;
+    sqe->addr = (uint64_t)(uintptr_t)&read->buffer[read->offset];
+    sqe->len = (uint32_t)length;
+    sqe->off = read->offset;
+    sqe->user_data = (uint64_t)(uintptr_t)read;
+
+    reader->sq_array[index] = index;
+    atomic_store_explicit((_Atomic unsigned *)reader->sq_tail, tail + 1, memory_order_release);
+    reader->to_submit += 1;
+}
+
+
+/*! Submit queued reads and wait for at least one to complete, then handle every completion. */
+int
+async_reader_uring_complete(async_reader *reader)
+{
+    int enter_err = (int)syscall(__NR_io_uring_enter, reader->ring_fd, reader->to_submit, 1,
+                                 IORING_ENTER_GETEVENTS, NULL, 0);
+    if (enter_err == -1) {
+        if (errno == EINTR) return 0;
+        return -1;
+    }
+    reader->to_submit = 0;
+
+    unsigned head = *reader->cq_head;
+    unsigned tail = atomic_load_explicit((_Atomic unsigned *)reader->cq_tail, memory_order_acquire);
+
+    for (; head != tail; head++) {
+        struct io_uring_cqe *cqe = &reader->cqes[head & *reader->cq_mask];
+        async_read *read = (async_read *)(uintptr_t)cqe->user_data;
+        int res = cqe->res;
+
+        if ((res == -EINTR) || (res == -EAGAIN)) {
+            async_reader_uring_queue_read(reader, read);
+        } else if (res < 0) {
+            read->error = -res;
+            async_read_finish(read);
+        } else if (res == 0) {
+            // The file shrank since it was opened.
+            read->size = read->offset;
+            async_read_finish(read);
+        } else {
+            read->offset += (size_t)res;
+            if (read->offset < read->size) {
+                async_reader_uring_queue_read(reader, read);
+            } else {
+                async_read_finish(read);
+            }
+        }
+    }
+
+    atomic_store_explicit((_Atomic unsigned *)reader->cq_head, head, memory_order_release);
+
+    return 0;
+}
+
+#endif /* ASYNC_READER_HAVE_IO_URING */
+
+
+// MARK: - Readers
+
+async_reader * UTILS_NULLABLE
+async_reader_create(size_t queue_depth, async_reader_backend backend)
+{
+    async_reader *reader = calloc(sizeof(async_reader), 1);
+    if (reader == NULL) return NULL;
+
+    reader->queue_depth = queue_depth ? queue_depth : ASYNC_READER_DEFAULT_QUEUE_DEPTH;
+    pthread_mutex_init(&reader->lock, NULL);
+    pthread_cond_init(&reader->ready_available, NULL);
+
+#if ASYNC_READER_HAVE_IO_URING
+    reader->ring_fd = -1;
+    if ((backend != async_reader_backend_threads) && async_reader_uring_setup(reader)) {
+        reader->backend = async_reader_backend_io_uring;
+        return reader;
+    }
+#endif
+
+    // Without io_uring, keeping a read in flight takes a thread.
+
+    reader->backend = async_reader_backend_threads;
+    reader->pool = thread_pool_create(reader->queue_depth);
+    if (reader->pool == NULL) {
+        async_reader_free(reader);
+        return NULL;
+    }
+
+    return reader;
+}
+
+
+void
+async_reader_free(async_reader * UTILS_NULLABLE reader)
+{
+    if (reader) {
+        async_read_result result;
+        while (async_reader_wait(reader, &result) == 0) {
+            free(result.buffer);
+        }
+
+        thread_pool_free(reader->pool);
+#if ASYNC_READER_HAVE_IO_URING
+        async_reader_uring_teardown(reader);
+#endif
+        pthread_cond_destroy(&reader->ready_available);
+        pthread_mutex_destroy(&reader->lock);
+        free(reader);
+    }
+}
+
+
+async_reader_backend
+async_reader_get_backend(async_reader *reader)
+{
+    return reader->backend;
+}
+
+
+const char *
+async_reader_backend_name(async_reader_backend backend)
+{
+    switch (backend) {
+        case async_reader_backend_any: return "any";
+        case async_reader_backend_io_uring: return "io_uring";
+        case async_reader_backend_threads: return "threads";
+    }
+    return "unknown";
+}
+
+
+size_t
+async_reader_queue_depth(async_reader *reader)
+{
+    return reader->queue_depth;
+}
+
+
+int
+async_reader_submit(async_reader *reader, const char *path, void * UTILS_NULLABLE context)
+{
+    if (reader->outstanding >= reader->queue_depth) {
+        errno = EBUSY;
+        return -1;
+    }
+
+    async_read *read = calloc(sizeof(async_read), 1);
+    if (read == NULL) return -1;
+
+    read->reader = reader;
+    read->fd = -1;
+    read->context = context;
+    reader->outstanding += 1;
+
+#if ASYNC_READER_HAVE_IO_URING
+    if (reader->backend == async_reader_backend_io_uring) {
+        // Opening is cheap next to reading, so it's done here and only
+        // the reads themselves go through the ring.
+
+        if (!async_read_open(read, path) || (read->size == 0)) {
+            async_read_finish(read);
+        } else {
+            async_reader_uring_queue_read(reader, read);
+        }
+        return 0;
+    }
+#endif
+
+    read->path = strdup(path);
+    if (read->path == NULL) {
+        read->error = ENOMEM;
+        async_read_finish(read);
+        return 0;
+    }
+
+    int submit_err = thread_pool_submit(reader->pool, async_read_task, read);
+    if (submit_err == -1) {
+        async_read_task(read, 0);
+    }
+
+    return 0;
+}
+
+
+int
+async_reader_wait(async_reader *reader, async_read_result *result)
+{
+    if (reader->outstanding == 0) {
+        errno = ENOENT;
+        return -1;
+    }
+
+    async_read *read = NULL;
+
+    pthread_mutex_lock(&reader->lock);
+    for (;;) {
+        read = reader->ready_head;
+        if (read) break;
+
+#if ASYNC_READER_HAVE_IO_URING
+        if (reader->backend == async_reader_backend_io_uring) {
+            // Completions are handled on this thread, so the lock
+            // doesn't need holding while waiting for them.
+            pthread_mutex_unlock(&reader->lock);
+            int complete_err = async_reader_uring_complete(reader);
+            pthread_mutex_lock(&reader->lock);
+            if (complete_err == -1) {
+                pthread_mutex_unlock(&reader->lock);
+                return -1;
+            }
+            continue;
+        }
+#endif
+
+        pthread_cond_wait(&reader->ready_available, &reader->lock);
+    }
+
+    reader->ready_head = read->next;
+    if (reader->ready_head == NULL) reader->ready_tail = NULL;
+    pthread_mutex_unlock(&reader->lock);
+
+    reader->outstanding -= 1;
+
+    result->context = read->context;
+    result->buffer = read->buffer;
+    result->size = read->size;
+    result->error = read->error;
+    free(read);
+
+    return 0;
+}
+
+
+UTILS_SOURCE_END
@@ -0,0 +1,97 @@
+//  async_reader.h
+//  General-Purpose Utilities
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#ifndef __ASYNC_READER__H__
+#define __ASYNC_READER__H__
+
+#include "utils_defines.h"
+
+#include <stdlib.h>
+
+UTILS_HEADER_BEGIN
+
+
+/*!
+    A reader of whole files into memory that keeps many reads in flight
+    at once, and hands back each file's contents as its read finishes.
+ */
+struct async_reader;
+typedef struct async_reader async_reader;
+
+
+/*! How an asynchronous reader does its I/O. */
+enum async_reader_backend {
+    async_reader_backend_any = 0,		//!< io_uring if available, threads otherwise
+    async_reader_backend_io_uring = 1,	//!< Linux io_uring
+    async_reader_backend_threads = 2,	//!< blocking reads on a pool of threads
+};
+typedef enum async_reader_backend async_reader_backend;
+
+
+/*! A finished read. */
+struct async_read_result {
+    void			* UTILS_NULLABLE context;	//!< as passed to `async_reader_submit`
+    void			* UTILS_NULLABLE buffer;	//!< the file's contents, which the caller must free
+    size_t			size;
+    int				error;						//!< errno if the read failed, otherwise 0
+};
+typedef struct async_read_result async_read_result;
+
+
+/*!
+    Create an asynchronous reader that keeps up to \a queue_depth reads
+    in flight, using the given backend. If io_uring is requested (or
+    \a backend is `async_reader_backend_any`) but isn't available, the
+    reader falls back to threads.
+ */
+UTILS_EXTERN
+async_reader * UTILS_NULLABLE
+async_reader_create(size_t queue_depth, async_reader_backend backend);
+
+/*! Wait for any reads still in flight, then free an asynchronous reader. */
+UTILS_EXTERN
+void
+async_reader_free(async_reader * UTILS_NULLABLE reader);
+
+/*! Get the backend an asynchronous reader actually uses. */
+UTILS_EXTERN
+async_reader_backend
+async_reader_get_backend(async_reader *reader);
+
+/*! Get the name of an asynchronous reader backend, for display. */
+UTILS_EXTERN
+const char *
+async_reader_backend_name(async_reader_backend backend);
+
+/*! Get the number of reads an asynchronous reader keeps in flight. */
+UTILS_EXTERN
+size_t
+async_reader_queue_depth(async_reader *reader);
+
+/*!
+    Start reading the whole file at \a path. Its result is returned by
+    `async_reader_wait`, with \a context, even if the file can't be
+    opened.
+
+    Returns -1 with errno set to `EBUSY` if the queue is already full.
+ */
+UTILS_EXTERN
+int
+async_reader_submit(async_reader *reader, const char *path, void * UTILS_NULLABLE context);
+
+/*!
+    Wait for a submitted read to finish, in whatever order they finish.
+
+    Returns -1 with errno set to `ENOENT` if there are no reads to wait for.
+ */
+UTILS_EXTERN
+int
+async_reader_wait(async_reader *reader, async_read_result *result);
+
+
+UTILS_HEADER_END
+
+#endif /* __ASYNC_READER__H__ */
@@ -41,6 +41,12 @@ inline
 static int32_t swap32be(int32_t value) {
     return (int32_t)swapu32be((uint32_t)value);
 }
+
+inline
+static uint64_t swapu64be(uint64_t value) {
+    return (  ((uint64_t)swapu32be((uint32_t)value) << 32)
+            | (uint64_t)swapu32be((uint32_t)(value >> 32)));
+}
 #elif __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
 inline
 inline
@@ -62,6 +68,11 @@ inline
 static uint32_t swapu32be(uint32_t value) {
     return value;
 }
+
+inline
+static uint64_t swapu64be(uint64_t value) {
+    return value;
+}
 #else
 #error PDP-11 not supported
 #endif
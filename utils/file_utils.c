@@ -0,0 +1,60 @@
+//  file_utils.c
+//  General-Purpose Utilities
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#include "file_utils.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <unistd.h>
+
+UTILS_SOURCE_BEGIN
+
+
+int
+write_file_atomically(const char *path, file_writer writer, void * UTILS_NULLABLE context)
+{
+    char temp_path[PATH_MAX];
+    int temp_length = snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+    if ((temp_length < 0) || ((size_t)temp_length >= sizeof(temp_path))) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+
+    FILE *f = fopen(temp_path, "wb");
+    if (f == NULL) return -1;
+
+    // A writer may not notice buffered output failing, so check the
+    // stream too.
+
+    int write_err = writer(f, context);
+    int write_errno = errno;
+    bool write_failed = (write_err == -1) || ferror(f);
+    if ((write_err == 0) && write_failed) write_errno = EIO;
+
+    int close_err = fclose(f);
+    if (!write_failed && (close_err == -1)) {
+        write_failed = true;
+        write_errno = errno;
+    }
+
+    if (!write_failed && (rename(temp_path, path) == -1)) {
+        write_failed = true;
+        write_errno = errno;
+    }
+
+    if (write_failed) {
+        unlink(temp_path);
+        errno = write_errno;
+        return -1;
+    }
+
+    return 0;
+}
+
+
+UTILS_SOURCE_END
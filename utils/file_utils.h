@@ -0,0 +1,39 @@
+//  file_utils.h
+//  General-Purpose Utilities
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#ifndef __FILE_UTILS__H__
+#define __FILE_UTILS__H__
+
+#include "utils_defines.h"
+
+#include <stdio.h>
+
+UTILS_HEADER_BEGIN
+
+
+/*!
+    Write a file's contents to \a f, returning 0 on success or -1 with
+    errno set.
+ */
+typedef int (*file_writer)(FILE *f, void * UTILS_NULLABLE context);
+
+/*!
+    Write the file at \a path by calling \a writer with \a context on a
+    temporary file alongside it, named with `.tmp` appended, which then
+    replaces \a path. A reader never sees a partly-written file, and an
+    interrupted or failed write leaves whatever was at \a path alone.
+
+    Returns 0 on success, or -1 with errno set and the temporary file
+    removed.
+ */
+UTILS_EXTERN
+int
+write_file_atomically(const char *path, file_writer writer, void * UTILS_NULLABLE context);
+
+
+UTILS_HEADER_END
+
+#endif /* __FILE_UTILS__H__ */
@@ -0,0 +1,509 @@
+//  hash_utils.c
+//  General-Purpose Utilities
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#include "hash_utils.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define HASH_SHA256_X86 1
+#define HASH_CRC32C_X86 1
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define HASH_CRC32C_ARM 1
+#endif
+
+UTILS_SOURCE_BEGIN
+
+
+// MARK: - XXH64
+
+#define XXH64_PRIME1	0x9E3779B185EBCA87ULL
+#define XXH64_PRIME2	0xC2B2AE3D27D4EB4FULL
+#define XXH64_PRIME3	0x165667B19E3779F9ULL
+#define XXH64_PRIME4	0x85EBCA77C2B2AE63ULL
+#define XXH64_PRIME5	0x27D4EB2F165667C5ULL
+
+
+static inline
+uint64_t hash_rotl64(uint64_t value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+/*! Read a little-endian 64-bit value, as XXH64 is defined over. */
+static inline
+uint64_t hash_read64le(const uint8_t *p)
+{
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    return value;
+}
+
+/*! Read a little-endian 32-bit value, as XXH64 is defined over. */
+static inline
+uint32_t hash_read32le(const uint8_t *p)
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap32(value);
+#endif
+    return value;
+}
+
+static inline
+uint64_t hash_xxh64_round(uint64_t acc, uint64_t input)
+{
+    acc += input * XXH64_PRIME2;
+    acc = hash_rotl64(acc, 31);
+    return acc * XXH64_PRIME1;
+}
+
+static inline
+uint64_t hash_xxh64_merge_round(uint64_t acc, uint64_t value)
+{
+    acc ^= hash_xxh64_round(0, value);
+    return acc * XXH64_PRIME1 + XXH64_PRIME4;
+}
+
+
+uint64_t
+hash_xxh64(const void *buf, size_t size, uint64_t seed)
+{
+    const uint8_t *p = buf;
+    const uint8_t *end = p + size;
+    uint64_t h;
+
+    if (size >= 32) {
+        // Four independent lanes over each 32-byte stripe.
+
+        uint64_t v1 = seed + XXH64_PRIME1 + XXH64_PRIME2;
+        uint64_t v2 = seed + XXH64_PRIME2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - XXH64_PRIME1;
+
+        const uint8_t *limit = end - 32;
+        do {
+            v1 = hash_xxh64_round(v1, hash_read64le(p));
+            v2 = hash_xxh64_round(v2, hash_read64le(p + 8));
+            v3 = hash_xxh64_round(v3, hash_read64le(p + 16));
+            v4 = hash_xxh64_round(v4, hash_read64le(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        h = hash_rotl64(v1, 1) + hash_rotl64(v2, 7) + hash_rotl64(v3, 12) + hash_rotl64(v4, 18);
+        h = hash_xxh64_merge_round(h, v1);
+        h = hash_xxh64_merge_round(h, v2);
+        h = hash_xxh64_merge_round(h, v3);
+        h = hash_xxh64_merge_round(h, v4);
+    } else {
+        h = seed + XXH64_PRIME5;
+    }
+
+    h += (uint64_t)size;
+
+    // Then whatever's left, 8, 4, and 1 bytes at a time.
+
+    while (p + 8 <= end) {
+        h ^= hash_xxh64_round(0, hash_read64le(p));
+        h = hash_rotl64(h, 27) * XXH64_PRIME1 + XXH64_PRIME4;
+        p += 8;
+    }
+
+    if (p + 4 <= end) {
+        h ^= (uint64_t)hash_read32le(p) * XXH64_PRIME1;
+        h = hash_rotl64(h, 23) * XXH64_PRIME2 + XXH64_PRIME3;
+        p += 4;
+    }
+
+    while (p < end) {
+        h ^= (uint64_t)(*p) * XXH64_PRIME5;
+        h = hash_rotl64(h, 11) * XXH64_PRIME1;
+        p += 1;
+    }
+
+    h ^= h >> 33;
+    h *= XXH64_PRIME2;
+    h ^= h >> 29;
+    h *= XXH64_PRIME3;
+    h ^= h >> 32;
+
+    return h;
+}
+
+
+// MARK: - SHA-256
+
+static const uint32_t hash_sha256_k[64] = {
+    0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+    0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+    0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+    0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+    0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+    0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+    0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+    0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2,
+};
+
+
+static inline
+uint32_t hash_rotr32(uint32_t value, int bits)
+{
+    return (value >> bits) | (value << (32 - bits));
+}
+
+/*! Read a big-endian 32-bit value, as SHA-256 is defined over. */
+static inline
+uint32_t hash_read32be(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+
+/*! Process \a blocks 64-byte blocks a word at a time. */
+static
+void hash_sha256_blocks_generic(uint32_t state[8], const uint8_t *data, size_t blocks)
+{
+    while (blocks--) {
+        uint32_t w[64];
+        for (int t = 0; t < 16; t++) {
+            w[t] = hash_read32be(&data[t * 4]);
+        }
+        for (int t = 16; t < 64; t++) {
+            uint32_t s0 = hash_rotr32(w[t - 15], 7) ^ hash_rotr32(w[t - 15], 18) ^ (w[t - 15] >> 3);
+            uint32_t s1 = hash_rotr32(w[t - 2], 17) ^ hash_rotr32(w[t - 2], 19) ^ (w[t - 2] >> 10);
+            w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+        for (int t = 0; t < 64; t++) {
+            uint32_t S1 = hash_rotr32(e, 6) ^ hash_rotr32(e, 11) ^ hash_rotr32(e, 25);
+            uint32_t ch = (e & f) ^ (~e & g);
+            uint32_t t1 = h + S1 + ch + hash_sha256_k[t] + w[t];
+            uint32_t S0 = hash_rotr32(a, 2) ^ hash_rotr32(a, 13) ^ hash_rotr32(a, 22);
+            uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+            uint32_t t2 = S0 + maj;
+
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+
+        data += 64;
+    }
+}
+
+
+#if HASH_SHA256_X86
+
+/*!
+    Process \a blocks 64-byte blocks using the SHA extensions, four
+    rounds and four message words at a time. The extensions want the
+    state as ABEF and CDGH rather than in order, so it's shuffled into
+    that form on the way in and back on the way out.
+ */
+__attribute__((target("sha,sse4.1")))
+static
+void hash_sha256_blocks_x86(uint32_t state[8], const uint8_t *data, size_t blocks)
+{
+    const __m128i byte_swap = _mm_set_epi64x(0x0C0D0E0F08090A0BULL, 0x0405060700010203ULL);
+
+    __m128i dcba = _mm_loadu_si128((const __m128i *)&state[0]);
+    __m128i hgfe = _mm_loadu_si128((const __m128i *)&state[4]);
+
+    __m128i cdab = _mm_shuffle_epi32(dcba, 0xB1);
+    __m128i efgh = _mm_shuffle_epi32(hgfe, 0x1B);
+    __m128i abef = _mm_alignr_epi8(cdab, efgh, 8);
+    __m128i cdgh = _mm_blend_epi16(efgh, cdab, 0xF0);
+
+    while (blocks--) {
+        const __m128i abef_saved = abef;
+        const __m128i cdgh_saved = cdgh;
+
+        __m128i message[4];
+        for (int i = 0; i < 4; i++) {
+            message[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)&data[i * 16]), byte_swap);
+        }
+
+        // Each pass does rounds 4r through 4r+3 with message[r % 4], then
+        // replaces it with the words needed four passes later.
+
+        for (int r = 0; r < 16; r++) {
+            __m128i words = _mm_add_epi32(message[r & 3], _mm_loadu_si128((const __m128i *)&hash_sha256_k[r * 4]));
+            cdgh = _mm_sha256rnds2_epu32(cdgh, abef, words);
+            abef = _mm_sha256rnds2_epu32(abef, cdgh, _mm_shuffle_epi32(words, 0x0E));
+
+            if (r < 12) {
+                __m128i next = _mm_sha256msg1_epu32(message[r & 3], message[(r + 1) & 3]);
+                next = _mm_add_epi32(next, _mm_alignr_epi8(message[(r + 3) & 3], message[(r + 2) & 3], 4));
+                message[r & 3] = _mm_sha256msg2_epu32(next, message[(r + 3) & 3]);
+            }
+        }
+
+        abef = _mm_add_epi32(abef, abef_saved);
+        cdgh = _mm_add_epi32(cdgh, cdgh_saved);
+
+        data += 64;
+    }
+
+    __m128i feba = _mm_shuffle_epi32(abef, 0x1B);
+    __m128i dchg = _mm_shuffle_epi32(cdgh, 0xB1);
+    dcba = _mm_blend_epi16(feba, dchg, 0xF0);
+    hgfe = _mm_alignr_epi8(dchg, feba, 8);
+
+    _mm_storeu_si128((__m128i *)&state[0], dcba);
+    _mm_storeu_si128((__m128i *)&state[4], hgfe);
+}
+
+
+/*! Whether the CPU has the SHA extensions, and the SSSE3 and SSE4.1 they're used with. */
+static
+bool hash_sha256_x86_available(void)
+{
+    // Checked once; 0 is unknown, 1 is no, 2 is yes.
+    static atomic_int available = 0;
+
+    int known = atomic_load_explicit(&available, memory_order_relaxed);
+    if (known == 0) {
+        unsigned int eax, ebx, ecx, edx;
+        bool sse = __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & (1u << 9)) && (ecx & (1u << 19));
+        bool sha = (__get_cpuid_max(0, NULL) >= 7) && __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)
+                   && (ebx & (1u << 29));
+        known = (sse && sha) ? 2 : 1;
+        atomic_store_explicit(&available, known, memory_order_relaxed);
+    }
+
+    return known == 2;
+}
+
+#endif /* HASH_SHA256_X86 */
+
+
+/*! Process \a blocks 64-byte blocks as fast as this CPU can. */
+static
+void hash_sha256_blocks(uint32_t state[8], const uint8_t *data, size_t blocks)
+{
+#if HASH_SHA256_X86
+    if (hash_sha256_x86_available()) {
+        hash_sha256_blocks_x86(state, data, blocks);
+        return;
+    }
+#endif
+    hash_sha256_blocks_generic(state, data, blocks);
+}
+
+
+void
+hash_sha256(const void *buf, size_t size, uint8_t digest[HASH_SHA256_SIZE])
+{
+    uint32_t state[8] = {
+        0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19,
+    };
+
+    // Whole blocks are processed straight from the buffer; the rest is
+    // padded with a 1 bit, zeros, and the length in bits.
+
+    const uint8_t *p = buf;
+    size_t blocks = size / 64;
+    hash_sha256_blocks(state, p, blocks);
+
+    uint8_t last[128] = { 0 };
+    size_t tail = size % 64;
+    memcpy(last, &p[blocks * 64], tail);
+    last[tail] = 0x80;
+
+    size_t last_size = (tail < 56) ? 64 : 128;
+    uint64_t bits = (uint64_t)size * 8;
+    for (int i = 0; i < 8; i++) {
+        last[last_size - 1 - i] = (uint8_t)(bits >> (i * 8));
+    }
+    hash_sha256_blocks(state, last, last_size / 64);
+
+    for (int i = 0; i < 8; i++) {
+        digest[i * 4 + 0] = (uint8_t)(state[i] >> 24);
+        digest[i * 4 + 1] = (uint8_t)(state[i] >> 16);
+        digest[i * 4 + 2] = (uint8_t)(state[i] >> 8);
+        digest[i * 4 + 3] = (uint8_t)state[i];
+    }
+}
+
+
+// MARK: - CRC32C
+
+/*! The reflected CRC32C (Castagnoli) table, for polynomial $82F63B78. */
+static const uint32_t hash_crc32c_table[256] = {
+    0x00000000, 0xF26B8303, 0xE13B70F7, 0x1350F3F4, 0xC79A971F, 0x35F1141C, 0x26A1E7E8, 0xD4CA64EB,
+    0x8AD958CF, 0x78B2DBCC, 0x6BE22838, 0x9989AB3B, 0x4D43CFD0, 0xBF284CD3, 0xAC78BF27, 0x5E133C24,
+    0x105EC76F, 0xE235446C, 0xF165B798, 0x030E349B, 0xD7C45070, 0x25AFD373, 0x36FF2087, 0xC494A384,
+    0x9A879FA0, 0x68EC1CA3, 0x7BBCEF57, 0x89D76C54, 0x5D1D08BF, 0xAF768BBC, 0xBC267848, 0x4E4DFB4B,
+    0x20BD8EDE, 0xD2D60DDD, 0xC186FE29, 0x33ED7D2A, 0xE72719C1, 0x154C9AC2, 0x061C6936, 0xF477EA35,
+    0xAA64D611, 0x580F5512, 0x4B5FA6E6, 0xB93425E5, 0x6DFE410E, 0x9F95C20D, 0x8CC531F9, 0x7EAEB2FA,
+    0x30E349B1, 0xC288CAB2, 0xD1D83946, 0x23B3BA45, 0xF779DEAE, 0x05125DAD, 0x1642AE59, 0xE4292D5A,
+    0xBA3A117E, 0x4851927D, 0x5B016189, 0xA96AE28A, 0x7DA08661, 0x8FCB0562, 0x9C9BF696, 0x6EF07595,
+    0x417B1DBC, 0xB3109EBF, 0xA0406D4B, 0x522BEE48, 0x86E18AA3, 0x748A09A0, 0x67DAFA54, 0x95B17957,
+    0xCBA24573, 0x39C9C670, 0x2A993584, 0xD8F2B687, 0x0C38D26C, 0xFE53516F, 0xED03A29B, 0x1F682198,
+    0x5125DAD3, 0xA34E59D0, 0xB01EAA24, 0x42752927, 0x96BF4DCC, 0x64D4CECF, 0x77843D3B, 0x85EFBE38,
+    0xDBFC821C, 0x2997011F, 0x3AC7F2EB, 0xC8AC71E8, 0x1C661503, 0xEE0D9600, 0xFD5D65F4, 0x0F36E6F7,
+    0x61C69362, 0x93AD1061, 0x80FDE395, 0x72966096, 0xA65C047D, 0x5437877E, 0x4767748A, 0xB50CF789,
+    0xEB1FCBAD, 0x197448AE, 0x0A24BB5A, 0xF84F3859, 0x2C855CB2, 0xDEEEDFB1, 0xCDBE2C45, 0x3FD5AF46,
+    0x7198540D, 0x83F3D70E, 0x90A324FA, 0x62C8A7F9, 0xB602C312, 0x44694011, 0x5739B3E5, 0xA55230E6,
+    0xFB410CC2, 0x092A8FC1, 0x1A7A7C35, 0xE811FF36, 0x3CDB9BDD, 0xCEB018DE, 0xDDE0EB2A, 0x2F8B6829,
+    0x82F63B78, 0x709DB87B, 0x63CD4B8F, 0x91A6C88C, 0x456CAC67, 0xB7072F64, 0xA457DC90, 0x563C5F93,
+    0x082F63B7, 0xFA44E0B4, 0xE9141340, 0x1B7F9043, 0xCFB5F4A8, 0x3DDE77AB, 0x2E8E845F, 0xDCE5075C,
+    0x92A8FC17, 0x60C37F14, 0x73938CE0, 0x81F80FE3, 0x55326B08, 0xA759E80B, 0xB4091BFF, 0x466298FC,
+    0x1871A4D8, 0xEA1A27DB, 0xF94AD42F, 0x0B21572C, 0xDFEB33C7, 0x2D80B0C4, 0x3ED04330, 0xCCBBC033,
+    0xA24BB5A6, 0x502036A5, 0x4370C551, 0xB11B4652, 0x65D122B9, 0x97BAA1BA, 0x84EA524E, 0x7681D14D,
+    0x2892ED69, 0xDAF96E6A, 0xC9A99D9E, 0x3BC21E9D, 0xEF087A76, 0x1D63F975, 0x0E330A81, 0xFC588982,
+    0xB21572C9, 0x407EF1CA, 0x532E023E, 0xA145813D, 0x758FE5D6, 0x87E466D5, 0x94B49521, 0x66DF1622,
+    0x38CC2A06, 0xCAA7A905, 0xD9F75AF1, 0x2B9CD9F2, 0xFF56BD19, 0x0D3D3E1A, 0x1E6DCDEE, 0xEC064EED,
+    0xC38D26C4, 0x31E6A5C7, 0x22B65633, 0xD0DDD530, 0x0417B1DB, 0xF67C32D8, 0xE52CC12C, 0x1747422F,
+    0x49547E0B, 0xBB3FFD08, 0xA86F0EFC, 0x5A048DFF, 0x8ECEE914, 0x7CA56A17, 0x6FF599E3, 0x9D9E1AE0,
+    0xD3D3E1AB, 0x21B862A8, 0x32E8915C, 0xC083125F, 0x144976B4, 0xE622F5B7, 0xF5720643, 0x07198540,
+    0x590AB964, 0xAB613A67, 0xB831C993, 0x4A5A4A90, 0x9E902E7B, 0x6CFBAD78, 0x7FAB5E8C, 0x8DC0DD8F,
+    0xE330A81A, 0x115B2B19, 0x020BD8ED, 0xF0605BEE, 0x24AA3F05, 0xD6C1BC06, 0xC5914FF2, 0x37FACCF1,
+    0x69E9F0D5, 0x9B8273D6, 0x88D28022, 0x7AB90321, 0xAE7367CA, 0x5C18E4C9, 0x4F48173D, 0xBD23943E,
+    0xF36E6F75, 0x0105EC76, 0x12551F82, 0xE03E9C81, 0x34F4F86A, 0xC69F7B69, 0xD5CF889D, 0x27A40B9E,
+    0x79B737BA, 0x8BDCB4B9, 0x988C474D, 0x6AE7C44E, 0xBE2DA0A5, 0x4C4623A6, 0x5F16D052, 0xAD7D5351,
+};
+
+
+/*! Update \a crc (pre-inverted) a byte at a time from the table. */
+static
+uint32_t hash_crc32c_generic(uint32_t crc, const uint8_t *p, size_t size)
+{
+    while (size--) {
+        crc = hash_crc32c_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+
+#if HASH_CRC32C_X86
+
+/*!
+    Update \a crc (pre-inverted) using the SSE4.2 CRC32 instruction,
+    eight bytes at a time once \a p is aligned.
+ */
+__attribute__((target("sse4.2")))
+static
+uint32_t hash_crc32c_x86(uint32_t crc, const uint8_t *p, size_t size)
+{
+    while ((size > 0) && ((uintptr_t)p % 8)) {
+        crc = _mm_crc32_u8(crc, *p++);
+        size--;
+    }
+
+#if defined(__x86_64__)
+    uint64_t crc64 = crc;
+    while (size >= 8) {
+        uint64_t value;
+        memcpy(&value, p, sizeof(value));
+        crc64 = _mm_crc32_u64(crc64, value);
+        p += 8;
+        size -= 8;
+    }
+    crc = (uint32_t)crc64;
+#endif
+
+    while (size >= 4) {
+        uint32_t value;
+        memcpy(&value, p, sizeof(value));
+        crc = _mm_crc32_u32(crc, value);
+        p += 4;
+        size -= 4;
+    }
+
+    while (size--) {
+        crc = _mm_crc32_u8(crc, *p++);
+    }
+    return crc;
+}
+
+
+/*! Whether the CPU has SSE4.2, and so the CRC32 instruction. */
+static
+bool hash_crc32c_x86_available(void)
+{
+    // Checked once; 0 is unknown, 1 is no, 2 is yes.
+    static atomic_int available = 0;
+
+    int known = atomic_load_explicit(&available, memory_order_relaxed);
+    if (known == 0) {
+        unsigned int eax, ebx, ecx, edx;
+        bool sse42 = __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & (1u << 20));
+        known = sse42 ? 2 : 1;
+        atomic_store_explicit(&available, known, memory_order_relaxed);
+    }
+
+    return known == 2;
+}
+
+#endif /* HASH_CRC32C_X86 */
+
+
+#if HASH_CRC32C_ARM
+
+/*!
+    Update \a crc (pre-inverted) using the ARMv8 CRC32C instructions,
+    which the compiler has been told every target CPU has.
+ */
+static
+uint32_t hash_crc32c_arm(uint32_t crc, const uint8_t *p, size_t size)
+{
+    while ((size > 0) && ((uintptr_t)p % 8)) {
+        crc = __crc32cb(crc, *p++);
+        size--;
+    }
+
+    while (size >= 8) {
+        uint64_t value;
+        memcpy(&value, p, sizeof(value));
+        crc = __crc32cd(crc, value);
+        p += 8;
+        size -= 8;
+    }
+
+    while (size--) {
+        crc = __crc32cb(crc, *p++);
+    }
+    return crc;
+}
+
+#endif /* HASH_CRC32C_ARM */
+
+
+uint32_t
+hash_crc32c(uint32_t crc, const void *buf, size_t size)
+{
+    const uint8_t *p = buf;
+    crc = ~crc;
+
+#if HASH_CRC32C_X86
+    if (hash_crc32c_x86_available()) return ~hash_crc32c_x86(crc, p, size);
+#endif
+#if HASH_CRC32C_ARM
+    return ~hash_crc32c_arm(crc, p, size);
+#else
+    return ~hash_crc32c_generic(crc, p, size);
+#endif
+}
+
+
+UTILS_SOURCE_END
@@ -0,0 +1,63 @@
+//  hash_utils.h
+//  General-Purpose Utilities
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#ifndef __HASH_UTILS__H__
+#define __HASH_UTILS__H__
+
+#include "utils_defines.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+UTILS_HEADER_BEGIN
+
+
+/*!
+    Compute the 64-bit xxHash (XXH64) of \a size bytes at \a buf, with
+    the given \a seed.
+
+    This is a fast non-cryptographic hash, suitable for noticing when
+    content has changed but not for defending against anyone trying to
+    make it look like it hasn't.
+ */
+UTILS_EXTERN
+uint64_t
+hash_xxh64(const void *buf, size_t size, uint64_t seed);
+
+
+/*! The size of a SHA-256 digest, in bytes. */
+#define HASH_SHA256_SIZE	32
+
+/*!
+    Compute the SHA-256 digest of \a size bytes at \a buf into \a digest.
+
+    This is a cryptographic hash, suitable for naming content by what it
+    holds. Where the CPU has the SHA extensions, they're used to process
+    each block; otherwise it's computed a word at a time.
+ */
+UTILS_EXTERN
+void
+hash_sha256(const void *buf, size_t size, uint8_t digest[HASH_SHA256_SIZE]);
+
+
+
+/*!
+    Update the CRC32C (Castagnoli) \a crc of some data with \a size more
+    bytes at \a buf; start with a \a crc of 0. This is the CRC used by
+    iSCSI and ext4, so it can be checked with other tools.
+
+    Where the CPU has CRC32C instructions (SSE4.2 on x86, or ARMv8's CRC
+    extension when compiled for it), they're used eight bytes at a time;
+    otherwise it's computed a byte at a time from a table.
+ */
+UTILS_EXTERN
+uint32_t
+hash_crc32c(uint32_t crc, const void *buf, size_t size);
+
+
+UTILS_HEADER_END
+
+#endif /* __HASH_UTILS__H__ */
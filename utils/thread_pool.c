@@ -0,0 +1,339 @@
+//  thread_pool.c
+//  General-Purpose Utilities
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#include "thread_pool.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+UTILS_SOURCE_BEGIN
+
+
+struct thread_pool_task {
+    thread_pool_task_fn		fn;
+    void					* UTILS_NULLABLE context;
+};
+typedef struct thread_pool_task thread_pool_task;
+
+/*!
+    A worker's double-ended task queue. The owning worker pushes and pops
+    at the bottom, while other workers steal from the top, so work spreads
+    out oldest-first and stays local newest-first.
+ */
+struct thread_pool_deque {
+    pthread_mutex_t		lock;
+    thread_pool_task	* UTILS_NULLABLE tasks;		//!< ring buffer
+    size_t				capacity;
+    size_t				top;
+    size_t				count;
+};
+typedef struct thread_pool_deque thread_pool_deque;
+
+struct thread_pool_worker {
+    thread_pool			* UTILS_NULLABLE pool;
+    pthread_t			thread;
+    size_t				index;
+    thread_pool_deque	deque;
+};
+typedef struct thread_pool_worker thread_pool_worker;
+
+struct thread_pool {
+    thread_pool_worker	* UTILS_NULLABLE workers;
+    size_t				thread_count;
+    size_t				started_count;
+    atomic_size_t		next_worker;		//!< round-robin target for outside submissions
+
+    pthread_mutex_t		lock;
+    pthread_cond_t		task_available;		//!< signaled when a task is queued or the pool stops
+    pthread_cond_t		tasks_finished;		//!< signaled when outstanding reaches 0
+
+    atomic_size_t		queued;				//!< tasks sitting in deques
+    atomic_size_t		outstanding;		//!< tasks queued or running
+    bool				stopping;
+};
+
+
+/*! The worker running on the current thread, if any. */
+static _Thread_local thread_pool_worker * UTILS_NULLABLE thread_pool_current_worker = NULL;
+
+
+// MARK: - Deques
+
+int
+thread_pool_deque_push(thread_pool_deque *deque, thread_pool_task task)
+{
+    pthread_mutex_lock(&deque->lock);
+
+    if (deque->count == deque->capacity) {
+        size_t new_capacity = deque->capacity ? deque->capacity * 2 : 64;
+        thread_pool_task *tasks = malloc(sizeof(thread_pool_task) * new_capacity);
+        if (tasks == NULL) {
+            pthread_mutex_unlock(&deque->lock);
+            return -1;
+        }
+        for (size_t i = 0; i < deque->count; i++) {
+            tasks[i] = deque->tasks[(deque->top + i) % deque->capacity];
+        }
+        free(deque->tasks);
+        deque->tasks = tasks;
+        deque->capacity = new_capacity;
+        deque->top = 0;
+    }
+
+    deque->tasks[(deque->top + deque->count) % deque->capacity] = task;
+    deque->count += 1;
+
+    pthread_mutex_unlock(&deque->lock);
+    return 0;
+}
+
+bool
+thread_pool_deque_pop(thread_pool_deque *deque, thread_pool_task *task)
+{
+    bool found = false;
+
+    pthread_mutex_lock(&deque->lock);
+    if (deque->count > 0) {
+        deque->count -= 1;
+        *task = deque->tasks[(deque->top + deque->count) % deque->capacity];
+        found = true;
+    }
+    pthread_mutex_unlock(&deque->lock);
+
+    return found;
+}
+
+bool
+thread_pool_deque_steal(thread_pool_deque *deque, thread_pool_task *task)
+{
+    bool found = false;
+
+    // Don't wait on a busy victim; there are others to try.
+    if (pthread_mutex_trylock(&deque->lock) != 0) return false;
+
+    if (deque->count > 0) {
+        *task = deque->tasks[deque->top];
+        deque->top = (deque->top + 1) % deque->capacity;
+        deque->count -= 1;
+        found = true;
+    }
+    pthread_mutex_unlock(&deque->lock);
+
+    return found;
+}
+
+
+// MARK: - Workers
+
+size_t
+thread_pool_default_thread_count(void)
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (count > 0) ? (size_t)count : 1;
+}
+
+
+/*! Find a task for \a worker, from its own deque or by stealing one. */
+bool
+thread_pool_find_task(thread_pool_worker *worker, thread_pool_task *task)
+{
+    thread_pool *pool = worker->pool;
+
+    if (thread_pool_deque_pop(&worker->deque, task)) return true;
+
+    for (size_t i = 1; i < pool->started_count; i++) {
+        thread_pool_worker *victim = &pool->workers[(worker->index + i) % pool->started_count];
+        if (thread_pool_deque_steal(&victim->deque, task)) return true;
+    }
+
+    return false;
+}
+
+
+void *
+thread_pool_worker_main(void *arg)
+{
+    thread_pool_worker *worker = arg;
+    thread_pool *pool = worker->pool;
+
+    thread_pool_current_worker = worker;
+
+    // Wait for the pool to finish starting, so the set of workers to
+    // steal from is settled.
+    pthread_mutex_lock(&pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (;;) {
+        thread_pool_task task;
+
+        if (thread_pool_find_task(worker, &task)) {
+            atomic_fetch_sub(&pool->queued, 1);
+
+            task.fn(task.context, worker->index);
+
+            if (atomic_fetch_sub(&pool->outstanding, 1) == 1) {
+                pthread_mutex_lock(&pool->lock);
+                pthread_cond_broadcast(&pool->tasks_finished);
+                pthread_mutex_unlock(&pool->lock);
+            }
+            continue;
+        }
+
+        // Nothing to run or steal, so sleep until something's queued.
+        // A victim may have been skipped because it was busy, so only
+        // sleep once nothing is queued anywhere.
+
+        pthread_mutex_lock(&pool->lock);
+        while ((atomic_load(&pool->queued) == 0) && !pool->stopping) {
+            pthread_cond_wait(&pool->task_available, &pool->lock);
+        }
+        bool done = pool->stopping && (atomic_load(&pool->queued) == 0);
+        pthread_mutex_unlock(&pool->lock);
+
+        if (done) break;
+    }
+
+    thread_pool_current_worker = NULL;
+
+    return NULL;
+}
+
+
+// MARK: - Pools
+
+thread_pool * UTILS_NULLABLE
+thread_pool_create(size_t thread_count)
+{
+    thread_pool *pool = calloc(sizeof(thread_pool), 1);
+    if (pool == NULL) return NULL;
+
+    pool->thread_count = (thread_count > 0) ? thread_count : thread_pool_default_thread_count();
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->task_available, NULL);
+    pthread_cond_init(&pool->tasks_finished, NULL);
+    atomic_init(&pool->next_worker, 0);
+    atomic_init(&pool->queued, 0);
+    atomic_init(&pool->outstanding, 0);
+
+    pool->workers = calloc(sizeof(thread_pool_worker), pool->thread_count);
+    if (pool->workers == NULL) goto error;
+
+    for (size_t i = 0; i < pool->thread_count; i++) {
+        pool->workers[i].pool = pool;
+        pool->workers[i].index = i;
+        pthread_mutex_init(&pool->workers[i].deque.lock, NULL);
+    }
+
+    // Workers steal from each other, so the worker array must be
+    // complete before any of them start.
+
+    pthread_mutex_lock(&pool->lock);
+    for (size_t i = 0; i < pool->thread_count; i++) {
+        int create_err = pthread_create(&pool->workers[i].thread, NULL,
+                                        thread_pool_worker_main, &pool->workers[i]);
+        if (create_err != 0) break;
+        pool->started_count += 1;
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    if (pool->started_count == 0) goto error;
+
+    return pool;
+
+error:
+    thread_pool_free(pool);
+    return NULL;
+}
+
+
+void
+thread_pool_free(thread_pool * UTILS_NULLABLE pool)
+{
+    if (pool) {
+        if (pool->started_count > 0) thread_pool_wait(pool);
+
+        pthread_mutex_lock(&pool->lock);
+        pool->stopping = true;
+        pthread_cond_broadcast(&pool->task_available);
+        pthread_mutex_unlock(&pool->lock);
+
+        for (size_t i = 0; i < pool->started_count; i++) {
+            pthread_join(pool->workers[i].thread, NULL);
+        }
+
+        if (pool->workers) {
+            for (size_t i = 0; i < pool->thread_count; i++) {
+                pthread_mutex_destroy(&pool->workers[i].deque.lock);
+                free(pool->workers[i].deque.tasks);
+            }
+        }
+
+        pthread_cond_destroy(&pool->tasks_finished);
+        pthread_cond_destroy(&pool->task_available);
+        pthread_mutex_destroy(&pool->lock);
+
+        free(pool->workers);
+        free(pool);
+    }
+}
+
+
+size_t
+thread_pool_thread_count(thread_pool *pool)
+{
+    return pool->started_count;
+}
+
+
+int
+thread_pool_submit(thread_pool *pool, thread_pool_task_fn fn, void * UTILS_NULLABLE context)
+{
+    thread_pool_task task = { fn, context };
+
+    // Tasks submitted by a worker stay on its own deque, where it'll pick
+    // them up next unless someone idle steals them first. Others are
+    // dealt out round-robin.
+
+    thread_pool_worker *worker = thread_pool_current_worker;
+    if ((worker == NULL) || (worker->pool != pool)) {
+        size_t next = atomic_fetch_add(&pool->next_worker, 1);
+        worker = &pool->workers[next % pool->started_count];
+    }
+
+    atomic_fetch_add(&pool->outstanding, 1);
+    atomic_fetch_add(&pool->queued, 1);
+
+    int push_err = thread_pool_deque_push(&worker->deque, task);
+    if (push_err == -1) {
+        atomic_fetch_sub(&pool->queued, 1);
+        atomic_fetch_sub(&pool->outstanding, 1);
+        return -1;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_signal(&pool->task_available);
+    pthread_mutex_unlock(&pool->lock);
+
+    return 0;
+}
+
+
+void
+thread_pool_wait(thread_pool *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    while (atomic_load(&pool->outstanding) > 0) {
+        pthread_cond_wait(&pool->tasks_finished, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+
+UTILS_SOURCE_END
@@ -0,0 +1,74 @@
+//  thread_pool.h
+//  General-Purpose Utilities
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#ifndef __THREAD_POOL__H__
+#define __THREAD_POOL__H__
+
+#include "utils_defines.h"
+
+#include <stdlib.h>
+
+UTILS_HEADER_BEGIN
+
+
+/*!
+    A fixed-size pool of worker threads. Each worker has its own queue of
+    tasks, and a worker that runs out steals from the others.
+ */
+struct thread_pool;
+typedef struct thread_pool thread_pool;
+
+
+/*!
+    A task run on a thread pool, given its context and the index of the
+    worker running it. The worker index is always less than the pool's
+    thread count, so it can be used to index per-worker state.
+ */
+typedef void (*thread_pool_task_fn)(void * UTILS_NULLABLE context, size_t worker);
+
+
+/*! Get a reasonable number of worker threads for this machine. */
+UTILS_EXTERN
+size_t
+thread_pool_default_thread_count(void);
+
+/*! Create a thread pool; a \a thread_count of 0 uses the default. */
+UTILS_EXTERN
+thread_pool * UTILS_NULLABLE
+thread_pool_create(size_t thread_count);
+
+/*! Wait for all submitted tasks, then stop and free a thread pool. */
+UTILS_EXTERN
+void
+thread_pool_free(thread_pool * UTILS_NULLABLE pool);
+
+/*! Get the number of worker threads in a thread pool. */
+UTILS_EXTERN
+size_t
+thread_pool_thread_count(thread_pool *pool);
+
+/*!
+    Submit a task to a thread pool. Returns -1 if it can't be queued.
+
+    A task submitted from one of the pool's own workers is queued on that
+    worker, so related work tends to stay on the same thread.
+ */
+UTILS_EXTERN
+int
+thread_pool_submit(thread_pool *pool, thread_pool_task_fn fn, void * UTILS_NULLABLE context);
+
+/*!
+    Wait until every task submitted to a thread pool has finished. This
+    must not be called from one of the pool's own workers.
+ */
+UTILS_EXTERN
+void
+thread_pool_wait(thread_pool *pool);
+
+
+UTILS_HEADER_END
+
+#endif /* __THREAD_POOL__H__ */
@@ -0,0 +1,199 @@
+//  zero_copy.c
+//  General-Purpose Utilities
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#include "zero_copy.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#define ZERO_COPY_HAVE_VMSPLICE 1
+#if defined(__NR_copy_file_range)
+#define ZERO_COPY_HAVE_COPY_FILE_RANGE 1
+#endif
+#endif
+
+UTILS_SOURCE_BEGIN
+
+
+/*! The most handed to the kernel in a single call. */
+#define ZERO_COPY_MAX_CHUNK ((size_t)1 << 30)
+
+/*! The size of the buffer used to copy between files by hand. */
+#define ZERO_COPY_BUFFER_SIZE ((size_t)1 << 20)
+
+
+#if ZERO_COPY_HAVE_VMSPLICE
+
+/*!
+    Splice as much of \a buf into the pipe \a fd as possible, adding the
+    amount spliced to \a written. Returns -1 with errno set if splicing
+    isn't possible, in which case the rest can still be written.
+ */
+int
+zero_copy_vmsplice(int fd, const uint8_t *buf, size_t size, size_t *written)
+{
+    while (*written < size) {
+        size_t remaining = size - *written;
+        struct iovec iov = {
+            .iov_base = (void *)&buf[*written],
+            .iov_len = (remaining < ZERO_COPY_MAX_CHUNK) ? remaining : ZERO_COPY_MAX_CHUNK,
+        };
+
+        // Called directly, since the wrapper needs _GNU_SOURCE.
+        long n = syscall(__NR_vmsplice, fd, &iov, 1UL, 0U);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        *written += (size_t)n;
+    }
+
+    return 0;
+}
+
+#endif
+
+
+int
+zero_copy_write(int fd, const void *buf, size_t size, bool * UTILS_NULLABLE spliced)
+{
+    const uint8_t *bytes = buf;
+    size_t written = 0;
+
+    if (spliced) *spliced = false;
+
+#if ZERO_COPY_HAVE_VMSPLICE
+    struct stat st;
+    if ((size > 0) && (fstat(fd, &st) == 0) && S_ISFIFO(st.st_mode)) {
+        int splice_err = zero_copy_vmsplice(fd, bytes, size, &written);
+        if (splice_err == 0) {
+            if (spliced) *spliced = true;
+            return 0;
+        }
+
+        // A reader that's gone away is an error however it's written to;
+        // anything else just means falling back to writing.
+        if (errno == EPIPE) return -1;
+    }
+#endif
+
+    while (written < size) {
+        size_t remaining = size - written;
+        ssize_t n = write(fd, &bytes[written], (remaining < ZERO_COPY_MAX_CHUNK) ? remaining : ZERO_COPY_MAX_CHUNK);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        written += (size_t)n;
+    }
+
+    return 0;
+}
+
+
+#if ZERO_COPY_HAVE_COPY_FILE_RANGE
+
+/*!
+    Have the kernel copy as much of the range as possible, adding the
+    amount copied to \a copied. Returns -1 with errno set if it can't
+    copy between these files, in which case the rest can still be
+    copied by hand.
+ */
+int
+zero_copy_copy_file_range(int out_fd, off_t out_offset, int in_fd, off_t in_offset, size_t size, size_t *copied)
+{
+    while (*copied < size) {
+        size_t remaining = size - *copied;
+        int64_t in_position = in_offset + (off_t)*copied;
+        int64_t out_position = out_offset + (off_t)*copied;
+
+        // Called directly, since the wrapper needs _GNU_SOURCE.
+        long n = syscall(__NR_copy_file_range, in_fd, &in_position, out_fd, &out_position,
+                         (remaining < ZERO_COPY_MAX_CHUNK) ? remaining : ZERO_COPY_MAX_CHUNK, 0U);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) {
+            errno = EIO;
+            return -1;
+        }
+        *copied += (size_t)n;
+    }
+
+    return 0;
+}
+
+#endif
+
+
+int
+zero_copy_file_range(int out_fd, off_t out_offset, int in_fd, off_t in_offset, size_t size)
+{
+    size_t copied = 0;
+
+#if ZERO_COPY_HAVE_COPY_FILE_RANGE
+    if (size > 0) {
+        int copy_err = zero_copy_copy_file_range(out_fd, out_offset, in_fd, in_offset, size, &copied);
+        if (copy_err == 0) return 0;
+
+        // These just mean the kernel can't copy between these two files
+        // (different file systems, an old kernel, special files); any
+        // other failure would happen again by hand.
+        if ((errno != EXDEV) && (errno != ENOSYS) && (errno != EINVAL) && (errno != EOPNOTSUPP)) return -1;
+    }
+#endif
+
+    if (copied == size) return 0;
+
+    size_t buffer_size = (size - copied < ZERO_COPY_BUFFER_SIZE) ? size - copied : ZERO_COPY_BUFFER_SIZE;
+    uint8_t *buffer = malloc(buffer_size);
+    if (buffer == NULL) return -1;
+
+    int result = -1;
+
+    while (copied < size) {
+        size_t remaining = size - copied;
+        ssize_t n = pread(in_fd, buffer, (remaining < buffer_size) ? remaining : buffer_size,
+                          in_offset + (off_t)copied);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            goto done;
+        }
+        if (n == 0) {
+            errno = EIO;
+            goto done;
+        }
+
+        size_t written = 0;
+        while (written < (size_t)n) {
+            ssize_t w = pwrite(out_fd, &buffer[written], (size_t)n - written,
+                               out_offset + (off_t)(copied + written));
+            if (w == -1) {
+                if (errno == EINTR) continue;
+                goto done;
+            }
+            written += (size_t)w;
+        }
+
+        copied += (size_t)n;
+    }
+
+    result = 0;
+
+done:
+    free(buffer);
+    return result;
+}
+
+
+UTILS_SOURCE_END
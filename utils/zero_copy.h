@@ -0,0 +1,63 @@
+//  zero_copy.h
+//  General-Purpose Utilities
+//
+//  Copyright © 2026 Christopher M. Hanson. All rights reserved.
+//  See file COPYING for details.
+
+#ifndef __ZERO_COPY__H__
+#define __ZERO_COPY__H__
+
+#include "utils_defines.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+UTILS_HEADER_BEGIN
+
+
+/*!
+    Write all \a size bytes at \a buf to the file descriptor \a fd, with
+    as little copying as the platform allows.
+
+    When \a fd is a pipe on Linux, the pages holding \a buf are spliced
+    into the pipe with `vmsplice`, so the bytes are never copied through
+    user space; if \a buf is a mapping of a file, the reader gets the
+    page cache's own pages. Otherwise, or if splicing isn't possible,
+    the bytes are written with as few large `write` calls as possible.
+
+    Since the pipe may go on referring to the pages after this returns,
+    \a buf must not be modified afterwards. (Unmapping or freeing it is
+    fine; the pipe holds on to the pages themselves.)
+
+    If \a spliced is given, it's set to whether the bytes were spliced.
+
+    Returns 0 on success, or -1 with errno set.
+ */
+UTILS_EXTERN
+int
+zero_copy_write(int fd, const void *buf, size_t size, bool * UTILS_NULLABLE spliced);
+
+/*!
+    Copy \a size bytes at \a in_offset in the file \a in_fd to
+    \a out_offset in the file \a out_fd, with as little copying as the
+    platform allows. Neither descriptor's file offset is changed.
+
+    On Linux the copy is done by the kernel with `copy_file_range`, so
+    the bytes never pass through user space, and on file systems that
+    support it the two files may even share the same blocks afterwards.
+    Otherwise, or if that isn't possible between the two files, the
+    bytes are copied with large `pread` and `pwrite` calls.
+
+    Fails with EIO if \a in_fd ends before \a size bytes were copied.
+
+    Returns 0 on success, or -1 with errno set.
+ */
+UTILS_EXTERN
+int
+zero_copy_file_range(int out_fd, off_t out_offset, int in_fd, off_t in_offset, size_t size);
+
+
+UTILS_HEADER_END
+
+#endif /* __ZERO_COPY__H__ */